@@ -3,6 +3,8 @@
 # Variables
 UNITTEST_PROGRAM="./itc_platform_unittest"
 UNITTEST_LOG="unittest/test-results/itc_platform_unittest.log"
+BENCH_PROGRAM="./itc_platform_bench"
+BENCH_RESULT_JSON="bench/results/itc_platform_bench.json"
 VALGRIND_REPORT_XML="unittest/valgrind/memory_leak_report.xml"
 TEST_COVERAGE_INFO="unittest/coverage/coverage.info"
 TEST_COVERAGE_OUTPUT="unittest/coverage/output"
@@ -23,6 +25,7 @@ TEST_COVERAGE_RATE="92"
 ENABLE_REBUILD="no"
 ENABLE_ADDRESS_SANITIZER=""
 ENABLE_THREAD_SANITIZER=""
+ENABLE_LATENCY_TRACE=""
 
 # Parse arguments
 for arg in "$@"; do
@@ -69,6 +72,12 @@ for arg in "$@"; do
             ENABLE_THREAD_SANITIZER="--enable-thread-sanitizer"
             shift
             ;;
+        --enable-latency-trace)
+            ENABLE_LATENCY_TRACE="--enable-latency-trace"
+            # Preamble layout changes, so every object must be rebuilt
+            ENABLE_REBUILD="yes"
+            shift
+            ;;
         *)
             echo "[-] Unknown option: $arg"
             exit 1
@@ -88,6 +97,7 @@ echo "[+] Test Coverage Rate: $TEST_COVERAGE_RATE"
 echo "[+] Enable Rebuild: $ENABLE_REBUILD"
 echo "[+] Enable Address Sanitizer: $ENABLE_ADDRESS_SANITIZER"
 echo "[+] Enable Thread Sanitizer: $ENABLE_THREAD_SANITIZER"
+echo "[+] Enable Latency Trace: $ENABLE_LATENCY_TRACE"
 
 # Validate conditions: If valgrind or coverage is enabled but UT is disabled, return an error
 if  [[ "$BUILD_TARGET" != "target1" ]] &&
@@ -97,7 +107,8 @@ if  [[ "$BUILD_TARGET" != "target1" ]] &&
 fi
 if  [[ "$BUILD_TYPE" != "debug" ]] &&
     [[ "$BUILD_TYPE" != "release" ]] &&
-    [[ "$BUILD_TYPE" != "unittest" ]]; then
+    [[ "$BUILD_TYPE" != "unittest" ]] &&
+    [[ "$BUILD_TYPE" != "benchmark" ]]; then
     echo "[-] Error: Unknown BUILD_TYPE option: $BUILD_TYPE"
     exit 1
 fi
@@ -151,7 +162,7 @@ if { [[ "$ENABLE_VALGRIND" == "yes" ]] || [[ "$ENABLE_TEST_COVERAGE" == "yes" ]]
     exit 1
 fi
 
-TO_BE_REMOVED="./itc_platform_unittest unittest/test-results/* unittest/valgrind/* unittest/coverage/* sw/itc-api/src/*.gcda sw/itc-api/src/*.gcno sw/itc-common/src/*.gcda sw/itc-common/src/*.gcno"
+TO_BE_REMOVED="./itc_platform_unittest ./itc_platform_bench unittest/test-results/* unittest/valgrind/* unittest/coverage/* sw/itc-api/src/*.gcda sw/itc-api/src/*.gcno sw/itc-common/src/*.gcda sw/itc-common/src/*.gcno"
 
 # Build configure.ac options
 AUTO_BUILD_COMMAND=""
@@ -170,6 +181,7 @@ AUTO_BUILD_COMMAND+="ENABLE_VALGRIND=$ENABLE_VALGRIND "
 AUTO_BUILD_COMMAND+="ENABLE_TEST_COVERAGE=$ENABLE_TEST_COVERAGE "
 AUTO_BUILD_COMMAND+="$ENABLE_ADDRESS_SANITIZER "
 AUTO_BUILD_COMMAND+="$ENABLE_THREAD_SANITIZER "
+AUTO_BUILD_COMMAND+="$ENABLE_LATENCY_TRACE "
 AUTO_BUILD_COMMAND+="&& echo '================== COMPILATION START ==================' "
 AUTO_BUILD_COMMAND+="&& make "
 AUTO_BUILD_COMMAND+="&& echo '================== COMPILATION DONE ==================' "
@@ -223,6 +235,17 @@ if  [[ "$BUILD_TYPE" == "unittest" ]]; then
     
 fi
 
+if  [[ "$BUILD_TYPE" == "benchmark" ]]; then
+    AUTO_BUILD_COMMAND+="&& echo '================== BENCHMARK START ==================' "
+    AUTO_BUILD_COMMAND+="&& mkdir -p $(dirname $BENCH_RESULT_JSON) "
+    AUTO_BUILD_COMMAND+="&& $BENCH_PROGRAM --json=$BENCH_RESULT_JSON "
+    AUTO_BUILD_COMMAND+="&& echo '============================================================================' "
+    AUTO_BUILD_COMMAND+="&& echo '[+] Benchmark results saved in: $BENCH_RESULT_JSON' "
+    AUTO_BUILD_COMMAND+="&& echo '[+] Keep the file of each release to compare p50/p99/p99.9 and throughput against it' "
+    AUTO_BUILD_COMMAND+="&& echo '============================================================================' "
+    AUTO_BUILD_COMMAND+="&& echo '================== BENCHMARK DONE ==================' "
+fi
+
 # Print final configuration command
 echo "[+] Running: $AUTO_BUILD_COMMAND"
 
@@ -0,0 +1,48 @@
+#include "itcBench.h"
+#include "itcBenchMessage.h"
+
+#include "itcAdminMessage.h"
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+/* Latency is one allocate() plus one deallocate() on the same thread, taken from the MemoryPool size classes or its unlimited tier. */
+template<uint32_t MESSAGE_SIZE>
+BenchRun benchAdminMessageAllocateDeallocate(const BenchConfig &config)
+{
+    BenchConfig producersOnly = config;
+    producersOnly.nrConsumers = 0;
+    return runPipeline(producersOnly,
+        [](uint32_t, uint64_t, std::vector<uint64_t> &latencies)
+        {
+            uint64_t start = benchNow();
+            auto adminMsg = ItcAdminMessageHelper::allocate(ITC_BENCH_MESSAGE_MSGNO, MESSAGE_SIZE);
+            ItcAdminMessageHelper::deallocate(adminMsg);
+            latencies.push_back(benchNow() - start);
+        },
+        nullptr);
+}
+
+ITC_BENCH_REGISTER("ItcAdminMessageHelper/allocateDeallocate",
+    "Every thread allocates and deallocates small messages",
+    {{1, 0}, {2, 0}, {4, 0}, {32, 0}},
+    benchAdminMessageAllocateDeallocate<ITC_BENCH_MESSAGE_SIZE>)
+
+ITC_BENCH_REGISTER("ItcAdminMessageHelper/allocateDeallocateLarge",
+    "Every thread allocates and deallocates 1KB messages",
+    {{1, 0}, {4, 0}},
+    benchAdminMessageAllocateDeallocate<1024>)
+
+ITC_BENCH_REGISTER("ItcAdminMessageHelper/allocateDeallocate64KB",
+    "Every thread allocates and deallocates 64KB messages",
+    {{1, 0}, {4, 0}},
+    benchAdminMessageAllocateDeallocate<64 * 1024>)
+
+} // namespace INTERNAL
+} // namespace ITC
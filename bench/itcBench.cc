@@ -0,0 +1,311 @@
+#include "itcBench.h"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <ctime>
+#include <atomic>
+#include <thread>
+#include <latch>
+
+#include <unistd.h>
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+std::vector<BenchCase> &BenchRegistry::getCases()
+{
+    static std::vector<BenchCase> cases;
+    return cases;
+}
+
+BenchRun runPipeline(const BenchConfig &config, const BenchProducer &produce, const BenchConsumer &consume)
+{
+    const uint64_t nrTotalMessages = config.nrProducers * config.nrMessages;
+    std::vector<std::vector<uint64_t>> latencies(config.nrProducers + config.nrConsumers);
+    std::atomic<uint64_t> nrConsumedMessages {0};
+    std::latch startLatch(config.nrProducers + config.nrConsumers + 1);
+    std::vector<std::thread> threads;
+
+    for(uint32_t i = 0; i < config.nrProducers; ++i)
+    {
+        latencies.at(i).reserve(config.nrConsumers ? 0 : config.nrMessages);
+        threads.emplace_back([&, i]()
+        {
+            startLatch.arrive_and_wait();
+            for(uint64_t sequence = 0; sequence < config.nrMessages; ++sequence)
+            {
+                produce(i, sequence, latencies.at(i));
+            }
+        });
+    }
+    for(uint32_t i = 0; i < config.nrConsumers; ++i)
+    {
+        auto &consumerLatencies = latencies.at(config.nrProducers + i);
+        consumerLatencies.reserve(nrTotalMessages / config.nrConsumers + 1);
+        threads.emplace_back([&, i]()
+        {
+            startLatch.arrive_and_wait();
+            while(nrConsumedMessages.load(std::memory_order_relaxed) < nrTotalMessages)
+            {
+                uint64_t count = consume(i, consumerLatencies);
+                if(count > 0)
+                {
+                    nrConsumedMessages.fetch_add(count, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    BenchRun run;
+    startLatch.arrive_and_wait();
+    uint64_t start = benchNow();
+    for(auto &thread : threads)
+    {
+        thread.join();
+    }
+    run.elapsedNs = benchNow() - start;
+    run.nrOps = nrTotalMessages;
+    for(auto &threadLatencies : latencies)
+    {
+        run.latencies.insert(run.latencies.end(), threadLatencies.begin(), threadLatencies.end());
+    }
+    return run;
+}
+
+namespace
+{
+
+struct BenchOptions
+{
+    std::string filter;
+    std::string jsonPath;
+    uint64_t nrMessages {ITC_BENCH_DEFAULT_NUMBER_OF_MESSAGES};
+    uint32_t nrRepetitions {ITC_BENCH_DEFAULT_NUMBER_OF_REPETITIONS};
+    bool isListOnly {false};
+};
+
+struct BenchResult
+{
+    std::string name;
+    BenchConfig config;
+    uint32_t nrRepetitions {0};
+    /* Throughput of each repetition, ops/s. */
+    double throughputMean {0};
+    double throughputStddev {0};
+    double throughputMin {0};
+    double throughputMax {0};
+    /* Over all samples of all repetitions, ns. */
+    uint64_t latencyP50 {0};
+    uint64_t latencyP99 {0};
+    uint64_t latencyP999 {0};
+    uint64_t latencyMax {0};
+    double latencyMean {0};
+    /* 0 if the case does not count them or the kernel would not let it. */
+    double tlbMissesPerOp {0};
+};
+
+uint64_t getPercentile(const std::vector<uint64_t> &sortedSamples, double percentile)
+{
+    if(sortedSamples.empty())
+    {
+        return 0;
+    }
+    auto rank = static_cast<size_t>(std::ceil(percentile / 100.0 * sortedSamples.size()));
+    return sortedSamples.at(std::clamp(rank, (size_t)(1), sortedSamples.size()) - 1);
+}
+
+BenchResult runCase(const BenchCase &benchCase, const BenchConfig &config, uint32_t nrRepetitions)
+{
+    BenchResult result;
+    result.name = benchCase.name;
+    result.config = config;
+    result.nrRepetitions = nrRepetitions;
+
+    std::vector<double> throughputs;
+    std::vector<uint64_t> samples;
+    uint64_t nrTlbMisses {0};
+    uint64_t nrOps {0};
+    for(uint32_t i = 0; i < nrRepetitions; ++i)
+    {
+        BenchRun run = benchCase.function(config);
+        throughputs.push_back(run.elapsedNs ? run.nrOps * 1e9 / run.elapsedNs : 0);
+        samples.insert(samples.end(), run.latencies.begin(), run.latencies.end());
+        nrTlbMisses += run.nrTlbMisses;
+        nrOps += run.nrOps;
+    }
+    result.tlbMissesPerOp = nrOps ? static_cast<double>(nrTlbMisses) / nrOps : 0;
+
+    result.throughputMean = std::accumulate(throughputs.begin(), throughputs.end(), 0.0) / throughputs.size();
+    double variance = 0;
+    for(auto throughput : throughputs)
+    {
+        variance += (throughput - result.throughputMean) * (throughput - result.throughputMean);
+    }
+    result.throughputStddev = throughputs.size() > 1 ? std::sqrt(variance / (throughputs.size() - 1)) : 0;
+    result.throughputMin = *std::min_element(throughputs.begin(), throughputs.end());
+    result.throughputMax = *std::max_element(throughputs.begin(), throughputs.end());
+
+    std::sort(samples.begin(), samples.end());
+    result.latencyP50 = getPercentile(samples, 50);
+    result.latencyP99 = getPercentile(samples, 99);
+    result.latencyP999 = getPercentile(samples, 99.9);
+    result.latencyMax = samples.empty() ? 0 : samples.back();
+    result.latencyMean = samples.empty() ? 0 : std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    return result;
+}
+
+void printResult(std::ostream &os, const BenchResult &result)
+{
+    os << "[BENCHMARK] " << result.name
+       << " producers=" << result.config.nrProducers
+       << " consumers=" << result.config.nrConsumers
+       << std::fixed << std::setprecision(0)
+       << " throughput=" << result.throughputMean << " ops/s"
+       << std::setprecision(1)
+       << " (stddev " << (result.throughputMean > 0 ? 100.0 * result.throughputStddev / result.throughputMean : 0) << "%)"
+       << " p50=" << result.latencyP50 << " ns"
+       << " p99=" << result.latencyP99 << " ns"
+       << " p99.9=" << result.latencyP999 << " ns"
+       << " max=" << result.latencyMax << " ns";
+    if(result.tlbMissesPerOp > 0)
+    {
+        os << std::setprecision(3) << " dTLB-misses/op=" << result.tlbMissesPerOp;
+    }
+    os << "\n";
+}
+
+void writeJson(std::ostream &os, const BenchOptions &options, const std::vector<BenchResult> &results)
+{
+    char hostname[256] {};
+    ::gethostname(hostname, sizeof(hostname) - 1);
+    std::time_t now = std::time(nullptr);
+    char date[32] {};
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    os << std::fixed << std::setprecision(1);
+    os << "{\n";
+    os << "  \"context\": {\n";
+#ifdef PACKAGE_VERSION
+    os << "    \"version\": \"" << PACKAGE_VERSION << "\",\n";
+#endif
+    os << "    \"date\": \"" << date << "\",\n";
+    os << "    \"host\": \"" << hostname << "\",\n";
+    os << "    \"nrCpus\": " << std::thread::hardware_concurrency() << ",\n";
+    os << "    \"nrMessagesPerProducer\": " << options.nrMessages << ",\n";
+    os << "    \"nrRepetitions\": " << options.nrRepetitions << "\n";
+    os << "  },\n";
+    os << "  \"benchmarks\": [";
+    for(size_t i = 0; i < results.size(); ++i)
+    {
+        const auto &result = results.at(i);
+        os << (i ? ",\n" : "\n");
+        os << "    {\n";
+        os << "      \"name\": \"" << result.name << "\",\n";
+        os << "      \"producers\": " << result.config.nrProducers << ",\n";
+        os << "      \"consumers\": " << result.config.nrConsumers << ",\n";
+        os << "      \"throughputOpsPerSec\": {\"mean\": " << result.throughputMean << ", \"stddev\": " << result.throughputStddev
+           << ", \"min\": " << result.throughputMin << ", \"max\": " << result.throughputMax << "},\n";
+        os << "      \"latencyNs\": {\"p50\": " << result.latencyP50 << ", \"p99\": " << result.latencyP99 << ", \"p99.9\": " << result.latencyP999
+           << ", \"max\": " << result.latencyMax << ", \"mean\": " << result.latencyMean << "}";
+        if(result.tlbMissesPerOp > 0)
+        {
+            os << ",\n      \"dtlbLoadMissesPerOp\": " << std::setprecision(3) << result.tlbMissesPerOp << std::setprecision(1);
+        }
+        os << "\n";
+        os << "    }";
+    }
+    os << "\n  ]\n";
+    os << "}\n";
+}
+
+void printUsage(const char *program)
+{
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --filter=<substring>    Only run bench cases whose name contains substring\n"
+              << "  --messages=<N>          Messages per producer thread (default " << ITC_BENCH_DEFAULT_NUMBER_OF_MESSAGES << ")\n"
+              << "  --repetitions=<N>       Repetitions of every case (default " << ITC_BENCH_DEFAULT_NUMBER_OF_REPETITIONS << ")\n"
+              << "  --json=<file>           Also write results as JSON, \"-\" for stdout\n"
+              << "  --list                  List bench cases and exit\n";
+}
+
+} // namespace
+
+} // namespace INTERNAL
+} // namespace ITC
+
+using namespace ITC::INTERNAL;
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if(arg.rfind("--filter=", 0) == 0)
+        {
+            options.filter = arg.substr(arg.find('=') + 1);
+        } else if(arg.rfind("--messages=", 0) == 0)
+        {
+            options.nrMessages = std::stoull(arg.substr(arg.find('=') + 1));
+        } else if(arg.rfind("--repetitions=", 0) == 0)
+        {
+            options.nrRepetitions = std::max(std::stoul(arg.substr(arg.find('=') + 1)), 1UL);
+        } else if(arg.rfind("--json=", 0) == 0)
+        {
+            options.jsonPath = arg.substr(arg.find('=') + 1);
+        } else if(arg == "--list")
+        {
+            options.isListOnly = true;
+        } else
+        {
+            printUsage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    std::vector<BenchResult> results;
+    for(const auto &benchCase : BenchRegistry::getCases())
+    {
+        if(benchCase.name.find(options.filter) == std::string::npos)
+        {
+            continue;
+        }
+        if(options.isListOnly)
+        {
+            std::cout << benchCase.name << ": " << benchCase.description << "\n";
+            continue;
+        }
+        for(const auto &[nrProducers, nrConsumers] : benchCase.threadCounts)
+        {
+            BenchConfig config {nrProducers, nrConsumers, options.nrMessages};
+            results.push_back(runCase(benchCase, config, options.nrRepetitions));
+            /* Keep stdout clean for --json=- */
+            printResult(options.jsonPath == "-" ? std::cerr : std::cout, results.back());
+        }
+    }
+
+    if(options.jsonPath == "-")
+    {
+        writeJson(std::cout, options, results);
+    } else if(!options.jsonPath.empty())
+    {
+        std::ofstream file(options.jsonPath);
+        if(!file)
+        {
+            std::cerr << "Failed to open " << options.jsonPath << "\n";
+            return 1;
+        }
+        writeJson(file, options, results);
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <chrono>
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+#define ITC_BENCH_DEFAULT_NUMBER_OF_MESSAGES        (uint64_t)(100000) /* Per producer */
+#define ITC_BENCH_DEFAULT_NUMBER_OF_REPETITIONS     (uint32_t)(5)
+
+struct BenchConfig
+{
+    uint32_t nrProducers {1};
+    uint32_t nrConsumers {1};
+    uint64_t nrMessages {ITC_BENCH_DEFAULT_NUMBER_OF_MESSAGES}; /* Per producer */
+};
+
+/* Outcome of one repetition of a bench case. */
+struct BenchRun
+{
+    uint64_t                nrOps {0};
+    uint64_t                elapsedNs {0};
+    std::vector<uint64_t>   latencies; /* ns, one sample per message */
+    uint64_t                nrTlbMisses {0}; /* dTLB load misses, only counted by cases about memory layout */
+};
+
+using BenchFunction = std::function<BenchRun(const BenchConfig &config)>;
+using BenchThreadCounts = std::vector<std::pair<uint32_t /* producers */, uint32_t /* consumers */>>;
+
+struct BenchCase
+{
+    std::string         name;
+    std::string         description;
+    BenchThreadCounts   threadCounts;
+    BenchFunction       function;
+};
+
+/***
+ * Bench cases register themselves at static initialisation time, see ITC_BENCH_REGISTER(),
+ * and are run by itc_platform_bench in registration order.
+ */
+class BenchRegistry
+{
+public:
+    static std::vector<BenchCase> &getCases();
+
+    BenchRegistry(BenchCase benchCase)
+    {
+        getCases().emplace_back(std::move(benchCase));
+    }
+};
+
+#define ITC_BENCH_CONCAT_IMPL(a, b)     a##b
+#define ITC_BENCH_CONCAT(a, b)          ITC_BENCH_CONCAT_IMPL(a, b)
+#define ITC_BENCH_REGISTER(...) \
+    static ::ITC::INTERNAL::BenchRegistry ITC_BENCH_CONCAT(benchRegistry, __LINE__)(::ITC::INTERNAL::BenchCase{__VA_ARGS__});
+
+/* CLOCK_MONOTONIC, so stamps taken in different processes can be compared, too. */
+inline uint64_t benchNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+using BenchProducer = std::function<void(uint32_t producerIndex, uint64_t sequence, std::vector<uint64_t> &latencies)>;
+using BenchConsumer = std::function<uint64_t(uint32_t consumerIndex, std::vector<uint64_t> &latencies)>;
+
+/***
+ * Starts config.nrProducers threads calling produce() config.nrMessages times each, and config.nrConsumers threads
+ * calling consume() until all messages have been consumed. All threads are released at once.
+ * Producers stamp benchNow() into what they send, consume() must never block, returns how many messages it took
+ * and appends their benchNow() - stamp to latencies. Without consumers, producers record their own latencies.
+ */
+BenchRun runPipeline(const BenchConfig &config, const BenchProducer &produce, const BenchConsumer &consume);
+
+} // namespace INTERNAL
+} // namespace ITC
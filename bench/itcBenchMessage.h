@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "itcBench.h"
+#include "itcAdminMessage.h"
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+/* Bench messages carry the sender's benchNow() right after msgno. */
+#define ITC_BENCH_MESSAGE_MSGNO             (uint32_t)(0xBE0C0001)
+#define ITC_BENCH_MESSAGE_SIZE              (uint32_t)(ITC_MESSAGE_MSGNO_SIZE + sizeof(uint64_t))
+
+inline void stampBenchMessage(ItcAdminMessageRawPtr adminMsg)
+{
+    uint64_t now = benchNow();
+    std::memcpy(&adminMsg->msgno + 1, &now, sizeof(now));
+}
+
+inline uint64_t getBenchMessageLatency(ItcAdminMessageRawPtr adminMsg)
+{
+    uint64_t stamp {0};
+    std::memcpy(&stamp, &adminMsg->msgno + 1, sizeof(stamp));
+    return benchNow() - stamp;
+}
+
+} // namespace INTERNAL
+} // namespace ITC
@@ -0,0 +1,85 @@
+#include "itcBench.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "itcConcurrentContainer.h"
+#include "itcMailbox.h"
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+using ItcBenchMailboxList = ConcurrentContainer<ItcMailbox, ITC_MAX_SUPPORTED_MAILBOXES>;
+
+/* Lookups only, every thread walks through all names in its own order. */
+BenchRun benchConcurrentContainerLookUp(const BenchConfig &config)
+{
+    auto mboxList = std::make_unique<ItcBenchMailboxList>([](ItcMailbox *, uint32_t) {});
+    std::vector<std::string> names;
+    for(uint32_t i = 0; i < ITC_MAX_SUPPORTED_MAILBOXES; ++i)
+    {
+        names.push_back("benchMailbox" + std::to_string(i));
+        mboxList->addEntryToHashMap(names.back(), mboxList->tryPopFromQueue());
+    }
+    return runPipeline(config,
+        [&mboxList, &names](uint32_t producerIndex, uint64_t sequence, std::vector<uint64_t> &latencies)
+        {
+            const auto &name = names[(sequence * 7 + producerIndex) % names.size()];
+            uint64_t start = benchNow();
+            MAYBE_UNUSED auto volatile mbox = mboxList->lookUpFromHashMap(name);
+            latencies.push_back(benchNow() - start);
+        },
+        [](uint32_t, std::vector<uint64_t> &) -> uint64_t
+        {
+            return 0;
+        });
+}
+
+/* The name index as it used to be, for comparison. */
+BenchRun benchConcurrentContainerLookUpMutex(const BenchConfig &config)
+{
+    std::mutex lock;
+    std::unordered_map<std::string, uint32_t> index;
+    std::vector<std::string> names;
+    for(uint32_t i = 0; i < ITC_MAX_SUPPORTED_MAILBOXES; ++i)
+    {
+        names.push_back("benchMailbox" + std::to_string(i));
+        index.emplace(names.back(), i);
+    }
+    return runPipeline(config,
+        [&lock, &index, &names](uint32_t producerIndex, uint64_t sequence, std::vector<uint64_t> &latencies)
+        {
+            const auto &name = names[(sequence * 7 + producerIndex) % names.size()];
+            uint64_t start = benchNow();
+            {
+                std::scoped_lock<std::mutex> guard(lock);
+                MAYBE_UNUSED auto volatile found = index.find(name)->second;
+            }
+            latencies.push_back(benchNow() - start);
+        },
+        [](uint32_t, std::vector<uint64_t> &) -> uint64_t
+        {
+            return 0;
+        });
+}
+
+ITC_BENCH_REGISTER("ConcurrentContainer/lookUp",
+    "Threads look up 1024 mailbox names with lookUpFromHashMap()",
+    {{1, 0}, {4, 0}, {8, 0}, {16, 0}, {32, 0}},
+    benchConcurrentContainerLookUp)
+
+ITC_BENCH_REGISTER("ConcurrentContainer/lookUpMutex",
+    "Same as ConcurrentContainer/lookUp, but through a std::mutex guarded std::unordered_map",
+    {{1, 0}, {4, 0}, {8, 0}, {16, 0}, {32, 0}},
+    benchConcurrentContainerLookUpMutex)
+
+} // namespace INTERNAL
+} // namespace ITC
@@ -0,0 +1,155 @@
+#include "itcBench.h"
+
+#include <memory>
+#include <vector>
+#include <cstring>
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "itcMemoryManager.h"
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+#define ITC_BENCH_HUGE_PAGE_NUMBER_OF_POOLS         (uint32_t)(64) /* As many Regions' pools as a busy sender writes into */
+
+/***
+ * Counts dTLB load misses in user space of the calling thread and of every thread it starts afterwards, those are
+ * added once they have exited. Counts nothing if perf events are not available, e.g. in a container.
+ */
+class TlbMissCounter
+{
+public:
+    TlbMissCounter()
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        m_fd = static_cast<int32_t>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if(m_fd >= 0)
+        {
+            ::ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    ~TlbMissCounter()
+    {
+        if(m_fd >= 0)
+        {
+            ::close(m_fd);
+        }
+    }
+
+    uint64_t read()
+    {
+        uint64_t count {0};
+        if(m_fd < 0 || ::read(m_fd, &count, sizeof(count)) != sizeof(count))
+        {
+            return 0;
+        }
+        return count;
+    }
+
+private:
+    int32_t m_fd {-1};
+};
+
+/***
+ * Every producer allocates a slot from one of ITC_BENCH_HUGE_PAGE_NUMBER_OF_POOLS pools picked at random, fills its
+ * first cache line and gives it back. Free lists are FIFO, so the slots handed out walk through all data pages of
+ * all pools, some 50 MiB, which the TLB cannot cover with 4 KiB pages but easily with 2 MiB ones.
+ * All pages are touched before the run, so that no page fault is measured.
+ */
+static BenchRun benchPoolAccess(const BenchConfig &config, bool isHugePages)
+{
+    std::vector<MemoryAllocatorParams> params(ITC_BENCH_HUGE_PAGE_NUMBER_OF_POOLS);
+    std::vector<std::unique_ptr<MemoryPool>> pools;
+    for(auto &poolParams : params)
+    {
+        poolParams.mode = MEMORY_ALLOCATOR_MODE_2;
+        poolParams.isHugePages = isHugePages ? 1 : 0;
+        UInt8RawPtr baseAddr = MemoryAllocator::allocate(MEMORY_POOL_TOTAL_SIZE, poolParams);
+        if(!baseAddr)
+        {
+            break;
+        }
+        if(!isHugePages)
+        {
+            /* With transparent huge pages set to "always", the baseline would get them anyway. */
+            ::madvise(baseAddr, poolParams.attrs.mode2.size, MADV_NOHUGEPAGE);
+        }
+        std::memset(baseAddr, 0, MEMORY_POOL_TOTAL_SIZE);
+        pools.push_back(std::make_unique<MemoryPool>(baseAddr, MEMORY_POOL_TOTAL_SIZE));
+    }
+
+    BenchRun run;
+    if(pools.size() == ITC_BENCH_HUGE_PAGE_NUMBER_OF_POOLS)
+    {
+        constexpr uint32_t sizes[] {MEMORY_POOL_64_SLOT_SIZE, MEMORY_POOL_256_SLOT_SIZE, MEMORY_POOL_512_SLOT_SIZE};
+        TlbMissCounter tlbMissCounter;
+        run = runPipeline(config, [&pools, &sizes](uint32_t producerIndex, uint64_t sequence, std::vector<uint64_t> &latencies)
+        {
+            uint64_t random = (sequence * ITC_BENCH_HUGE_PAGE_NUMBER_OF_POOLS + producerIndex + 1) * 0x9E3779B97F4A7C15ULL;
+            auto &pool = pools[(random >> 32) % ITC_BENCH_HUGE_PAGE_NUMBER_OF_POOLS];
+            uint64_t start = benchNow();
+            UInt8RawPtr slot = pool->allocate(sizes[(random >> 16) % 3]);
+            if(slot)
+            {
+                std::memset(slot, static_cast<int>(sequence), MEMORY_POOL_64_SLOT_SIZE);
+                pool->deallocate(slot);
+            }
+            latencies.push_back(benchNow() - start);
+        },
+        [](uint32_t consumerIndex, std::vector<uint64_t> &latencies) -> uint64_t
+        {
+            return 0;
+        });
+        run.nrTlbMisses = tlbMissCounter.read();
+    }
+
+    pools.clear();
+    for(auto &poolParams : params)
+    {
+        MemoryAllocator::deallocate(poolParams);
+    }
+    return run;
+}
+
+BenchRun benchPoolAccess4KPages(const BenchConfig &config)
+{
+    return benchPoolAccess(config, false);
+}
+
+BenchRun benchPoolAccessHugePages(const BenchConfig &config)
+{
+    return benchPoolAccess(config, true);
+}
+
+ITC_BENCH_REGISTER("MemoryPool/poolAccess4KPages",
+    "Producers allocate, touch and free slots spread over many pools mapped with 4 KiB pages, no consumers",
+    {{1, 0}, {4, 0}},
+    benchPoolAccess4KPages)
+
+ITC_BENCH_REGISTER("MemoryPool/poolAccessHugePages",
+    "Same as MemoryPool/poolAccess4KPages with every pool on 2 MiB pages (MAP_HUGETLB, else madvise(MADV_HUGEPAGE))",
+    {{1, 0}, {4, 0}},
+    benchPoolAccessHugePages)
+
+} // namespace INTERNAL
+} // namespace ITC
@@ -0,0 +1,51 @@
+#include "itcBench.h"
+
+#include <memory>
+
+#include "itcLockFreeQueue.h"
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+#define ITC_BENCH_LOCK_FREE_QUEUE_SIZE      (uint32_t)(1024)
+
+/* Elements are the producers' timestamps themselves, which are never 0. */
+template<uint32_t IS_SPSC_VALUE>
+BenchRun benchLockFreeQueuePushPop(const BenchConfig &config)
+{
+    auto queue = std::make_unique<LockFreeQueue<uint64_t, ITC_BENCH_LOCK_FREE_QUEUE_SIZE, 0, MINIMIZE_CONTENTION, MAXIMIZE_THROUGHPUT, !IS_TOTAL_ORDER, IS_SPSC_VALUE>>();
+    return runPipeline(config,
+        [&queue](uint32_t, uint64_t, std::vector<uint64_t> &)
+        {
+            queue->push(benchNow());
+        },
+        [&queue](uint32_t, std::vector<uint64_t> &latencies) -> uint64_t
+        {
+            uint64_t stamp {0};
+            if(!queue->tryPop(stamp))
+            {
+                return 0;
+            }
+            latencies.push_back(benchNow() - stamp);
+            return 1;
+        });
+}
+
+ITC_BENCH_REGISTER("LockFreeQueue/pushPop",
+    "MPMC queue, producers push() and consumers tryPop() timestamps",
+    {{1, 1}, {2, 1}, {4, 1}, {2, 2}, {4, 4}},
+    benchLockFreeQueuePushPop<!IS_SPSC>)
+
+ITC_BENCH_REGISTER("LockFreeQueue/pushPopSpsc",
+    "SPSC queue, one producer push() and one consumer tryPop() timestamps",
+    {{1, 1}},
+    benchLockFreeQueuePushPop<IS_SPSC>)
+
+} // namespace INTERNAL
+} // namespace ITC
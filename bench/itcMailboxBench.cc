@@ -0,0 +1,142 @@
+#include "itcBench.h"
+#include "itcBenchMessage.h"
+#include "itcMailbox.h"
+
+#include <algorithm>
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+/* A mailbox has a single receiving thread, so only producers are scaled. */
+BenchRun benchMailboxPushPop(const BenchConfig &config)
+{
+    ItcMailbox mbox;
+    mbox.setState(true);
+    return runPipeline(config,
+        [&mbox](uint32_t, uint64_t, std::vector<uint64_t> &)
+        {
+            auto adminMsg = ItcAdminMessageHelper::allocate(ITC_BENCH_MESSAGE_MSGNO, ITC_BENCH_MESSAGE_SIZE);
+            stampBenchMessage(adminMsg);
+            mbox.push(adminMsg);
+        },
+        [&mbox](uint32_t, std::vector<uint64_t> &latencies) -> uint64_t
+        {
+            auto adminMsg = mbox.pop(ITC_MODE_RECEIVE_NON_BLOCKING);
+            if(!adminMsg)
+            {
+                return 0;
+            }
+            latencies.push_back(getBenchMessageLatency(adminMsg));
+            ItcAdminMessageHelper::deallocate(adminMsg);
+            return 1;
+        });
+}
+
+BenchRun benchMailboxPushPopBatch(const BenchConfig &config)
+{
+    ItcMailbox mbox;
+    mbox.setState(true);
+    return runPipeline(config,
+        [&mbox](uint32_t, uint64_t, std::vector<uint64_t> &)
+        {
+            auto adminMsg = ItcAdminMessageHelper::allocate(ITC_BENCH_MESSAGE_MSGNO, ITC_BENCH_MESSAGE_SIZE);
+            stampBenchMessage(adminMsg);
+            mbox.push(adminMsg);
+        },
+        [&mbox](uint32_t, std::vector<uint64_t> &latencies) -> uint64_t
+        {
+            ItcAdminMessageRawPtr adminMsgs[ITC_BATCH_CHUNK_SIZE];
+            uint32_t count = mbox.popBatch(adminMsgs, ITC_BATCH_CHUNK_SIZE, ITC_MODE_RECEIVE_NON_BLOCKING);
+            for(uint32_t i = 0; i < count; ++i)
+            {
+                latencies.push_back(getBenchMessageLatency(adminMsgs[i]));
+                ItcAdminMessageHelper::deallocate(adminMsgs[i]);
+            }
+            return count;
+        });
+}
+
+/* Latency samples are only taken from the priority messages, throughput counts all of them. */
+BenchRun benchMailboxPriorityUnderLoad(const BenchConfig &config)
+{
+    ItcMailbox mbox;
+    mbox.setState(true);
+    return runPipeline(config,
+        [&mbox](uint32_t producerIndex, uint64_t sequence, std::vector<uint64_t> &)
+        {
+            auto adminMsg = ItcAdminMessageHelper::allocate(ITC_BENCH_MESSAGE_MSGNO, ITC_BENCH_MESSAGE_SIZE);
+            if(producerIndex == 0 && sequence % ITC_BATCH_CHUNK_SIZE == 0)
+            {
+                ItcAdminMessageHelper::setPriority(adminMsg, ITC_MESSAGE_PRIORITY_MAX);
+            }
+            stampBenchMessage(adminMsg);
+            mbox.push(adminMsg);
+        },
+        [&mbox](uint32_t, std::vector<uint64_t> &latencies) -> uint64_t
+        {
+            auto adminMsg = mbox.pop(ITC_MODE_RECEIVE_NON_BLOCKING);
+            if(!adminMsg)
+            {
+                return 0;
+            }
+            if(ItcAdminMessageHelper::getPriority(adminMsg) != ITC_MESSAGE_PRIORITY_DEFAULT)
+            {
+                latencies.push_back(getBenchMessageLatency(adminMsg));
+            }
+            ItcAdminMessageHelper::deallocate(adminMsg);
+            return 1;
+        });
+}
+
+#define ITC_BENCH_RECEIVE_TIMEOUT                   (uint32_t)(100) /* us */
+#define ITC_BENCH_MAX_NUMBER_OF_TIMED_RECEIVES      (uint64_t)(1000) /* Each one sleeps the whole timeout */
+
+/* Latency is how far past its timeout a timed receive on an empty mailbox returns. */
+BenchRun benchMailboxTimedReceiveTimeout(const BenchConfig &config)
+{
+    ItcMailbox mbox;
+    mbox.setState(true);
+    BenchConfig timedConfig = config;
+    timedConfig.nrMessages = std::min(config.nrMessages, ITC_BENCH_MAX_NUMBER_OF_TIMED_RECEIVES);
+    return runPipeline(timedConfig,
+        [&mbox](uint32_t, uint64_t, std::vector<uint64_t> &latencies)
+        {
+            uint64_t start = benchNow();
+            mbox.pop(ITC_MODE_RECEIVE_TIMEOUT, ITC_BENCH_RECEIVE_TIMEOUT);
+            uint64_t elapsed = benchNow() - start;
+            latencies.push_back(elapsed > ITC_BENCH_RECEIVE_TIMEOUT * 1000 ? elapsed - ITC_BENCH_RECEIVE_TIMEOUT * 1000 : 0);
+        },
+        [](uint32_t, std::vector<uint64_t> &) -> uint64_t
+        {
+            return 0;
+        });
+}
+
+ITC_BENCH_REGISTER("ItcMailbox/pushPop",
+    "Producers allocate and push() stamped messages, the owner pop()s and deallocates them",
+    {{1, 1}, {2, 1}, {4, 1}},
+    benchMailboxPushPop)
+
+ITC_BENCH_REGISTER("ItcMailbox/pushPopBatch",
+    "Same as ItcMailbox/pushPop, but the owner drains with popBatch()",
+    {{1, 1}, {4, 1}},
+    benchMailboxPushPopBatch)
+
+ITC_BENCH_REGISTER("ItcMailbox/priorityUnderLoad",
+    "Same as ItcMailbox/pushPop, but every 64th message of the first producer has ITC_MESSAGE_PRIORITY_MAX, latency is only theirs",
+    {{1, 1}, {4, 1}},
+    benchMailboxPriorityUnderLoad)
+
+ITC_BENCH_REGISTER("ItcMailbox/timedReceiveTimeout",
+    "The owner pop()s an empty mailbox with a 100 us ITC_MODE_RECEIVE_TIMEOUT, latency is the overshoot past it",
+    {{1, 0}},
+    benchMailboxTimedReceiveTimeout)
+
+} // namespace INTERNAL
+} // namespace ITC
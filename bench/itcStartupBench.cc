@@ -0,0 +1,152 @@
+#include "itcBench.h"
+#include "itcBenchMessage.h"
+
+#include <memory>
+#include <vector>
+#include <cerrno>
+#include <iostream>
+
+#include <unistd.h>
+#include <sys/ipc.h>
+#include <sys/msg.h>
+#include <sys/wait.h>
+
+#include "itcThreadManager.h"
+#include "itcSyncObject.h"
+#include "itcTransportLocal.h"
+#include "itcConcurrentContainer.h"
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+#define ITC_BENCH_STARTUP_REGION_ID                 (itc_mailbox_id_t)(0x00C00000)
+#define ITC_BENCH_STARTUP_NUMBER_OF_RX_THREADS      (uint32_t)(2) /* As ItcPlatform, sysv and posix shm */
+
+using ThreadManagerIfReturnCode = ThreadManager::ThreadManagerIfReturnCode;
+
+/* Same setup as ItcTransportSysvMsgQueue::sysvMsgQueueRxThread() does before it reports ready, on a private queue. */
+static void *startupRxThread(void *args)
+{
+    auto syncObj = reinterpret_cast<SyncObject *>(args);
+    int32_t msgQueueId = ::msgget(IPC_PRIVATE, IPC_CREAT | 0600);
+    struct msqid_ds msqinfo;
+    if(msgQueueId != -1)
+    {
+        ::msgctl(msgQueueId, IPC_STAT, &msqinfo);
+        ::msgctl(msgQueueId, IPC_RMID, nullptr);
+    }
+
+    MUTEX_LOCK(&syncObj->elems->mtx);
+    CWrapperIf::getInstance().lock()->cPthreadCondSignal(&syncObj->elems->cond);
+    MUTEX_UNLOCK(&syncObj->elems->mtx);
+    return nullptr;
+}
+
+/***
+ * Runs in a freshly forked Region: the rx threads are started by ThreadManager as in ItcPlatform::initialise(),
+ * then the first message is sent to a local mailbox. Returns benchNow() once that send() succeeded, 0 on failure.
+ */
+static uint64_t startRegionAndSend()
+{
+    std::vector<std::shared_ptr<SyncObject>> syncObjs;
+    auto threadManager = ThreadManager::getInstance().lock();
+    for(uint32_t i = 0; i < ITC_BENCH_STARTUP_NUMBER_OF_RX_THREADS; ++i)
+    {
+        syncObjs.push_back(std::make_shared<SyncObject>([](SyncObjectElementsSharedPtr elemsPtr)
+        {
+            return CWrapperIf::getInstance().lock()->cPthreadCondAttrSetClock(&elemsPtr->condAttrs, CLOCK_MONOTONIC);
+        }));
+        syncObjs.back()->setTimeout(100 /* ms */);
+        threadManager->addThread(Task(&startupRxThread, syncObjs.back().get()), syncObjs.back());
+    }
+    if(threadManager->startAllThreads() != MAKE_RETURN_CODE(ThreadManagerIfReturnCode, THREAD_MANAGER_OK))
+    {
+        return 0;
+    }
+
+    auto mboxList = std::make_shared<ConcurrentContainer<ItcMailbox, ITC_MAX_SUPPORTED_MAILBOXES>>([](ItcMailboxRawPtr mailbox, uint32_t index)
+    {
+        mailbox->m_mailboxId = ITC_BENCH_STARTUP_REGION_ID | (index & ITC_MASK_UNIT_ID);
+    });
+    ItcMailboxRawPtr receiver = mboxList->tryPopFromQueue();
+    receiver->setState(true);
+    auto transportLocal = ItcTransportLocal::getInstance().lock();
+    transportLocal->initialise(mboxList);
+
+    auto adminMsg = ItcAdminMessageHelper::allocate(ITC_BENCH_MESSAGE_MSGNO, ITC_BENCH_MESSAGE_SIZE);
+    adminMsg->receiver = receiver->m_mailboxId;
+    if(transportLocal->send(adminMsg) != MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK))
+    {
+        return 0;
+    }
+    return benchNow();
+}
+
+/***
+ * config.nrProducers Regions are forked at once, as when a container restarts its processes. Each one reports
+ * the time from right before its fork() until its first successful send(), the throughput is Regions per second.
+ * Locating itc-server is not part of it, ItcPlatform does not build into itc_platform_bench.
+ */
+BenchRun benchStartupToFirstSend(const BenchConfig &config)
+{
+    BenchRun run;
+    int32_t resultFds[2] {-1, -1};
+    if(::pipe(resultFds) == -1)
+    {
+        std::cerr << "[BENCHMARK] Failed to create pipe, errno = " << errno << "\n";
+        return run;
+    }
+
+    std::vector<pid_t> pids;
+    uint64_t start = benchNow();
+    for(uint32_t i = 0; i < config.nrProducers; ++i)
+    {
+        uint64_t forkStamp = benchNow();
+        pid_t pid = ::fork();
+        if(pid == 0)
+        {
+            ::close(resultFds[0]);
+            uint64_t sendStamp = startRegionAndSend();
+            uint64_t latency = sendStamp ? sendStamp - forkStamp : 0;
+            ssize_t written = ::write(resultFds[1], &latency, sizeof(latency));
+            ::_exit(written == sizeof(latency) ? 0 : 1);
+        }
+        if(pid > 0)
+        {
+            pids.push_back(pid);
+        }
+    }
+    ::close(resultFds[1]);
+
+    uint64_t latency {0};
+    while(::read(resultFds[0], &latency, sizeof(latency)) == sizeof(latency))
+    {
+        if(latency)
+        {
+            run.latencies.push_back(latency);
+        }
+    }
+    run.elapsedNs = benchNow() - start;
+    run.nrOps = run.latencies.size();
+
+    ::close(resultFds[0]);
+    for(auto pid : pids)
+    {
+        ::waitpid(pid, nullptr, 0);
+    }
+    return run;
+}
+
+ITC_BENCH_REGISTER("ItcPlatform/startupToFirstSend",
+    "Producers is the number of Regions forked at once, each starts its rx threads and sends its first local message, --messages is not used",
+    {{1, 0}, {16, 0}, {64, 0}},
+    benchStartupToFirstSend)
+
+} // namespace INTERNAL
+} // namespace ITC
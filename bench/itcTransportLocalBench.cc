@@ -0,0 +1,171 @@
+#include "itcBench.h"
+#include "itcBenchMessage.h"
+
+#include <memory>
+#include <cstring>
+
+#include "itcTransportLocal.h"
+#include "itcConcurrentContainer.h"
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+#define ITC_BENCH_REGION_ID             (itc_mailbox_id_t)(0x00B00000)
+#define ITC_BENCH_RELAY_MESSAGE_SIZE    (uint32_t)(1024)
+
+/* Producers look the singleton up on every send() just like ItcPlatform does. */
+BenchRun benchTransportLocalSendReceive(const BenchConfig &config)
+{
+    auto mboxList = std::make_shared<ConcurrentContainer<ItcMailbox, ITC_MAX_SUPPORTED_MAILBOXES>>([](ItcMailboxRawPtr mailbox, uint32_t index)
+    {
+        mailbox->m_mailboxId = ITC_BENCH_REGION_ID | (index & ITC_MASK_UNIT_ID);
+    });
+    ItcMailboxRawPtr receiver = mboxList->tryPopFromQueue();
+    receiver->setState(true);
+    ItcTransportLocal::getInstance().lock()->initialise(mboxList);
+
+    itc_mailbox_id_t receiverId = receiver->m_mailboxId;
+    auto run = runPipeline(config,
+        [receiverId](uint32_t, uint64_t, std::vector<uint64_t> &)
+        {
+            auto adminMsg = ItcAdminMessageHelper::allocate(ITC_BENCH_MESSAGE_MSGNO, ITC_BENCH_MESSAGE_SIZE);
+            adminMsg->receiver = receiverId;
+            stampBenchMessage(adminMsg);
+            ItcTransportLocal::getInstance().lock()->send(adminMsg);
+        },
+        [receiver](uint32_t, std::vector<uint64_t> &latencies) -> uint64_t
+        {
+            auto adminMsg = ItcTransportLocal::getInstance().lock()->receive(receiver, ITC_MODE_RECEIVE_NON_BLOCKING);
+            if(!adminMsg)
+            {
+                return 0;
+            }
+            latencies.push_back(getBenchMessageLatency(adminMsg));
+            ItcAdminMessageHelper::deallocate(adminMsg);
+            return 1;
+        });
+    receiver->setState(false);
+    return run;
+}
+
+ITC_BENCH_REGISTER("ItcTransportLocal/sendReceive",
+    "Producers allocate and send() stamped messages to one mailbox, its owner receive()s and deallocates them",
+    {{1, 1}, {2, 1}, {4, 1}},
+    benchTransportLocalSendReceive)
+
+/* A single thread allocates, send()s, receive()s and deallocates, looking both singletons up every time. */
+BenchRun benchTransportLocalRoundTrip(const BenchConfig &config)
+{
+    auto mboxList = std::make_shared<ConcurrentContainer<ItcMailbox, ITC_MAX_SUPPORTED_MAILBOXES>>([](ItcMailboxRawPtr mailbox, uint32_t index)
+    {
+        mailbox->m_mailboxId = ITC_BENCH_REGION_ID | (index & ITC_MASK_UNIT_ID);
+    });
+    ItcMailboxRawPtr receiver = mboxList->tryPopFromQueue();
+    receiver->setState(true);
+    ItcTransportLocal::getInstance().lock()->initialise(mboxList);
+
+    auto run = runPipeline(config,
+        [receiver](uint32_t, uint64_t, std::vector<uint64_t> &latencies)
+        {
+            uint64_t start = benchNow();
+            auto adminMsg = ItcAdminMessageHelper::allocate(ITC_BENCH_MESSAGE_MSGNO, ITC_BENCH_MESSAGE_SIZE);
+            adminMsg->receiver = receiver->m_mailboxId;
+            ItcTransportLocal::getInstance().lock()->send(adminMsg);
+            adminMsg = ItcTransportLocal::getInstance().lock()->receive(receiver, ITC_MODE_RECEIVE_NON_BLOCKING);
+            ItcAdminMessageHelper::deallocate(adminMsg);
+            latencies.push_back(benchNow() - start);
+        },
+        [](uint32_t, std::vector<uint64_t> &) -> uint64_t
+        {
+            return 0;
+        });
+    receiver->setState(false);
+    return run;
+}
+
+ITC_BENCH_REGISTER("ItcTransportLocal/roundTrip",
+    "One thread allocates, send()s, receive()s and deallocates a message to its own mailbox, the whole round trip is timed",
+    {{1, 0}},
+    benchTransportLocalRoundTrip)
+
+/***
+ * The producer sends to a relay mailbox, takes the message out there and passes it on to a sink mailbox, either in the
+ * received buffer as ItcPlatform::forward() does or in a fresh copy as a plain send() would need. Only that hop, up to
+ * the message arriving at the sink, is timed. One producer and no consumers, so that thread switches do not hide it.
+ */
+static BenchRun benchTransportLocalRelay(const BenchConfig &config, bool isInPlace)
+{
+    auto mboxList = std::make_shared<ConcurrentContainer<ItcMailbox, ITC_MAX_SUPPORTED_MAILBOXES>>([](ItcMailboxRawPtr mailbox, uint32_t index)
+    {
+        mailbox->m_mailboxId = ITC_BENCH_REGION_ID | (index & ITC_MASK_UNIT_ID);
+    });
+    ItcMailboxRawPtr relay = mboxList->tryPopFromQueue();
+    relay->setState(true);
+    ItcMailboxRawPtr sink = mboxList->tryPopFromQueue();
+    sink->setState(true);
+    ItcTransportLocal::getInstance().lock()->initialise(mboxList);
+
+    auto run = runPipeline(config,
+        [relay, sink, isInPlace](uint32_t, uint64_t, std::vector<uint64_t> &latencies)
+        {
+            auto transportLocal = ItcTransportLocal::getInstance().lock();
+            auto adminMsg = ItcAdminMessageHelper::allocate(ITC_BENCH_MESSAGE_MSGNO, ITC_BENCH_RELAY_MESSAGE_SIZE);
+            adminMsg->receiver = relay->m_mailboxId;
+            transportLocal->send(adminMsg);
+            adminMsg = transportLocal->receive(relay, ITC_MODE_RECEIVE_NON_BLOCKING);
+
+            uint64_t start = benchNow();
+            if(isInPlace)
+            {
+                ItcAdminMessageHelper::prepareResend(adminMsg);
+            } else
+            {
+                auto copy = ItcAdminMessageHelper::allocate(adminMsg->msgno, adminMsg->size);
+                std::memcpy(&copy->msgno + 1, &adminMsg->msgno + 1, adminMsg->size - ITC_MESSAGE_MSGNO_SIZE);
+                ItcAdminMessageHelper::deallocate(adminMsg);
+                adminMsg = copy;
+            }
+            adminMsg->sender = relay->m_mailboxId;
+            adminMsg->receiver = sink->m_mailboxId;
+            transportLocal->send(adminMsg);
+            adminMsg = transportLocal->receive(sink, ITC_MODE_RECEIVE_NON_BLOCKING);
+            latencies.push_back(benchNow() - start);
+            ItcAdminMessageHelper::deallocate(adminMsg);
+        },
+        [](uint32_t, std::vector<uint64_t> &) -> uint64_t
+        {
+            return 0;
+        });
+    relay->setState(false);
+    sink->setState(false);
+    return run;
+}
+
+BenchRun benchTransportLocalRelayCopy(const BenchConfig &config)
+{
+    return benchTransportLocalRelay(config, false);
+}
+
+BenchRun benchTransportLocalRelayInPlace(const BenchConfig &config)
+{
+    return benchTransportLocalRelay(config, true);
+}
+
+ITC_BENCH_REGISTER("ItcTransportLocal/relayCopy",
+    "A relayed 1 KiB message is copied into a new one for the sink mailbox, the relay hop is timed",
+    {{1, 0}},
+    benchTransportLocalRelayCopy)
+
+ITC_BENCH_REGISTER("ItcTransportLocal/relayInPlace",
+    "Same as ItcTransportLocal/relayCopy with the message passed on in the received buffer",
+    {{1, 0}},
+    benchTransportLocalRelayInPlace)
+
+} // namespace INTERNAL
+} // namespace ITC
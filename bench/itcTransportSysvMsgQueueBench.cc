@@ -0,0 +1,137 @@
+#include "itcBench.h"
+#include "itcBenchMessage.h"
+
+#include <vector>
+#include <cerrno>
+#include <iostream>
+
+#include <unistd.h>
+#include <sys/ipc.h>
+#include <sys/msg.h>
+#include <sys/wait.h>
+
+#include "itcTransportSysvMsgQueue.h"
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+#define ITC_BENCH_SYSV_RX_BUFFER_SIZE       (uint32_t)(1024)
+
+/***
+ * Same wire format and msgsnd() as ItcTransportSysvMsgQueue::send(), without the rx thread and locating,
+ * which need a running ItcPlatform. The receiving Region is a forked child process reading from a private queue,
+ * it reports its latencies back through a pipe once it has received everything.
+ */
+static void sendSysvMessage(int32_t msgQueueId)
+{
+    auto adminMsg = ItcAdminMessageHelper::allocate(ITC_BENCH_MESSAGE_MSGNO, ITC_BENCH_MESSAGE_SIZE);
+    int32_t size = ITC_ADMIN_MESSAGE_PREAMBLE_SIZE + adminMsg->size + ITC_ADMIN_MESSAGE_ENDPOINT_SIZE;
+    uint8_t *txBuffer = new uint8_t[sizeof(long) + size];
+    auto txMsg {reinterpret_cast<long *>(txBuffer)};
+    *txMsg = (long)ITC_SYSV_MESSAGE_QUEUE_TX_MSGNO;
+    stampBenchMessage(adminMsg);
+    std::memcpy(txMsg + 1, adminMsg, size);
+    while(::msgsnd(msgQueueId, txMsg, size, MSG_NOERROR) == -1 && errno == EINTR);
+    delete[] txBuffer;
+    ItcAdminMessageHelper::deallocate(adminMsg);
+}
+
+static void receiveSysvMessages(int32_t msgQueueId, uint64_t nrMessages, int32_t resultFd)
+{
+    std::vector<uint64_t> latencies;
+    latencies.reserve(nrMessages);
+    alignas(long) uint8_t rxBuffer[ITC_BENCH_SYSV_RX_BUFFER_SIZE];
+    while(latencies.size() < nrMessages)
+    {
+        if(::msgrcv(msgQueueId, rxBuffer, sizeof(rxBuffer) - sizeof(long), 0, 0) < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        latencies.push_back(getBenchMessageLatency(reinterpret_cast<ItcAdminMessageRawPtr>(rxBuffer + sizeof(long))));
+    }
+
+    auto data = reinterpret_cast<const uint8_t *>(latencies.data());
+    size_t remaining = latencies.size() * sizeof(uint64_t);
+    while(remaining > 0)
+    {
+        ssize_t written = ::write(resultFd, data, remaining);
+        if(written <= 0)
+        {
+            break;
+        }
+        data += written;
+        remaining -= written;
+    }
+}
+
+BenchRun benchSysvMsgQueueCrossProcessSend(const BenchConfig &config)
+{
+    BenchRun run;
+    const uint64_t nrTotalMessages = config.nrProducers * config.nrMessages;
+    int32_t msgQueueId = ::msgget(IPC_PRIVATE, IPC_CREAT | 0600);
+    int32_t resultFds[2] {-1, -1};
+    if(msgQueueId == -1 || ::pipe(resultFds) == -1)
+    {
+        std::cerr << "[BENCHMARK] Failed to set up sysv message queue, errno = " << errno << "\n";
+        return run;
+    }
+
+    /* No other threads are running yet, so the child may safely keep going after fork(). */
+    pid_t pid = ::fork();
+    if(pid == 0)
+    {
+        ::close(resultFds[0]);
+        receiveSysvMessages(msgQueueId, nrTotalMessages, resultFds[1]);
+        ::_exit(0);
+    }
+    ::close(resultFds[1]);
+
+    uint64_t start = benchNow();
+    BenchConfig producersOnly = config;
+    producersOnly.nrConsumers = 0;
+    runPipeline(producersOnly,
+        [msgQueueId](uint32_t, uint64_t, std::vector<uint64_t> &)
+        {
+            sendSysvMessage(msgQueueId);
+        },
+        nullptr);
+
+    run.latencies.resize(nrTotalMessages);
+    auto data = reinterpret_cast<uint8_t *>(run.latencies.data());
+    size_t received = 0;
+    while(received < nrTotalMessages * sizeof(uint64_t))
+    {
+        ssize_t count = ::read(resultFds[0], data + received, nrTotalMessages * sizeof(uint64_t) - received);
+        if(count <= 0)
+        {
+            break;
+        }
+        received += count;
+    }
+    run.elapsedNs = benchNow() - start;
+    run.latencies.resize(received / sizeof(uint64_t));
+    run.nrOps = run.latencies.size();
+
+    ::close(resultFds[0]);
+    ::waitpid(pid, nullptr, 0);
+    ::msgctl(msgQueueId, IPC_RMID, nullptr);
+    return run;
+}
+
+ITC_BENCH_REGISTER("ItcTransportSysvMsgQueue/crossProcessSend",
+    "Producer threads msgsnd() stamped messages in the transport's wire format to a forked receiving process",
+    {{1, 1}, {2, 1}, {4, 1}},
+    benchSysvMsgQueueCrossProcessSend)
+
+} // namespace INTERNAL
+} // namespace ITC
@@ -3,6 +3,11 @@
 #include <cstdint>
 #include <string>
 #include <memory>
+#include <vector>
+#include <array>
+#include <utility>
+#include <algorithm>
+#include <functional>
 
 // #include <enumUtils.h>
 
@@ -31,6 +36,7 @@ namespace ITC
 namespace PROVIDED
 {
 #define ITC_MAX_SUPPORTED_MAILBOXES 							(uint32_t)(1024)
+#define ITC_MAX_MAILBOXES_PER_THREAD 							(uint32_t)(8)
 #define ITC_MAILBOX_ID_DEFAULT 									(uint32_t)(0xFFFFFFFF)
 #define ITC_MESSAGE_MSGNO_DEFAULT 								(uint32_t)(0xFFFFFFFF)
 #define ITC_MESSAGE_MSGNO_SIZE 									(uint32_t)(sizeof(uint32_t))
@@ -42,7 +48,23 @@ namespace PROVIDED
 #define ITC_MODE_LOCATE_IN_WORLD								(uint32_t)(0b100)
 #define ITC_MODE_LOCATE_IN_UNIVERSE								(uint32_t)(0b1000)
 #define ITC_MODE_LOCATE_IN_ALL									(uint32_t)(0b1110)
-#define ITC_MASK_LOCATE											(uint32_t)(0x1110)
+#define ITC_MASK_LOCATE											(uint32_t)(0b1110)
+#define ITC_MODE_RECEIVE_TIMEOUT								(uint32_t)(0b10000)
+#define ITC_MAILBOX_RX_CAPACITY_DEFAULT							(uint32_t)(1024)
+#define ITC_MAILBOX_RX_OVERFLOW_BLOCK							(uint32_t)(0) /* Senders wait until the receiver makes room */
+#define ITC_MAILBOX_RX_OVERFLOW_GROW							(uint32_t)(1) /* Messages beyond capacity go into an unbounded overflow segment */
+#define ITC_MAILBOX_RX_OVERFLOW_REJECT							(uint32_t)(2) /* send() returns ITC_QUEUE_FULL, the message stays with the sender */
+#define ITC_MAILBOX_RX_OVERFLOW_DROP_OLDEST						(uint32_t)(3) /* The oldest pending message is deleted to make room */
+#define ITC_LATENCY_STAGE_SEND_TO_PUSH							(uint32_t)(0) /* send() until pushed into the receiver's mailbox, all hops included */
+#define ITC_LATENCY_STAGE_REGION_TX_TO_RX						(uint32_t)(1) /* Between Regions: SysV message queue or POSIX shm until the receiving Region's rx thread */
+#define ITC_LATENCY_STAGE_REGION_RX_TO_PUSH						(uint32_t)(2) /* Receiving Region's rx thread until pushed into the mailbox */
+#define ITC_LATENCY_STAGE_PUSH_TO_RECEIVE						(uint32_t)(3) /* Waiting in the mailbox until the receiver takes it */
+#define ITC_LATENCY_STAGE_SEND_TO_RECEIVE						(uint32_t)(4) /* End to end */
+#define ITC_LATENCY_NUMBER_OF_STAGES							(uint32_t)(5)
+#define ITC_MESSAGE_PRIORITY_DEFAULT							(uint32_t)(0) /* Lowest, e.g. bulk data */
+#define ITC_MESSAGE_PRIORITY_MAX								(uint32_t)(3) /* E.g. supervision and timeouts */
+#define ITC_NUMBER_OF_MESSAGE_PRIORITIES						(uint32_t)(4)
+#define ITC_MASK_TIMEOUT										(uint32_t)(0b10001) /* Mode bits which are passed on to receive() */
 #define ITC_SYSTEM_BASE 										(uint32_t)(0x00000000)
 #define ITC_SYSTEM_MESSAGE_NUMBER_BASE 							(uint32_t)(ITC_SYSTEM_BASE + 0x10)
 #define ITC_SYSTEM_MESSAGE_LOCATE_MBOX_IN_ITC_SERVER_REPLY		(uint32_t)(ITC_SYSTEM_MESSAGE_NUMBER_BASE + 0x5)
@@ -60,6 +82,87 @@ struct MailboxContactInfo
 	~MailboxContactInfo() = default;
 };
 
+/***
+ * Receive side limits of a mailbox, given to createMailbox():
+ * + capacity: number of pending messages at which overflowPolicy kicks in, at most ITC_MAILBOX_RX_CAPACITY_DEFAULT.
+ * + overflowPolicy: one of ITC_MAILBOX_RX_OVERFLOW_*.
+ * + highWatermark: once that many messages are pending, onHighWatermark is called from the sender's thread.
+ *   It is called again only after the receiver has brought them down to half of it. 0 disables it.
+ *   Keep the callback short, it must neither block nor send to the same mailbox.
+ */
+struct MailboxRxConfig
+{
+	uint32_t capacity {ITC_MAILBOX_RX_CAPACITY_DEFAULT};
+	uint32_t overflowPolicy {ITC_MAILBOX_RX_OVERFLOW_BLOCK};
+	uint32_t highWatermark {0};
+	std::function<void(itc_mailbox_id_t mboxId, uint32_t nrPendingMsgs)> onHighWatermark {nullptr};
+};
+
+/***
+ * Latency samples of one stage, in nanoseconds. Buckets are ascending and non-empty only,
+ * each one is {highest value of the bucket, number of samples}, see getLatencySnapshot().
+ */
+struct LatencyHistogramSnapshot
+{
+	uint64_t count {0};
+	uint64_t min {0};
+	uint64_t max {0};
+	uint64_t sum {0};
+	std::vector<std::pair<uint64_t, uint64_t>> buckets;
+
+	/* Upper bound of the bucket holding the given percentile (0-100], so at most one bucket width too high. */
+	uint64_t getPercentile(double percentile) const
+	{
+		double exactRank = percentile / 100.0 * count;
+		uint64_t rank = static_cast<uint64_t>(exactRank);
+		rank += (rank < exactRank || rank == 0) ? 1 : 0;
+		uint64_t nrSeenSamples = 0;
+		for(const auto &[upperBound, nrSamples] : buckets)
+		{
+			nrSeenSamples += nrSamples;
+			if(nrSeenSamples >= rank)
+			{
+				return std::min(upperBound, max);
+			}
+		}
+		return max;
+	}
+};
+
+/* Indexed by ITC_LATENCY_STAGE_* */
+using MailboxLatencySnapshot = std::array<LatencyHistogramSnapshot, ITC_LATENCY_NUMBER_OF_STAGES>;
+
+/* Counters since the mailbox was created, see getStatistics(). */
+struct MailboxStatistics
+{
+	uint64_t nrSentMsgs {0};		/* Sent by the mailbox owner */
+	uint64_t nrEnqueuedMsgs {0};	/* Put into its rx queue by any sender */
+	uint64_t nrReceivedMsgs {0};	/* Taken out of its rx queue by the owner */
+	uint64_t nrDroppedMsgs {0};		/* ITC_MAILBOX_RX_OVERFLOW_DROP_OLDEST */
+	uint64_t nrRejectedMsgs {0};	/* ITC_MAILBOX_RX_OVERFLOW_REJECT */
+	uint32_t nrQueuedMsgs {0};		/* Right now */
+	uint32_t maxQueueDepth {0};		/* As seen by the owner whenever it received */
+};
+
+#define ITC_TRANSPORT_LOCAL							(uint32_t)(0)
+#define ITC_TRANSPORT_SYSV_MSG_QUEUE				(uint32_t)(1)
+#define ITC_TRANSPORT_POSIX_SHM						(uint32_t)(2)
+#define ITC_NUMBER_OF_TRANSPORTS					(uint32_t)(3)
+
+/* Counters since ItcPlatform was initialised, bytes are [msgno] + [user payload]. */
+struct TransportStatistics
+{
+	uint64_t nrSentMsgs {0};
+	uint64_t nrSentBytes {0};
+	uint64_t nrFailedSends {0};		/* Receiver unknown, inactive or full */
+	uint64_t nrReceivedMsgs {0};	/* Taken by receivers for local transport, by our rx thread for the others */
+	uint64_t nrReceivedBytes {0};
+	uint64_t nrDroppedMsgs {0};		/* Malformed or undeliverable on the rx side */
+};
+
+/* Indexed by ITC_TRANSPORT_* */
+using TransportStatisticsList = std::array<TransportStatistics, ITC_NUMBER_OF_TRANSPORTS>;
+
 struct itc_system_message_locate_mbox_in_itc_server_reply {
 	uint32_t			msgno {ITC_MESSAGE_MSGNO_DEFAULT}; // Must be ITC_SYSTEM_MESSAGE_LOCATE_MBOX_IN_ITC_SERVER_REPLY
 	MailboxContactInfo 	locatedMbox;
@@ -84,6 +187,7 @@ public:
 		ITC_UNDEFINED,
 		ITC_OK,
 		ITC_FAILED,
+		ITC_QUEUE_FULL,
 	};
 
 	// enum class ItcPlatformIfReturnCodeRaw
@@ -144,6 +248,7 @@ public:
 	 * Currently, flags is only used internally in ITC system to identify if the process that has called initialise()
 	 * is itc-server or not, external usage is reserved.
 	 * + ITC_FLAG_I_AM_ITC_SERVER	0b1
+	 * Starts itc-server if there is none yet and waits up to 2 seconds for it to answer.
 	 */
     virtual ItcPlatformIfReturnCode initialise(uint32_t flags = ITC_FLAG_DEFAULT) = 0;
 	
@@ -152,28 +257,93 @@ public:
 	 */
 	virtual ItcPlatformIfReturnCode release() = 0;
 	
+	/***
+	 * Messages are allocated from memory of the NUMA node the calling thread runs on. If you already know the receiver,
+	 * pass it as toMbox, a message to a mailbox of our own Region is then placed on the node of its receiver instead,
+	 * so that the receiver does not read it from remote memory. That is all toMbox is used for, send() it as usual.
+	 * Messages to other Regions or Worlds are copied or received into memory of the receiving side anyway.
+	 * On single node machines both are the same.
+	 */
 	virtual ItcMessageRawPtr allocateMessage(uint32_t msgno, size_t size = ITC_MESSAGE_MSGNO_SIZE) = 0;
+	virtual ItcMessageRawPtr allocateMessage(uint32_t msgno, size_t size, const MailboxContactInfo &toMbox) = 0;
 	virtual ItcPlatformIfReturnCode deallocateMessage(ItcMessageRawPtr msg) = 0;
 	
 	/***
 	 * Currently "flags" (OR bits) indicate whether:
 	 * 		+ ITC_FLAG_EXTERNAL_COMMUNICATION_NEEDED = 0b1: The created mailbox desires to have external communication to other Worlds or not.
+	 * rxConfig bounds how many messages may pile up in the mailbox and what happens to senders beyond that, see MailboxRxConfig.
+	 * A thread may own up to ITC_MAX_MAILBOXES_PER_THREAD mailboxes, e.g. one for control and one for data.
+	 * Its first one is the default for send(), receive() and myMailboxFd(), the others are read with receiveAny().
+	 * If the default mailbox is deleted, the next oldest one of the thread takes over.
 	 */
-	virtual itc_mailbox_id_t createMailbox(const std::string &name, uint32_t flags = ITC_FLAG_DEFAULT) = 0;
+	virtual itc_mailbox_id_t createMailbox(const std::string &name, uint32_t flags = ITC_FLAG_DEFAULT, const MailboxRxConfig &rxConfig = MailboxRxConfig()) = 0;
 	virtual ItcPlatformIfReturnCode deleteMailbox(itc_mailbox_id_t mboxId) = 0;
 	
 	/***
 	 * In case of sending messages inside a Region/World only, leave worldId the default initialised value.
 	 * Otherwise you may need to provide worldId in case of outside World communication required.
 	 * To have worldId, you may need to locate mailbox first via either locateMailboxSync or locateMailboxAsync.
+	 * ITC_QUEUE_FULL means the receiver's mailbox is full and was created with ITC_MAILBOX_RX_OVERFLOW_REJECT,
+	 * the message is still yours, so back off and send it again later or deallocate it.
 	 */
 	virtual ItcPlatformIfReturnCode send(ItcMessageRawPtr msg, const MailboxContactInfo &toMbox) = 0;
 	
 	/***
-	 * There are 1 modes:
+	 * Sends count messages at once, msgs[i] goes to toMboxes[i].
+	 * Messages are grouped by destination Region, so each group costs one queue operation inside our Region,
+	 * or one shared memory submit to another Region on the same host, instead of one per message.
+	 * Order between a given sender and receiver is kept.
+	 * Every message which was sent is set to nullptr in msgs. ITC_FAILED means some could not be sent,
+	 * those are still left in msgs and you have to deallocate them yourself as with send().
+	 */
+	virtual ItcPlatformIfReturnCode sendBatch(ItcMessageRawPtr *msgs, const MailboxContactInfo *toMboxes, size_t count) = 0;
+
+	/***
+	 * Passes a received message on to toMbox in the same buffer, no allocation and no copy of its payload.
+	 * msgno, payload and priority are kept, we become its sender. Same rules as send() otherwise,
+	 * the message is only gone once ITC_OK is returned.
+	 */
+	virtual ItcPlatformIfReturnCode forward(ItcMessageRawPtr msg, const MailboxContactInfo &toMbox) = 0;
+
+	/***
+	 * Sends a received message back to its sender in the same buffer with msgno changed to the given one,
+	 * so the reply can be written over the request's payload, which must be big enough for it.
+	 * Only for senders inside our World, messages from other Worlds do not tell where they came from,
+	 * so locate the sender and use forward() for those.
+	 */
+	virtual ItcPlatformIfReturnCode reply(ItcMessageRawPtr msg, uint32_t msgno) = 0;
+
+	/***
+	 * There are 2 modes:
 	 * + ITC_MODE_RECEIVE_NON_BLOCKING
+	 * + ITC_MODE_RECEIVE_TIMEOUT: wait at most timeout microseconds, then return nullptr.
+	 * 	 The thread sleeps in the kernel meanwhile, timeout is measured on CLOCK_MONOTONIC.
+	 * Without any of them, receive() waits until a message arrives.
+	 */
+	virtual ItcMessageRawPtr receive(uint32_t mode = ITC_MODE_DEFAULT, uint32_t timeout = 0) = 0;
+	
+	/***
+	 * Same modes as receive(), but only returns the oldest message whose msgno is listed in filter.
+	 * Other messages stay queued in their order and are returned by later receive calls,
+	 * so e.g. waiting for a reply never loses what arrived in between. An empty filter matches all messages.
+	 */
+	virtual ItcMessageRawPtr receiveSelective(const std::vector<uint32_t> &filter, uint32_t mode = ITC_MODE_DEFAULT, uint32_t timeout = 0) = 0;
+	
+	/***
+	 * Same modes as receive(), but hands over up to max pending messages at once into out.
+	 * Returns the number of received messages, 0 means the same as a nullptr from receive().
+	 * In blocking mode, it only waits while there is no message at all, it never waits to fill up out.
 	 */
-	virtual ItcMessageRawPtr receive(uint32_t mode = ITC_MODE_DEFAULT) = 0;
+	virtual size_t receiveBatch(ItcMessageRawPtr *out, size_t max, uint32_t mode = ITC_MODE_DEFAULT, uint32_t timeout = 0) = 0;
+	
+	/***
+	 * Same modes as receive(), but waits on several mailboxes of our thread at once and returns the first message
+	 * of the highest priority mailbox which has one. Use getReceiver() to see which one that was.
+	 * priorities[i] belongs to mboxIds[i], higher goes first, equal ones keep the order of mboxIds, empty means mboxIds order.
+	 * Higher priority mailboxes are always drained first, so a flooded one starves the ones below it.
+	 * The thread sleeps in a single poll on all the mailboxes, not one wait per mailbox.
+	 */
+	virtual ItcMessageRawPtr receiveAny(const std::vector<itc_mailbox_id_t> &mboxIds, const std::vector<uint32_t> &priorities = {}, uint32_t mode = ITC_MODE_DEFAULT, uint32_t timeout = 0) = 0;
 	
 	/***
 	 * To locate mailboxes, you must give itc-server a mode (OR bits)
@@ -193,7 +363,10 @@ public:
 	 * Please note that locating mailboxes in Universe may be time consuming
 	 * than searching internally inside a World or Region.
 	 * 
-	 * mode = (ITC_MODE_TIMEOUT_* | ITC_MODE_LOCATE_*)
+	 * mode = (ITC_MODE_RECEIVE_TIMEOUT | ITC_MODE_LOCATE_*), then timeout in microseconds bounds the wait for itc-server's reply.
+	 * 
+	 * Mailboxes found by itc-server in our World are cached per thread, so locating the same name again with the same mode
+	 * is answered locally until any mailbox is deleted. Mailboxes in other Worlds are always asked for.
 	 */
 	virtual MailboxContactInfo locateMailboxSync(const std::string &mboxName, uint32_t mode = ITC_MODE_LOCATE_IN_ALL, uint32_t timeout = 0) = 0;
 	
@@ -217,8 +390,34 @@ public:
 	virtual itc_mailbox_id_t getSender(const ItcMessageRawPtr &msg) = 0;
 	virtual itc_mailbox_id_t getReceiver(const ItcMessageRawPtr &msg) = 0;
 	virtual size_t getMsgSize(const ItcMessageRawPtr &msg) = 0;
+	/***
+	 * Priority from ITC_MESSAGE_PRIORITY_DEFAULT up to ITC_MESSAGE_PRIORITY_MAX, set it before send().
+	 * Each mailbox keeps one rx queue per priority and receive calls always take from the highest non-empty one,
+	 * so e.g. supervision messages overtake a backlog of data messages. Order is only kept within the same priority.
+	 * Priorities above default are not limited by the mailbox's MailboxRxConfig.
+	 */
+	virtual ItcPlatformIfReturnCode setMsgPriority(ItcMessageRawPtr msg, uint32_t priority) = 0;
+	virtual uint32_t getMsgPriority(const ItcMessageRawPtr &msg) = 0;
+	/***
+	 * Returns an eventfd which becomes readable when our mailbox goes from empty to non-empty,
+	 * so it can be added into your own epoll/poll loop. Do not read from it yourself,
+	 * just call receive(ITC_MODE_RECEIVE_NON_BLOCKING) until it returns nullptr, which also re-arms the fd.
+	 */
 	virtual int32_t myMailboxFd() = 0;
 	virtual std::string getMailboxName(itc_mailbox_id_t mboxId) = 0;
+	/***
+	 * Latency histograms of a mailbox in our Region, one per ITC_LATENCY_STAGE_*, recorded whenever its owner receives.
+	 * Only available if itc-platform was built with --enable-latency-trace, ITC_FAILED otherwise.
+	 * Compare the stages to see whether transport hops, the SysV/POSIX shm rx thread, or the receiver itself is slow.
+	 */
+	virtual ItcPlatformIfReturnCode getLatencySnapshot(itc_mailbox_id_t mboxId, MailboxLatencySnapshot &snapshot) = 0;
+	/***
+	 * Counters of a mailbox in our Region. Senders only pay a relaxed increment per message,
+	 * the per-thread shards are summed up here, so counters read together are not an atomic cut.
+	 */
+	virtual ItcPlatformIfReturnCode getStatistics(itc_mailbox_id_t mboxId, MailboxStatistics &statistics) = 0;
+	/* Counters of all transports in our Region, aggregated the same way as getStatistics(). */
+	virtual ItcPlatformIfReturnCode getTransportStatistics(TransportStatisticsList &statistics) = 0;
 
 protected:
     ItcPlatformIf() = default;
@@ -6,6 +6,7 @@
 #include "itcAdminMessage.h"
 #include "itcConstant.h"
 #include "itcConcurrentContainer.h"
+#include "itcLocateCache.h"
 
 #include <mutex>
 #include <memory>
@@ -32,6 +33,10 @@ namespace INTERNAL
 
 using namespace ITC::PROVIDED;
 
+class ItcTransportLocal;
+class ItcTransportSysvMsgQueue;
+class ItcTransportPosixShm;
+
 class ItcPlatform : public ItcPlatformIf
 {
 public:
@@ -40,19 +45,31 @@ public:
 	ItcPlatformIfReturnCode initialise(uint32_t flags = ITC_FLAG_DEFAULT) override;
 	ItcPlatformIfReturnCode release() override;
 	ItcMessageRawPtr allocateMessage(uint32_t msgno, size_t size = ITC_MESSAGE_MSGNO_SIZE) override;
+	ItcMessageRawPtr allocateMessage(uint32_t msgno, size_t size, const MailboxContactInfo &toMbox) override;
 	ItcPlatformIfReturnCode deallocateMessage(ItcMessageRawPtr msg) override;
-	itc_mailbox_id_t createMailbox(const std::string &name, uint32_t flags = ITC_FLAG_DEFAULT) override;
+	itc_mailbox_id_t createMailbox(const std::string &name, uint32_t flags = ITC_FLAG_DEFAULT, const MailboxRxConfig &rxConfig = MailboxRxConfig()) override;
 	ItcPlatformIfReturnCode deleteMailbox(itc_mailbox_id_t mboxId) override;
 	ItcPlatformIfReturnCode send(ItcMessageRawPtr msg, const MailboxContactInfo &toMbox) override;
-	ItcMessageRawPtr receive(uint32_t mode = ITC_MODE_DEFAULT) override;
+	ItcPlatformIfReturnCode sendBatch(ItcMessageRawPtr *msgs, const MailboxContactInfo *toMboxes, size_t count) override;
+	ItcPlatformIfReturnCode forward(ItcMessageRawPtr msg, const MailboxContactInfo &toMbox) override;
+	ItcPlatformIfReturnCode reply(ItcMessageRawPtr msg, uint32_t msgno) override;
+	ItcMessageRawPtr receive(uint32_t mode = ITC_MODE_DEFAULT, uint32_t timeout = 0) override;
+	ItcMessageRawPtr receiveSelective(const std::vector<uint32_t> &filter, uint32_t mode = ITC_MODE_DEFAULT, uint32_t timeout = 0) override;
+	size_t receiveBatch(ItcMessageRawPtr *out, size_t max, uint32_t mode = ITC_MODE_DEFAULT, uint32_t timeout = 0) override;
+	ItcMessageRawPtr receiveAny(const std::vector<itc_mailbox_id_t> &mboxIds, const std::vector<uint32_t> &priorities = {}, uint32_t mode = ITC_MODE_DEFAULT, uint32_t timeout = 0) override;
 	MailboxContactInfo locateMailboxSync(const std::string &mboxName, uint32_t mode = ITC_MODE_LOCATE_IN_ALL, uint32_t timeout = 0) override;
 	ItcPlatformIfReturnCode locateMailboxAsync(const std::string &mboxName, uint32_t mode = ITC_MODE_LOCATE_IN_ALL) override;
 	
 	itc_mailbox_id_t getSender(const ItcMessageRawPtr &msg) override;
 	itc_mailbox_id_t getReceiver(const ItcMessageRawPtr &msg) override;
 	size_t getMsgSize(const ItcMessageRawPtr &msg) override;
+	ItcPlatformIfReturnCode setMsgPriority(ItcMessageRawPtr msg, uint32_t priority) override;
+	uint32_t getMsgPriority(const ItcMessageRawPtr &msg) override;
 	int32_t myMailboxFd() override;
 	std::string getMailboxName(itc_mailbox_id_t mboxId) override;
+	ItcPlatformIfReturnCode getLatencySnapshot(itc_mailbox_id_t mboxId, MailboxLatencySnapshot &snapshot) override;
+	ItcPlatformIfReturnCode getStatistics(itc_mailbox_id_t mboxId, MailboxStatistics &statistics) override;
+	ItcPlatformIfReturnCode getTransportStatistics(TransportStatisticsList &statistics) override;
 
 	ItcPlatform();
 	virtual ~ItcPlatform();
@@ -66,7 +83,13 @@ public:
 private:
 	bool startDaemon(const std::string &programPath);
 	bool checkAndStartItcServer();
+	/* Sets m_regionId and m_itcServerMboxId, retries for up to ITC_ITC_SERVER_LOCATE_TIMEOUT. */
+	bool locateItcServer();
 	void destructMailboxAtThreadExit(void *args);
+	/* Index into m_myMailboxes, -1 if mboxId is not a mailbox of the calling thread. */
+	static int32_t findMyMailboxIndex(itc_mailbox_id_t mboxId);
+	/* Takes mbox out of the name index and puts it back among the free ones. */
+	void releaseMailbox(ItcMailboxRawPtr mbox, const char *name);
 	ItcPlatformIfReturnCode forwardMessageToItcServer(ItcAdminMessageRawPtr adminMsg, itc_mailbox_id_t toWorldId);
 
 private:
@@ -75,14 +98,28 @@ private:
 	itc_mailbox_id_t m_regionId {ITC_MAILBOX_ID_DEFAULT};
 	itc_mailbox_id_t m_itcServerMboxId {ITC_MAILBOX_ID_DEFAULT};
 	std::shared_ptr<ConcurrentContainer<ItcMailbox, ITC_MAX_SUPPORTED_MAILBOXES>> m_mboxList {nullptr};
+	std::shared_ptr<ItcTransportLocal> m_transportLocal {nullptr};
+	std::shared_ptr<ItcTransportSysvMsgQueue> m_transportSysvMsgQueue {nullptr};
+	std::shared_ptr<ItcTransportPosixShm> m_transportPosixShm {nullptr};
+	std::shared_ptr<CWrapperIf> m_cWrapperIf {nullptr};
 	pthread_key_t m_destructKey;
 	bool m_isInitialised {false};
 	static thread_local ItcMailboxRawPtr m_myMailbox;
+	/* All mailboxes of the calling thread, oldest first. Plain array, since it is still needed by the pthread key destructor. */
+	static thread_local std::array<ItcMailboxRawPtr, ITC_MAX_MAILBOXES_PER_THREAD> m_myMailboxes;
+	static thread_local uint32_t m_nrMyMailboxes;
+	/* Names of m_myMailboxes, same order, plain for the same reason. */
+	static thread_local std::array<std::array<char, CONCURRENT_CONTAINER_MAX_KEY_LENGTH + 1>, ITC_MAX_MAILBOXES_PER_THREAD> m_myMailboxNames;
+	/* What itc-server answered to this thread's locateMailboxSync() calls, see LocateCache. */
+	static thread_local LocateCache m_locateCache;
 	
 	friend void ::destructMailboxAtThreadExitWrapper(void *args);
 	
 	friend class ItcPlatformIfTest;
 	FRIEND_TEST(ItcPlatformIfTest, checkAndStartItcServerTest1);
+	FRIEND_TEST(ItcPlatformIfTest, locateInRegionTest1);
+	FRIEND_TEST(ItcPlatformIfTest, locateRequestOwnershipTest1);
+	FRIEND_TEST(ItcPlatformIfTest, allocateMessageTest1);
 
 }; // class ItcPlatform
 
@@ -2,13 +2,19 @@
 
 #include <cstdint>
 #include <string>
+#include <array>
+#include <algorithm>
+#include <numeric>
+#include <future>
 #include <unistd.h>
+#include <sys/wait.h>
 
 #include "itcFileSystemIf.h"
 #include "itcConstant.h"
 #include "itcTransportLocal.h"
 #include "itcTransportLSocket.h"
 #include "itcTransportSysvMsgQueue.h"
+#include "itcTransportPosixShm.h"
 #include "itcSystemProto.h"
 
 using namespace ITC::INTERNAL;
@@ -50,6 +56,10 @@ using ThreadManagerIfReturnCode = ThreadManagerIf::ThreadManagerIfReturnCode;
 SINGLETON_DEFINITION(ItcPlatform)
 
 thread_local ItcMailboxRawPtr ItcPlatform::m_myMailbox = nullptr;
+thread_local std::array<ItcMailboxRawPtr, ITC_MAX_MAILBOXES_PER_THREAD> ItcPlatform::m_myMailboxes {};
+thread_local uint32_t ItcPlatform::m_nrMyMailboxes = 0;
+thread_local std::array<std::array<char, CONCURRENT_CONTAINER_MAX_KEY_LENGTH + 1>, ITC_MAX_MAILBOXES_PER_THREAD> ItcPlatform::m_myMailboxNames {};
+thread_local LocateCache ItcPlatform::m_locateCache;
 
 ItcPlatform::ItcPlatform()
 {
@@ -65,54 +75,73 @@ ItcPlatform::~ItcPlatform()
 
 ItcPlatformIfReturnCode ItcPlatform::initialise(uint32_t flags)
 {
-    if(!checkAndStartItcServer())
-    {
-        return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
-    }
-    
     if(m_isInitialised)
     {
         return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK);
     }
     
-    if(flags & ITC_FLAG_I_AM_ITC_SERVER)
-    {
-        m_regionId = 1 << ITC_REGION_ID_SHIFT;
-        m_itcServerMboxId = m_regionId | 1;
-    } else
+    bool isItcServer = (flags & ITC_FLAG_I_AM_ITC_SERVER) != 0;
+    if(!isItcServer && !checkAndStartItcServer())
     {
-        auto locatedResults = ItcTransportLSocket::getInstance().lock()->locateItcServer();
-        if(locatedResults.assignedRegionId == ITC_MAILBOX_ID_DEFAULT || locatedResults.itcServerMboxId == ITC_MAILBOX_ID_DEFAULT)
-        {
-            return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
-        }
-        
-        m_regionId = locatedResults.assignedRegionId;
-        m_itcServerMboxId = locatedResults.itcServerMboxId;
+        return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
     }
     
-    bool areTransportsInitialised {true};
-    areTransportsInitialised &= ItcTransportLocal::getInstance().lock()->initialise(m_mboxList);
-    areTransportsInitialised &= ItcTransportLSocket::getInstance().lock()->initialise(m_regionId);
-    areTransportsInitialised &= ItcTransportSysvMsgQueue::getInstance().lock()->initialise(m_regionId);
-    if(!areTransportsInitialised)
+    /* Resolved once here, so that sending/receiving never goes through getInstance() again. */
+    m_transportLocal = ItcTransportLocal::getInstance().lock();
+    m_transportSysvMsgQueue = ItcTransportSysvMsgQueue::getInstance().lock();
+    m_transportPosixShm = ItcTransportPosixShm::getInstance().lock();
+    m_cWrapperIf = CWrapperIf::getInstance().lock();
+    
+    /* Whatever does not need our Region id is done while itc-server may still be starting up. */
+    if(!m_transportLocal->initialise(m_mboxList))
     {
         return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
     }
     
-    auto ret = CWrapperIf::getInstance().lock()->cPthreadKeyCreate(&m_destructKey, destructMailboxAtThreadExitWrapper);
+    auto ret = m_cWrapperIf->cPthreadKeyCreate(&m_destructKey, destructMailboxAtThreadExitWrapper);
 	if(ret != 0)
 	{
 		TPT_TRACE(TRACE_ERROR, SSTR("Failed to create destruct_key, error code = ", ret));
 		return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
 	}
     
-    auto rc = ThreadManagerIf::getInstance().lock()->startAllThreads();
-    if(rc != MAKE_RETURN_CODE(ThreadManagerIfReturnCode, THREAD_MANAGER_OK))
+    if(isItcServer)
+    {
+        m_regionId = 1 << ITC_REGION_ID_SHIFT;
+        m_itcServerMboxId = m_regionId | 1;
+    } else if(!locateItcServer())
+    {
+        return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+    }
+    
+    /***
+     * The lsocket to itc-server, which tells it once this Region is gone, costs a round trip to itc-server.
+     * It is done meanwhile the other transports set up their queue and shared memory segment and start their rx threads.
+     */
+    std::future<bool> isLSocketInitialised;
+    if(!isItcServer)
+    {
+        isLSocketInitialised = std::async(std::launch::async, [regionId = m_regionId]()
+        {
+            return ItcTransportLSocket::getInstance().lock()->initialise(regionId);
+        });
+    }
+    
+    bool areTransportsInitialised {true};
+    areTransportsInitialised &= m_transportSysvMsgQueue->initialise(m_regionId);
+    areTransportsInitialised &= m_transportPosixShm->initialise(m_regionId);
+    bool areThreadsStarted = areTransportsInitialised
+        && ThreadManagerIf::getInstance().lock()->startAllThreads() == MAKE_RETURN_CODE(ThreadManagerIfReturnCode, THREAD_MANAGER_OK);
+    if(isLSocketInitialised.valid())
+    {
+        areTransportsInitialised &= isLSocketInitialised.get();
+    }
+    if(!areTransportsInitialised || !areThreadsStarted)
     {
         return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
     }
     
+    m_isInitialised = true;
     return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK);
 }
 
@@ -129,18 +158,23 @@ ItcPlatformIfReturnCode ItcPlatform::release()
         return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
     }
     
+    /* Its rx thread parks on a futex, which is no cancellation point. */
+    m_transportPosixShm->stopRxThread();
     auto rc = ThreadManagerIf::getInstance().lock()->terminateAllThreads();
     if(rc != MAKE_RETURN_CODE(ThreadManagerIfReturnCode, THREAD_MANAGER_OK))
     {
         return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
     }
     
-    m_mboxList->clear();
+    /* Only the calling thread's own mailboxes can be left, see the check above. */
+    destructMailboxAtThreadExit(nullptr);
     
     ItcTransportLSocket::getInstance().lock()->release();
-    ItcTransportSysvMsgQueue::getInstance().lock()->release();
+    m_transportSysvMsgQueue->release();
+    m_transportPosixShm->release();
+    m_isInitialised = false;
     
-    auto ret = CWrapperIf::getInstance().lock()->cPthreadKeyDelete(m_destructKey);
+    auto ret = m_cWrapperIf->cPthreadKeyDelete(m_destructKey);
 	if(ret != 0)
 	{
 		// ERROR trace is needed here
@@ -157,6 +191,18 @@ ItcMessageRawPtr ItcPlatform::allocateMessage(uint32_t msgno, size_t size)
     return CONVERT_TO_USER_MESSAGE(adminMsg);
 }
 
+ItcMessageRawPtr ItcPlatform::allocateMessage(uint32_t msgno, size_t size, const MailboxContactInfo &toMbox)
+{
+    /* Only mailboxes of our own Region are read from this buffer, others get a copy on their side. */
+    uint32_t numaNode = MEMORY_NUMA_NODE_ANY;
+    if(m_isInitialised && toMbox.worldId == 0 && (toMbox.mailboxId & ITC_MASK_REGION_ID) == m_regionId)
+    {
+        numaNode = m_transportLocal->getNumaNode(toMbox.mailboxId);
+    }
+    auto adminMsg = ItcAdminMessageHelper::allocate(msgno, size, numaNode);
+    return CONVERT_TO_USER_MESSAGE(adminMsg);
+}
+
 ItcPlatformIfReturnCode ItcPlatform::deallocateMessage(ItcMessageRawPtr msg)
 {
     if(ItcAdminMessageHelper::deallocate(CONVERT_TO_ADMIN_MESSAGE(msg)))
@@ -166,46 +212,70 @@ ItcPlatformIfReturnCode ItcPlatform::deallocateMessage(ItcMessageRawPtr msg)
     return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
 }
 
-itc_mailbox_id_t ItcPlatform::createMailbox(const std::string &name, uint32_t flags)
+itc_mailbox_id_t ItcPlatform::createMailbox(const std::string &name, uint32_t flags, const MailboxRxConfig &rxConfig)
 {
     if(!m_isInitialised)
     {
         return ITC_MAILBOX_ID_DEFAULT;
     }
     
-    if(m_myMailbox)
+    if(m_nrMyMailboxes >= ITC_MAX_MAILBOXES_PER_THREAD)
     {
-        return m_myMailbox->mailboxId;
+        TPT_TRACE(TRACE_ERROR, SSTR("Too many mailboxes in this thread, max = ", ITC_MAX_MAILBOXES_PER_THREAD));
+        return ITC_MAILBOX_ID_DEFAULT;
     }
     
-    if(auto indexOpt = m_mboxList->emplace(ItcMailbox(name, flags)); indexOpt.has_value())
+    /* Longer names could not be located inside our Region, see ConcurrentContainerIndex. */
+    if(name.empty() || name.length() > CONCURRENT_CONTAINER_MAX_KEY_LENGTH)
     {
-        if(auto mboxOpt = m_mboxList->at(indexOpt.value()); mboxOpt.has_value())
-        {
-            mboxOpt.value().get().mailboxId = m_regionId | (indexOpt.value() & ITC_MASK_UNIT_ID);
-        }
-        m_myMailbox = m_mboxList->data(indexOpt.value());
-    } else
+        TPT_TRACE(TRACE_ERROR, SSTR("Invalid mailbox name length = ", name.length(), ", max = ", CONCURRENT_CONTAINER_MAX_KEY_LENGTH));
+        return ITC_MAILBOX_ID_DEFAULT;
+    }
+    
+    /* tryPopFromQueue() would wait for a free slot otherwise. */
+    if(m_mboxList->size() >= ITC_MAX_SUPPORTED_MAILBOXES)
     {
+        TPT_TRACE(TRACE_ERROR, SSTR("Too many mailboxes in this Region, max = ", ITC_MAX_SUPPORTED_MAILBOXES));
         return ITC_MAILBOX_ID_DEFAULT;
     }
     
-    auto cWrapperIf = CWrapperIf::getInstance().lock();
-    auto ret = cWrapperIf->cPthreadSetSpecific(m_destructKey, m_myMailbox);
-	if(ret != 0)
-	{
-		// ERROR trace is needed here
-		TPT_TRACE(TRACE_ERROR, SSTR("Failed to pthread_setspecific, error code = ", ret));
-		return ITC_MAILBOX_ID_DEFAULT;
-	}
+    ItcMailboxRawPtr newMailbox = m_mboxList->tryPopFromQueue();
+    newMailbox->m_mailboxId = m_regionId | (m_mboxList->getIndex(newMailbox) & ITC_MASK_UNIT_ID);
+    newMailbox->m_flags = flags;
+    /* Nobody knows our mailbox id yet, so nothing can be pushed concurrently. */
+    newMailbox->setRxConfig(rxConfig);
+    newMailbox->setState(true);
+    if(!m_mboxList->addEntryToHashMap(name, newMailbox))
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("Mailbox name already in use in this Region, name = ", name));
+        newMailbox->setState(false);
+        m_mboxList->tryPushIntoQueue(newMailbox);
+        return ITC_MAILBOX_ID_DEFAULT;
+    }
     
-    if(m_regionId != (m_itcServerMboxId | ITC_MASK_REGION_ID))
+    name.copy(m_myMailboxNames[m_nrMyMailboxes].data(), name.length());
+    m_myMailboxNames[m_nrMyMailboxes][name.length()] = '\0';
+    m_myMailboxes[m_nrMyMailboxes++] = newMailbox;
+    if(!m_myMailbox)
+    {
+        /* Only the default mailbox is registered, destructMailboxAtThreadExit() cleans up all of them. */
+        m_myMailbox = newMailbox;
+        auto ret = m_cWrapperIf->cPthreadSetSpecific(m_destructKey, m_myMailbox);
+        if(ret != 0)
+        {
+            // ERROR trace is needed here
+            TPT_TRACE(TRACE_ERROR, SSTR("Failed to pthread_setspecific, error code = ", ret));
+            return ITC_MAILBOX_ID_DEFAULT;
+        }
+    }
+    
+    if(m_regionId != (m_itcServerMboxId & ITC_MASK_REGION_ID))
     {
         auto req = allocateMessage(ITC_SYSTEM_MESSAGE_NOTIFY_MBOX_CREATION_DELETION_TO_ITC_SERVER_REQUEST, offsetof(itc_system_message_notify_mbox_creation_deletion_to_itc_server_request, mboxName) + name.length() + 1);
         req->m_itc_system_message_notify_mbox_creation_deletion_to_itc_server_request.isCreation = 1;
-        req->m_itc_system_message_notify_mbox_creation_deletion_to_itc_server_request.mboxId = m_myMailbox->mailboxId;
+        req->m_itc_system_message_notify_mbox_creation_deletion_to_itc_server_request.mboxId = newMailbox->m_mailboxId;
         req->m_itc_system_message_notify_mbox_creation_deletion_to_itc_server_request.isExternalCommunicationNeeded = (flags & ITC_FLAG_EXTERNAL_COMMUNICATION_NEEDED) ? 1 : 0;
-        cWrapperIf->cStrcpy(req->m_itc_system_message_notify_mbox_creation_deletion_to_itc_server_request.mboxName, name.c_str()); 
+        m_cWrapperIf->cStrcpy(req->m_itc_system_message_notify_mbox_creation_deletion_to_itc_server_request.mboxName, name.c_str()); 
         if(send(req, MailboxContactInfo(m_itcServerMboxId)) != MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK))
         {
             deallocateMessage(req);
@@ -213,7 +283,7 @@ itc_mailbox_id_t ItcPlatform::createMailbox(const std::string &name, uint32_t fl
         }
     }
     
-    return m_myMailbox->mailboxId;
+    return newMailbox->m_mailboxId;
 }
 
 ItcPlatformIfReturnCode ItcPlatform::deleteMailbox(itc_mailbox_id_t mboxId)
@@ -223,33 +293,45 @@ ItcPlatformIfReturnCode ItcPlatform::deleteMailbox(itc_mailbox_id_t mboxId)
         return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
     }
     
-    if(mboxId != m_myMailbox->mailboxId)
+    int32_t myIndex = findMyMailboxIndex(mboxId);
+    if(myIndex < 0)
     {
         TPT_TRACE(TRACE_ERROR, SSTR("Not allowed to delete other thread's mailbox, mbox_id = 0x", std::hex, std::setw(2), std::setfill('0'), mboxId));
         return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
     }
     
-    std::string mboxName = m_myMailbox->name;
+    ItcMailboxRawPtr mbox = m_myMailboxes[myIndex];
+    std::string mboxName = m_myMailboxNames[myIndex].data();
+    
+    releaseMailbox(mbox, mboxName.c_str());
+    /* Other threads may have located it via itc-server, so have them all ask again. */
+    LocateCache::invalidateAll();
+    std::copy(m_myMailboxes.begin() + myIndex + 1, m_myMailboxes.begin() + m_nrMyMailboxes, m_myMailboxes.begin() + myIndex);
+    std::copy(m_myMailboxNames.begin() + myIndex + 1, m_myMailboxNames.begin() + m_nrMyMailboxes, m_myMailboxNames.begin() + myIndex);
+    m_myMailboxes[--m_nrMyMailboxes] = nullptr;
     
-    size_t index = mboxId & ITC_MASK_UNIT_ID;
-    m_mboxList->remove(index);
+    auto rc = MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK);
     
-    auto cWrapperIf = CWrapperIf::getInstance().lock();
-    if(m_regionId != (m_itcServerMboxId | ITC_MASK_REGION_ID))
+    if(m_regionId != (m_itcServerMboxId & ITC_MASK_REGION_ID))
     {
         auto req = allocateMessage(ITC_SYSTEM_MESSAGE_NOTIFY_MBOX_CREATION_DELETION_TO_ITC_SERVER_REQUEST, offsetof(itc_system_message_notify_mbox_creation_deletion_to_itc_server_request, mboxName) + mboxName.length() + 1);
         req->m_itc_system_message_notify_mbox_creation_deletion_to_itc_server_request.isCreation = 2;
-        req->m_itc_system_message_notify_mbox_creation_deletion_to_itc_server_request.mboxId = m_myMailbox->mailboxId;
-        cWrapperIf->cStrcpy(req->m_itc_system_message_notify_mbox_creation_deletion_to_itc_server_request.mboxName, mboxName.c_str()); 
+        req->m_itc_system_message_notify_mbox_creation_deletion_to_itc_server_request.mboxId = mboxId;
+        m_cWrapperIf->cStrcpy(req->m_itc_system_message_notify_mbox_creation_deletion_to_itc_server_request.mboxName, mboxName.c_str()); 
         if(send(req, MailboxContactInfo(m_itcServerMboxId)) != MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK))
         {
             deallocateMessage(req);
-            return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+            rc = MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
         }
     }
     
-    m_myMailbox = nullptr;
-    return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK);
+    if(mbox == m_myMailbox)
+    {
+        /* The oldest remaining mailbox of this thread becomes the default one. */
+        m_myMailbox = m_nrMyMailboxes > 0 ? m_myMailboxes[0] : nullptr;
+        m_cWrapperIf->cPthreadSetSpecific(m_destructKey, m_myMailbox);
+    }
+    return rc;
 }
 
 ItcPlatformIfReturnCode ItcPlatform::send(ItcMessageRawPtr msg, const MailboxContactInfo &toMbox)
@@ -264,33 +346,178 @@ ItcPlatformIfReturnCode ItcPlatform::send(ItcMessageRawPtr msg, const MailboxCon
         return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
     }
     
-    if(toMbox.mailboxId == m_myMailbox->mailboxId && toMbox.worldId == 0)
+    if(toMbox.mailboxId == m_myMailbox->m_mailboxId && toMbox.worldId == 0)
     {
         return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
     }
     
     auto adminMsg = CONVERT_TO_ADMIN_MESSAGE(msg);
     adminMsg->receiver = toMbox.mailboxId;
-    adminMsg->sender = m_myMailbox->mailboxId;
+    adminMsg->sender = m_myMailbox->m_mailboxId;
+    ITC_LATENCY_STAMP(adminMsg, ITC_LATENCY_STAMP_SEND);
     
+    ItcPlatformIfReturnCode rc;
     if(toMbox.worldId != 0)
     {
-        return forwardMessageToItcServer(adminMsg, toMbox.worldId);
+        rc = forwardMessageToItcServer(adminMsg, toMbox.worldId);
     } else
     {
         if((toMbox.mailboxId & ITC_MASK_REGION_ID) != m_regionId)
         {
-            return ItcTransportSysvMsgQueue::getInstance().lock()->send(adminMsg);
+            /* Zero-copy path first, messages which do not fit into the receiver's pool go through the kernel instead. */
+            rc = m_transportPosixShm->send(adminMsg);
+            if(rc != MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK))
+            {
+                rc = m_transportSysvMsgQueue->send(adminMsg);
+            }
         } else
         {
-            return ItcTransportLocal::getInstance().lock()->send(adminMsg);
+            rc = m_transportLocal->send(adminMsg);
         }
     }
     
-    return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+    if(rc == MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK))
+    {
+        m_myMailbox->addNrSentMsgs(1);
+    }
+    return rc;
 }
 
-ItcMessageRawPtr ItcPlatform::receive(uint32_t mode)
+ItcPlatformIfReturnCode ItcPlatform::sendBatch(ItcMessageRawPtr *msgs, const MailboxContactInfo *toMboxes, size_t count)
+{
+    if(!m_isInitialised)
+    {
+        return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+    }
+    
+    if(!m_myMailbox)
+    {
+        return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+    }
+    
+    bool isAllSent {true};
+    uint64_t nrSentMsgs {0};
+    std::array<uint32_t, ITC_BATCH_CHUNK_SIZE> order;
+    std::array<ItcAdminMessageRawPtr, ITC_BATCH_CHUNK_SIZE> adminMsgs;
+    for(size_t chunkStart = 0; chunkStart < count; chunkStart += ITC_BATCH_CHUNK_SIZE)
+    {
+        size_t chunkEnd = std::min<size_t>(chunkStart + ITC_BATCH_CHUNK_SIZE, count);
+        uint32_t nrMsgs = 0;
+        for(size_t i = chunkStart; i < chunkEnd; ++i)
+        {
+            if(!msgs[i] || (toMboxes[i].mailboxId == m_myMailbox->m_mailboxId && toMboxes[i].worldId == 0))
+            {
+                isAllSent = false;
+                continue;
+            }
+            
+            auto adminMsg = CONVERT_TO_ADMIN_MESSAGE(msgs[i]);
+            adminMsg->receiver = toMboxes[i].mailboxId;
+            adminMsg->sender = m_myMailbox->m_mailboxId;
+            ITC_LATENCY_STAMP(adminMsg, ITC_LATENCY_STAMP_SEND);
+            if(toMboxes[i].worldId != 0)
+            {
+                /* Other Worlds are reached via itc-server, one message at a time. */
+                if(forwardMessageToItcServer(adminMsg, toMboxes[i].worldId) == MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK))
+                {
+                    msgs[i] = nullptr;
+                    ++nrSentMsgs;
+                } else
+                {
+                    isAllSent = false;
+                }
+                continue;
+            }
+            order[nrMsgs++] = i - chunkStart;
+        }
+        
+        /* Group by receiver, which also groups by Region. Comparing indexes last keeps each receiver's messages in order. */
+        std::sort(order.begin(), order.begin() + nrMsgs, [&](uint32_t a, uint32_t b)
+        {
+            itc_mailbox_id_t receiverA = toMboxes[chunkStart + a].mailboxId;
+            itc_mailbox_id_t receiverB = toMboxes[chunkStart + b].mailboxId;
+            return receiverA < receiverB || (receiverA == receiverB && a < b);
+        });
+        for(uint32_t k = 0; k < nrMsgs; ++k)
+        {
+            adminMsgs[k] = CONVERT_TO_ADMIN_MESSAGE(msgs[chunkStart + order[k]]);
+        }
+        
+        uint32_t groupStart = 0;
+        while(groupStart < nrMsgs)
+        {
+            itc_mailbox_id_t regionId = adminMsgs[groupStart]->receiver & ITC_MASK_REGION_ID;
+            uint32_t groupEnd = groupStart + 1;
+            while(groupEnd < nrMsgs && (adminMsgs[groupEnd]->receiver & ITC_MASK_REGION_ID) == regionId)
+            {
+                ++groupEnd;
+            }
+            
+            ItcAdminMessageRawPtr *group = adminMsgs.data() + groupStart;
+            uint32_t groupSize = groupEnd - groupStart;
+            if(regionId == m_regionId)
+            {
+                m_transportLocal->sendBatch(group, groupSize);
+            } else
+            {
+                m_transportPosixShm->sendBatch(group, groupSize);
+                /* Whatever did not fit into the receiver's pool goes through the kernel, as in send(). */
+                for(uint32_t j = 0; j < groupSize; ++j)
+                {
+                    if(group[j] && m_transportSysvMsgQueue->send(group[j]) == MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK))
+                    {
+                        group[j] = nullptr;
+                    }
+                }
+            }
+            groupStart = groupEnd;
+        }
+        
+        for(uint32_t k = 0; k < nrMsgs; ++k)
+        {
+            if(!adminMsgs[k])
+            {
+                msgs[chunkStart + order[k]] = nullptr;
+                ++nrSentMsgs;
+            } else
+            {
+                isAllSent = false;
+            }
+        }
+    }
+    
+    m_myMailbox->addNrSentMsgs(nrSentMsgs);
+    return isAllSent ? MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK) : MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+}
+
+ItcPlatformIfReturnCode ItcPlatform::forward(ItcMessageRawPtr msg, const MailboxContactInfo &toMbox)
+{
+    if(!msg || !ItcAdminMessageHelper::prepareResend(CONVERT_TO_ADMIN_MESSAGE(msg)))
+    {
+        return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+    }
+    return send(msg, toMbox);
+}
+
+ItcPlatformIfReturnCode ItcPlatform::reply(ItcMessageRawPtr msg, uint32_t msgno)
+{
+    if(!msg)
+    {
+        return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+    }
+
+    auto adminMsg = CONVERT_TO_ADMIN_MESSAGE(msg);
+    itc_mailbox_id_t toMboxId = adminMsg->sender;
+    if(toMboxId == ITC_MAILBOX_ID_DEFAULT || !ItcAdminMessageHelper::prepareResend(adminMsg))
+    {
+        return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+    }
+
+    adminMsg->msgno = msgno;
+    return send(msg, MailboxContactInfo(toMboxId));
+}
+
+ItcMessageRawPtr ItcPlatform::receive(uint32_t mode, uint32_t timeout)
 {
     if(!m_isInitialised)
     {
@@ -302,8 +529,95 @@ ItcMessageRawPtr ItcPlatform::receive(uint32_t mode)
         return nullptr;
     }
     
-    auto adminMsg = ItcTransportLocal::getInstance().lock()->receive(m_myMailbox, mode);
-    return CONVERT_TO_USER_MESSAGE(adminMsg);
+    auto adminMsg = m_transportLocal->receive(m_myMailbox, mode, timeout);
+    return adminMsg ? CONVERT_TO_USER_MESSAGE(adminMsg) : nullptr;
+}
+
+ItcMessageRawPtr ItcPlatform::receiveSelective(const std::vector<uint32_t> &filter, uint32_t mode, uint32_t timeout)
+{
+    if(!m_isInitialised)
+    {
+        return nullptr;
+    }
+    
+    if(!m_myMailbox)
+    {
+        return nullptr;
+    }
+    
+    auto adminMsg = m_transportLocal->receiveSelective(m_myMailbox, filter, mode, timeout);
+    return adminMsg ? CONVERT_TO_USER_MESSAGE(adminMsg) : nullptr;
+}
+
+size_t ItcPlatform::receiveBatch(ItcMessageRawPtr *out, size_t max, uint32_t mode, uint32_t timeout)
+{
+    if(!m_isInitialised)
+    {
+        return 0;
+    }
+    
+    if(!m_myMailbox)
+    {
+        return 0;
+    }
+    
+    std::array<ItcAdminMessageRawPtr, ITC_BATCH_CHUNK_SIZE> adminMsgs;
+    size_t count = 0;
+    while(count < max)
+    {
+        size_t chunkSize = std::min<size_t>(ITC_BATCH_CHUNK_SIZE, max - count);
+        /* Only the very first chunk may block, afterwards just take what is already pending. */
+        size_t nrMsgs = m_transportLocal->receiveBatch(m_myMailbox, adminMsgs.data(), chunkSize, count == 0 ? mode : ITC_MODE_RECEIVE_NON_BLOCKING, timeout);
+        for(size_t i = 0; i < nrMsgs; ++i)
+        {
+            out[count + i] = CONVERT_TO_USER_MESSAGE(adminMsgs[i]);
+        }
+        count += nrMsgs;
+        if(nrMsgs < chunkSize)
+        {
+            break;
+        }
+    }
+    return count;
+}
+
+ItcMessageRawPtr ItcPlatform::receiveAny(const std::vector<itc_mailbox_id_t> &mboxIds, const std::vector<uint32_t> &priorities, uint32_t mode, uint32_t timeout)
+{
+    if(!m_isInitialised)
+    {
+        return nullptr;
+    }
+    
+    if(mboxIds.empty() || mboxIds.size() > m_nrMyMailboxes || (!priorities.empty() && priorities.size() != mboxIds.size()))
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("Invalid mailboxes to receive from, number of mailboxes = ", mboxIds.size(), ", number of priorities = ", priorities.size()));
+        return nullptr;
+    }
+    
+    std::array<uint32_t, ITC_MAX_MAILBOXES_PER_THREAD> order;
+    std::iota(order.begin(), order.begin() + mboxIds.size(), 0);
+    if(!priorities.empty())
+    {
+        std::stable_sort(order.begin(), order.begin() + mboxIds.size(), [&priorities](uint32_t lhs, uint32_t rhs)
+        {
+            return priorities[lhs] > priorities[rhs];
+        });
+    }
+    
+    std::array<ItcMailboxRawPtr, ITC_MAX_MAILBOXES_PER_THREAD> myMboxes;
+    for(size_t i = 0; i < mboxIds.size(); ++i)
+    {
+        int32_t myIndex = findMyMailboxIndex(mboxIds[order[i]]);
+        if(myIndex < 0)
+        {
+            TPT_TRACE(TRACE_ERROR, SSTR("Not allowed to receive from other thread's mailbox, mbox_id = 0x", std::hex, std::setw(2), std::setfill('0'), mboxIds[order[i]]));
+            return nullptr;
+        }
+        myMboxes[i] = m_myMailboxes[myIndex];
+    }
+    
+    auto adminMsg = m_transportLocal->receiveAny(myMboxes.data(), mboxIds.size(), mode, timeout);
+    return adminMsg ? CONVERT_TO_USER_MESSAGE(adminMsg) : nullptr;
 }
 
 MailboxContactInfo ItcPlatform::locateMailboxSync(const std::string &mboxName, uint32_t mode, uint32_t timeout)
@@ -317,9 +631,10 @@ MailboxContactInfo ItcPlatform::locateMailboxSync(const std::string &mboxName, u
     uint32_t locateMode = mode & ITC_MASK_LOCATE;
     if(locateMode & ITC_MODE_LOCATE_IN_REGION)
     {
-        if(auto mboxOpt = m_mboxList->at(mboxName); mboxOpt.has_value())
+        /* Lock-free, so concurrent locates in our Region do not serialise on each other. */
+        if(auto mbox = m_mboxList->lookUpFromHashMap(mboxName))
         {
-            info.mailboxId = mboxOpt.value().get().mailboxId;
+            info.mailboxId = mbox->m_mailboxId;
             return info;
         }
     }
@@ -329,32 +644,42 @@ MailboxContactInfo ItcPlatform::locateMailboxSync(const std::string &mboxName, u
         return info;
     }
     
+    if(m_locateCache.lookUp(mboxName, locateMode, info))
+    {
+        return info;
+    }
+    
     /* If cannot find in local, send locating-mailbox requests to itc-server. */
+    uint64_t generation = LocateCache::getGeneration();
     auto req = allocateMessage(ITC_SYSTEM_MESSAGE_LOCATE_MBOX_SYNC_IN_ITC_SERVER_REQUEST, offsetof(itc_system_message_locate_mbox_sync_in_itc_server_request, locatedMboxName) + mboxName.length() + 1);
     req->m_itc_system_message_locate_mbox_sync_in_itc_server_request.mode = locateMode;
-    CWrapperIf::getInstance().lock()->cStrcpy(req->m_itc_system_message_locate_mbox_sync_in_itc_server_request.locatedMboxName, mboxName.c_str());
+    m_cWrapperIf->cStrcpy(req->m_itc_system_message_locate_mbox_sync_in_itc_server_request.locatedMboxName, mboxName.c_str());
     
-    auto rc = send(req, MailboxContactInfo(m_itcServerMboxId));
-    deallocateMessage(req);
-    if(rc != MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK))
+    /* Once sent, req belongs to itc-server. */
+    if(send(req, MailboxContactInfo(m_itcServerMboxId)) != MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK))
     {
+        deallocateMessage(req);
         return info;
     }
     
+    /* Only pick the reply, anything else sent to us meanwhile stays queued for the user. */
+    static const std::vector<uint32_t> replyFilter {ITC_SYSTEM_MESSAGE_LOCATE_MBOX_IN_ITC_SERVER_REPLY};
     uint32_t timeoutMode = mode & ITC_MASK_TIMEOUT;
-    auto rep = receive(timeoutMode);
+    auto rep = receiveSelective(replyFilter, timeoutMode, timeout);
     if(!rep)
     {
         return info;
     }
-        
-    if(rep->m_itc_system_message_locate_mbox_in_itc_server_reply.msgno != ITC_SYSTEM_MESSAGE_LOCATE_MBOX_IN_ITC_SERVER_REPLY)
-    {
-        return info;
-    }
     
     info.mailboxId = rep->m_itc_system_message_locate_mbox_in_itc_server_reply.locatedMbox.mailboxId;
     info.worldId = rep->m_itc_system_message_locate_mbox_in_itc_server_reply.locatedMbox.worldId;
+    deallocateMessage(rep);
+    
+    /* Deletions in other Worlds never reach our itc-server, so only our own World's answers can be kept. */
+    if(info.mailboxId != ITC_MAILBOX_ID_DEFAULT && info.worldId == 0)
+    {
+        m_locateCache.insert(mboxName, locateMode, info, generation);
+    }
     return info;
 }
 
@@ -368,16 +693,19 @@ ItcPlatformIfReturnCode ItcPlatform::locateMailboxAsync(const std::string &mboxN
     uint32_t locateMode = mode & ITC_MASK_LOCATE;
     auto req = allocateMessage(ITC_SYSTEM_MESSAGE_LOCATE_MBOX_ASYNC_IN_ITC_SERVER_REQUEST, offsetof(itc_system_message_locate_mbox_async_in_itc_server_request, locatedMboxName) + mboxName.length() + 1);
     req->m_itc_system_message_locate_mbox_async_in_itc_server_request.mode = locateMode;
-    CWrapperIf::getInstance().lock()->cStrcpy(req->m_itc_system_message_locate_mbox_async_in_itc_server_request.locatedMboxName, mboxName.c_str());
+    m_cWrapperIf->cStrcpy(req->m_itc_system_message_locate_mbox_async_in_itc_server_request.locatedMboxName, mboxName.c_str());
     
-    if(auto mboxOpt = m_mboxList->at(mboxName); mboxOpt.has_value())
+    if(auto mbox = m_mboxList->lookUpFromHashMap(mboxName))
     {
         req->m_itc_system_message_locate_mbox_async_in_itc_server_request.replyImmediately = 1;
-        req->m_itc_system_message_locate_mbox_async_in_itc_server_request.mailboxId = mboxOpt.value().get().mailboxId;
+        req->m_itc_system_message_locate_mbox_async_in_itc_server_request.mailboxId = mbox->m_mailboxId;
     }
     
     auto rc = send(req, MailboxContactInfo(m_itcServerMboxId));
-    deallocateMessage(req);
+    if(rc != MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK))
+    {
+        deallocateMessage(req);
+    }
     return rc;
 }
 
@@ -399,6 +727,22 @@ size_t ItcPlatform::getMsgSize(const ItcMessageRawPtr &msg)
     return adminMsg->size;
 }
 
+ItcPlatformIfReturnCode ItcPlatform::setMsgPriority(ItcMessageRawPtr msg, uint32_t priority)
+{
+    if(!msg || priority >= ITC_NUMBER_OF_MESSAGE_PRIORITIES)
+    {
+        return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+    }
+    ItcAdminMessageHelper::setPriority(CONVERT_TO_ADMIN_MESSAGE(msg), priority);
+    return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK);
+}
+
+uint32_t ItcPlatform::getMsgPriority(const ItcMessageRawPtr &msg)
+{
+    const auto adminMsg = CONVERT_TO_ADMIN_MESSAGE(msg);
+    return ItcAdminMessageHelper::getPriority(adminMsg);
+}
+
 int32_t ItcPlatform::myMailboxFd()
 {
     if(m_myMailbox)
@@ -410,13 +754,67 @@ int32_t ItcPlatform::myMailboxFd()
 
 std::string ItcPlatform::getMailboxName(itc_mailbox_id_t mboxId)
 {
-    if(m_myMailbox)
+    int32_t myIndex = findMyMailboxIndex(mboxId);
+    if(myIndex >= 0)
     {
-        return m_myMailbox->name;
+        return m_myMailboxNames[myIndex].data();
     }
     return "";
 }
 
+ItcPlatformIfReturnCode ItcPlatform::getLatencySnapshot(itc_mailbox_id_t mboxId, MailboxLatencySnapshot &snapshot)
+{
+    if(!m_isInitialised || (mboxId & ITC_MASK_REGION_ID) != m_regionId)
+    {
+        return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+    }
+    
+    ItcMailboxRawPtr mbox = m_mboxList->at(mboxId & ITC_MASK_UNIT_ID);
+    if(!mbox || mbox->m_mailboxId != mboxId || !mbox->getLatencySnapshot(snapshot))
+    {
+        return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+    }
+    return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK);
+}
+
+ItcPlatformIfReturnCode ItcPlatform::getStatistics(itc_mailbox_id_t mboxId, MailboxStatistics &statistics)
+{
+    if(!m_isInitialised || (mboxId & ITC_MASK_REGION_ID) != m_regionId)
+    {
+        return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+    }
+    
+    ItcMailboxRawPtr mbox = m_mboxList->at(mboxId & ITC_MASK_UNIT_ID);
+    if(!mbox || mbox->m_mailboxId != mboxId || !mbox->getStatistics(statistics))
+    {
+        return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+    }
+    return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK);
+}
+
+ItcPlatformIfReturnCode ItcPlatform::getTransportStatistics(TransportStatisticsList &statistics)
+{
+    if(!m_isInitialised)
+    {
+        return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+    }
+    
+    statistics.fill(TransportStatistics());
+    if(m_transportLocal)
+    {
+        statistics.at(ITC_TRANSPORT_LOCAL) = m_transportLocal->getStatistics();
+    }
+    if(m_transportSysvMsgQueue)
+    {
+        statistics.at(ITC_TRANSPORT_SYSV_MSG_QUEUE) = m_transportSysvMsgQueue->getStatistics();
+    }
+    if(m_transportPosixShm)
+    {
+        statistics.at(ITC_TRANSPORT_POSIX_SHM) = m_transportPosixShm->getStatistics();
+    }
+    return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK);
+}
+
 bool ItcPlatform::startDaemon(const std::string &programPath)
 {
     pid_t pid = fork();
@@ -426,7 +824,8 @@ bool ItcPlatform::startDaemon(const std::string &programPath)
         return false;
     } else if (pid > 0)
     {
-        // Parent process exits, leaving the daemon running
+        // Only reap the intermediate child, which exits right after the second fork, the daemon keeps running
+        waitpid(pid, nullptr, 0);
         std::cout << "[INFO] Daemon started with PID: " << pid << std::endl;
         return true;
     }
@@ -469,7 +868,29 @@ bool ItcPlatform::checkAndStartItcServer()
     {
         return startDaemon(ITC_PATH_ITC_SERVER_PROGRAM);
     }
-    return false;
+    return true;
+}
+
+bool ItcPlatform::locateItcServer()
+{
+    /* An itc-server which was just started, by us or by a Region starting at the same time, is not listening yet. */
+    auto transportLSocket = ItcTransportLSocket::getInstance().lock();
+    for(uint32_t waitTime = 0; ; waitTime += ITC_ITC_SERVER_LOCATE_RETRY_INTERVAL)
+    {
+        auto locatedResults = transportLSocket->locateItcServer();
+        if(locatedResults.assignedRegionId != ITC_MAILBOX_ID_DEFAULT && locatedResults.itcServerMboxId != ITC_MAILBOX_ID_DEFAULT)
+        {
+            m_regionId = locatedResults.assignedRegionId;
+            m_itcServerMboxId = locatedResults.itcServerMboxId;
+            return true;
+        }
+        if(waitTime >= ITC_ITC_SERVER_LOCATE_TIMEOUT * 1000)
+        {
+            TPT_TRACE(TRACE_ERROR, SSTR("Failed to locate itc-server within ", ITC_ITC_SERVER_LOCATE_TIMEOUT, " ms!"));
+            return false;
+        }
+        m_cWrapperIf->cUsleep(ITC_ITC_SERVER_LOCATE_RETRY_INTERVAL);
+    }
 }
 
 ItcPlatformIfReturnCode ItcPlatform::forwardMessageToItcServer(ItcAdminMessageRawPtr adminMsg, itc_mailbox_id_t toWorldId)
@@ -479,21 +900,46 @@ ItcPlatformIfReturnCode ItcPlatform::forwardMessageToItcServer(ItcAdminMessageRa
     
     req->m_itc_system_message_forward_message_to_itc_server_request.toWorldId = toWorldId;
     req->m_itc_system_message_forward_message_to_itc_server_request.flattenMsgLength = flattenMsgLength;
-    CWrapperIf::getInstance().lock()->cMemcpy(req->m_itc_system_message_forward_message_to_itc_server_request.flattenMsg, adminMsg, flattenMsgLength);
+    m_cWrapperIf->cMemcpy(req->m_itc_system_message_forward_message_to_itc_server_request.flattenMsg, adminMsg, flattenMsgLength);
     
+    /* Only the flattened copy travels, adminMsg stays with the caller unless it was sent. */
     auto rc = send(req, MailboxContactInfo(m_itcServerMboxId));
+    if(rc != MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK))
+    {
+        deallocateMessage(req);
+        return rc;
+    }
     ItcAdminMessageHelper::deallocate(adminMsg);
     return rc;
 }
 
-void ItcPlatform::destructMailboxAtThreadExit(void *args)
+void ItcPlatform::destructMailboxAtThreadExit(MAYBE_UNUSED void *args)
 {
-    auto myMbox = reinterpret_cast<ItcMailboxRawPtr>(args);
-    if(m_mboxList->exist(myMbox->name))
+    /* args is only our default mailbox, the others of this thread have to go as well, newest first. */
+    for(uint32_t i = m_nrMyMailboxes; i > 0; --i)
     {
-        deleteMailbox(myMbox->mailboxId);
+        deleteMailbox(m_myMailboxes[i - 1]->m_mailboxId);
     }
 }
 
+void ItcPlatform::releaseMailbox(ItcMailboxRawPtr mbox, const char *name)
+{
+    m_mboxList->removeEntryFromHashMap(name);
+    mbox->setState(false);
+    m_mboxList->tryPushIntoQueue(mbox);
+}
+
+int32_t ItcPlatform::findMyMailboxIndex(itc_mailbox_id_t mboxId)
+{
+    for(uint32_t i = 0; i < m_nrMyMailboxes; ++i)
+    {
+        if(m_myMailboxes[i]->m_mailboxId == mboxId)
+        {
+            return static_cast<int32_t>(i);
+        }
+    }
+    return -1;
+}
+
 } // namespace INTERNAL
 } // namespace ITC
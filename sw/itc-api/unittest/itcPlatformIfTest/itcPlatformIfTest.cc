@@ -10,6 +10,8 @@
 #include "itc.h"
 #include "itcConstant.h"
 #include "itcFileSystemIfMock.h"
+#include "itcTransportLocal.h"
+#include "itcMemoryManager.h"
 
 namespace ITC
 {
@@ -38,6 +40,31 @@ protected:
         // m_itcPlatform->m_instance.reset();
     }
     
+    /***
+     * A Region which acts as its own itc-server like in initialise(ITC_FLAG_I_AM_ITC_SERVER), but without other
+     * transports and threads, so only the local transport carries messages.
+     */
+    void initialiseLocalRegion()
+    {
+        m_itcPlatform->m_regionId = 1 << ITC_REGION_ID_SHIFT;
+        m_itcPlatform->m_itcServerMboxId = m_itcPlatform->m_regionId | 1;
+        m_itcPlatform->m_transportLocal = ItcTransportLocal::getInstance().lock();
+        m_itcPlatform->m_transportLocal->initialise(m_itcPlatform->m_mboxList);
+        m_itcPlatform->m_cWrapperIf = CWrapperIf::getInstance().lock();
+        m_itcPlatform->m_isInitialised = true;
+    }
+    
+    void releaseLocalRegion()
+    {
+        m_itcPlatform->destructMailboxAtThreadExit(nullptr);
+        m_itcPlatform->m_isInitialised = false;
+        m_itcPlatform->m_instance.reset();
+    }
+    
+    void setItcServerMboxId(itc_mailbox_id_t mboxId)
+    {
+        m_itcPlatform->m_itcServerMboxId = mboxId;
+    }
     
 protected:
     std::shared_ptr<ItcPlatform> m_itcPlatform;
@@ -70,7 +97,98 @@ TEST_F(ItcPlatformIfTest, checkAndStartItcServerTest1)
     m_itcPlatform->m_instance.reset();
 }
 
+TEST_F(ItcPlatformIfTest, locateInRegionTest1)
+{
+    /***
+     * Test scenario: a mailbox is located in our Region by its name without asking itc-server, until it is deleted.
+     * Names the index cannot hold and names already in use are refused.
+     */
+    initialiseLocalRegion();
+    auto mboxId = m_itcPlatform->createMailbox("locateInRegionTest1");
+    ASSERT_NE(mboxId, ITC_MAILBOX_ID_DEFAULT);
+    ASSERT_EQ(mboxId & ITC_MASK_REGION_ID, m_itcPlatform->m_regionId);
+    ASSERT_EQ(m_itcPlatform->getMailboxName(mboxId), "locateInRegionTest1");
+    ASSERT_EQ(m_itcPlatform->locateMailboxSync("locateInRegionTest1", ITC_MODE_LOCATE_IN_REGION).mailboxId, mboxId);
+    
+    ASSERT_EQ(m_itcPlatform->createMailbox("locateInRegionTest1"), ITC_MAILBOX_ID_DEFAULT);
+    ASSERT_EQ(m_itcPlatform->createMailbox(std::string(CONCURRENT_CONTAINER_MAX_KEY_LENGTH + 1, 'a')), ITC_MAILBOX_ID_DEFAULT);
+    auto longestNameMboxId = m_itcPlatform->createMailbox(std::string(CONCURRENT_CONTAINER_MAX_KEY_LENGTH, 'a'));
+    ASSERT_NE(longestNameMboxId, ITC_MAILBOX_ID_DEFAULT);
+    ASSERT_EQ(m_itcPlatform->locateMailboxSync(std::string(CONCURRENT_CONTAINER_MAX_KEY_LENGTH, 'a'), ITC_MODE_LOCATE_IN_REGION).mailboxId, longestNameMboxId);
+    
+    ASSERT_EQ(m_itcPlatform->deleteMailbox(mboxId), MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK));
+    ASSERT_EQ(m_itcPlatform->locateMailboxSync("locateInRegionTest1", ITC_MODE_LOCATE_IN_REGION).mailboxId, ITC_MAILBOX_ID_DEFAULT);
+    ASSERT_EQ(m_itcPlatform->getMailboxName(longestNameMboxId), std::string(CONCURRENT_CONTAINER_MAX_KEY_LENGTH, 'a'));
+    releaseLocalRegion();
+}
+
+TEST_F(ItcPlatformIfTest, locateRequestOwnershipTest1)
+{
+    /***
+     * Test scenario: locate requests belong to itc-server once they are sent. After two locates were served,
+     * two new messages must not share a buffer, which they would if a request had also been freed by the locator.
+     */
+    initialiseLocalRegion();
+    ASSERT_NE(m_itcPlatform->createMailbox("locateRequestOwnershipTest1"), ITC_MAILBOX_ID_DEFAULT);
+    auto itcServerMboxId = m_itcPlatform->createMailbox("locateRequestOwnershipTest1-itc-server");
+    ASSERT_NE(itcServerMboxId, ITC_MAILBOX_ID_DEFAULT);
+    setItcServerMboxId(itcServerMboxId);
+    
+    auto info = m_itcPlatform->locateMailboxSync("unknown", ITC_MODE_LOCATE_IN_WORLD | ITC_MODE_RECEIVE_TIMEOUT, 1000);
+    ASSERT_EQ(info.mailboxId, ITC_MAILBOX_ID_DEFAULT);
+    ASSERT_EQ(m_itcPlatform->locateMailboxAsync("unknown", ITC_MODE_LOCATE_IN_WORLD), MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK));
+    
+    auto syncReq = m_itcPlatform->receiveAny({itcServerMboxId}, {}, ITC_MODE_RECEIVE_NON_BLOCKING);
+    auto asyncReq = m_itcPlatform->receiveAny({itcServerMboxId}, {}, ITC_MODE_RECEIVE_NON_BLOCKING);
+    ASSERT_NE(syncReq, nullptr);
+    ASSERT_NE(asyncReq, nullptr);
+    ASSERT_NE(syncReq, asyncReq);
+    ASSERT_EQ(syncReq->msgno, ITC_SYSTEM_MESSAGE_LOCATE_MBOX_SYNC_IN_ITC_SERVER_REQUEST);
+    ASSERT_EQ(asyncReq->msgno, ITC_SYSTEM_MESSAGE_LOCATE_MBOX_ASYNC_IN_ITC_SERVER_REQUEST);
+    ASSERT_EQ(m_itcPlatform->deallocateMessage(syncReq), MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK));
+    ASSERT_EQ(m_itcPlatform->deallocateMessage(asyncReq), MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK));
+    
+    auto msg1 = m_itcPlatform->allocateMessage(0xAAAA0001);
+    auto msg2 = m_itcPlatform->allocateMessage(0xAAAA0002);
+    ASSERT_NE(msg1, msg2);
+    ASSERT_EQ(msg1->msgno, 0xAAAA0001);
+    m_itcPlatform->deallocateMessage(msg1);
+    m_itcPlatform->deallocateMessage(msg2);
+    releaseLocalRegion();
+}
 
+TEST_F(ItcPlatformIfTest, allocateMessageTest1)
+{
+    /***
+     * Test scenario: a message allocated for a receiver of our Region is asked for on the receiver's NUMA node,
+     * one for another Region is not, and both are sent as usual.
+     */
+    initialiseLocalRegion();
+    ASSERT_NE(m_itcPlatform->createMailbox("allocateMessageTest1"), ITC_MAILBOX_ID_DEFAULT);
+    auto receiverMboxId = m_itcPlatform->createMailbox("allocateMessageTest1-receiver");
+    ASSERT_NE(receiverMboxId, ITC_MAILBOX_ID_DEFAULT);
+    auto memManager = MemoryManager::getInstance().lock();
+    auto statistics = memManager->getStatistics();
+    
+    MailboxContactInfo receiver {receiverMboxId};
+    MailboxContactInfo otherRegionReceiver {(m_itcPlatform->m_regionId + (1 << ITC_REGION_ID_SHIFT)) | 1};
+    auto msg1 = m_itcPlatform->allocateMessage(0xAAAA0001, ITC_MESSAGE_MSGNO_SIZE, receiver);
+    auto msg2 = m_itcPlatform->allocateMessage(0xAAAA0002, ITC_MESSAGE_MSGNO_SIZE, otherRegionReceiver);
+    ASSERT_NE(msg1, nullptr);
+    ASSERT_NE(msg2, nullptr);
+    ASSERT_EQ(msg1->msgno, 0xAAAA0001);
+    ASSERT_EQ(msg2->msgno, 0xAAAA0002);
+    /* Single node machines have nothing to choose from and do not count. */
+    uint64_t nrNodeAllocs = statistics.nrNumaNodes > 1 ? 1 : 0;
+    ASSERT_EQ(memManager->getStatistics().nrNodeAllocs - statistics.nrNodeAllocs, nrNodeAllocs);
+    
+    ASSERT_EQ(m_itcPlatform->send(msg1, receiver), MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK));
+    auto receivedMsg = m_itcPlatform->receiveAny({receiverMboxId}, {}, ITC_MODE_RECEIVE_NON_BLOCKING);
+    ASSERT_EQ(receivedMsg, msg1);
+    m_itcPlatform->deallocateMessage(receivedMsg);
+    m_itcPlatform->deallocateMessage(msg2);
+    releaseLocalRegion();
+}
 
 } // namespace INTERNAL
 } // namespace ITC
\ No newline at end of file
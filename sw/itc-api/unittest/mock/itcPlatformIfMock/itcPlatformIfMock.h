@@ -21,18 +21,30 @@ public:
     MOCK_METHOD(ItcPlatformIfReturnCode, initialise, (uint32_t flags), (override));
     MOCK_METHOD(ItcPlatformIfReturnCode, release, (), (override));
     MOCK_METHOD(ItcMessageRawPtr, allocateMessage, (uint32_t msgno, size_t size), (override));
+    MOCK_METHOD(ItcMessageRawPtr, allocateMessage, (uint32_t msgno, size_t size, const MailboxContactInfo &toMbox), (override));
     MOCK_METHOD(ItcPlatformIfReturnCode, deallocateMessage, (ItcMessageRawPtr msg), (override));
-    MOCK_METHOD(itc_mailbox_id_t, createMailbox, (const std::string &name, uint32_t flags), (override));
+    MOCK_METHOD(itc_mailbox_id_t, createMailbox, (const std::string &name, uint32_t flags, const MailboxRxConfig &rxConfig), (override));
     MOCK_METHOD(ItcPlatformIfReturnCode, deleteMailbox, (itc_mailbox_id_t mboxId), (override));
     MOCK_METHOD(ItcPlatformIfReturnCode, send, (ItcMessageRawPtr msg, const MailboxContactInfo &toMbox), (override));
-    MOCK_METHOD(ItcMessageRawPtr, receive, (uint32_t mode), (override));
+    MOCK_METHOD(ItcPlatformIfReturnCode, sendBatch, (ItcMessageRawPtr *msgs, const MailboxContactInfo *toMboxes, size_t count), (override));
+    MOCK_METHOD(ItcPlatformIfReturnCode, forward, (ItcMessageRawPtr msg, const MailboxContactInfo &toMbox), (override));
+    MOCK_METHOD(ItcPlatformIfReturnCode, reply, (ItcMessageRawPtr msg, uint32_t msgno), (override));
+    MOCK_METHOD(ItcMessageRawPtr, receive, (uint32_t mode, uint32_t timeout), (override));
+    MOCK_METHOD(ItcMessageRawPtr, receiveSelective, (const std::vector<uint32_t> &filter, uint32_t mode, uint32_t timeout), (override));
+    MOCK_METHOD(size_t, receiveBatch, (ItcMessageRawPtr *out, size_t max, uint32_t mode, uint32_t timeout), (override));
+    MOCK_METHOD(ItcMessageRawPtr, receiveAny, (const std::vector<itc_mailbox_id_t> &mboxIds, const std::vector<uint32_t> &priorities, uint32_t mode, uint32_t timeout), (override));
     MOCK_METHOD(MailboxContactInfo, locateMailboxSync, (const std::string &mboxName, uint32_t mode, uint32_t timeout), (override));
     MOCK_METHOD(ItcPlatformIfReturnCode, locateMailboxAsync, (const std::string &mboxName, uint32_t mode), (override));
     MOCK_METHOD(itc_mailbox_id_t, getSender, (const ItcMessageRawPtr &msg), (override));
     MOCK_METHOD(itc_mailbox_id_t, getReceiver, (const ItcMessageRawPtr &msg), (override));
     MOCK_METHOD(size_t, getMsgSize, (const ItcMessageRawPtr &msg), (override));
+    MOCK_METHOD(ItcPlatformIfReturnCode, setMsgPriority, (ItcMessageRawPtr msg, uint32_t priority), (override));
+    MOCK_METHOD(uint32_t, getMsgPriority, (const ItcMessageRawPtr &msg), (override));
     MOCK_METHOD(int32_t, myMailboxFd, (), (override));
     MOCK_METHOD(std::string, getMailboxName, (itc_mailbox_id_t mboxId), (override));
+    MOCK_METHOD(ItcPlatformIfReturnCode, getLatencySnapshot, (itc_mailbox_id_t mboxId, MailboxLatencySnapshot &snapshot), (override));
+    MOCK_METHOD(ItcPlatformIfReturnCode, getStatistics, (itc_mailbox_id_t mboxId, MailboxStatistics &statistics), (override));
+    MOCK_METHOD(ItcPlatformIfReturnCode, getTransportStatistics, (TransportStatisticsList &statistics), (override));
 
 private:
     ItcPlatformIfMock() = default;
@@ -73,6 +73,7 @@ struct Thread
 			isRunning = std::move(other.isRunning);
 			useHighestPriority = std::move(other.useHighestPriority);
 			syncObj = std::move(other.syncObj);
+			other.tid = 0;
 			other.reset();
 		}
 	}
@@ -94,6 +95,7 @@ private:
 		{
 			CWrapperIf::getInstance().lock()->cPthreadCancel(tid);
 			CWrapperIf::getInstance().lock()->cPthreadJoin(tid, nullptr);
+			tid = 0;
 		}
 		task.taskFunc = nullptr;
 		task.taskArgs = nullptr;
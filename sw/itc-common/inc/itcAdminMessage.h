@@ -2,8 +2,11 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <algorithm>
 
 #include "itcConstant.h"
+#include "itcMemoryManager.h"
+#include "itcLatencyHistogram.h"
 #include "itc.h"
 
 namespace ITC
@@ -25,8 +28,10 @@ using ItcPlatformIfReturnCode = ItcPlatformIf::ItcPlatformIfReturnCode;
  * + Preamble:
  *      - 4 bytes: sender           : Who sends this message.
  *      - 4 bytes: receiver         : Who receives this message.
- *      - 4 bytes: flags            : To check if message is in any mailbox's rx queue.
+ *      - 4 bytes: flags            : To check if message is in any mailbox's rx queue, and its priority.
  *      - 4 bytes: size             : Size in bytes of [msgno] + [user payload].
+ *      - 32 bytes: latencyStamps   : CLOCK_MONOTONIC ns per ITC_LATENCY_STAMP_*, only if built with ITC_LATENCY_TRACE_ENABLE,
+ *                                    so all Regions talking to each other must be built the same way.
  * 
  * + Message number:
  *      - 4 bytes: msgno            : Protocol which is clearly understood between senders and receivers.
@@ -45,6 +50,9 @@ struct ItcAdminMessage
     itc_mailbox_id_t        receiver {ITC_MAILBOX_ID_DEFAULT};
     uint32_t               	flags {ITC_FLAG_DEFAULT};
     uint32_t                size {ITC_MESSAGE_MSGNO_SIZE};
+#if defined ITC_LATENCY_TRACE_ENABLE
+    uint64_t                latencyStamps[ITC_LATENCY_NUMBER_OF_STAMPS] {};
+#endif
     
     uint32_t               	msgno {ITC_MESSAGE_MSGNO_DEFAULT};
     // uint8_t                 payload[];
@@ -57,6 +65,10 @@ struct ItcAdminMessage
 #define ITC_ADMIN_MESSAGE_PREAMBLE_SIZE     (uint32_t)(offsetof(ItcAdminMessage, msgno))
 #define ITC_ADMIN_MESSAGE_MIN_SIZE          (uint32_t)(ITC_ADMIN_MESSAGE_PREAMBLE_SIZE + ITC_MESSAGE_MSGNO_SIZE + ITC_ADMIN_MESSAGE_ENDPOINT_SIZE)
 #define ITC_FLAG_MESSAGE_IN_RX_QUEUE        (uint32_t)(0x1)
+#define ITC_FLAG_MESSAGE_PRIORITY_SHIFT     (uint32_t)(8)
+#define ITC_MASK_MESSAGE_PRIORITY           (uint32_t)(0x300) /* Travels with the message to other Regions, unlike the other flags */
+
+static_assert(ITC_NUMBER_OF_MESSAGE_PRIORITIES - 1 <= (ITC_MASK_MESSAGE_PRIORITY >> ITC_FLAG_MESSAGE_PRIORITY_SHIFT), "Message priority does not fit into flags!");
 
 using ItcAdminMessageRawPtr = ItcAdminMessage *;
 
@@ -72,25 +84,75 @@ using ItcAdminMessageRawPtr = ItcAdminMessage *;
 class ItcAdminMessageHelper
 {
 public:
-    static ItcAdminMessageRawPtr allocate(uint32_t msgno, size_t size = ITC_MESSAGE_MSGNO_SIZE)
+    /* numaNode is that of the receiver if it is known already, see MemoryManager::allocate(). */
+    static ItcAdminMessageRawPtr allocate(uint32_t msgno, size_t size = ITC_MESSAGE_MSGNO_SIZE, uint32_t numaNode = MEMORY_NUMA_NODE_ANY)
     {
         if(size < ITC_MESSAGE_MSGNO_SIZE)
         {
             return nullptr;
         }
 
-        auto adminMsg = reinterpret_cast<ItcAdminMessageRawPtr>(new uint8_t[ITC_ADMIN_MESSAGE_PREAMBLE_SIZE + size + ITC_ADMIN_MESSAGE_ENDPOINT_SIZE]);
+        auto memManager = MemoryManager::getInstanceRawPtr();
+        if(!memManager) UNLIKELY
+        {
+            return nullptr;
+        }
+
+        auto adminMsg = reinterpret_cast<ItcAdminMessageRawPtr>(memManager->allocate(ITC_ADMIN_MESSAGE_PREAMBLE_SIZE + size + ITC_ADMIN_MESSAGE_ENDPOINT_SIZE, numaNode));
+        if(!adminMsg) UNLIKELY
+        {
+            return nullptr;
+        }
 
         adminMsg->msgno = msgno;
         adminMsg->sender = ITC_MAILBOX_ID_DEFAULT;
         adminMsg->receiver = ITC_MAILBOX_ID_DEFAULT;
         adminMsg->size = size;
         adminMsg->flags = ITC_FLAG_DEFAULT;
+#if defined ITC_LATENCY_TRACE_ENABLE
+        std::fill(std::begin(adminMsg->latencyStamps), std::end(adminMsg->latencyStamps), 0);
+#endif
         auto endpoint = reinterpret_cast<uint8_t *>(reinterpret_cast<uintptr_t>(&adminMsg->msgno) + size);
         *endpoint = ITC_ADMIN_MESSAGE_ENDPOINT;
         return adminMsg;
     }
     
+    static uint32_t getPriority(const ItcAdminMessage *adminMsg)
+    {
+        return (adminMsg->flags & ITC_MASK_MESSAGE_PRIORITY) >> ITC_FLAG_MESSAGE_PRIORITY_SHIFT;
+    }
+
+    static void setPriority(ItcAdminMessageRawPtr adminMsg, uint32_t priority)
+    {
+        adminMsg->flags = (adminMsg->flags & ~ITC_MASK_MESSAGE_PRIORITY) | ((priority << ITC_FLAG_MESSAGE_PRIORITY_SHIFT) & ITC_MASK_MESSAGE_PRIORITY);
+    }
+
+    /***
+     * Gets a received message ready to be sent again as it is, instead of allocating a new one and copying its payload.
+     * Only the priority is kept from the last hop, sender and receiver are set by the send path as usual.
+     */
+    static bool prepareResend(ItcAdminMessageRawPtr adminMsg)
+    {
+        if(adminMsg->flags & ITC_FLAG_MESSAGE_IN_RX_QUEUE)
+        {
+            TPT_TRACE(TRACE_ABN, "Message still in rx queue!");
+            return false;
+        }
+
+        auto endpoint = GET_ITC_ADMIN_MESSAGE_ENDPOINT(adminMsg);
+        if(*endpoint != ITC_ADMIN_MESSAGE_ENDPOINT)
+        {
+            TPT_TRACE(TRACE_ABN, SSTR("Invalid *endpoint = 0x", *endpoint & 0xFF));
+            return false;
+        }
+
+        adminMsg->flags &= ITC_MASK_MESSAGE_PRIORITY;
+#if defined ITC_LATENCY_TRACE_ENABLE
+        std::fill(std::begin(adminMsg->latencyStamps), std::end(adminMsg->latencyStamps), 0);
+#endif
+        return true;
+    }
+
     static bool deallocate(ItcAdminMessageRawPtr adminMsg)
     {
         if(!adminMsg)
@@ -111,7 +173,13 @@ public:
             return false;
         }
 
-        delete[] adminMsg;
+        auto memManager = MemoryManager::getInstanceRawPtr();
+        if(!memManager) UNLIKELY
+        {
+            return false;
+        }
+
+        memManager->deallocate(reinterpret_cast<UInt8RawPtr>(adminMsg));
         return true;
     }
 };
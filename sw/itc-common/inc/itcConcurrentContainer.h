@@ -2,11 +2,17 @@
 
 #include <atomic>
 #include <cstdint>
-#include <unordered_map>
+#include <cstring>
+#include <array>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <functional>
+#include <vector>
 
 #include "itcLockFreeQueue.h"
+#include "itcMemoryManager.h"
 
 namespace ITC
 {
@@ -21,34 +27,276 @@ namespace INTERNAL
 #define GET_ALIGNED_ENTRY(i) \
     reinterpret_cast<RawPtr>(reinterpret_cast<uint8_t *>(m_rawEntries) + (i * CACHE_LINE_BYTES))
 
+#define CONCURRENT_CONTAINER_SLOTS_PER_PAGE     (uint32_t)(MEMORY_POOL_PAGE_SIZE / CACHE_LINE_BYTES) /* Unit of NUMA placement */
+#define CONCURRENT_CONTAINER_MAX_KEY_LENGTH     (uint32_t)(64) /* Longer keys are refused by addEntryToHashMap() */
+#define CONCURRENT_CONTAINER_KEY_EMPTY          (uint64_t)(0) /* Slot never used since the last clean-up, ends every probe */
+#define CONCURRENT_CONTAINER_KEY_REMOVED        (uint64_t)(1) /* Tombstone, probes go on past it */
+
+/***
+ * Name index of ConcurrentContainer: open addressing with linear probing over twice as many slots as entries,
+ * keyed by a precomputed 64-bit hash of the name, which is stored inline in the slot.
+ * Writers are serialised by a mutex since mailboxes come and go rarely, readers never take a lock or write anything:
+ * every slot is a seqlock, so a reader retries a slot which changed underneath it. Entries never move to other slots,
+ * so a lookup always finds a name which was in the index during the whole lookup.
+ */
+template<typename RawPtr, uint32_t NUMBER_OF_SLOTS>
+class ConcurrentContainerIndex
+{
+public:
+    static_assert((NUMBER_OF_SLOTS & (NUMBER_OF_SLOTS - 1)) == 0, "Number of slots must be a power of 2!");
+    static constexpr uint32_t KEY_WORDS = CONCURRENT_CONTAINER_MAX_KEY_LENGTH / sizeof(uint64_t);
+    using KeyWords = std::array<uint64_t, KEY_WORDS>;
+
+    ConcurrentContainerIndex()
+        : m_slots(std::make_unique<Slot[]>(NUMBER_OF_SLOTS))
+    {}
+
+    bool add(std::string_view key, RawPtr entry)
+    {
+        if(key.size() > CONCURRENT_CONTAINER_MAX_KEY_LENGTH) UNLIKELY
+        {
+            return false;
+        }
+        KeyWords keyWords = toKeyWords(key);
+        uint64_t hash = getHash(key);
+        std::scoped_lock<std::mutex> lock(m_writerLock);
+        int64_t freeIndex = -1;
+        uint32_t index = hash & (NUMBER_OF_SLOTS - 1);
+        for(uint32_t probe = 0; probe < NUMBER_OF_SLOTS; ++probe, index = (index + 1) & (NUMBER_OF_SLOTS - 1))
+        {
+            Slot &slot = m_slots[index];
+            uint64_t slotHash = slot.hash.load(MEMORY_ORDER_RELAXED);
+            if(slotHash == CONCURRENT_CONTAINER_KEY_EMPTY)
+            {
+                freeIndex = freeIndex < 0 ? index : freeIndex;
+                break;
+            }
+            if(slotHash == CONCURRENT_CONTAINER_KEY_REMOVED)
+            {
+                freeIndex = freeIndex < 0 ? index : freeIndex;
+            } else if(slotHash == hash && isKeyEqual(slot, key.size(), keyWords))
+            {
+                return false;
+            }
+        }
+        if(freeIndex < 0) UNLIKELY
+        {
+            return false;
+        }
+        writeSlot(m_slots[freeIndex], hash, key.size(), keyWords, entry);
+        return true;
+    }
+
+    bool remove(std::string_view key)
+    {
+        if(key.size() > CONCURRENT_CONTAINER_MAX_KEY_LENGTH) UNLIKELY
+        {
+            return false;
+        }
+        KeyWords keyWords = toKeyWords(key);
+        uint64_t hash = getHash(key);
+        std::scoped_lock<std::mutex> lock(m_writerLock);
+        uint32_t index = hash & (NUMBER_OF_SLOTS - 1);
+        for(uint32_t probe = 0; probe < NUMBER_OF_SLOTS; ++probe, index = (index + 1) & (NUMBER_OF_SLOTS - 1))
+        {
+            Slot &slot = m_slots[index];
+            uint64_t slotHash = slot.hash.load(MEMORY_ORDER_RELAXED);
+            if(slotHash == CONCURRENT_CONTAINER_KEY_EMPTY)
+            {
+                return false;
+            }
+            if(slotHash == hash && isKeyEqual(slot, key.size(), keyWords))
+            {
+                writeSlot(slot, CONCURRENT_CONTAINER_KEY_REMOVED, 0, KeyWords {}, nullptr);
+                clearTombstones(index);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    RawPtr lookUp(std::string_view key) const
+    {
+        if(key.size() > CONCURRENT_CONTAINER_MAX_KEY_LENGTH) UNLIKELY
+        {
+            return nullptr;
+        }
+        KeyWords keyWords = toKeyWords(key);
+        uint64_t hash = getHash(key);
+        uint32_t index = hash & (NUMBER_OF_SLOTS - 1);
+        for(uint32_t probe = 0; probe < NUMBER_OF_SLOTS; ++probe, index = (index + 1) & (NUMBER_OF_SLOTS - 1))
+        {
+            const Slot &slot = m_slots[index];
+            while(true)
+            {
+                uint32_t sequence = slot.sequence.load(MEMORY_ORDER_ACQUIRE);
+                if(sequence & 1) UNLIKELY
+                {
+                    yieldProcessor();
+                    continue;
+                }
+                uint64_t slotHash = slot.hash.load(MEMORY_ORDER_RELAXED);
+                RawPtr entry = slot.entry.load(MEMORY_ORDER_RELAXED);
+                bool isMatch = slotHash == hash && isKeyEqual(slot, key.size(), keyWords);
+                std::atomic_thread_fence(MEMORY_ORDER_ACQUIRE);
+                if(slot.sequence.load(MEMORY_ORDER_RELAXED) != sequence) UNLIKELY
+                {
+                    continue;
+                }
+                if(isMatch)
+                {
+                    return entry;
+                }
+                if(slotHash == CONCURRENT_CONTAINER_KEY_EMPTY)
+                {
+                    return nullptr;
+                }
+                break;
+            }
+        }
+        return nullptr;
+    }
+
+    void clear()
+    {
+        std::scoped_lock<std::mutex> lock(m_writerLock);
+        for(uint32_t i = 0; i < NUMBER_OF_SLOTS; ++i)
+        {
+            if(m_slots[i].hash.load(MEMORY_ORDER_RELAXED) != CONCURRENT_CONTAINER_KEY_EMPTY)
+            {
+                writeSlot(m_slots[i], CONCURRENT_CONTAINER_KEY_EMPTY, 0, KeyWords {}, nullptr);
+            }
+        }
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<uint32_t>                       sequence {0}; /* Odd while a writer changes the slot */
+        std::atomic<uint32_t>                       keyLength {0};
+        std::atomic<uint64_t>                       hash {CONCURRENT_CONTAINER_KEY_EMPTY};
+        std::atomic<RawPtr>                         entry {nullptr};
+        std::array<std::atomic<uint64_t>, KEY_WORDS> key {};
+    };
+
+    static uint64_t getHash(std::string_view key)
+    {
+        uint64_t hash = std::hash<std::string_view>{}(key);
+        return hash > CONCURRENT_CONTAINER_KEY_REMOVED ? hash : hash + 2;
+    }
+
+    static KeyWords toKeyWords(std::string_view key)
+    {
+        KeyWords keyWords {};
+        std::memcpy(keyWords.data(), key.data(), key.size());
+        return keyWords;
+    }
+
+    static bool isKeyEqual(const Slot &slot, size_t keyLength, const KeyWords &keyWords)
+    {
+        if(slot.keyLength.load(MEMORY_ORDER_RELAXED) != keyLength)
+        {
+            return false;
+        }
+        for(uint32_t i = 0; i * sizeof(uint64_t) < keyLength; ++i)
+        {
+            if(slot.key[i].load(MEMORY_ORDER_RELAXED) != keyWords[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static void writeSlot(Slot &slot, uint64_t hash, size_t keyLength, const KeyWords &keyWords, RawPtr entry)
+    {
+        uint32_t sequence = slot.sequence.load(MEMORY_ORDER_RELAXED);
+        slot.sequence.store(sequence + 1, MEMORY_ORDER_RELAXED);
+        std::atomic_thread_fence(MEMORY_ORDER_RELEASE);
+        slot.hash.store(hash, MEMORY_ORDER_RELAXED);
+        slot.keyLength.store(keyLength, MEMORY_ORDER_RELAXED);
+        slot.entry.store(entry, MEMORY_ORDER_RELAXED);
+        for(uint32_t i = 0; i < KEY_WORDS; ++i)
+        {
+            slot.key[i].store(keyWords[i], MEMORY_ORDER_RELAXED);
+        }
+        slot.sequence.store(sequence + 2, MEMORY_ORDER_RELEASE);
+    }
+
+    /***
+     * Tombstones right in front of an empty slot are not part of any probe sequence any more, make them empty again,
+     * so that lookups of unknown names stay short however often mailboxes come and go.
+     */
+    void clearTombstones(uint32_t index)
+    {
+        if(m_slots[(index + 1) & (NUMBER_OF_SLOTS - 1)].hash.load(MEMORY_ORDER_RELAXED) != CONCURRENT_CONTAINER_KEY_EMPTY)
+        {
+            return;
+        }
+        for(uint32_t probe = 0; probe < NUMBER_OF_SLOTS && m_slots[index].hash.load(MEMORY_ORDER_RELAXED) == CONCURRENT_CONTAINER_KEY_REMOVED; ++probe)
+        {
+            writeSlot(m_slots[index], CONCURRENT_CONTAINER_KEY_EMPTY, 0, KeyWords {}, nullptr);
+            index = (index - 1) & (NUMBER_OF_SLOTS - 1);
+        }
+    }
+
+private:
+    std::unique_ptr<Slot[]> m_slots;
+    std::mutex m_writerLock;
+};
+
 
 template<typename T, uint32_t SIZE>
 class ConcurrentContainer
 {
 public:
     using RawPtr = T *;
+    using InactiveQueue = LockFreeQueue<RawPtr, SIZE, nullptr, MINIMIZE_CONTENTION, MAXIMIZE_THROUGHPUT, !IS_TOTAL_ORDER, !IS_SPSC>;
     
     ConcurrentContainer(std::function<void(T *, uint32_t)> initializer)
     {
         
         static_assert(sizeof(T) <= 64, "Otherwise, cannot apply lock-free for this type T!");
-        m_rawEntries = new uint8_t[SIZE * CACHE_LINE_BYTES];
+        /* Page aligned, and on huge pages if configured, every lookup of a mailbox by id lands somewhere in here. */
+        m_tableParams.mode = MEMORY_ALLOCATOR_MODE_2;
+        m_rawEntries = MemoryAllocator::allocate(SIZE * CACHE_LINE_BYTES, m_tableParams);
+        if(!m_rawEntries)
+        {
+            m_tableParams.mode = MEMORY_ALLOCATOR_MODE_1;
+            m_rawEntries = MemoryAllocator::allocate(SIZE * CACHE_LINE_BYTES, m_tableParams);
+        }
+
+        /* Whole pages of slots per NUMA node, bound there before anything touches them. */
+        uint32_t nrNodes = m_tableParams.mode == MEMORY_ALLOCATOR_MODE_2 ? NumaTopology::getNumberOfNodes() : 1;
+        m_slotsPerNode = ((SIZE + nrNodes - 1) / nrNodes + CONCURRENT_CONTAINER_SLOTS_PER_PAGE - 1) / CONCURRENT_CONTAINER_SLOTS_PER_PAGE * CONCURRENT_CONTAINER_SLOTS_PER_PAGE;
+        for(uint32_t node = 0; node * m_slotsPerNode < SIZE; ++node)
+        {
+            if(nrNodes > 1)
+            {
+                NumaTopology::bindToNode(GET_ALIGNED_ENTRY(node * m_slotsPerNode), std::min(m_slotsPerNode, SIZE - node * m_slotsPerNode) * CACHE_LINE_BYTES, node);
+            }
+            m_inactiveEntries.push_back(std::make_unique<InactiveQueue>());
+        }
+
         for(uint32_t i = 0; i < SIZE; ++i)
         {
             RawPtr entry = GET_ALIGNED_ENTRY(i);
             entry = new (reinterpret_cast<uint8_t *>(entry)) T();
             initializer(entry, i);
-            m_inactiveEntries.tryPush(entry);
+            m_inactiveEntries[getNode(i)]->tryPush(entry);
         }
         
     }
     
     ~ConcurrentContainer()
     {
-        delete[] m_rawEntries;
-        while(!m_inactiveEntries.empty())
+        MemoryAllocator::deallocate(m_tableParams);
+        for(auto &inactiveEntries : m_inactiveEntries)
         {
-            m_inactiveEntries.pop();
+            while(!inactiveEntries->empty())
+            {
+                inactiveEntries->pop();
+            }
         }
         m_activeEntries.clear();
     }
@@ -58,62 +306,80 @@ public:
         return GET_ALIGNED_ENTRY(index);
     }
     
+    uint32_t getIndex(RawPtr entry) const
+    {
+        return static_cast<uint32_t>((reinterpret_cast<uint8_t *>(entry) - m_rawEntries) / CACHE_LINE_BYTES);
+    }
+    
+    /* False if key is already there or longer than CONCURRENT_CONTAINER_MAX_KEY_LENGTH. */
     bool addEntryToHashMap(const std::string &key, RawPtr entry)
     {
-        std::unique_lock lock(m_activeEntriesLock);
-        auto found = m_activeEntries.find(key);
-        if(found != m_activeEntries.cend()) UNLIKELY
-        {
-            return false;
-        }
-        m_activeEntries.emplace(key, entry);
-        return true;
+        return m_activeEntries.add(key, entry);
     }
     
     bool removeEntryFromHashMap(const std::string &key)
     {
-        std::unique_lock lock(m_activeEntriesLock);
-        auto found = m_activeEntries.find(key);
-        if(found == m_activeEntries.cend()) UNLIKELY
-        {
-            return false;
-        }
-        m_activeEntries.erase(key);
-        return true;
+        return m_activeEntries.remove(key);
     }
     
-    RawPtr lookUpFromHashMap(const std::string &key)
+    /* Lock-free, so any number of threads may look up names at the same time. */
+    RawPtr lookUpFromHashMap(const std::string &key) const
     {
-        std::unique_lock lock(m_activeEntriesLock);
-        auto found = m_activeEntries.find(key);
-        if(found != m_activeEntries.cend()) UNLIKELY
-        {
-            return nullptr;
-        }
-        return found->second;
+        return m_activeEntries.lookUp(key);
     }
     
     bool tryPushIntoQueue(RawPtr entry)
     {
-        return m_inactiveEntries.tryPush(entry);
+        return m_inactiveEntries[getNode(getIndex(entry))]->tryPush(entry);
     }
     
+    /***
+     * A slot on the calling thread's NUMA node if there is one left, since whoever creates a mailbox is the one
+     * receiving from it. Other nodes are only tried after that, and only waited for if none has any.
+     */
     RawPtr tryPopFromQueue()
     {
-        return m_inactiveEntries.pop();
+        if(m_inactiveEntries.size() == 1) LIKELY
+        {
+            return m_inactiveEntries.front()->pop();
+        }
+
+        uint32_t node = NumaTopology::getCurrentNode() % m_inactiveEntries.size();
+        RawPtr entry {nullptr};
+        for(uint32_t i = 0; i < m_inactiveEntries.size(); ++i)
+        {
+            if(m_inactiveEntries[(node + i) % m_inactiveEntries.size()]->tryPop(entry))
+            {
+                return entry;
+            }
+        }
+        return m_inactiveEntries[node]->pop();
+    }
+    
+    /* NUMA node the slot at index was placed on, 0 on machines without NUMA. */
+    uint32_t getNode(uint32_t index) const
+    {
+        return index / m_slotsPerNode;
     }
     
     uint32_t size()
     {
-        return SIZE - m_inactiveEntries.size();
+        uint32_t nrInactiveEntries {0};
+        for(const auto &inactiveEntries : m_inactiveEntries)
+        {
+            nrInactiveEntries += inactiveEntries->size();
+        }
+        return SIZE - nrInactiveEntries;
     }
         
 private:
     uint8_t *m_rawEntries {nullptr};
-    LockFreeQueue<RawPtr, SIZE, nullptr, MINIMIZE_CONTENTION, MAXIMIZE_THROUGHPUT, !IS_TOTAL_ORDER, !IS_SPSC> m_inactiveEntries;
+    MemoryAllocatorParams m_tableParams;
+    uint32_t m_slotsPerNode {SIZE};
+    /* Free slots, one queue per NUMA node which got any, indexed by node. */
+    std::vector<std::unique_ptr<InactiveQueue>> m_inactiveEntries;
     
-    std::mutex m_activeEntriesLock;
-    std::unordered_map<std::string, RawPtr> m_activeEntries;
+    ConcurrentContainerIndex<RawPtr, roundUpToPowerOf2(2 * SIZE)> m_activeEntries;
 };
 
 } // namespace INTERNAL
@@ -3,8 +3,8 @@
 #include <cstdint>
 #include <cmath>
 #include <limits>
+#include <atomic>
 
-#include "itcAdminMessage.h"
 #include "itc.h"
 
 namespace ITC
@@ -40,26 +40,40 @@ namespace INTERNAL
 #define ITC_REGION_ID_SHIFT                                         (uint32_t)(20) /* Right shift by 20 bits to get region ID */
 #define ITC_MAX_SOCKET_RX_BUFFER_SIZE                               (uint32_t)(1024)
 #define ITC_MAX_SUPPORTED_REGIONS                                   (uint32_t)(255)
+#define ITC_BATCH_CHUNK_SIZE                                        (uint32_t)(64) /* Messages handled per transport operation in sendBatch()/receiveBatch() */
 #define ITC_PATH_ITC_DIRECTORY_POSITION                             (size_t)(2) /* 0th is '/', 1st is '/tmp', so 2nd is '/tmp/itc' */
 #define ITC_PATH_ITC_SERVER_SOCKET                                  "/tmp/itc/itc-server/itc-server"
-// #define ITC_PATH_ITC_SERVER_PROGRAM                                 "/usr/local/bin/itc-server"
-#define ITC_PATH_ITC_SERVER_PROGRAM                                 "/home/etrugia/workspace/test/daemon"
+#define ITC_PATH_ITC_SERVER_LOCK_FILE                               "/tmp/itc/itc-server/itc-server.lock"
+#define ITC_PATH_ITC_SERVER_PROGRAM                                 "/usr/local/bin/itc-server"
+#define ITC_ITC_SERVER_LOCATE_TIMEOUT                               (uint32_t)(2000) /* ms, how long a Region waits for a just started itc-server */
+#define ITC_ITC_SERVER_LOCATE_RETRY_INTERVAL                        (uint32_t)(1000) /* us */
 
 #define ITC_NR_INTERNAL_USED_MAILBOXES                              (size_t)(1)
 
+/***
+ * getInstance() only takes m_singletonMutex until the instance has been constructed,
+ * afterwards m_instanceRawPtr lets every caller skip the lock.
+ */
 #define SINGLETON_DECLARATION(ClassName) \
     static std::shared_ptr<ClassName> m_instance; \
-	static std::mutex m_singletonMutex;
+	static std::mutex m_singletonMutex; \
+	static std::atomic<ClassName *> m_instanceRawPtr;
 
 #define SINGLETON_DEFINITION(ClassName) \
     std::shared_ptr<ClassName> ClassName::m_instance = nullptr; \
     std::mutex ClassName::m_singletonMutex; \
+    std::atomic<ClassName *> ClassName::m_instanceRawPtr {nullptr}; \
     std::weak_ptr<ClassName> ClassName::getInstance() \
     { \
+        if (m_instanceRawPtr.load(std::memory_order_acquire) && m_instance) LIKELY \
+        { \
+            return m_instance; \
+        } \
         std::scoped_lock<std::mutex> lock(m_singletonMutex); \
         if (!m_instance) \
         { \
             m_instance.reset(new ClassName); \
+            m_instanceRawPtr.store(m_instance.get(), std::memory_order_release); \
         } \
         return m_instance; \
     }
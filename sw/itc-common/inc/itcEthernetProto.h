@@ -33,6 +33,17 @@ struct itc_ethernet_message_locate_itc_server_reply
 	itc_mailbox_id_t	itcServerMboxId {ITC_MAILBOX_ID_DEFAULT};
 };
 
+/***
+ * Every message itc-proxy sends to another World over TCP is preceded by this header, in network byte order.
+ * It is followed by length bytes of the message flattened as [preamble] [msgno] [user payload] [endpoint],
+ * see ItcAdminMessage, which is sent as is, so both Worlds must have the same byte order and build options.
+ */
+struct itc_ethernet_proxy_frame_header
+{
+	uint32_t			length {0};
+	uint32_t			fromWorldId {0};
+};
+
 
 } // namespace INTERNAL
 } // namespace ITC
\ No newline at end of file
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <array>
+#include <ctime>
+
+#include "itc.h"
+#include "itcConstant.h"
+#include "itcLockFreeQueue.h"
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+using namespace ITC::PROVIDED;
+
+/***
+ * Indexes into ItcAdminMessage::latencyStamps, which only exists if built with ITC_LATENCY_TRACE_ENABLE.
+ * A stamp stays 0 if the message never took that hop, e.g. REGION_TX/RX inside a Region.
+ */
+#define ITC_LATENCY_STAMP_SEND                  (uint32_t)(0) /* ItcPlatform::send()/sendBatch() */
+#define ITC_LATENCY_STAMP_REGION_TX             (uint32_t)(1) /* Handed to SysV message queue or POSIX shm */
+#define ITC_LATENCY_STAMP_REGION_RX             (uint32_t)(2) /* Picked up by the receiving Region's rx thread */
+#define ITC_LATENCY_STAMP_MAILBOX_PUSH          (uint32_t)(3) /* ItcMailbox::push()/pushBatch() */
+#define ITC_LATENCY_NUMBER_OF_STAMPS            (uint32_t)(4)
+
+#define ITC_LATENCY_HISTOGRAM_SUB_BUCKET_BITS   (uint32_t)(3) /* 8 buckets per power of two, i.e. at most 12.5% too high */
+#define ITC_LATENCY_HISTOGRAM_MAX_BITS          (uint32_t)(36) /* ~68s, anything longer ends up in the last bucket */
+
+#if defined ITC_LATENCY_TRACE_ENABLE
+#define ITC_LATENCY_STAMP(adminMsg, stamp)      ((adminMsg)->latencyStamps[stamp] = getMonotonicTimeNs())
+#else
+#define ITC_LATENCY_STAMP(adminMsg, stamp)
+#endif
+
+inline uint64_t getMonotonicTimeNs()
+{
+    struct timespec now;
+    ::clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+/***
+ * HDR-style histogram: values below 2^SUB_BUCKET_BITS get their own bucket, every power of two above
+ * is split into 2^SUB_BUCKET_BITS linear buckets. Any thread may record() and snapshot() concurrently,
+ * each sample costs a handful of relaxed atomic operations and no allocation.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr uint32_t SUB_BUCKETS = 1 << ITC_LATENCY_HISTOGRAM_SUB_BUCKET_BITS;
+    static constexpr uint32_t NUMBER_OF_BUCKETS = (ITC_LATENCY_HISTOGRAM_MAX_BITS - ITC_LATENCY_HISTOGRAM_SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    static uint32_t getBucketIndex(uint64_t value)
+    {
+        if(value < SUB_BUCKETS)
+        {
+            return static_cast<uint32_t>(value);
+        }
+        uint32_t msb = 63 - __builtin_clzll(value);
+        if(msb >= ITC_LATENCY_HISTOGRAM_MAX_BITS) UNLIKELY
+        {
+            return NUMBER_OF_BUCKETS - 1;
+        }
+        uint32_t shift = msb - ITC_LATENCY_HISTOGRAM_SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + static_cast<uint32_t>((value >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    /* Highest value which falls into the bucket. */
+    static uint64_t getBucketUpperBound(uint32_t index)
+    {
+        if(index < SUB_BUCKETS)
+        {
+            return index;
+        }
+        uint32_t shift = index / SUB_BUCKETS - 1;
+        uint64_t subBucket = index % SUB_BUCKETS;
+        return ((SUB_BUCKETS + subBucket + 1) << shift) - 1;
+    }
+
+    void record(uint64_t value)
+    {
+        m_buckets[getBucketIndex(value)].fetch_add(1, MEMORY_ORDER_RELAXED);
+        m_sum.fetch_add(value, MEMORY_ORDER_RELAXED);
+
+        uint64_t min = m_min.load(MEMORY_ORDER_RELAXED);
+        while(value < min && !m_min.compare_exchange_weak(min, value, MEMORY_ORDER_RELAXED));
+        uint64_t max = m_max.load(MEMORY_ORDER_RELAXED);
+        while(value > max && !m_max.compare_exchange_weak(max, value, MEMORY_ORDER_RELAXED));
+    }
+
+    /* Not an atomic cut across buckets, samples recorded meanwhile may or may not be in it. */
+    LatencyHistogramSnapshot snapshot() const
+    {
+        LatencyHistogramSnapshot result;
+        for(uint32_t i = 0; i < NUMBER_OF_BUCKETS; ++i)
+        {
+            uint64_t nrSamples = m_buckets[i].load(MEMORY_ORDER_RELAXED);
+            if(nrSamples > 0)
+            {
+                result.buckets.emplace_back(getBucketUpperBound(i), nrSamples);
+                result.count += nrSamples;
+            }
+        }
+        result.sum = m_sum.load(MEMORY_ORDER_RELAXED);
+        result.min = result.count ? m_min.load(MEMORY_ORDER_RELAXED) : 0;
+        result.max = m_max.load(MEMORY_ORDER_RELAXED);
+        return result;
+    }
+
+    void reset()
+    {
+        for(auto &bucket : m_buckets)
+        {
+            bucket.store(0, MEMORY_ORDER_RELAXED);
+        }
+        m_sum.store(0, MEMORY_ORDER_RELAXED);
+        m_min.store(UINT64_MAX, MEMORY_ORDER_RELAXED);
+        m_max.store(0, MEMORY_ORDER_RELAXED);
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, NUMBER_OF_BUCKETS> m_buckets {};
+    std::atomic<uint64_t> m_sum {0};
+    std::atomic<uint64_t> m_min {UINT64_MAX};
+    std::atomic<uint64_t> m_max {0};
+};
+
+using ItcMailboxLatencyStats = std::array<LatencyHistogram, ITC_LATENCY_NUMBER_OF_STAGES>;
+
+} // namespace INTERNAL
+} // namespace ITC
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <string>
+#include <unordered_map>
+
+#include "itc.h"
+#include "itcConstant.h"
+#include "itcLockFreeQueue.h"
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+using namespace ITC::PROVIDED;
+
+#define ITC_LOCATE_CACHE_MAX_ENTRIES                (size_t)(256) /* Per thread, the cache starts over once full */
+
+/***
+ * Per-thread cache of mailbox name -> MailboxContactInfo, filled with what itc-server answered to locateMailboxSync().
+ * Only positive answers are cached. Creating a mailbox never makes them stale, deleting one does, so every mailbox
+ * deletion in this process and every deletion which itc-server relays to this Region bumps one process-wide generation.
+ * Each thread compares the generation on lookUp() and drops all its entries once it moved on, so a hit costs one
+ * acquire load plus a hash lookup and invalidating never touches other threads' caches.
+ */
+class LocateCache
+{
+public:
+    static uint64_t getGeneration()
+    {
+        return getGenerationCounter().load(MEMORY_ORDER_ACQUIRE);
+    }
+
+    static void invalidateAll()
+    {
+        getGenerationCounter().fetch_add(1, MEMORY_ORDER_RELEASE);
+    }
+
+    bool lookUp(const std::string &mboxName, uint32_t locateMode, MailboxContactInfo &info)
+    {
+        uint64_t generation = getGeneration();
+        if(generation != m_generation) UNLIKELY
+        {
+            m_entries.clear();
+            m_generation = generation;
+            return false;
+        }
+
+        auto it = m_entries.find(mboxName);
+        if(it == m_entries.end() || it->second.locateMode != locateMode)
+        {
+            return false;
+        }
+        info = it->second.info;
+        return true;
+    }
+
+    /* generation must be taken before asking itc-server, so that a deletion racing with the answer is never cached. */
+    void insert(const std::string &mboxName, uint32_t locateMode, const MailboxContactInfo &info, uint64_t generation)
+    {
+        if(generation != getGeneration())
+        {
+            return;
+        }
+        if(generation != m_generation || m_entries.size() >= ITC_LOCATE_CACHE_MAX_ENTRIES)
+        {
+            m_entries.clear();
+            m_generation = generation;
+        }
+        m_entries.insert_or_assign(mboxName, Entry {info, locateMode});
+    }
+
+    size_t size() const
+    {
+        return m_entries.size();
+    }
+
+private:
+    struct Entry
+    {
+        MailboxContactInfo info;
+        uint32_t locateMode {ITC_MODE_LOCATE_IN_ALL};
+    };
+
+    static std::atomic<uint64_t> &getGenerationCounter()
+    {
+        static std::atomic<uint64_t> generation {0};
+        return generation;
+    }
+
+    std::unordered_map<std::string, Entry> m_entries;
+    uint64_t m_generation {0};
+};
+
+} // namespace INTERNAL
+} // namespace ITC
@@ -298,6 +298,38 @@ public:
         return true;
     }
 
+    /***
+     * All-or-nothing: claims count consecutive slots with a single head advance,
+     * so the elements also stay consecutive against other producers.
+     */
+    template<class T>
+    ALWAYS_INLINE bool tryPushBatch(const T *elements, uint32_t count) noexcept
+    {
+        auto head = m_head.load(MEMORY_ORDER_RELAXED);
+        if(DerivedClass::m_isSPSC)
+        {
+            if(static_cast<int32_t>(head + count - m_tail.load(MEMORY_ORDER_RELAXED)) > static_cast<int32_t>(static_cast<DerivedClass &>(*this).m_size))
+            {
+                return false;
+            }
+            m_head.store(head + count, MEMORY_ORDER_RELAXED);
+        }
+        else {
+            do {
+                if(static_cast<int32_t>(head + count - m_tail.load(MEMORY_ORDER_RELAXED)) > static_cast<int32_t>(static_cast<DerivedClass &>(*this).m_size))
+                {
+                    return false;
+                }
+            } while(C_UNLIKELY(!m_head.compare_exchange_weak(head, head + count, MEMORY_ORDER_RELAXED, MEMORY_ORDER_RELAXED)));
+        }
+
+        for(uint32_t i = 0; i < count; ++i)
+        {
+            static_cast<DerivedClass &>(*this).doPush(elements[i], head + i);
+        }
+        return true;
+    }
+
     template<class T>
     ALWAYS_INLINE bool tryPop(T& element) noexcept
     {
@@ -324,6 +356,42 @@ public:
         return true;
     }
 
+    /***
+     * Claims up to maxCount consecutive elements with a single tail advance.
+     * Returns how many were popped into elements, 0 if the queue is empty.
+     */
+    template<class T>
+    ALWAYS_INLINE uint32_t tryPopBatch(T *elements, uint32_t maxCount) noexcept
+    {
+        auto tail = m_tail.load(MEMORY_ORDER_RELAXED);
+        uint32_t count;
+        if(DerivedClass::m_isSPSC)
+        {
+            count = std::min<int32_t>(std::max(static_cast<int32_t>(m_head.load(MEMORY_ORDER_RELAXED) - tail), 0), maxCount);
+            if(count == 0)
+            {
+                return 0;
+            }
+            m_tail.store(tail + count, MEMORY_ORDER_RELAXED);
+        } else
+        {
+            do
+            {
+                count = std::min<int32_t>(std::max(static_cast<int32_t>(m_head.load(MEMORY_ORDER_RELAXED) - tail), 0), maxCount);
+                if(count == 0)
+                {
+                    return 0;
+                }
+            } while(C_UNLIKELY(!m_tail.compare_exchange_weak(tail, tail + count, MEMORY_ORDER_RELAXED, MEMORY_ORDER_RELAXED)));
+        }
+
+        for(uint32_t i = 0; i < count; ++i)
+        {
+            elements[i] = static_cast<DerivedClass &>(*this).doPop(tail + i);
+        }
+        return count;
+    }
+
     template<class T>
     ALWAYS_INLINE void push(T &&element) noexcept
     {
@@ -340,6 +408,25 @@ public:
         static_cast<DerivedClass &>(*this).doPush(std::forward<T>(element), head);
     }
 
+    template<class T>
+    ALWAYS_INLINE void pushBatch(const T *elements, uint32_t count) noexcept
+    {
+        uint32_t head;
+        if(DerivedClass::m_isSPSC)
+        {
+            head = m_head.load(MEMORY_ORDER_RELAXED);
+            m_head.store(head + count, MEMORY_ORDER_RELAXED);
+        } else
+        {
+            constexpr auto memoryOrder = DerivedClass::m_isTotalOrder ? std::memory_order_seq_cst : std::memory_order_relaxed;
+            head = m_head.fetch_add(count, memoryOrder);
+        }
+        for(uint32_t i = 0; i < count; ++i)
+        {
+            static_cast<DerivedClass &>(*this).doPush(elements[i], head + i);
+        }
+    }
+
     ALWAYS_INLINE auto pop() noexcept
     {
         uint32_t tail;
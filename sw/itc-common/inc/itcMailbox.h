@@ -4,16 +4,26 @@
 #include <memory>
 #include <string>
 #include <queue>
+#include <deque>
+#include <vector>
+#include <mutex>
 #include <functional>
+#include <utility>
+#include <ctime>
+
+#include <unistd.h>
 
 // #include <enumUtils.h>
 
 #include "itc.h"
 #include "itcConstant.h"
+#include "itcAdminMessage.h"
 #include "itcSyncObject.h"
 #include "itcCWrapperIf.h"
 #include "itcMutex.h"
 #include "itcLockFreeQueue.h"
+#include "itcLatencyHistogram.h"
+#include "itcStatistics.h"
 
 #include <gtest/gtest.h>
 
@@ -30,20 +40,89 @@ using namespace ITC::PROVIDED;
 
 #define ITC_FLAG_MAILBOX_IN_RX      			(uint32_t)(0x1)
 #define ITC_MAILBOX_RX_MESSAGE_QUEUE_SIZE      	(uint32_t)(1024)
+#define ITC_MAILBOX_RX_SPIN_COUNT      			(uint32_t)(1024) /* Number of polls before a blocking receiver parks itself. */
+#define ITC_MAILBOX_RX_AWAKE      				(uint32_t)(0)
+#define ITC_MAILBOX_RX_PARKED      				(uint32_t)(1)
+#define ITC_MAILBOX_RX_FD_HANDED_OUT			(uint8_t)(0x01) /* getMboxFd() was called, the fd may be polled at any time. */
+#define ITC_MAILBOX_RX_FD_POLLED				(uint8_t)(0x02) /* popAny() sleeps in ppoll() on the fd. */
+
+/* Indexes into ItcMailboxStatistics::counters */
+#define ITC_MAILBOX_COUNTER_SENT_MSGS      		(uint32_t)(0)
+#define ITC_MAILBOX_COUNTER_ENQUEUED_MSGS      	(uint32_t)(1)
+#define ITC_MAILBOX_COUNTER_RECEIVED_MSGS      	(uint32_t)(2)
+#define ITC_MAILBOX_NUMBER_OF_COUNTERS      	(uint32_t)(3)
+
+static_assert(ITC_MAILBOX_RX_CAPACITY_DEFAULT == ITC_MAILBOX_RX_MESSAGE_QUEUE_SIZE, "Default capacity must be the whole rx queue!");
+
+using ItcMailboxRxQueue = LockFreeQueue<ItcAdminMessageRawPtr, ITC_MAILBOX_RX_MESSAGE_QUEUE_SIZE, nullptr, MINIMIZE_CONTENTION, MAXIMIZE_THROUGHPUT, !IS_TOTAL_ORDER, !IS_SPSC>;
+
+/***
+ * Only exists for mailboxes created with a non-default MailboxRxConfig, so the default push() stays a plain queue push.
+ * With ITC_MAILBOX_RX_OVERFLOW_GROW, messages which do not fit into the rx queue are appended to overflowMsgs.
+ * As long as overflowMsgs is not empty, every sender appends there too, and the receiver only takes from it
+ * once the rx queue is empty, so order between a given sender and receiver is kept.
+ */
+struct ItcMailboxRxControl
+{
+	MailboxRxConfig 					config;
+	std::atomic<uint32_t> 				nrOverflowMsgs {0};
+	std::atomic_bool 					isAboveHighWatermark {false};
+	std::atomic<uint64_t> 				nrHighWatermarkHits {0};
+	std::atomic<uint64_t> 				nrDroppedMsgs {0};
+	std::atomic<uint64_t> 				nrRejectedMsgs {0};
+	std::mutex 							overflowMutex;
+	std::deque<ItcAdminMessageRawPtr> 	overflowMsgs;
+};
+
+/***
+ * Rx queues for messages above ITC_MESSAGE_PRIORITY_DEFAULT, those keep using m_rxMsgQueue. queues[priority - 1] is only
+ * allocated by the first sender of that priority, so a mailbox which never sees priorities pays nothing but this block.
+ * Bit priority of occupancy is set by senders after pushing and cleared by the receiver once it finds that queue drained,
+ * so the receiver goes straight to the highest non-empty queue, and only loads occupancy if there is no priority traffic.
+ */
+struct ItcMailboxPriorityQueues
+{
+	std::atomic<uint32_t> 													occupancy {0};
+	std::array<std::atomic<ItcMailboxRxQueue *>, ITC_NUMBER_OF_MESSAGE_PRIORITIES - 1> 	queues {};
+
+	~ItcMailboxPriorityQueues()
+	{
+		for(auto &queue : queues)
+		{
+			delete queue.load(MEMORY_ORDER_RELAXED);
+		}
+	}
+};
+
+/***
+ * Created by the first setState(true) and reset by every later one, kept out of ItcMailbox to keep it small.
+ * Senders bump their own shard of counters, maxQueueDepth and the latency histograms are only written by the receiver.
+ */
+struct ItcMailboxStatistics
+{
+	ShardedCounters<ITC_MAILBOX_NUMBER_OF_COUNTERS> 	counters;
+	alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> 	maxQueueDepth {0};
+#if defined ITC_LATENCY_TRACE_ENABLE
+	ItcMailboxLatencyStats 								latencyStats;
+#endif
+};
 
 /* To enable lock-free data structure, never make sizeof(ItcMailbox) > 64 bytes. */
 class ItcMailbox
 {
 public:
+	/* The rx queue is only created by the first setState(true), most of the ITC_MAX_SUPPORTED_MAILBOXES never get there. */
 	ItcMailbox(uint32_t flags = ITC_FLAG_DEFAULT)
 		:  m_flags(flags)
-	{
-		m_rxMsgQueue = std::make_unique<LockFreeQueue<ItcAdminMessageRawPtr, ITC_MAILBOX_RX_MESSAGE_QUEUE_SIZE, nullptr, MINIMIZE_CONTENTION, MAXIMIZE_THROUGHPUT, !IS_TOTAL_ORDER, !IS_SPSC>>();
-	}
+	{}
 	
 	~ItcMailbox()
 	{
 		setState(false);
+		if(m_rxFd >= 0)
+		{
+			::close(m_rxFd);
+		}
 	}
 	
 	ItcMailbox(const ItcMailbox &other)
@@ -66,6 +145,11 @@ public:
 			m_mailboxId = std::move(other.m_mailboxId);
 			m_flags = std::move(other.m_flags);
 			m_rxMsgQueue = std::move(other.m_rxMsgQueue);
+			m_rxFd = std::exchange(other.m_rxFd, -1);
+			m_deferredMsgs = std::move(other.m_deferredMsgs);
+			m_rxControl = std::move(other.m_rxControl);
+			m_statistics = std::move(other.m_statistics);
+			m_priorityQueues = std::move(other.m_priorityQueues);
 		}
 	}
 	ItcMailbox &operator=(ItcMailbox &&other) noexcept
@@ -73,9 +157,18 @@ public:
 		if(this != &other)
 		{
 			setState(false);
+			if(m_rxFd >= 0)
+			{
+				::close(m_rxFd);
+			}
 			m_mailboxId = std::move(other.m_mailboxId);
 			m_flags = std::move(other.m_flags);
 			m_rxMsgQueue = std::move(other.m_rxMsgQueue);
+			m_rxFd = std::exchange(other.m_rxFd, -1);
+			m_deferredMsgs = std::move(other.m_deferredMsgs);
+			m_rxControl = std::move(other.m_rxControl);
+			m_statistics = std::move(other.m_statistics);
+			m_priorityQueues = std::move(other.m_priorityQueues);
 		}
 		return *this;
 	}
@@ -90,24 +183,120 @@ public:
         return !(*this == other);
     }
 	
+	/***
+	 * False if the mailbox is inactive, or full with ITC_MAILBOX_RX_OVERFLOW_REJECT. Then msg is still the caller's.
+	 * Messages above ITC_MESSAGE_PRIORITY_DEFAULT go into their own rx queue, the overflow policy does not apply to them.
+	 */
 	bool push(ItcAdminMessageRawPtr msg);
-	/* Default is blocking mode. */
-	ItcAdminMessageRawPtr pop(uint32_t mode = ITC_MODE_DEFAULT);
+	/***
+	 * Same as push() for count messages, but with a single queue operation and at most one wake-up.
+	 * Returns how many of the first messages were taken, the rest are still the caller's.
+	 */
+	uint32_t pushBatch(const ItcAdminMessageRawPtr *msgs, uint32_t count);
+	/***
+	 * All pop functions take from the highest priority rx queue which has a message, see ItcMailboxPriorityQueues.
+	 * Messages put aside by popSelective() are older than the queued ones of the same priority, they come first among those.
+	 * Default is blocking mode: spin for ITC_MAILBOX_RX_SPIN_COUNT polls, then park on a futex
+	 * until push() or setState(false) wakes us up. Senders only pay for a syscall if we are really parked.
+	 * With ITC_MODE_RECEIVE_TIMEOUT, the futex wait ends at the latest timeout microseconds (CLOCK_MONOTONIC) after the call.
+	 */
+	ItcAdminMessageRawPtr pop(uint32_t mode = ITC_MODE_DEFAULT, uint32_t timeout = 0);
+	/***
+	 * Takes up to maxCount messages with a single queue operation, returns how many were written into msgs.
+	 * Blocks like pop() only while nothing at all is pending.
+	 */
+	uint32_t popBatch(ItcAdminMessageRawPtr *msgs, uint32_t maxCount, uint32_t mode = ITC_MODE_DEFAULT, uint32_t timeout = 0);
+	/***
+	 * Returns the oldest message whose msgno is in filter, an empty filter matches all.
+	 * Other messages popped on the way are put aside in m_deferredMsgs, which only the receiving thread touches,
+	 * and are handed out first, in order, by later pop()/popBatch()/popSelective() calls.
+	 */
+	ItcAdminMessageRawPtr popSelective(const std::vector<uint32_t> &filter, uint32_t mode = ITC_MODE_DEFAULT, uint32_t timeout = 0);
+	/***
+	 * Waits on count mailboxes of the calling thread at once, mboxes[0] having the highest priority.
+	 * Always returns the next message of the first mailbox which has one, so a busy high priority mailbox
+	 * starves the others. Spins like pop(), then sleeps in a single ppoll() on all mailbox fds.
+	 */
+	static ItcAdminMessageRawPtr popAny(ItcMailbox *const *mboxes, uint32_t count, uint32_t mode = ITC_MODE_DEFAULT, uint32_t timeout = 0);
 	void setState(bool newState);
+	/***
+	 * Must be called before the mailbox id is handed out, i.e. before any sender can push() to us.
+	 * A default MailboxRxConfig drops the rx control and goes back to the plain rx queue.
+	 */
+	void setRxConfig(const MailboxRxConfig &config);
+	bool isActive() const;
+	/* Messages in all rx queues and the overflow segment, not counting the ones put aside by popSelective(). */
+	uint32_t getNrPendingMsgs() const;
+	/***
+	 * Valid while the mailbox is active, readable as long as messages may be pending. Senders only signal the fd
+	 * once it has been handed out here, or while popAny() waits on it, otherwise they would pay for a write() per wake-up.
+	 */
+	int32_t getMboxFd();
+	/* Only called by the owner. */
+	void addNrSentMsgs(uint64_t count);
+	/* Counters since the last setState(true), false if never activated. */
+	bool getStatistics(MailboxStatistics &statistics) const;
+	/* Histograms since the last setState(true), false if not built with ITC_LATENCY_TRACE_ENABLE. */
+	bool getLatencySnapshot(MailboxLatencySnapshot &snapshot) const;
 	
 public:
 	itc_mailbox_id_t m_mailboxId {ITC_MAILBOX_ID_DEFAULT};
     uint32_t m_flags {ITC_FLAG_DEFAULT};
 	
+private:
+	void notifyReceiver();
+	ItcAdminMessageRawPtr popFromQueue(uint32_t mode, const struct timespec *deadline);
+	bool pushWithRxControl(ItcAdminMessageRawPtr msg);
+	void pushWithPriority(ItcAdminMessageRawPtr msg, uint32_t priority);
+	/* Only from rx queues above minPriority. */
+	bool tryPopPriorityMessage(ItcAdminMessageRawPtr &msg, uint32_t minPriority = ITC_MESSAGE_PRIORITY_DEFAULT);
+	/* Next of the messages put aside by popSelective(), unless a higher priority one has arrived since. */
+	ItcAdminMessageRawPtr popDeferredMessage();
+	void checkHighWatermark(uint32_t nrPendingMsgs);
+	void clearHighWatermark();
+	bool tryPopMessage(ItcAdminMessageRawPtr &msg);
+	uint32_t tryPopMessages(ItcAdminMessageRawPtr *msgs, uint32_t maxCount);
+	void recordReceived(const ItcAdminMessageRawPtr *msgs, uint32_t count);
+	
 private:
 	std::unique_ptr<LockFreeQueue<ItcAdminMessageRawPtr, ITC_MAILBOX_RX_MESSAGE_QUEUE_SIZE, nullptr, MINIMIZE_CONTENTION, MAXIMIZE_THROUGHPUT, !IS_TOTAL_ORDER, !IS_SPSC>> m_rxMsgQueue {nullptr};
 	std::atomic_bool m_isActive {false};
+	std::atomic<uint32_t> m_rxWaiterState {ITC_MAILBOX_RX_AWAKE}; /* Futex word. */
+	std::atomic_bool m_isRxFdSignalled {false};
+	std::atomic<uint8_t> m_rxFdUsers {0}; /* ITC_MAILBOX_RX_FD_* */
+	int32_t m_rxFd {-1};
+	std::unique_ptr<std::deque<ItcAdminMessageRawPtr>> m_deferredMsgs {nullptr}; /* Created on first popSelective(). */
+	std::unique_ptr<ItcMailboxRxControl> m_rxControl {nullptr}; /* Created by setRxConfig(). */
+	std::unique_ptr<ItcMailboxStatistics> m_statistics {nullptr}; /* Created by first setState(true). */
+	std::unique_ptr<ItcMailboxPriorityQueues> m_priorityQueues {nullptr}; /* Created by first setState(true). */
 	
 	friend class ItcMailboxTest;
 	FRIEND_TEST(ItcMailboxTest, test1);
 	FRIEND_TEST(ItcMailboxTest, test2);
 	FRIEND_TEST(ItcMailboxTest, test3);
 	FRIEND_TEST(ItcMailboxTest, test4);
+	FRIEND_TEST(ItcMailboxTest, blockingReceiveTest1);
+	FRIEND_TEST(ItcMailboxTest, blockingReceiveTest2);
+	FRIEND_TEST(ItcMailboxTest, mailboxFdTest1);
+	FRIEND_TEST(ItcMailboxTest, mailboxFdTest2);
+	FRIEND_TEST(ItcMailboxTest, mailboxFdTest3);
+	FRIEND_TEST(ItcMailboxTest, popBatchTest1);
+	FRIEND_TEST(ItcMailboxTest, popBatchTest2);
+	FRIEND_TEST(ItcMailboxTest, timedReceiveTest1);
+	FRIEND_TEST(ItcMailboxTest, timedReceiveTest2);
+	FRIEND_TEST(ItcMailboxTest, selectiveReceiveTest1);
+	FRIEND_TEST(ItcMailboxTest, selectiveReceiveTest2);
+	FRIEND_TEST(ItcMailboxTest, rxOverflowRejectTest1);
+	FRIEND_TEST(ItcMailboxTest, rxOverflowDropOldestTest1);
+	FRIEND_TEST(ItcMailboxTest, rxOverflowGrowTest1);
+	FRIEND_TEST(ItcMailboxTest, rxHighWatermarkTest1);
+	FRIEND_TEST(ItcMailboxTest, latencyTraceTest1);
+	FRIEND_TEST(ItcMailboxTest, statisticsTest1);
+	FRIEND_TEST(ItcMailboxTest, popAnyTest1);
+	FRIEND_TEST(ItcMailboxTest, popAnyTest2);
+	FRIEND_TEST(ItcMailboxTest, priorityTest1);
+	FRIEND_TEST(ItcMailboxTest, priorityTest2);
+	FRIEND_TEST(ItcMailboxTest, priorityTest3);
 	
 	friend class ItcTransportLocalTest;
 	FRIEND_TEST(ItcTransportLocalTest, test1);
@@ -1,14 +1,27 @@
 #pragma once
 
 #include "itcLockFreeQueue.h"
+#include "itcConstant.h"
+#include "itcStatistics.h"
 
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <functional>
 #include <atomic>
+#include <array>
+#include <algorithm>
 #include <initializer_list>
 #include <variant>
 #include <string>
+#include <iostream>
+#include <fstream>
+
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <errno.h>
+#include <gtest/gtest.h>
 
 #include <sys/mman.h>
 #include <sys/types.h>
@@ -17,6 +30,8 @@
 
 #include <sys/ipc.h>
 #include <sys/shm.h> 
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
 
 #include <errno.h>
 
@@ -35,34 +50,49 @@ namespace INTERNAL
 #define MEMORY_POOL_256_SLOT_SIZE           (uint32_t)(256)
 #define MEMORY_POOL_512_SLOT_SIZE           (uint32_t)(512)
 
+#define MEMORY_POOL_SIZE_CLASS_64           (uint32_t)(0)
+#define MEMORY_POOL_SIZE_CLASS_256          (uint32_t)(1)
+#define MEMORY_POOL_SIZE_CLASS_512          (uint32_t)(2)
+#define MEMORY_POOL_NUMBER_OF_SIZE_CLASSES  (uint32_t)(3) /* Also means "no size class" */
+#define MEMORY_POOL_MAX_BATCH_SIZE          (uint32_t)(32) /* Slots moved per allocateBatch()/deallocateBatch() */
+
 #define MEMORY_POOL_PAGE_SIZE               (uint32_t)(4096)
 #define ROUND_UP_TO_64_BYTES(x)             (((x) + 63) & ~63)
 #define ROUND_UP_TO_PAGE_SIZES(x)           (((x) + MEMORY_POOL_PAGE_SIZE - 1) & ~(MEMORY_POOL_PAGE_SIZE - 1))
+#define MEMORY_POOL_HUGE_PAGE_SIZE          (uint32_t)(2 * 1024 * 1024)
+#define ROUND_UP_TO_HUGE_PAGE_SIZES(x)      (((x) + MEMORY_POOL_HUGE_PAGE_SIZE - 1) & ~(MEMORY_POOL_HUGE_PAGE_SIZE - 1))
+#define MEMORY_POOL_HUGE_PAGE_COLOURS       (uint32_t)(32) /* Page offsets within its huge pages a mode 2 pool starts at, round robin */
 
-// 
 /***
- * + 6 x 64 bytes   :   MEMORY_POOL_64_METADATA             = (384 bytes)       }
- * + 3 x 64 bytes   :   MEMORY_POOL_256_METADATA            = (192 bytes)       }
- * + 3 x 64 bytes   :   MEMORY_POOL_512_METADATA            = (192 bytes)       } -> (4096 bytes)
- * + 1 x 64 bytes   :   MEMORY_POOL_UNLIMITED_METADATA      = (64 bytes)        }
- * + 51 x 64 bytes  :   MEMORY_POOL_64_DATA                 = (3264 bytes)      }
- * + 16 x 256 bytes :   MEMORY_POOL_256_DATA                = (4096 bytes)
- * + 16 x 512 bytes :   MEMORY_POOL_512_DATA                = (8192 bytes)
- * -> 4 pages = 16KB
+ * All offsets below are relative to the pool's base address:
+ * + MEMORY_POOL_64_METADATA        : free list of 64-byte slot offsets     = (16512 bytes)     }
+ * + MEMORY_POOL_256_METADATA       : free list of 256-byte slot offsets    = (4224 bytes)      }
+ * + MEMORY_POOL_512_METADATA       : free list of 512-byte slot offsets    = (2176 bytes)      } -> 6 pages (24KB)
+ * + MEMORY_POOL_UNLIMITED_METADATA                                         = (64 bytes)        }
+ * + 4096 x 64 bytes    :   MEMORY_POOL_64_DATA                             = (256KB)
+ * + 1024 x 256 bytes   :   MEMORY_POOL_256_DATA                            = (256KB)
+ * + 512 x 512 bytes    :   MEMORY_POOL_512_DATA                            = (256KB)
+ * -> 198 pages = 792KB
+ *
+ * Slot counts must be powers of 2, otherwise LockFreeQueue rounds its capacity up and the static_asserts in MemoryPool fail.
+ * Data starts on a page boundary, so every slot is cache line aligned.
  */
 
-#define MEMORY_POOL_64_SLOTS                (uint32_t)(51)
-#define MEMORY_POOL_256_SLOTS               (uint32_t)(16)
-#define MEMORY_POOL_512_SLOTS               (uint32_t)(16)
+#define MEMORY_POOL_64_SLOTS                (uint32_t)(4096)
+#define MEMORY_POOL_256_SLOTS               (uint32_t)(1024)
+#define MEMORY_POOL_512_SLOTS               (uint32_t)(512)
 #define MEMORY_POOL_UNLIMITED_SLOTS         (uint32_t)(1)
 
 #define MEMORY_POOL_64_METADATA_SIZE        (uint32_t)ROUND_UP_TO_64_BYTES((sizeof(int32_t) * MEMORY_POOL_64_SLOTS) + 128) /* 128 is for LockFreeQueueBase's head and tail. */
-#define MEMORY_POOL_256_METADATA_SIZE       (uint32_t)((sizeof(int32_t) * MEMORY_POOL_256_SLOTS) + 128) /* 128 is for LockFreeQueueBase's head and tail. */
-#define MEMORY_POOL_512_METADATA_SIZE       (uint32_t)((sizeof(int32_t) * MEMORY_POOL_512_SLOTS) + 128) /* 128 is for LockFreeQueueBase's head and tail. */
-#define MEMORY_POOL_UNLIMITED_METADATA_SIZE (uint32_t)ROUND_UP_TO_64_BYTES(sizeof(std::atomic<int32_t>))
-
-#define MEMORY_POOL_METADATA_SIZE           (uint32_t)(MEMORY_POOL_64_METADATA_SIZE + MEMORY_POOL_256_METADATA_SIZE + MEMORY_POOL_512_METADATA_SIZE + MEMORY_POOL_UNLIMITED_METADATA_SIZE)
+#define MEMORY_POOL_256_METADATA_SIZE       (uint32_t)ROUND_UP_TO_64_BYTES((sizeof(int32_t) * MEMORY_POOL_256_SLOTS) + 128) /* 128 is for LockFreeQueueBase's head and tail. */
+#define MEMORY_POOL_512_METADATA_SIZE       (uint32_t)ROUND_UP_TO_64_BYTES((sizeof(int32_t) * MEMORY_POOL_512_SLOTS) + 128) /* 128 is for LockFreeQueueBase's head and tail. */
+#define MEMORY_POOL_UNLIMITED_METADATA_SIZE (uint32_t)ROUND_UP_TO_64_BYTES(sizeof(pthread_mutex_t))
 
+#define MEMORY_POOL_64_METADATA_OFFSET          (uint32_t)(0)
+#define MEMORY_POOL_256_METADATA_OFFSET         (uint32_t)(MEMORY_POOL_64_METADATA_OFFSET + MEMORY_POOL_64_METADATA_SIZE)
+#define MEMORY_POOL_512_METADATA_OFFSET         (uint32_t)(MEMORY_POOL_256_METADATA_OFFSET + MEMORY_POOL_256_METADATA_SIZE)
+#define MEMORY_POOL_UNLIMITED_METADATA_OFFSET   (uint32_t)(MEMORY_POOL_512_METADATA_OFFSET + MEMORY_POOL_512_METADATA_SIZE)
+#define MEMORY_POOL_METADATA_SIZE               (uint32_t)ROUND_UP_TO_PAGE_SIZES(MEMORY_POOL_UNLIMITED_METADATA_OFFSET + MEMORY_POOL_UNLIMITED_METADATA_SIZE)
 
 #define MEMORY_POOL_64_TOTAL_SIZE               (uint32_t)(MEMORY_POOL_64_SLOTS * MEMORY_POOL_64_SLOT_SIZE)
 #define MEMORY_POOL_256_TOTAL_SIZE              (uint32_t)(MEMORY_POOL_256_SLOTS * MEMORY_POOL_256_SLOT_SIZE)
@@ -72,13 +102,39 @@ namespace INTERNAL
 #define MEMORY_POOL_64_START_OFFSET             (uint32_t)(MEMORY_POOL_METADATA_SIZE)
 #define MEMORY_POOL_256_START_OFFSET            (uint32_t)(MEMORY_POOL_64_START_OFFSET + MEMORY_POOL_64_TOTAL_SIZE)
 #define MEMORY_POOL_512_START_OFFSET            (uint32_t)(MEMORY_POOL_256_START_OFFSET + MEMORY_POOL_256_TOTAL_SIZE)
-// #define MEMORY_POOL_UNLIMITED_START_OFFSET      (uint32_t)(MEMORY_POOL_512_START_OFFSET + MEMORY_POOL_512_TOTAL_SIZE)
+#define MEMORY_POOL_END_OFFSET                  (uint32_t)(MEMORY_POOL_512_START_OFFSET + MEMORY_POOL_512_TOTAL_SIZE)
+#define MEMORY_POOL_UNLIMITED_START_OFFSET      (uint32_t)(MEMORY_POOL_END_OFFSET) /* Offsets from here on point into the unlimited tier, see MemoryPool::getOffset() */
+
+/***
+ * The unlimited tier lives on a separate memory area, see MemoryAllocator::append() and MemoryPool::appendUnlimited():
+ * + MEMORY_POOL_UNLIMITED_HEADER   : free list heads and block states                   = (12KB)
+ * + 32 x 256KB         :   MEMORY_POOL_UNLIMITED_DATA, buddy blocks of 1KB up to 256KB  = (8MB)
+ *
+ * Blocks of 256KB are taken into use one at a time when no free block is large enough, so only the pages
+ * which have ever held a message are backed by memory.
+ */
+
+#define MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE    (uint32_t)(1024)
+#define MEMORY_POOL_UNLIMITED_NUMBER_OF_ORDERS  (uint32_t)(9) /* Block sizes 1KB, 2KB, ..., 256KB */
+#define MEMORY_POOL_UNLIMITED_MAX_BLOCK_SIZE    (uint32_t)(MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE << (MEMORY_POOL_UNLIMITED_NUMBER_OF_ORDERS - 1))
+#define MEMORY_POOL_UNLIMITED_MAX_BLOCKS        (uint32_t)(32) /* Of MEMORY_POOL_UNLIMITED_MAX_BLOCK_SIZE */
+#define MEMORY_POOL_UNLIMITED_DATA_SIZE         (uint32_t)(MEMORY_POOL_UNLIMITED_MAX_BLOCKS * MEMORY_POOL_UNLIMITED_MAX_BLOCK_SIZE)
+#define MEMORY_POOL_UNLIMITED_MIN_BLOCKS        (uint32_t)(MEMORY_POOL_UNLIMITED_DATA_SIZE / MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE)
+#define MEMORY_POOL_UNLIMITED_HEADER_SIZE       (uint32_t)ROUND_UP_TO_PAGE_SIZES(sizeof(uint32_t) * (1 + MEMORY_POOL_UNLIMITED_NUMBER_OF_ORDERS) + MEMORY_POOL_UNLIMITED_MIN_BLOCKS)
+#define MEMORY_POOL_UNLIMITED_TOTAL_SIZE        (uint32_t)(MEMORY_POOL_UNLIMITED_HEADER_SIZE + MEMORY_POOL_UNLIMITED_DATA_SIZE)
+
+#define MEMORY_POOL_UNLIMITED_BLOCK_NONE        (uint8_t)(0x00) /* Inside a larger block, or not in use yet */
+#define MEMORY_POOL_UNLIMITED_BLOCK_USED        (uint8_t)(0x40)
+#define MEMORY_POOL_UNLIMITED_BLOCK_FREE        (uint8_t)(0x80)
+#define MEMORY_POOL_UNLIMITED_BLOCK_ORDER_MASK  (uint8_t)(0x3F)
 
 #define MEMORY_POOL_MODE_NO_POOLING             (uint32_t)(0)
 #define MEMORY_POOL_MODE_SYSV_SHARED            (uint32_t)(1)
 #define MEMORY_POOL_MODE_POSIX_SHARED           (uint32_t)(2)
 #define MEMORY_POOL_MODE_THREAD_SHARED          (uint32_t)(3)
 
+#define MEMORY_SYSV_APPEND_PROJ_ID_FLAG         (int32_t)(0x80) /* ftok() project id of an appended SYSV segment: its base segment's one with this bit set */
+
 /***
  * 1. new/delete                    align 16                        tất cả threads tự allocate msg, rx queue đặt ở đâu cũng được, rx queue chứa absolute address
  * 2. mmap(ANONYMOUS)               align 4096                      tất cả threads cùng vào shopping 1 pool, rx queue đặt ở đâu cũng được, rx queue chứa absolute address, pool unlimited bắt là một mmap(ANONYMOUS) khác -> push vào là absolute address
@@ -116,7 +172,9 @@ class SYSVSharedMemory : public SharedMemoryIf
 {
 public:
     SYSVSharedMemory(const std::string &shmName, int32_t projId, uint32_t size)
-        : SharedMemoryIf(ROUND_UP_TO_PAGE_SIZES(size))
+        : SharedMemoryIf(ROUND_UP_TO_PAGE_SIZES(size)),
+          m_shmName(shmName),
+          m_projId(projId)
     {
         key_t shmKey = ftok(shmName.c_str(), projId);
         if(shmKey < 0)
@@ -134,6 +192,14 @@ public:
     }
     ~SYSVSharedMemory()
     {
+        if(m_appendedPtr)
+        {
+            shmdt(reinterpret_cast<void *>(m_appendedPtr));
+        }
+        if(m_appendedShmId > 0)
+        {
+            shmctl(m_appendedShmId, IPC_RMID, NULL);
+        }
         if(m_basePtr)
         {
             shmdt(reinterpret_cast<void *>(m_basePtr));
@@ -149,21 +215,59 @@ public:
         return m_basePtr;
     }
     
+    /***
+     * A SYSV shared memory segment cannot grow in place, so a second one is created instead. Its key is derived from
+     * the same file with MEMORY_SYSV_APPEND_PROJ_ID_FLAG set, so that other processes find it, see getAppended().
+     */
     bool append(uint32_t size) override
     {
-        
+        if(m_appendedPtr || !m_basePtr)
+        {
+            return false;
+        }
+
+        key_t shmKey = ftok(m_shmName.c_str(), m_projId | MEMORY_SYSV_APPEND_PROJ_ID_FLAG);
+        if(shmKey < 0)
+        {
+            return false;
+        }
+
+        m_appendedShmId = shmget(shmKey, ROUND_UP_TO_PAGE_SIZES(size), 0666 | IPC_CREAT | IPC_EXCL);
+        if(m_appendedShmId < 0)
+        {
+            return false;
+        }
+
+        void *addr = shmat(m_appendedShmId, NULL, 0);
+        if(addr == reinterpret_cast<void *>(-1))
+        {
+            shmctl(m_appendedShmId, IPC_RMID, NULL);
+            m_appendedShmId = -1;
+            return false;
+        }
+        m_appendedPtr = reinterpret_cast<UInt8RawPtr>(addr);
+        return true;
+    }
+
+    UInt8RawPtr getAppended()
+    {
+        return m_appendedPtr;
     }
 
 private:
+    std::string m_shmName;
+    int32_t m_projId {-1};
     int32_t m_shmId {-1};
+    int32_t m_appendedShmId {-1};
+    UInt8RawPtr m_appendedPtr {nullptr};
 };
 
 class POSIXSharedMemory : public SharedMemoryIf
 {
 public:
     POSIXSharedMemory(const std::string &shmName, uint32_t size)
-        : m_shmName(shmName),
-          SharedMemoryIf(ROUND_UP_TO_PAGE_SIZES(size))
+        : SharedMemoryIf(ROUND_UP_TO_PAGE_SIZES(size)),
+          m_shmName(shmName)
     {
         int32_t shmId = shm_open(m_shmName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
         if(shmId < 0 && errno != EEXIST)
@@ -235,10 +339,77 @@ public:
     {
         return m_basePtr;
     }
+};
+
+#define MEMORY_NUMA_MAX_NODES               (uint32_t)(8)
+#define MEMORY_NUMA_NODE_ANY                (uint32_t)(0xFFFFFFFF) /* Wherever the first touch happens */
+
+/***
+ * NUMA nodes of this machine as far as itc-platform cares, ids from 0 up to MEMORY_NUMA_MAX_NODES - 1.
+ * Memory is placed by raw mbind(2)/move_pages(2) syscalls, so that libnuma is not needed.
+ */
+class NumaTopology
+{
+public:
+    /* Read once from sysfs, 1 if that is not there. */
+    static uint32_t getNumberOfNodes()
+    {
+        static const uint32_t nrNodes = readNumberOfNodes();
+        return nrNodes;
+    }
+
+    /* Node of the CPU the calling thread runs on right now, 0 if unknown. */
+    static uint32_t getCurrentNode()
+    {
+        uint32_t cpu {0};
+        uint32_t node {0};
+        if(getcpu(&cpu, &node) < 0 || node >= MEMORY_NUMA_MAX_NODES)
+        {
+            return 0;
+        }
+        return node;
+    }
+
+    /***
+     * Pages of [addr, addr + size) go to node from now on, those touched already are moved there. addr must be page
+     * aligned. MPOL_PREFERRED rather than MPOL_BIND, since a full node must not make allocations fail.
+     */
+    static bool bindToNode(void *addr, size_t size, uint32_t node)
+    {
+        if(node >= MEMORY_NUMA_MAX_NODES)
+        {
+            return false;
+        }
+        unsigned long nodeMask = 1UL << node;
+        return syscall(SYS_mbind, addr, size, MPOL_PREFERRED, &nodeMask, sizeof(nodeMask) * 8, MPOL_MF_MOVE) == 0;
+    }
+
+    /* Node the page of addr is on, MEMORY_NUMA_NODE_ANY if it has never been touched or the kernel would not tell. */
+    static uint32_t getNodeOfAddress(const void *addr)
+    {
+        auto page = reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(addr) & ~static_cast<uintptr_t>(MEMORY_POOL_PAGE_SIZE - 1));
+        int32_t status {-1};
+        if(syscall(SYS_move_pages, 0, 1, &page, nullptr, &status, 0) < 0 || status < 0)
+        {
+            return MEMORY_NUMA_NODE_ANY;
+        }
+        return static_cast<uint32_t>(status);
+    }
 
 private:
-    UInt8RawPtr m_basePtr {nullptr};
-    uint32_t m_size {0};
+    static uint32_t readNumberOfNodes()
+    {
+        /* A list of ranges such as "0" or "0-1", the highest id comes last. */
+        std::ifstream file("/sys/devices/system/node/online");
+        std::string nodes;
+        if(!std::getline(file, nodes) || nodes.empty())
+        {
+            return 1;
+        }
+        size_t lastIdPos = nodes.find_last_of("-,");
+        uint32_t lastId = std::strtoul(nodes.c_str() + (lastIdPos == std::string::npos ? 0 : lastIdPos + 1), nullptr, 10);
+        return std::min(lastId + 1, MEMORY_NUMA_MAX_NODES);
+    }
 };
 
 struct MemoryChunkInfo
@@ -252,14 +423,22 @@ struct MemoryChunkInfo
 #define MEMORY_ALLOCATOR_MODE_3             (uint32_t)(3)
 #define MEMORY_ALLOCATOR_MODE_4             (uint32_t)(4)
 
+#if defined ITC_HUGE_PAGES_ENABLE
+#define MEMORY_ALLOCATOR_HUGE_PAGES         (uint32_t)(1)
+#else
+#define MEMORY_ALLOCATOR_HUGE_PAGES         (uint32_t)(0)
+#endif
+
 /* 1. ThreadSharedMemory1: trivial new[]/delete[] */
 struct Mode1Attributes
 {
     UInt8RawPtr baseAddr {nullptr};
+    UInt8RawPtr appendedBaseAddress {nullptr};
     
     void reset()
     {
         baseAddr = nullptr;
+        appendedBaseAddress = nullptr;
     }
 };
 
@@ -268,11 +447,19 @@ struct Mode2Attributes
 {
     UInt8RawPtr baseAddr {nullptr};
     uint32_t size {0};
+    uint32_t isHugeTlb {0}; /* 1: backed by reserved huge pages (MAP_HUGETLB), 0: by 4 KiB pages. */
+    uint32_t colourOffset {0}; /* baseAddr - colourOffset is what was mapped, size bytes long. */
+    UInt8RawPtr appendedBaseAddress {nullptr};
+    uint32_t appendedSize {0};
     
     void reset()
     {
         baseAddr = nullptr;
         size = 0;
+        isHugeTlb = 0;
+        colourOffset = 0;
+        appendedBaseAddress = nullptr;
+        appendedSize = 0;
     }
 };
 
@@ -285,6 +472,7 @@ struct Mode3Attributes
     uint32_t appendedSize {0};
     int32_t shmId {-1};
     uint32_t isOwner {0}; /* 1: owner who created the POSIX Shared Memory object. 0: we are opening only. */
+    uint32_t isAttachOnly {0}; /* 1: only open an already existing object, never create it. */
     std::string shmName;
     
     void reset()
@@ -295,6 +483,7 @@ struct Mode3Attributes
         appendedSize = 0;
         shmId = -1;
         isOwner = 0;
+        isAttachOnly = 0;
         shmName = "";
     }
 };
@@ -307,6 +496,10 @@ struct Mode4Attributes
     int32_t shmId {-1};
     int32_t projId {-1};
     uint32_t isOwner {0}; /* 1: owner who created the POSIX Shared Memory object. 0: we are opening only. */
+    uint32_t isHugeTlb {0}; /* 1: backed by reserved huge pages (SHM_HUGETLB), 0: by 4 KiB pages. */
+    UInt8RawPtr appendedBaseAddress {nullptr};
+    uint32_t appendedSize {0};
+    int32_t appendedShmId {-1}; /* Keyed by projId | MEMORY_SYSV_APPEND_PROJ_ID_FLAG. */
     std::string shmName;
     
     void reset()
@@ -316,6 +509,10 @@ struct Mode4Attributes
         shmId = -1;
         projId = -1;
         isOwner = 0;
+        isHugeTlb = 0;
+        appendedBaseAddress = nullptr;
+        appendedSize = 0;
+        appendedShmId = -1;
         shmName = "";
     }
 };
@@ -323,14 +520,20 @@ struct Mode4Attributes
 struct MemoryAllocatorParams
 {
     uint32_t mode {MEMORY_ALLOCATOR_MODE_1};
-    union
+    /***
+     * 1: modes 2-4 ask for 2 MiB pages, reserved ones first (MAP_HUGETLB/SHM_HUGETLB, see /proc/sys/vm/nr_hugepages),
+     * then transparent ones (madvise(MADV_HUGEPAGE)). POSIX shared memory only gets the latter. Mode 1 ignores it.
+     */
+    uint32_t isHugePages {MEMORY_ALLOCATOR_HUGE_PAGES};
+    uint32_t numaNode {MEMORY_NUMA_NODE_ANY}; /* Node mode 2 memory is placed on, see NumaTopology::bindToNode(). */
+    /* Not a union, Mode3Attributes and Mode4Attributes hold a std::string. */
+    struct
     {
         Mode1Attributes mode1;
         Mode2Attributes mode2;
         Mode3Attributes mode3;
         Mode4Attributes mode4;
     } attrs;
-    
 };
 
 
@@ -343,11 +546,47 @@ public:
         {
             params.attrs.mode1.baseAddr = new uint8_t[size];
             return params.attrs.mode1.baseAddr;
+        } else if(params.mode == MEMORY_ALLOCATOR_MODE_2 && params.isHugePages)
+        {
+            return allocateHugePages(size, params);
         } else if(params.mode == MEMORY_ALLOCATOR_MODE_2)
         {
-            params.attrs.mode2.baseAddr = reinterpret_cast<UInt8RawPtr>(mmap(nullptr, ROUND_UP_TO_PAGE_SIZES(size), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+            void *addr = mmap(nullptr, ROUND_UP_TO_PAGE_SIZES(size), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(addr == MAP_FAILED)
+            {
+                std::cout << "ETRUGIA: Failed to mmap, errno = " << errno << std::endl;
+                return nullptr;
+            }
+            if(params.numaNode != MEMORY_NUMA_NODE_ANY)
+            {
+                NumaTopology::bindToNode(addr, ROUND_UP_TO_PAGE_SIZES(size), params.numaNode);
+            }
+            params.attrs.mode2.baseAddr = reinterpret_cast<UInt8RawPtr>(addr);
             params.attrs.mode2.size = ROUND_UP_TO_PAGE_SIZES(size);
             return params.attrs.mode2.baseAddr;
+        } else if(params.mode == MEMORY_ALLOCATOR_MODE_3 && params.attrs.mode3.isAttachOnly)
+        {
+            int32_t shmId = shm_open(params.attrs.mode3.shmName.c_str(), O_RDWR, 0666);
+            if(shmId < 0)
+            {
+                return nullptr;
+            }
+
+            void *addr = mmap(nullptr, getMappedSize(size, params), PROT_READ | PROT_WRITE, MAP_SHARED, shmId, 0);
+            if(addr == MAP_FAILED)
+            {
+                close(shmId);
+                return nullptr;
+            }
+            if(params.isHugePages)
+            {
+                adviseHugePages(addr, getMappedSize(size, params));
+            }
+            params.attrs.mode3.baseAddr = reinterpret_cast<UInt8RawPtr>(addr);
+            params.attrs.mode3.size = getMappedSize(size, params);
+            params.attrs.mode3.shmId = shmId;
+            params.attrs.mode3.isOwner = 0;
+            return params.attrs.mode3.baseAddr;
         } else if(params.mode == MEMORY_ALLOCATOR_MODE_3)
         {
             uint32_t isOwner {1};
@@ -381,7 +620,7 @@ public:
                 return nullptr;
             }
             
-            ret = ftruncate(shmId, ROUND_UP_TO_PAGE_SIZES(size));
+            ret = ftruncate(shmId, getMappedSize(size, params));
             if(ret < 0)
             {
                 std::cout << "ETRUGIA: Failed to ftruncate, errno = " << errno << std::endl;
@@ -393,8 +632,23 @@ public:
                 return nullptr;
             }
             
-            params.attrs.mode3.baseAddr = reinterpret_cast<UInt8RawPtr>(mmap(nullptr, ROUND_UP_TO_PAGE_SIZES(size), PROT_READ | PROT_WRITE, MAP_SHARED, shmId, 0));
-            params.attrs.mode3.size = ROUND_UP_TO_PAGE_SIZES(size);
+            void *addr = mmap(nullptr, getMappedSize(size, params), PROT_READ | PROT_WRITE, MAP_SHARED, shmId, 0);
+            if(addr == MAP_FAILED)
+            {
+                std::cout << "ETRUGIA: Failed to mmap, errno = " << errno << std::endl;
+                close(shmId);
+                if(isOwner)
+                {
+                    shm_unlink(params.attrs.mode3.shmName.c_str());
+                }
+                return nullptr;
+            }
+            if(params.isHugePages)
+            {
+                adviseHugePages(addr, getMappedSize(size, params));
+            }
+            params.attrs.mode3.baseAddr = reinterpret_cast<UInt8RawPtr>(addr);
+            params.attrs.mode3.size = getMappedSize(size, params);
             params.attrs.mode3.shmId = shmId;
             params.attrs.mode3.isOwner = isOwner;
             return params.attrs.mode3.baseAddr;
@@ -407,7 +661,18 @@ public:
                 return nullptr;
             }
 
-            int32_t shmId = shmget(shmKey, ROUND_UP_TO_PAGE_SIZES(size), 0666 | IPC_CREAT | IPC_EXCL);
+            uint32_t isHugeTlb {0};
+            int32_t shmId {-1};
+            if(params.isHugePages)
+            {
+                /* Fails without enough reserved huge pages, or with EEXIST as below. */
+                shmId = shmget(shmKey, ROUND_UP_TO_HUGE_PAGE_SIZES(size), 0666 | IPC_CREAT | IPC_EXCL | SHM_HUGETLB);
+                isHugeTlb = shmId < 0 ? 0 : 1;
+            }
+            if(shmId < 0)
+            {
+                shmId = shmget(shmKey, ROUND_UP_TO_PAGE_SIZES(size), 0666 | IPC_CREAT | IPC_EXCL);
+            }
             if(shmId < 0)
             {
                 if(errno != EEXIST)
@@ -425,41 +690,146 @@ public:
             }
 
             params.attrs.mode4.baseAddr = reinterpret_cast<UInt8RawPtr>(shmat(shmId, nullptr, 0));
-            params.attrs.mode4.size = ROUND_UP_TO_PAGE_SIZES(size);
+            params.attrs.mode4.size = isHugeTlb ? ROUND_UP_TO_HUGE_PAGE_SIZES(size) : ROUND_UP_TO_PAGE_SIZES(size);
             params.attrs.mode4.shmId = shmId;
             params.attrs.mode4.isOwner = isOwner;
+            params.attrs.mode4.isHugeTlb = isHugeTlb;
+            if(params.isHugePages && !isHugeTlb && params.attrs.mode4.baseAddr != reinterpret_cast<UInt8RawPtr>(-1))
+            {
+                adviseHugePages(params.attrs.mode4.baseAddr, params.attrs.mode4.size);
+            }
             return params.attrs.mode4.baseAddr;
         }
         
         return nullptr;
     }
 
+    /***
+     * Adds a second memory area of size bytes to what allocate() made with the same params and returns it, e.g. for
+     * the unlimited tier of a MemoryPool. Only one per allocate(), deallocate() releases both.
+     * + Mode 3 grows the POSIX shared memory object, the area starts at file offset attrs.mode3.size in every process
+     *   which maps it. Attach only mappings never grow the object, they only map what its owner has appended.
+     * + Mode 4 creates a second SYSV segment, keyed by projId | MEMORY_SYSV_APPEND_PROJ_ID_FLAG.
+     * A failed append leaves the first area as it was.
+     */
     static UInt8RawPtr append(uint32_t size, MemoryAllocatorParams &params)
     {
-        if(params.mode == MEMORY_ALLOCATOR_MODE_3)
+        if(params.mode == MEMORY_ALLOCATOR_MODE_1)
         {
-            if(params.attrs.mode3.appendedBaseAddress)
+            if(params.attrs.mode1.appendedBaseAddress)
+            {
+                return nullptr;
+            }
+
+            params.attrs.mode1.appendedBaseAddress = new uint8_t[size];
+            return params.attrs.mode1.appendedBaseAddress;
+        } else if(params.mode == MEMORY_ALLOCATOR_MODE_2)
+        {
+            if(params.attrs.mode2.appendedBaseAddress)
+            {
+                return nullptr;
+            }
+
+            void *addr = mmap(nullptr, ROUND_UP_TO_PAGE_SIZES(size), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(addr == MAP_FAILED)
+            {
+                std::cout << "ETRUGIA: Failed to mmap, errno = " << errno << std::endl;
+                return nullptr;
+            }
+            if(params.isHugePages)
+            {
+                adviseHugePages(addr, ROUND_UP_TO_PAGE_SIZES(size));
+            }
+            if(params.numaNode != MEMORY_NUMA_NODE_ANY)
+            {
+                NumaTopology::bindToNode(addr, ROUND_UP_TO_PAGE_SIZES(size), params.numaNode);
+            }
+            params.attrs.mode2.appendedBaseAddress = reinterpret_cast<UInt8RawPtr>(addr);
+            params.attrs.mode2.appendedSize = ROUND_UP_TO_PAGE_SIZES(size);
+            return params.attrs.mode2.appendedBaseAddress;
+        } else if(params.mode == MEMORY_ALLOCATOR_MODE_3)
+        {
+            if(params.attrs.mode3.appendedBaseAddress || params.attrs.mode3.shmId < 0)
             {
                 return nullptr;
             }
             
-            int32_t ret = ftruncate(params.attrs.mode3.shmId, params.attrs.mode3.size + ROUND_UP_TO_PAGE_SIZES(size));
-            if(ret < 0)
+            off_t fileSize = static_cast<off_t>(params.attrs.mode3.size) + ROUND_UP_TO_PAGE_SIZES(size);
+            if(params.attrs.mode3.isAttachOnly)
             {
-                std::cout << "ETRUGIA: Failed to ftruncate, errno = " << errno << std::endl;
-                if(params.attrs.mode3.isOwner)
+                /* Touching a mapping beyond the end of the object raises SIGBUS, so the owner must have appended. */
+                struct stat shmStat;
+                if(fstat(params.attrs.mode3.shmId, &shmStat) < 0 || shmStat.st_size < fileSize)
                 {
-                    close(params.attrs.mode3.shmId);
-                    shm_unlink(params.attrs.mode3.shmName.c_str());
+                    return nullptr;
                 }
+            } else if(ftruncate(params.attrs.mode3.shmId, fileSize) < 0)
+            {
+                std::cout << "ETRUGIA: Failed to ftruncate, errno = " << errno << std::endl;
                 return nullptr;
             }
             
-            params.attrs.mode3.appendedBaseAddress = reinterpret_cast<UInt8RawPtr>(mmap(nullptr, ROUND_UP_TO_PAGE_SIZES(size), PROT_READ | PROT_WRITE, MAP_SHARED, params.attrs.mode3.shmId, params.attrs.mode3.size));
+            void *addr = mmap(nullptr, ROUND_UP_TO_PAGE_SIZES(size), PROT_READ | PROT_WRITE, MAP_SHARED, params.attrs.mode3.shmId, params.attrs.mode3.size);
+            if(addr == MAP_FAILED)
+            {
+                std::cout << "ETRUGIA: Failed to mmap, errno = " << errno << std::endl;
+                return nullptr;
+            }
+            if(params.isHugePages)
+            {
+                adviseHugePages(addr, ROUND_UP_TO_PAGE_SIZES(size));
+            }
+            params.attrs.mode3.appendedBaseAddress = reinterpret_cast<UInt8RawPtr>(addr);
             params.attrs.mode3.appendedSize = ROUND_UP_TO_PAGE_SIZES(size);
-        } else if(params.mode == MEMORY_ALLOCATOR_MODE_1 || params.mode == MEMORY_ALLOCATOR_MODE_2 || params.mode == MEMORY_ALLOCATOR_MODE_4)
+            return params.attrs.mode3.appendedBaseAddress;
+        } else if(params.mode == MEMORY_ALLOCATOR_MODE_4)
         {
-            return allocate(size, params);
+            if(params.attrs.mode4.appendedBaseAddress)
+            {
+                return nullptr;
+            }
+
+            key_t shmKey = ftok(params.attrs.mode4.shmName.c_str(), params.attrs.mode4.projId | MEMORY_SYSV_APPEND_PROJ_ID_FLAG);
+            if(shmKey < 0)
+            {
+                return nullptr;
+            }
+
+            uint32_t isCreated {1};
+            int32_t shmId = shmget(shmKey, ROUND_UP_TO_PAGE_SIZES(size), 0666 | IPC_CREAT | IPC_EXCL);
+            if(shmId < 0)
+            {
+                if(errno != EEXIST)
+                {
+                    return nullptr;
+                }
+
+                shmId = shmget(shmKey, ROUND_UP_TO_PAGE_SIZES(size), 0666);
+                if(shmId < 0)
+                {
+                    return nullptr;
+                }
+
+                isCreated = 0;
+            }
+
+            void *addr = shmat(shmId, nullptr, 0);
+            if(addr == reinterpret_cast<void *>(-1))
+            {
+                if(isCreated)
+                {
+                    shmctl(shmId, IPC_RMID, NULL);
+                }
+                return nullptr;
+            }
+            if(params.isHugePages)
+            {
+                adviseHugePages(addr, ROUND_UP_TO_PAGE_SIZES(size));
+            }
+            params.attrs.mode4.appendedBaseAddress = reinterpret_cast<UInt8RawPtr>(addr);
+            params.attrs.mode4.appendedSize = ROUND_UP_TO_PAGE_SIZES(size);
+            params.attrs.mode4.appendedShmId = shmId;
+            return params.attrs.mode4.appendedBaseAddress;
         }
         
         return nullptr;
@@ -472,16 +842,24 @@ public:
             if(params.attrs.mode1.baseAddr)
             {
                 delete[] params.attrs.mode1.baseAddr;
-                params.attrs.mode1.reset();
             }
+            if(params.attrs.mode1.appendedBaseAddress)
+            {
+                delete[] params.attrs.mode1.appendedBaseAddress;
+            }
+            params.attrs.mode1.reset();
         } else if(params.mode == MEMORY_ALLOCATOR_MODE_2)
         {
             if(params.attrs.mode2.baseAddr)
             {
-                munmap(params.attrs.mode2.baseAddr, params.attrs.mode2.size);
-                params.attrs.mode2.reset();
+                munmap(params.attrs.mode2.baseAddr - params.attrs.mode2.colourOffset, params.attrs.mode2.size);
             }
-        } else if(params.mode == MEMORY_ALLOCATOR_MODE_3 && params.attrs.mode3.isOwner)
+            if(params.attrs.mode2.appendedBaseAddress)
+            {
+                munmap(params.attrs.mode2.appendedBaseAddress, params.attrs.mode2.appendedSize);
+            }
+            params.attrs.mode2.reset();
+        } else if(params.mode == MEMORY_ALLOCATOR_MODE_3)
         {
             if(params.attrs.mode3.baseAddr)
             {
@@ -495,7 +873,10 @@ public:
             {
                 close(params.attrs.mode3.shmId);
             }
-            shm_unlink(params.attrs.mode3.shmName.c_str());
+            if(params.attrs.mode3.isOwner)
+            {
+                shm_unlink(params.attrs.mode3.shmName.c_str());
+            }
             params.attrs.mode3.reset();
         } else if(params.mode == MEMORY_ALLOCATOR_MODE_4 && params.attrs.mode4.isOwner)
         {
@@ -507,125 +888,744 @@ public:
             {
                 shmctl(params.attrs.mode4.shmId, IPC_RMID, NULL);
             }
+            if(params.attrs.mode4.appendedBaseAddress)
+            {
+                shmdt(reinterpret_cast<void *>(params.attrs.mode4.appendedBaseAddress));
+            }
+            if(params.attrs.mode4.appendedShmId > 0)
+            {
+                shmctl(params.attrs.mode4.appendedShmId, IPC_RMID, NULL);
+            }
             params.attrs.mode4.reset();
         }
     }
+
+private:
+    /***
+     * Mode 2 with huge pages. Without reserved ones, 4 KiB pages are mapped on a 2 MiB boundary and whole 2 MiB
+     * long, so that khugepaged can collapse every one of them into a transparent huge page.
+     * Pools all starting on a 2 MiB boundary would have their free list heads and hottest slots in the same cache
+     * sets, so each one starts a few pages further in than the one before, as far as the unused tail allows.
+     */
+    static UInt8RawPtr allocateHugePages(uint32_t size, MemoryAllocatorParams &params)
+    {
+        static std::atomic<uint32_t> nextColour {0};
+        uint32_t hugeSize = ROUND_UP_TO_HUGE_PAGE_SIZES(size);
+        uint32_t nrColours = std::min((hugeSize - ROUND_UP_TO_PAGE_SIZES(size)) / MEMORY_POOL_PAGE_SIZE + 1, MEMORY_POOL_HUGE_PAGE_COLOURS);
+        uint32_t colourOffset = nextColour.fetch_add(1, MEMORY_ORDER_RELAXED) % nrColours * MEMORY_POOL_PAGE_SIZE;
+
+        void *addr = mmap(nullptr, hugeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if(addr != MAP_FAILED)
+        {
+            if(params.numaNode != MEMORY_NUMA_NODE_ANY)
+            {
+                NumaTopology::bindToNode(addr, hugeSize, params.numaNode);
+            }
+            params.attrs.mode2.baseAddr = reinterpret_cast<UInt8RawPtr>(addr) + colourOffset;
+            params.attrs.mode2.size = hugeSize;
+            params.attrs.mode2.isHugeTlb = 1;
+            params.attrs.mode2.colourOffset = colourOffset;
+            return params.attrs.mode2.baseAddr;
+        }
+
+        /* One huge page more than needed, the unaligned head and tail are given back right away. */
+        addr = mmap(nullptr, hugeSize + MEMORY_POOL_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(addr == MAP_FAILED)
+        {
+            std::cout << "ETRUGIA: Failed to mmap, errno = " << errno << std::endl;
+            return nullptr;
+        }
+        auto start = reinterpret_cast<uintptr_t>(addr);
+        auto alignedStart = (start + MEMORY_POOL_HUGE_PAGE_SIZE - 1) & ~static_cast<uintptr_t>(MEMORY_POOL_HUGE_PAGE_SIZE - 1);
+        if(alignedStart > start)
+        {
+            munmap(addr, alignedStart - start);
+        }
+        if(alignedStart - start < MEMORY_POOL_HUGE_PAGE_SIZE)
+        {
+            munmap(reinterpret_cast<void *>(alignedStart + hugeSize), MEMORY_POOL_HUGE_PAGE_SIZE - (alignedStart - start));
+        }
+        adviseHugePages(reinterpret_cast<void *>(alignedStart), hugeSize);
+        if(params.numaNode != MEMORY_NUMA_NODE_ANY)
+        {
+            NumaTopology::bindToNode(reinterpret_cast<void *>(alignedStart), hugeSize, params.numaNode);
+        }
+
+        params.attrs.mode2.baseAddr = reinterpret_cast<UInt8RawPtr>(alignedStart) + colourOffset;
+        params.attrs.mode2.size = hugeSize;
+        params.attrs.mode2.isHugeTlb = 0;
+        params.attrs.mode2.colourOffset = colourOffset;
+        return params.attrs.mode2.baseAddr;
+    }
+
+    /* Huge pages of POSIX shared memory come from tmpfs, which only uses them for whole 2 MiB of the file. */
+    static uint32_t getMappedSize(uint32_t size, const MemoryAllocatorParams &params)
+    {
+        return params.isHugePages ? ROUND_UP_TO_HUGE_PAGE_SIZES(size) : ROUND_UP_TO_PAGE_SIZES(size);
+    }
+
+    static void adviseHugePages(void *addr, uint32_t size)
+    {
+        /* Only a hint, with transparent huge pages disabled it fails and 4 KiB pages have to do. Said once, it fails alike for every pool. */
+        static std::atomic<bool> isReported {false};
+        if(madvise(addr, size, MADV_HUGEPAGE) < 0 && !isReported.exchange(true, MEMORY_ORDER_RELAXED))
+        {
+            TPT_TRACE(TRACE_INFO, SSTR("Failed to madvise(MADV_HUGEPAGE), errno = ", errno));
+        }
+    }
 };
 
+/***
+ * Size-class pool placed entirely on a caller-provided memory region: the free lists (metadata)
+ * live at the start of the region and hold slot offsets rather than absolute addresses,
+ * so that the same layout can later be mapped by several processes.
+ *
+ * Messages larger than MEMORY_POOL_512_SLOT_SIZE go to the unlimited tier, if one has been appended, see
+ * appendUnlimited(). That is a buddy allocator whose free lists are kept on the appended area itself, guarded by
+ * a robust process-shared mutex in the pool's metadata, so it is shared across processes just like the size classes.
+ */
 class MemoryPool
 {
-    using MemoryPool64Queue = LockFreeQueue<int32_t /* 64-byte index from starting of pool 64 */, MEMORY_POOL_64_SLOTS, -1, MINIMIZE_CONTENTION, MAXIMIZE_THROUGHPUT, !IS_TOTAL_ORDER, !IS_SPSC>;
-    using MemoryPool256Queue = LockFreeQueue<int32_t /* 64-byte index from starting of pool 256 */, MEMORY_POOL_256_SLOTS, -1, MINIMIZE_CONTENTION, MAXIMIZE_THROUGHPUT, !IS_TOTAL_ORDER, !IS_SPSC>;
-    using MemoryPool512Queue = LockFreeQueue<int32_t /* 64-byte index from starting of pool 512 */, MEMORY_POOL_512_SLOTS, -1, MINIMIZE_CONTENTION, MAXIMIZE_THROUGHPUT, !IS_TOTAL_ORDER, !IS_SPSC>;
-    using MemoryPoolUnlimitedLock = std::atomic<int32_t /* 64-byte index from starting of pool unlimited */>;
+public:
+    using MemoryPool64Queue = LockFreeQueue<int32_t /* Offset of a 64-byte slot from the pool's base address */, MEMORY_POOL_64_SLOTS, -1, MINIMIZE_CONTENTION, MAXIMIZE_THROUGHPUT, !IS_TOTAL_ORDER, !IS_SPSC>;
+    using MemoryPool256Queue = LockFreeQueue<int32_t /* Offset of a 256-byte slot from the pool's base address */, MEMORY_POOL_256_SLOTS, -1, MINIMIZE_CONTENTION, MAXIMIZE_THROUGHPUT, !IS_TOTAL_ORDER, !IS_SPSC>;
+    using MemoryPool512Queue = LockFreeQueue<int32_t /* Offset of a 512-byte slot from the pool's base address */, MEMORY_POOL_512_SLOTS, -1, MINIMIZE_CONTENTION, MAXIMIZE_THROUGHPUT, !IS_TOTAL_ORDER, !IS_SPSC>;
+    using MemoryPoolUnlimitedLock = pthread_mutex_t; /* Held while someone works on the unlimited tier's free lists */
     using MemoryPool64QueueRawPtr = MemoryPool64Queue *;
     using MemoryPool256QueueRawPtr = MemoryPool256Queue *;
     using MemoryPool512QueueRawPtr = MemoryPool512Queue *;
     using MemoryPoolUnlimitedLockRawPtr = MemoryPoolUnlimitedLock *;
-    
-    MemoryPool(UInt8RawPtr baseAddr, uint32_t size)
+
+    /* At the start of the unlimited tier's area, blocks are numbered in MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE units. */
+    struct MemoryPoolUnlimitedHeader
+    {
+        uint32_t nrMaxBlocks; /* Blocks of MEMORY_POOL_UNLIMITED_MAX_BLOCK_SIZE taken into use so far */
+        std::array<int32_t, MEMORY_POOL_UNLIMITED_NUMBER_OF_ORDERS> freeLists; /* First free block of each order, -1 if none */
+        std::array<uint8_t, MEMORY_POOL_UNLIMITED_MIN_BLOCKS> blockStates; /* MEMORY_POOL_UNLIMITED_BLOCK_* | order, at a block's first unit */
+    };
+    using MemoryPoolUnlimitedHeaderRawPtr = MemoryPoolUnlimitedHeader *;
+
+    /* Written into free blocks, so that they can be unlinked when their buddy is freed. */
+    struct MemoryPoolUnlimitedFreeBlock
+    {
+        int32_t next;
+        int32_t prev;
+    };
+
+    static_assert(sizeof(MemoryPool64Queue) <= MEMORY_POOL_64_METADATA_SIZE, "MEMORY_POOL_64_SLOTS must be a power of 2!");
+    static_assert(sizeof(MemoryPool256Queue) <= MEMORY_POOL_256_METADATA_SIZE, "MEMORY_POOL_256_SLOTS must be a power of 2!");
+    static_assert(sizeof(MemoryPool512Queue) <= MEMORY_POOL_512_METADATA_SIZE, "MEMORY_POOL_512_SLOTS must be a power of 2!");
+    static_assert(sizeof(MemoryPoolUnlimitedHeader) <= MEMORY_POOL_UNLIMITED_HEADER_SIZE, "Invalid MEMORY_POOL_UNLIMITED_HEADER_SIZE!");
+    static_assert(MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE > MEMORY_POOL_512_SLOT_SIZE, "Unlimited tier must start above the largest size class!");
+
+    /***
+     * isAttaching = true is for a pool which has already been initialised by someone else,
+     * e.g. a peer Region's pool mapped from POSIX shared memory. Only the handles are set up then.
+     */
+    MemoryPool(UInt8RawPtr baseAddr, uint32_t size, bool isAttaching = false)
         : m_baseAddr(baseAddr)
     {
-        if(size < MEMORY_POOL_TOTAL_SIZE)
+        if(!m_baseAddr || size < MEMORY_POOL_TOTAL_SIZE)
         {
             return;
         }
-        
+
+        if(isAttaching)
+        {
+            m_pool64 = reinterpret_cast<MemoryPool64QueueRawPtr>(m_baseAddr + MEMORY_POOL_64_METADATA_OFFSET);
+            m_pool256 = reinterpret_cast<MemoryPool256QueueRawPtr>(m_baseAddr + MEMORY_POOL_256_METADATA_OFFSET);
+            m_pool512 = reinterpret_cast<MemoryPool512QueueRawPtr>(m_baseAddr + MEMORY_POOL_512_METADATA_OFFSET);
+            m_poolUnlimited = reinterpret_cast<MemoryPoolUnlimitedLockRawPtr>(m_baseAddr + MEMORY_POOL_UNLIMITED_METADATA_OFFSET);
+            return;
+        }
+
         /* Put pool metadata on allocated memory. */
-        m_pool64 = new (m_baseAddr) MemoryPool64Queue();
-        m_pool256 = new (m_pool64 + MEMORY_POOL_64_METADATA_SIZE) MemoryPool256Queue();
-        m_pool512 = new (m_pool256 + MEMORY_POOL_256_METADATA_SIZE) MemoryPool512Queue();
-        m_poolUnlimited = new (m_pool512 + MEMORY_POOL_UNLIMITED_METADATA_SIZE) MemoryPoolUnlimitedLock();
-        
+        m_pool64 = new (m_baseAddr + MEMORY_POOL_64_METADATA_OFFSET) MemoryPool64Queue();
+        m_pool256 = new (m_baseAddr + MEMORY_POOL_256_METADATA_OFFSET) MemoryPool256Queue();
+        m_pool512 = new (m_baseAddr + MEMORY_POOL_512_METADATA_OFFSET) MemoryPool512Queue();
+        m_poolUnlimited = reinterpret_cast<MemoryPoolUnlimitedLockRawPtr>(m_baseAddr + MEMORY_POOL_UNLIMITED_METADATA_OFFSET);
+        pthread_mutexattr_t lockAttrs;
+        pthread_mutexattr_init(&lockAttrs);
+        pthread_mutexattr_setpshared(&lockAttrs, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&lockAttrs, PTHREAD_MUTEX_ROBUST);
+        pthread_mutex_init(m_poolUnlimited, &lockAttrs);
+        pthread_mutexattr_destroy(&lockAttrs);
+
         /* Initialise pool slots. */
-        for(int32_t i = 0; i < static_cast<uint32_t>(MEMORY_POOL_64_SLOTS); ++i)
+        for(uint32_t i = 0; i < MEMORY_POOL_64_SLOTS; ++i)
         {
-            m_pool64->push(MEMORY_POOL_64_START_OFFSET + i * MEMORY_POOL_64_SLOT_SIZE);
+            m_pool64->push(static_cast<int32_t>(MEMORY_POOL_64_START_OFFSET + i * MEMORY_POOL_64_SLOT_SIZE));
         }
-        for(int32_t i = 0; i < static_cast<uint32_t>(MEMORY_POOL_256_SLOTS); ++i)
+        for(uint32_t i = 0; i < MEMORY_POOL_256_SLOTS; ++i)
         {
-            m_pool256->push(MEMORY_POOL_256_START_OFFSET + i * MEMORY_POOL_256_SLOT_SIZE);
+            m_pool256->push(static_cast<int32_t>(MEMORY_POOL_256_START_OFFSET + i * MEMORY_POOL_256_SLOT_SIZE));
         }
-        for(int32_t i = 0; i < static_cast<uint32_t>(MEMORY_POOL_512_SLOTS); ++i)
+        for(uint32_t i = 0; i < MEMORY_POOL_512_SLOTS; ++i)
         {
-            m_pool512->push(MEMORY_POOL_512_START_OFFSET + i * MEMORY_POOL_512_SLOT_SIZE);
+            m_pool512->push(static_cast<int32_t>(MEMORY_POOL_512_START_OFFSET + i * MEMORY_POOL_512_SLOT_SIZE));
         }
     }
-    
-    ~MemoryPool()
-    {}
-    
+
+    ~MemoryPool() = default;
+
+    MemoryPool(const MemoryPool &other) = delete;
+    MemoryPool &operator=(const MemoryPool &other) = delete;
+    MemoryPool(MemoryPool &&other) noexcept = delete;
+    MemoryPool &operator=(MemoryPool &&other) noexcept = delete;
+
+    bool isInitialised() const
+    {
+        return m_pool64 != nullptr;
+    }
+
+    /***
+     * Places the unlimited tier on size bytes at addr, at least MEMORY_POOL_UNLIMITED_TOTAL_SIZE, e.g. from
+     * MemoryAllocator::append() on the params this pool's region came from. isAttaching = true is for a tier which
+     * its owner has already set up, as for the constructor.
+     */
+    bool appendUnlimited(UInt8RawPtr addr, uint32_t size, bool isAttaching = false)
+    {
+        if(!isInitialised() || m_poolUnlimitedHeader || !addr || size < MEMORY_POOL_UNLIMITED_TOTAL_SIZE)
+        {
+            return false;
+        }
+
+        if(isAttaching)
+        {
+            m_poolUnlimitedHeader = reinterpret_cast<MemoryPoolUnlimitedHeaderRawPtr>(addr);
+        } else
+        {
+            m_poolUnlimitedHeader = new (addr) MemoryPoolUnlimitedHeader();
+            m_poolUnlimitedHeader->nrMaxBlocks = 0;
+            m_poolUnlimitedHeader->freeLists.fill(-1);
+            m_poolUnlimitedHeader->blockStates.fill(MEMORY_POOL_UNLIMITED_BLOCK_NONE);
+        }
+        m_poolUnlimitedBaseAddr = addr + MEMORY_POOL_UNLIMITED_HEADER_SIZE;
+        return true;
+    }
+
+    bool hasUnlimited() const
+    {
+        return m_poolUnlimitedHeader != nullptr;
+    }
+
+    /***
+     * Never blocks. If the matching size class is exhausted, larger classes are tried.
+     * Returns nullptr if no slot is big enough or all candidate classes are exhausted,
+     * callers are expected to fall back to the heap in that case.
+     */
     UInt8RawPtr allocate(uint32_t size)
     {
-        if(size <= MEMORY_POOL_64_SLOT_SIZE)
+        int32_t offset {-1};
+        if(size <= MEMORY_POOL_64_SLOT_SIZE && m_pool64->tryPop(offset)) LIKELY
         {
-            auto index = m_pool64->pop();
-            return reinterpret_cast<UInt8RawPtr>(m_baseAddr + MEMORY_POOL_64_START_OFFSET + index * MEMORY_POOL_64_SLOT_SIZE);
-        } else if(size <= MEMORY_POOL_256_SLOT_SIZE)
+            return m_baseAddr + offset;
+        }
+        if(size <= MEMORY_POOL_256_SLOT_SIZE && m_pool256->tryPop(offset))
         {
-            auto index = m_pool256->pop();
-            return reinterpret_cast<UInt8RawPtr>(m_baseAddr + MEMORY_POOL_256_START_OFFSET + index * MEMORY_POOL_256_SLOT_SIZE);
-        } else if(size <= MEMORY_POOL_512_SLOT_SIZE)
+            return m_baseAddr + offset;
+        }
+        if(size <= MEMORY_POOL_512_SLOT_SIZE && m_pool512->tryPop(offset))
         {
-            auto index = m_pool512->pop();
-            return reinterpret_cast<UInt8RawPtr>(m_baseAddr + MEMORY_POOL_512_START_OFFSET + index * MEMORY_POOL_512_SLOT_SIZE);
+            return m_baseAddr + offset;
+        }
+        if(size <= MEMORY_POOL_UNLIMITED_MAX_BLOCK_SIZE && m_poolUnlimitedHeader)
+        {
+            return allocateUnlimited(size);
         }
         return nullptr;
     }
-    
-    void deallocate(uint32_t size)
+
+    /***
+     * Returns false if ptr does not belong to this pool, e.g. it was a heap fallback.
+     */
+    bool deallocate(UInt8RawPtr ptr)
     {
-        if(m_mode == MEMORY_POOL_MODE_NO_POOLING)
+        if(!ownsSlot(ptr)) UNLIKELY
         {
-            return new uint8_t[size];
-        } else if (m_mode == MEMORY_POOL_MODE_SYSV_SHARED
-            || m_mode == MEMORY_POOL_MODE_POSIX_SHARED
-            || m_mode == MEMORY_POOL_MODE_THREAD_SHARED)
+            return ownsUnlimited(ptr) && deallocateUnlimited(ptr);
+        }
+
+        auto offset = static_cast<int32_t>(reinterpret_cast<uintptr_t>(ptr) - reinterpret_cast<uintptr_t>(m_baseAddr));
+        if(offset < static_cast<int32_t>(MEMORY_POOL_256_START_OFFSET))
         {
-            if(size <= MEMORY_POOL_64_SLOT_SIZE)
-            {
-                auto index = m_pool64->pop();
-                return reinterpret_cast<UInt8RawPtr>(m_baseAddr + MEMORY_POOL_64_START_OFFSET + index * MEMORY_POOL_64_SLOT_SIZE);
-            } else if(size <= MEMORY_POOL_256_SLOT_SIZE)
-            {
-                auto index = m_pool256->pop();
-                return reinterpret_cast<UInt8RawPtr>(m_baseAddr + MEMORY_POOL_256_START_OFFSET + index * MEMORY_POOL_256_SLOT_SIZE);
-            } else if(size <= MEMORY_POOL_512_SLOT_SIZE)
+            m_pool64->push(offset);
+        } else if(offset < static_cast<int32_t>(MEMORY_POOL_512_START_OFFSET))
+        {
+            m_pool256->push(offset);
+        } else
+        {
+            m_pool512->push(offset);
+        }
+        return true;
+    }
+
+    /* Smallest size class size fits into, MEMORY_POOL_NUMBER_OF_SIZE_CLASSES if it is too large for all of them. */
+    static uint32_t getSizeClass(uint32_t size)
+    {
+        if(size <= MEMORY_POOL_64_SLOT_SIZE) LIKELY
+        {
+            return MEMORY_POOL_SIZE_CLASS_64;
+        }
+        if(size <= MEMORY_POOL_256_SLOT_SIZE)
+        {
+            return MEMORY_POOL_SIZE_CLASS_256;
+        }
+        return size <= MEMORY_POOL_512_SLOT_SIZE ? MEMORY_POOL_SIZE_CLASS_512 : MEMORY_POOL_NUMBER_OF_SIZE_CLASSES;
+    }
+
+    /* Size class ptr was allocated from, MEMORY_POOL_NUMBER_OF_SIZE_CLASSES if it does not belong to any of them. */
+    uint32_t getSlotSizeClass(UInt8RawPtr ptr) const
+    {
+        if(!ownsSlot(ptr)) UNLIKELY
+        {
+            return MEMORY_POOL_NUMBER_OF_SIZE_CLASSES;
+        }
+
+        auto offset = reinterpret_cast<uintptr_t>(ptr) - reinterpret_cast<uintptr_t>(m_baseAddr);
+        if(offset < MEMORY_POOL_256_START_OFFSET)
+        {
+            return MEMORY_POOL_SIZE_CLASS_64;
+        }
+        return offset < MEMORY_POOL_512_START_OFFSET ? MEMORY_POOL_SIZE_CLASS_256 : MEMORY_POOL_SIZE_CLASS_512;
+    }
+
+    /***
+     * Takes up to count (at most MEMORY_POOL_MAX_BATCH_SIZE) slots of exactly sizeClass with one claim on its free
+     * list, no fallback to larger classes. Returns how many were written to slots.
+     */
+    uint32_t allocateBatch(uint32_t sizeClass, UInt8RawPtr *slots, uint32_t count)
+    {
+        std::array<int32_t, MEMORY_POOL_MAX_BATCH_SIZE> offsets;
+        count = std::min(count, MEMORY_POOL_MAX_BATCH_SIZE);
+        uint32_t nrSlots {0};
+        switch(sizeClass)
+        {
+        case MEMORY_POOL_SIZE_CLASS_64:
+            nrSlots = m_pool64->tryPopBatch(offsets.data(), count);
+            break;
+        case MEMORY_POOL_SIZE_CLASS_256:
+            nrSlots = m_pool256->tryPopBatch(offsets.data(), count);
+            break;
+        case MEMORY_POOL_SIZE_CLASS_512:
+            nrSlots = m_pool512->tryPopBatch(offsets.data(), count);
+            break;
+        default:
+            break;
+        }
+        for(uint32_t i = 0; i < nrSlots; ++i)
+        {
+            slots[i] = m_baseAddr + offsets[i];
+        }
+        return nrSlots;
+    }
+
+    /* Gives back count (at most MEMORY_POOL_MAX_BATCH_SIZE) slots of sizeClass, all of them must have come from this pool. */
+    void deallocateBatch(uint32_t sizeClass, const UInt8RawPtr *slots, uint32_t count)
+    {
+        std::array<int32_t, MEMORY_POOL_MAX_BATCH_SIZE> offsets;
+        count = std::min(count, MEMORY_POOL_MAX_BATCH_SIZE);
+        for(uint32_t i = 0; i < count; ++i)
+        {
+            offsets[i] = static_cast<int32_t>(reinterpret_cast<uintptr_t>(slots[i]) - reinterpret_cast<uintptr_t>(m_baseAddr));
+        }
+        switch(sizeClass)
+        {
+        case MEMORY_POOL_SIZE_CLASS_64:
+            m_pool64->pushBatch(offsets.data(), count);
+            break;
+        case MEMORY_POOL_SIZE_CLASS_256:
+            m_pool256->pushBatch(offsets.data(), count);
+            break;
+        case MEMORY_POOL_SIZE_CLASS_512:
+            m_pool512->pushBatch(offsets.data(), count);
+            break;
+        default:
+            break;
+        }
+    }
+
+    /* Bytes usable at ptr, 0 if it is not an allocated slot or block of this pool. */
+    uint32_t getSlotSize(UInt8RawPtr ptr) const
+    {
+        static constexpr std::array<uint32_t, MEMORY_POOL_NUMBER_OF_SIZE_CLASSES> slotSizes {MEMORY_POOL_64_SLOT_SIZE, MEMORY_POOL_256_SLOT_SIZE, MEMORY_POOL_512_SLOT_SIZE};
+        if(ownsSlot(ptr)) LIKELY
+        {
+            return slotSizes[getSlotSizeClass(ptr)];
+        }
+        if(!ownsUnlimited(ptr) || getUnlimitedFreeBlock(getUnlimitedBlock(ptr)) != reinterpret_cast<MemoryPoolUnlimitedFreeBlock *>(ptr))
+        {
+            return 0;
+        }
+        uint8_t state = m_poolUnlimitedHeader->blockStates[getUnlimitedBlock(ptr)];
+        return (state & MEMORY_POOL_UNLIMITED_BLOCK_USED) ? MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE << (state & MEMORY_POOL_UNLIMITED_BLOCK_ORDER_MASK) : 0;
+    }
+
+    UInt8RawPtr getBaseAddress() const
+    {
+        return m_baseAddr;
+    }
+
+    /***
+     * Position of ptr which means the same in every process mapping this pool, e.g. to be pushed into an rx ring.
+     * The unlimited tier is mapped on its own, its blocks count from MEMORY_POOL_UNLIMITED_START_OFFSET.
+     */
+    int32_t getOffset(UInt8RawPtr ptr) const
+    {
+        if(ownsUnlimited(ptr)) UNLIKELY
+        {
+            return static_cast<int32_t>(MEMORY_POOL_UNLIMITED_START_OFFSET + (ptr - m_poolUnlimitedBaseAddr));
+        }
+        return static_cast<int32_t>(ptr - m_baseAddr);
+    }
+
+    /* Inverse of getOffset(), nullptr if offset is outside this pool. */
+    UInt8RawPtr getAddress(int32_t offset) const
+    {
+        if(offset >= static_cast<int32_t>(MEMORY_POOL_UNLIMITED_START_OFFSET)) UNLIKELY
+        {
+            if(!m_poolUnlimitedBaseAddr)
             {
-                auto index = m_pool512->pop();
-                return reinterpret_cast<UInt8RawPtr>(m_baseAddr + MEMORY_POOL_512_START_OFFSET + index * MEMORY_POOL_512_SLOT_SIZE);
+                return nullptr;
             }
+            UInt8RawPtr ptr = m_poolUnlimitedBaseAddr + (offset - MEMORY_POOL_UNLIMITED_START_OFFSET);
+            return ownsUnlimited(ptr) ? ptr : nullptr;
         }
-        return nullptr;
+        return offset >= 0 && ownsSlot(m_baseAddr + offset) ? m_baseAddr + offset : nullptr;
+    }
+
+    bool owns(UInt8RawPtr ptr) const
+    {
+        return ownsSlot(ptr) || ownsUnlimited(ptr);
     }
 
 private:
+    /* In one of the size classes. */
+    bool ownsSlot(UInt8RawPtr ptr) const
+    {
+        if(!isInitialised()) UNLIKELY
+        {
+            return false;
+        }
+        auto addr = reinterpret_cast<uintptr_t>(ptr);
+        auto base = reinterpret_cast<uintptr_t>(m_baseAddr);
+        return addr >= base + MEMORY_POOL_64_START_OFFSET && addr < base + MEMORY_POOL_END_OFFSET;
+    }
 
-    struct NoDelete
+    bool ownsUnlimited(UInt8RawPtr ptr) const
     {
-        void operator()(void *) const noexcept
-        {}
-    };
-    
+        auto addr = reinterpret_cast<uintptr_t>(ptr);
+        auto base = reinterpret_cast<uintptr_t>(m_poolUnlimitedBaseAddr);
+        return m_poolUnlimitedBaseAddr && addr >= base && addr < base + MEMORY_POOL_UNLIMITED_DATA_SIZE;
+    }
+
+    int32_t getUnlimitedBlock(UInt8RawPtr ptr) const
+    {
+        return static_cast<int32_t>((ptr - m_poolUnlimitedBaseAddr) / MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE);
+    }
+
+    MemoryPoolUnlimitedFreeBlock *getUnlimitedFreeBlock(int32_t block) const
+    {
+        return reinterpret_cast<MemoryPoolUnlimitedFreeBlock *>(m_poolUnlimitedBaseAddr + block * MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE);
+    }
+
+    /***
+     * Whoever holds the lock may be another process. If it died holding it, the lock is handed over
+     * with EOWNERDEAD and the free lists, which it may have left half updated, are rebuilt first.
+     */
+    void lockUnlimited()
+    {
+        if(pthread_mutex_lock(m_poolUnlimited) == EOWNERDEAD) UNLIKELY
+        {
+            rebuildUnlimitedFreeLists();
+            pthread_mutex_consistent(m_poolUnlimited);
+        }
+    }
+
+    void unlockUnlimited()
+    {
+        pthread_mutex_unlock(m_poolUnlimited);
+    }
+
+    /***
+     * The links may be half updated, so the lists are rebuilt from the block states. Blocks the dead holder was
+     * splitting, merging or handing out are lost that way, but none of them can be handed out twice.
+     */
+    void rebuildUnlimitedFreeLists()
+    {
+        m_poolUnlimitedHeader->freeLists.fill(-1);
+        int32_t nrBlocks = static_cast<int32_t>(m_poolUnlimitedHeader->nrMaxBlocks << (MEMORY_POOL_UNLIMITED_NUMBER_OF_ORDERS - 1));
+        for(int32_t block = 0; block < nrBlocks;)
+        {
+            uint8_t state = m_poolUnlimitedHeader->blockStates[block];
+            uint32_t order = state & MEMORY_POOL_UNLIMITED_BLOCK_ORDER_MASK;
+            if(state & MEMORY_POOL_UNLIMITED_BLOCK_FREE)
+            {
+                pushUnlimitedFreeBlock(block, order);
+            }
+            block += (state == MEMORY_POOL_UNLIMITED_BLOCK_NONE) ? 1 : (1 << order);
+        }
+    }
+
+    void pushUnlimitedFreeBlock(int32_t block, uint32_t order)
+    {
+        auto &freeList = m_poolUnlimitedHeader->freeLists[order];
+        MemoryPoolUnlimitedFreeBlock *freeBlock = getUnlimitedFreeBlock(block);
+        freeBlock->next = freeList;
+        freeBlock->prev = -1;
+        if(freeList >= 0)
+        {
+            getUnlimitedFreeBlock(freeList)->prev = block;
+        }
+        freeList = block;
+        m_poolUnlimitedHeader->blockStates[block] = MEMORY_POOL_UNLIMITED_BLOCK_FREE | order;
+    }
+
+    void removeUnlimitedFreeBlock(int32_t block, uint32_t order)
+    {
+        MemoryPoolUnlimitedFreeBlock *freeBlock = getUnlimitedFreeBlock(block);
+        if(freeBlock->prev >= 0)
+        {
+            getUnlimitedFreeBlock(freeBlock->prev)->next = freeBlock->next;
+        } else
+        {
+            m_poolUnlimitedHeader->freeLists[order] = freeBlock->next;
+        }
+        if(freeBlock->next >= 0)
+        {
+            getUnlimitedFreeBlock(freeBlock->next)->prev = freeBlock->prev;
+        }
+        m_poolUnlimitedHeader->blockStates[block] = MEMORY_POOL_UNLIMITED_BLOCK_NONE;
+    }
+
+    /***
+     * Smallest free block of at least size bytes, split in halves down to the order size needs. With none left,
+     * the next MEMORY_POOL_UNLIMITED_MAX_BLOCK_SIZE of the area is taken into use.
+     */
+    UInt8RawPtr allocateUnlimited(uint32_t size)
+    {
+        uint32_t order {0};
+        while((MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE << order) < size)
+        {
+            ++order;
+        }
+
+        lockUnlimited();
+        uint32_t freeOrder = order;
+        while(freeOrder < MEMORY_POOL_UNLIMITED_NUMBER_OF_ORDERS && m_poolUnlimitedHeader->freeLists[freeOrder] < 0)
+        {
+            ++freeOrder;
+        }
+        if(freeOrder == MEMORY_POOL_UNLIMITED_NUMBER_OF_ORDERS)
+        {
+            if(m_poolUnlimitedHeader->nrMaxBlocks == MEMORY_POOL_UNLIMITED_MAX_BLOCKS) UNLIKELY
+            {
+                unlockUnlimited();
+                return nullptr;
+            }
+            freeOrder = MEMORY_POOL_UNLIMITED_NUMBER_OF_ORDERS - 1;
+            pushUnlimitedFreeBlock(static_cast<int32_t>(m_poolUnlimitedHeader->nrMaxBlocks++ << freeOrder), freeOrder);
+        }
+
+        int32_t block = m_poolUnlimitedHeader->freeLists[freeOrder];
+        removeUnlimitedFreeBlock(block, freeOrder);
+        while(freeOrder > order)
+        {
+            --freeOrder;
+            pushUnlimitedFreeBlock(block + (1 << freeOrder), freeOrder);
+        }
+        m_poolUnlimitedHeader->blockStates[block] = MEMORY_POOL_UNLIMITED_BLOCK_USED | order;
+        unlockUnlimited();
+        return m_poolUnlimitedBaseAddr + block * MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE;
+    }
+
+    /* Merges the block with its buddy for as long as that one is free and of the same size. */
+    bool deallocateUnlimited(UInt8RawPtr ptr)
+    {
+        int32_t block = getUnlimitedBlock(ptr);
+        lockUnlimited();
+        uint8_t state = m_poolUnlimitedHeader->blockStates[block];
+        if(!(state & MEMORY_POOL_UNLIMITED_BLOCK_USED) || getUnlimitedFreeBlock(block) != reinterpret_cast<MemoryPoolUnlimitedFreeBlock *>(ptr)) UNLIKELY
+        {
+            /* Not the start of an allocated block, freed twice or never allocated. */
+            unlockUnlimited();
+            return false;
+        }
+
+        uint32_t order = state & MEMORY_POOL_UNLIMITED_BLOCK_ORDER_MASK;
+        m_poolUnlimitedHeader->blockStates[block] = MEMORY_POOL_UNLIMITED_BLOCK_NONE;
+        while(order < MEMORY_POOL_UNLIMITED_NUMBER_OF_ORDERS - 1)
+        {
+            int32_t buddy = block ^ (1 << order);
+            if(m_poolUnlimitedHeader->blockStates[buddy] != (MEMORY_POOL_UNLIMITED_BLOCK_FREE | order))
+            {
+                break;
+            }
+            removeUnlimitedFreeBlock(buddy, order);
+            block = std::min(block, buddy);
+            ++order;
+        }
+        pushUnlimitedFreeBlock(block, order);
+        unlockUnlimited();
+        return true;
+    }
 
 private:
-    uint32_t m_mode;
     UInt8RawPtr m_baseAddr {nullptr};
-    MemoryPool64QueueRawPtr m_pool64 {nullptr}; /* 4KB */
-    MemoryPool256QueueRawPtr m_pool256 {nullptr}; /* 8KB */
-    MemoryPool512QueueRawPtr m_pool512 {nullptr}; /* 8KB */
-    
+    MemoryPool64QueueRawPtr m_pool64 {nullptr};
+    MemoryPool256QueueRawPtr m_pool256 {nullptr};
+    MemoryPool512QueueRawPtr m_pool512 {nullptr};
+
     MemoryPoolUnlimitedLockRawPtr m_poolUnlimited {nullptr};
-    uint32_t m_poolUnlimitedStartOffset {0};
+    MemoryPoolUnlimitedHeaderRawPtr m_poolUnlimitedHeader {nullptr};
+    UInt8RawPtr m_poolUnlimitedBaseAddr {nullptr}; /* First block, right behind the header */
+
+    friend class MemoryManagerTest;
+    FRIEND_TEST(MemoryManagerTest, memoryPoolTest1);
+    FRIEND_TEST(MemoryManagerTest, memoryPoolTest2);
+    FRIEND_TEST(MemoryManagerTest, memoryPoolTest3);
+    FRIEND_TEST(MemoryManagerTest, magazineTest1);
+    FRIEND_TEST(MemoryManagerTest, magazineTest2);
+    FRIEND_TEST(MemoryManagerTest, magazineTest3);
+    FRIEND_TEST(MemoryManagerTest, numaTest1);
+    FRIEND_TEST(MemoryManagerTest, unlimitedTest1);
+    FRIEND_TEST(MemoryManagerTest, unlimitedTest2);
+    FRIEND_TEST(MemoryManagerTest, unlimitedTest3);
 }; // class MemoryPool
 
+#define MEMORY_MAGAZINE_CAPACITY            (uint32_t)(32) /* Slots of each size class a thread keeps for itself */
+#define MEMORY_MAGAZINE_BATCH_SIZE          (uint32_t)(16) /* Slots moved between a magazine and the pool at once */
+#define MEMORY_MAGAZINE_POOL_SHARE          (uint32_t)(4) /* At most 1/4 of a size class's slots are held in magazines */
+
+static_assert(MEMORY_MAGAZINE_BATCH_SIZE <= MEMORY_POOL_MAX_BATCH_SIZE && MEMORY_MAGAZINE_BATCH_SIZE <= MEMORY_MAGAZINE_CAPACITY, "Invalid magazine batch size!");
+static_assert(MEMORY_POOL_512_SLOTS / MEMORY_MAGAZINE_POOL_SHARE >= MEMORY_MAGAZINE_CAPACITY, "Smallest size class must back at least one magazine!");
+
+/* Indexes into MemoryManager's counters */
+#define MEMORY_COUNTER_NODE_ALLOCS          (uint32_t)(0) /* allocate() for a given NUMA node, only counted with more than one node */
+#define MEMORY_COUNTER_NODE_FALLBACK_ALLOCS (uint32_t)(1) /* Of those, served from elsewhere since that node's pool was exhausted */
+#define MEMORY_NUMBER_OF_COUNTERS           (uint32_t)(2)
+
+/***
+ * Only allocations which name a node are counted, plain allocate() calls are not. Nothing tells whether a plain one
+ * was read on another node later, so there is no count of remote reads.
+ */
+struct MemoryStatistics
+{
+    uint32_t nrNumaNodes {1};
+    uint64_t nrNodeAllocs {0};
+    uint64_t nrNodeFallbackAllocs {0}; /* Not on the node asked for, since its pool was exhausted */
+};
+
+/***
+ * Process-wide owner of the message pool which backs ItcAdminMessageHelper::allocate/deallocate.
+ * Messages of up to MEMORY_POOL_UNLIMITED_MAX_BLOCK_SIZE which are too large for any size class come from the
+ * pool's unlimited tier. Larger ones, or those that arrive when the pool is exhausted, are served from the heap.
+ *
+ * Each thread keeps a magazine of free slots per size class in front of the pool, so that allocate/deallocate only
+ * touch thread-local memory as long as it is neither empty nor full. Magazines are refilled from and flushed to
+ * the pool's free lists MEMORY_MAGAZINE_BATCH_SIZE slots at a time. Only as many threads get a magazine of a size
+ * class as can be filled from 1/MEMORY_MAGAZINE_POOL_SHARE of its slots, the others use the pool's free lists
+ * directly, so idle threads cannot sit on a small size class. Slots of the shared pool, see setSharedPool(),
+ * never go into magazines, peer Regions allocate from it.
+ *
+ * On NUMA machines there is one pool per node, placed there by mbind(2). A thread's magazines serve the pool of the
+ * node it ran on when it first allocated. Callers who know the receiver of a message ask for the receiver's node
+ * instead, so that the receiver reads it from local memory, those slots bypass the magazines. These are
+ * ItcPlatform::allocateMessage() given a receiver, the sysv rx path and itc-server's deliveries from other Worlds.
+ * Plain allocateMessage() and thus most local sends do not know the receiver and stay on the sender's node.
+ */
 class MemoryManager
 {
+public:
+    static std::weak_ptr<MemoryManager> getInstance();
+    /***
+     * Same instance without getInstance()'s reference counting on a shared cache line, for the per-message paths.
+     * Nobody holds it, it is only valid as long as the MemoryManager is, which is until the process exits.
+     */
+    static MemoryManager *getInstanceRawPtr()
+    {
+        if(auto memManager = m_instanceRawPtr.load(MEMORY_ORDER_ACQUIRE)) LIKELY
+        {
+            return memManager;
+        }
+        return getInstance().lock().get();
+    }
+    virtual ~MemoryManager();
+
+    MemoryManager(const MemoryManager &other) = delete;
+    MemoryManager &operator=(const MemoryManager &other) = delete;
+    MemoryManager(MemoryManager &&other) noexcept = delete;
+    MemoryManager &operator=(MemoryManager &&other) noexcept = delete;
+
+    /* numaNode is where the message will be read, e.g. ItcTransportLocal::getNumaNode() of its receiver. */
+    UInt8RawPtr allocate(uint32_t size, uint32_t numaNode = MEMORY_NUMA_NODE_ANY);
+    void deallocate(UInt8RawPtr ptr);
+
+    /***
+     * Register this Region's POSIX shared memory pool, which peer Regions allocate into directly.
+     * Messages received from it are returned there by deallocate(). Pass nullptr to unregister.
+     */
+    void setSharedPool(MemoryPool *sharedPool);
+
+    /* Hands the calling thread's magazines back to the pool, done automatically when the thread exits. */
+    void flushThreadCache();
+
+    MemoryStatistics getStatistics() const;
 
 private:
-    MemoryPool m_memPool;
-    
-};
+    MemoryManager();
+
+    struct MemoryMagazine
+    {
+        /* Counted in m_nrFreeMagazines, without that the thread has to use the pool directly. */
+        bool isReserved {false};
+        uint32_t count {0};
+        std::array<UInt8RawPtr, MEMORY_MAGAZINE_CAPACITY> slots {};
+    };
+
+    struct ThreadMagazines
+    {
+        /* m_generation of the MemoryManager the slots belong to, 0 while empty. */
+        uint64_t generation {0};
+        /* Node of the pool the slots come from. */
+        uint32_t node {0};
+        std::array<MemoryMagazine, MEMORY_POOL_NUMBER_OF_SIZE_CLASSES> magazines;
+
+        ~ThreadMagazines();
+    };
+
+    /* Makes m_threadMagazines belong to this MemoryManager, a previous one's slots are simply forgotten. */
+    ThreadMagazines &getThreadMagazines();
+    UInt8RawPtr allocateOnNode(uint32_t size, uint32_t numaNode);
+    bool reserveMagazine(uint32_t node, uint32_t sizeClass, MemoryMagazine &magazine);
+
+private:
+    SINGLETON_DECLARATION(MemoryManager)
+
+    uint32_t m_nrNodes {1};
+    /* Indexed by NUMA node, a node without pool falls back to the heap. */
+    std::array<MemoryAllocatorParams, MEMORY_NUMA_MAX_NODES> m_allocatorParams;
+    std::array<std::unique_ptr<MemoryPool>, MEMORY_NUMA_MAX_NODES> m_memPools;
+    std::atomic<MemoryPool *> m_sharedPool {nullptr};
+    /* Magazines each node's pool can still back per size class. */
+    std::array<std::array<std::atomic<uint32_t>, MEMORY_POOL_NUMBER_OF_SIZE_CLASSES>, MEMORY_NUMA_MAX_NODES> m_nrFreeMagazines {};
+    uint64_t m_generation {0};
+    ShardedCounters<MEMORY_NUMBER_OF_COUNTERS> m_counters;
+
+    static std::atomic<uint64_t> m_lastGeneration;
+    static thread_local ThreadMagazines m_threadMagazines;
+
+    friend class MemoryManagerTest;
+    FRIEND_TEST(MemoryManagerTest, memoryManagerTest1);
+    FRIEND_TEST(MemoryManagerTest, memoryManagerTest2);
+    FRIEND_TEST(MemoryManagerTest, magazineTest1);
+    FRIEND_TEST(MemoryManagerTest, magazineTest2);
+    FRIEND_TEST(MemoryManagerTest, magazineTest3);
+    FRIEND_TEST(MemoryManagerTest, numaTest1);
+    FRIEND_TEST(MemoryManagerTest, unlimitedTest2);
+    FRIEND_TEST(ItcTransportPosixShmTest, createSharedSegmentTest1);
+    FRIEND_TEST(ItcTransportLocalTest, singletonFastPathTest1);
+}; // class MemoryManager
 
 
 } // namespace INTERNAL
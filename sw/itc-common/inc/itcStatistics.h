@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <array>
+
+#include "itc.h"
+#include "itcConstant.h"
+#include "itcLockFreeQueue.h"
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+using namespace ITC::PROVIDED;
+
+#define ITC_STATISTICS_NUMBER_OF_SHARDS             (uint32_t)(8)
+
+/* Indexes into ItcTransportCounters */
+#define ITC_TRANSPORT_COUNTER_SENT_MSGS             (uint32_t)(0)
+#define ITC_TRANSPORT_COUNTER_SENT_BYTES            (uint32_t)(1)
+#define ITC_TRANSPORT_COUNTER_FAILED_SENDS          (uint32_t)(2)
+#define ITC_TRANSPORT_COUNTER_RECEIVED_MSGS         (uint32_t)(3)
+#define ITC_TRANSPORT_COUNTER_RECEIVED_BYTES        (uint32_t)(4)
+#define ITC_TRANSPORT_COUNTER_DROPPED_MSGS          (uint32_t)(5)
+#define ITC_TRANSPORT_NUMBER_OF_COUNTERS            (uint32_t)(6)
+
+/* Shard of the calling thread, handed out round-robin on first use so that up to
+ * ITC_STATISTICS_NUMBER_OF_SHARDS threads never write into the same cache line. */
+inline uint32_t getStatisticsShardIndex()
+{
+    static std::atomic<uint32_t> nextShardIndex {0};
+    thread_local uint32_t shardIndex = nextShardIndex.fetch_add(1, MEMORY_ORDER_RELAXED) % ITC_STATISTICS_NUMBER_OF_SHARDS;
+    return shardIndex;
+}
+
+/***
+ * Counters written by many threads at once, e.g. all senders to one mailbox. A write is a relaxed fetch_add
+ * into the cache-line-padded shard of the calling thread, a read sums all shards up.
+ * Reads are therefore not an atomic cut across counters, which is fine for statistics.
+ */
+template<uint32_t NUMBER_OF_COUNTERS>
+class ShardedCounters
+{
+public:
+    void add(uint32_t counter, uint64_t value = 1)
+    {
+        m_shards[getStatisticsShardIndex()].counters[counter].fetch_add(value, MEMORY_ORDER_RELAXED);
+    }
+
+    uint64_t get(uint32_t counter) const
+    {
+        uint64_t sum = 0;
+        for(const auto &shard : m_shards)
+        {
+            sum += shard.counters[counter].load(MEMORY_ORDER_RELAXED);
+        }
+        return sum;
+    }
+
+    void reset()
+    {
+        for(auto &shard : m_shards)
+        {
+            for(auto &counter : shard.counters)
+            {
+                counter.store(0, MEMORY_ORDER_RELAXED);
+            }
+        }
+    }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Shard
+    {
+        std::array<std::atomic<uint64_t>, NUMBER_OF_COUNTERS> counters {};
+    };
+
+    std::array<Shard, ITC_STATISTICS_NUMBER_OF_SHARDS> m_shards {};
+};
+
+using ItcTransportCounters = ShardedCounters<ITC_TRANSPORT_NUMBER_OF_COUNTERS>;
+
+inline TransportStatistics getTransportStatistics(const ItcTransportCounters &counters)
+{
+    TransportStatistics statistics;
+    statistics.nrSentMsgs = counters.get(ITC_TRANSPORT_COUNTER_SENT_MSGS);
+    statistics.nrSentBytes = counters.get(ITC_TRANSPORT_COUNTER_SENT_BYTES);
+    statistics.nrFailedSends = counters.get(ITC_TRANSPORT_COUNTER_FAILED_SENDS);
+    statistics.nrReceivedMsgs = counters.get(ITC_TRANSPORT_COUNTER_RECEIVED_MSGS);
+    statistics.nrReceivedBytes = counters.get(ITC_TRANSPORT_COUNTER_RECEIVED_BYTES);
+    statistics.nrDroppedMsgs = counters.get(ITC_TRANSPORT_COUNTER_DROPPED_MSGS);
+    return statistics;
+}
+
+} // namespace INTERNAL
+} // namespace ITC
@@ -23,6 +23,9 @@ using namespace ITC::PROVIDED;
 #define ITC_SYSTEM_MESSAGE_LOCATE_MBOX_ASYNC_IN_ITC_SERVER_REQUEST 					(uint32_t)(ITC_SYSTEM_MESSAGE_NUMBER_BASE + 0x4)
 // #define ITC_SYSTEM_MESSAGE_LOCATE_MBOX_IN_ITC_SERVER_REPLY							(uint32_t)(ITC_SYSTEM_MESSAGE_NUMBER_BASE + 0x5) // Defined in itc-api header files such as itc.h
 #define ITC_SYSTEM_MESSAGE_FORWARD_MESSAGE_TO_ITC_SERVER_REQUEST					(uint32_t)(ITC_SYSTEM_MESSAGE_NUMBER_BASE + 0x6)
+/* Relayed by itc-server to every Region once a mailbox is deleted, payload is the deletion notification itself.
+ * Consumed by the Region's rx thread, which drops all locate caches of that process. */
+#define ITC_SYSTEM_MESSAGE_NOTIFY_MBOX_DELETION_FROM_ITC_SERVER_INDICATION			(uint32_t)(ITC_SYSTEM_MESSAGE_NUMBER_BASE + 0x7)
 
 
 struct itc_system_message_notify_mbox_creation_deletion_to_itc_server_request
@@ -82,6 +82,7 @@ private:
 	FRIEND_TEST(ThreadManagerIfTest, startAllThreadsTest1);
 	FRIEND_TEST(ThreadManagerIfTest, startAllThreadsTest2);
 	FRIEND_TEST(ThreadManagerIfTest, startAllThreadsTest3);
+	FRIEND_TEST(ThreadManagerIfTest, startAllThreadsTest4);
 	FRIEND_TEST(ThreadManagerIfTest, terminateAllThreadsTest1);
 }; // class ThreadManager
 
@@ -15,6 +15,7 @@
 #include "itcMailbox.h"
 #include "itcAdminMessage.h"
 #include "itcConcurrentContainer.h"
+#include "itcStatistics.h"
 
 namespace ITC
 {
@@ -45,7 +46,20 @@ public:
     bool initialise(std::shared_ptr<ConcurrentContainer<ItcMailbox, ITC_MAX_SUPPORTED_MAILBOXES>> mboxList);
     
     ItcPlatformIfReturnCode send(ItcAdminMessageRawPtr adminMsg);
-    ItcAdminMessageRawPtr receive(ItcMailboxRawPtr myMbox, uint32_t mode = ITC_MODE_DEFAULT);
+    /***
+     * All messages must be addressed to this Region. Messages which were taken are set to nullptr,
+     * ITC_FAILED means some of them are still left in adminMsgs.
+     * Sort adminMsgs by receiver first to get one queue operation per receiver.
+     */
+    ItcPlatformIfReturnCode sendBatch(ItcAdminMessageRawPtr *adminMsgs, size_t count);
+    ItcAdminMessageRawPtr receive(ItcMailboxRawPtr myMbox, uint32_t mode = ITC_MODE_DEFAULT, uint32_t timeout = 0);
+    ItcAdminMessageRawPtr receiveSelective(ItcMailboxRawPtr myMbox, const std::vector<uint32_t> &filter, uint32_t mode = ITC_MODE_DEFAULT, uint32_t timeout = 0);
+    size_t receiveBatch(ItcMailboxRawPtr myMbox, ItcAdminMessageRawPtr *adminMsgs, size_t maxCount, uint32_t mode = ITC_MODE_DEFAULT, uint32_t timeout = 0);
+    /* myMboxes are mailboxes of the calling thread, highest priority first. */
+    ItcAdminMessageRawPtr receiveAny(ItcMailboxRawPtr *myMboxes, size_t count, uint32_t mode = ITC_MODE_DEFAULT, uint32_t timeout = 0);
+    TransportStatistics getStatistics() const;
+    /* NUMA node the mailbox of this Region was placed on, for allocating messages where they will be read. */
+    uint32_t getNumaNode(itc_mailbox_id_t mboxId) const;
     
 private:
     SINGLETON_DECLARATION(ItcTransportLocal)
@@ -53,13 +67,20 @@ private:
     
 private:
     std::weak_ptr<ConcurrentContainer<ItcMailbox, ITC_MAX_SUPPORTED_MAILBOXES>> m_mboxList;
+    ItcTransportCounters m_counters;
     
     friend class ItcTransportLocalTest;
 	FRIEND_TEST(ItcTransportLocalTest, test1);
 	FRIEND_TEST(ItcTransportLocalTest, test2);
+	FRIEND_TEST(ItcTransportLocalTest, sendBatchTest1);
+	FRIEND_TEST(ItcTransportLocalTest, receiveBatchTest1);
+	FRIEND_TEST(ItcTransportLocalTest, singletonFastPathTest1);
 	FRIEND_TEST(ItcTransportLocalTest, sendReceiveTest2);
 	FRIEND_TEST(ItcTransportLocalTest, sendReceiveTest3);
 	FRIEND_TEST(ItcTransportLocalTest, sendReceiveTest4);
+	FRIEND_TEST(ItcTransportLocalTest, statisticsTest1);
+	FRIEND_TEST(ItcTransportLocalTest, receiveAnyTest1);
+	FRIEND_TEST(ItcTransportLocalTest, resendTest1);
 }; // class ItcTransportLocal
 
 } // namespace INTERNAL
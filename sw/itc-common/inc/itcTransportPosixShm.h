@@ -0,0 +1,190 @@
+#pragma once
+
+#include <string>
+#include <array>
+#include <vector>
+#include <utility>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <memory>
+#include <algorithm>
+
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/types.h>
+
+#include <gtest/gtest.h>
+
+#include "itc.h"
+#include "itcConstant.h"
+#include "itcAdminMessage.h"
+#include "itcMemoryManager.h"
+#include "itcLockFreeQueue.h"
+#include "itcSyncObject.h"
+#include "itcStatistics.h"
+
+void *posixShmRxThreadWrapper(void *args);
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+using namespace ITC::PROVIDED;
+using ItcPlatformIfReturnCode = ItcPlatformIf::ItcPlatformIfReturnCode;
+
+#define ITC_POSIX_SHM_NAME_PREFIX               "/itc_posixshm_region_"
+#define ITC_POSIX_SHM_RX_RING_SLOTS             (uint32_t)(1024)
+#define ITC_POSIX_SHM_RX_AWAKE                  (uint32_t)(0)
+#define ITC_POSIX_SHM_RX_PARKED                 (uint32_t)(1)
+#define ITC_POSIX_SHM_RX_PARK_TIMEOUT           (uint32_t)(1000) /* ms, the parked rx thread re-checks whether it was cancelled at least that often. */
+
+/***
+ * Every Region owns one POSIX shared memory segment (MEMORY_ALLOCATOR_MODE_3):
+ * + PosixShmHeader                                         = (64 bytes)
+ * + rx ring of MemoryPool offsets                          = (4224 bytes)      } -> 2 pages (8KB)
+ * + MemoryPool, see itcMemoryManager.h                     = (792KB)
+ * + MemoryPool's unlimited tier, see MemoryAllocator::append()  = (8MB + 12KB, pages used on demand)
+ *
+ * Senders map the receiver's segment, allocate a slot straight from the receiver's MemoryPool,
+ * write the message there and push the slot's offset into the receiver's rx ring.
+ * Messages of up to MEMORY_POOL_UNLIMITED_MAX_BLOCK_SIZE take the same way through the unlimited tier.
+ * The receiver hands the very same slot to the destination mailbox, so nothing passes through the kernel.
+ * When the message is deallocated, MemoryManager returns the slot into the shared pool again.
+ */
+struct PosixShmHeader
+{
+    std::atomic<uint32_t>   isReady {0};
+    pid_t                   ownerPid {-1};
+    std::atomic<uint32_t>   rxWaiterState {ITC_POSIX_SHM_RX_AWAKE}; /* Process-shared futex word, the rx thread parks on it while the rx ring is empty. */
+};
+
+using PosixShmRxRing = LockFreeQueue<int32_t /* MemoryPool::getOffset() of a slot in the receiver's pool */, ITC_POSIX_SHM_RX_RING_SLOTS, -1, MINIMIZE_CONTENTION, MAXIMIZE_THROUGHPUT, !IS_TOTAL_ORDER, !IS_SPSC>;
+using PosixShmRxRingRawPtr = PosixShmRxRing *;
+
+/***
+ * Never modified once published in m_contactList. When the receiver re-creates its segment,
+ * the whole object is replaced by a new one, so senders never see a half torn down mapping.
+ */
+struct PosixShmContactInfo
+{
+    MemoryAllocatorParams               params;
+    PosixShmHeader                      *header {nullptr};
+    PosixShmRxRingRawPtr                rxRing {nullptr};
+    std::unique_ptr<MemoryPool>         pool {nullptr};
+};
+
+/***
+ * This transport is to exchange messages between Regions/Processes on the same host without copying them into the kernel.
+ * Messages which do not fit into the receiver's pool are left to ItcTransportSysvMsgQueue.
+ */
+class ItcTransportPosixShm
+{
+public:
+    static constexpr uint32_t RX_RING_OFFSET = ROUND_UP_TO_64_BYTES(sizeof(PosixShmHeader));
+    static constexpr uint32_t POOL_OFFSET = ROUND_UP_TO_PAGE_SIZES(RX_RING_OFFSET + sizeof(PosixShmRxRing));
+    static constexpr uint32_t SEGMENT_SIZE = POOL_OFFSET + MEMORY_POOL_TOTAL_SIZE;
+
+    static std::weak_ptr<ItcTransportPosixShm> getInstance();
+    virtual ~ItcTransportPosixShm();
+
+    ItcTransportPosixShm(const ItcTransportPosixShm &other) = delete;
+    ItcTransportPosixShm &operator=(const ItcTransportPosixShm &other) = delete;
+    ItcTransportPosixShm(ItcTransportPosixShm &&other) noexcept = delete;
+    ItcTransportPosixShm &operator=(ItcTransportPosixShm &&other) noexcept = delete;
+
+    bool initialise(itc_mailbox_id_t regionId = ITC_MAILBOX_ID_DEFAULT);
+    void release();
+    /***
+     * Lets the rx thread return on its own. Call it before ThreadManager cancels the threads, a parked rx thread
+     * would only notice that after ITC_POSIX_SHM_RX_PARK_TIMEOUT.
+     */
+    void stopRxThread();
+
+    /***
+     * On success, adminMsg is deallocated. ITC_FAILED means the message was not taken,
+     * e.g. receiver's pool is exhausted or message is too large, and the caller should try another transport.
+     */
+    ItcPlatformIfReturnCode send(ItcAdminMessageRawPtr adminMsg);
+    /***
+     * All messages must be addressed to the same Region. Messages which were taken are deallocated and set to nullptr,
+     * on ITC_FAILED the remaining ones keep their order and are left to the caller.
+     */
+    ItcPlatformIfReturnCode sendBatch(ItcAdminMessageRawPtr *adminMsgs, size_t count);
+    TransportStatistics getStatistics() const;
+
+private:
+    ItcTransportPosixShm() = default;
+
+    /***
+     * Senders hold one from before getContact() until they are done with the contact,
+     * retired contacts are only freed while nobody holds one.
+     */
+    class ContactUseGuard
+    {
+    public:
+        explicit ContactUseGuard(ItcTransportPosixShm &transport);
+        ~ContactUseGuard();
+
+        ContactUseGuard(const ContactUseGuard &other) = delete;
+        ContactUseGuard &operator=(const ContactUseGuard &other) = delete;
+
+    private:
+        ItcTransportPosixShm &m_transport;
+    };
+
+    static std::string getShmName(itc_mailbox_id_t regionId);
+    bool createSharedSegment();
+    void removeSharedSegment();
+    PosixShmContactInfo *getContact(itc_mailbox_id_t receiver);
+    bool attachContactAtIndex(size_t atIndex);
+    void detachContactAtIndex(size_t atIndex);
+    void retireContactAtIndex(size_t atIndex);
+    static void destroyContact(PosixShmContactInfo *contact);
+    static bool isOwnerAlive(const PosixShmHeader *header);
+    void dropContactOfDeadOwner(PosixShmContactInfo *contact);
+    static void wakeReceiver(PosixShmHeader *header);
+    void reclaimRetiredContacts();
+    uint32_t forwardRxMessages();
+    void *posixShmRxThread(void *args);
+
+private:
+    SINGLETON_DECLARATION(ItcTransportPosixShm)
+
+    itc_mailbox_id_t m_regionId {ITC_MAILBOX_ID_DEFAULT};
+    MemoryAllocatorParams m_params;
+    PosixShmHeader *m_header {nullptr};
+    PosixShmRxRingRawPtr m_rxRing {nullptr};
+    std::unique_ptr<MemoryPool> m_pool {nullptr};
+    std::shared_ptr<SyncObject> m_syncObj;
+    bool m_isInitialised {false};
+    std::atomic<bool> m_isRxThreadTerminated {false};
+    std::mutex m_contactListMutex;
+    std::array<std::atomic<PosixShmContactInfo *>, ITC_MAX_SUPPORTED_REGIONS> m_contactList {};
+    std::vector<PosixShmContactInfo *> m_retiredContacts;
+    std::atomic<uint32_t> m_nrContactUsers {0};
+    std::atomic<bool> m_hasRetiredContacts {false};
+    ItcTransportCounters m_counters;
+
+    friend void *::posixShmRxThreadWrapper(void *args);
+
+    friend class ItcTransportPosixShmTest;
+	FRIEND_TEST(ItcTransportPosixShmTest, createSharedSegmentTest1);
+	FRIEND_TEST(ItcTransportPosixShmTest, attachContactTest1);
+	FRIEND_TEST(ItcTransportPosixShmTest, attachContactTest2);
+	FRIEND_TEST(ItcTransportPosixShmTest, releaseTest1);
+	FRIEND_TEST(ItcTransportPosixShmTest, sendTest1);
+	FRIEND_TEST(ItcTransportPosixShmTest, sendTest2);
+	FRIEND_TEST(ItcTransportPosixShmTest, sendTest3);
+	FRIEND_TEST(ItcTransportPosixShmTest, sendTest4);
+	FRIEND_TEST(ItcTransportPosixShmTest, sendBatchTest1);
+}; // class ItcTransportPosixShm
+
+} // namespace INTERNAL
+} // namespace ITC
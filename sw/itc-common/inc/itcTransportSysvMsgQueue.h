@@ -26,6 +26,7 @@
 #include "itcThreadManagerIf.h"
 #include "itcMutex.h"
 #include "itcCWrapperIf.h"
+#include "itcStatistics.h"
 
 void destructRxThreadWrapper(void *args);
 void *sysvMsgQueueRxThreadWrapper(void *args);
@@ -67,6 +68,7 @@ public:
     bool initialise(itc_mailbox_id_t regionId = ITC_MAILBOX_ID_DEFAULT);
     void release();
     ItcPlatformIfReturnCode send(ItcAdminMessageRawPtr adminMsg);
+    TransportStatistics getStatistics() const;
     
 private:
     ItcTransportSysvMsgQueue() = default;
@@ -93,6 +95,7 @@ private:
     size_t m_maxMsgSize {std::numeric_limits<size_t>::max()};
     uint8_t *m_rxBuffer {nullptr};
     std::array<SysvMsgQueueContactInfo, ITC_MAX_SUPPORTED_REGIONS> m_contactList;
+    ItcTransportCounters m_counters;
     
     friend void ::destructRxThreadWrapper(void *args);
     friend void *::sysvMsgQueueRxThreadWrapper(void *args);
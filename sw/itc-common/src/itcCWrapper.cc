@@ -271,6 +271,21 @@ int32_t CWrapper::cFclose(FILE *stream)
     return ::fclose(stream);
 }
 
+int32_t CWrapper::cEventFd(uint32_t initval, int32_t flags)
+{
+    return ::eventfd(initval, flags);
+}
+
+ssize_t CWrapper::cRead(int32_t fd, void *buf, size_t count)
+{
+    return ::read(fd, buf, count);
+}
+
+ssize_t CWrapper::cWrite(int32_t fd, const void *buf, size_t count)
+{
+    return ::write(fd, buf, count);
+}
+
 
 /***
  * Time APIs
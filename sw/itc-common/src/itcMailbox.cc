@@ -1,5 +1,18 @@
 #include "itcMailbox.h"
 
+#include <climits>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <ctime>
+#include <thread>
+
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+
 namespace ITC
 {
 /***
@@ -9,6 +22,52 @@ namespace ITC
 namespace INTERNAL
 {
 
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free, "Futex word must be a plain 32-bit integer!");
+
+/***
+ * Without deadline, waits until woken up. Otherwise deadline is an absolute CLOCK_MONOTONIC time
+ * (FUTEX_WAIT_BITSET, so spurious wake-ups never stretch the total wait), and false means it has passed.
+ */
+static inline bool futexWait(std::atomic<uint32_t> *addr, uint32_t expected, const struct timespec *deadline = nullptr)
+{
+    if(!deadline)
+    {
+        ::syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+        return true;
+    }
+    auto ret = ::syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAIT_BITSET_PRIVATE, expected, deadline, nullptr, FUTEX_BITSET_MATCH_ANY);
+    return !(ret == -1 && errno == ETIMEDOUT);
+}
+
+static inline void calculateDeadline(uint32_t timeout /* us */, struct timespec &deadline)
+{
+    ::clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec     += timeout / 1000000;
+    deadline.tv_nsec    += (timeout % 1000000) * 1000;
+    if(deadline.tv_nsec >= 1000000000)
+    {
+        deadline.tv_sec     += 1;
+        deadline.tv_nsec    -= 1000000000;
+    }
+}
+
+static inline void futexWake(std::atomic<uint32_t> *addr, int32_t count)
+{
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+static inline void signalRxFd(int32_t fd)
+{
+    uint64_t one {1};
+    MAYBE_UNUSED auto ret = ::write(fd, &one, sizeof(one));
+}
+
+static inline void clearRxFd(int32_t fd)
+{
+    uint64_t counter {0};
+    MAYBE_UNUSED auto ret = ::read(fd, &counter, sizeof(counter));
+}
+
 bool ItcMailbox::push(ItcAdminMessageRawPtr msg)
 {
     bool active = m_isActive.load(MEMORY_ORDER_ACQUIRE);
@@ -16,11 +75,338 @@ bool ItcMailbox::push(ItcAdminMessageRawPtr msg)
     {
         return false;
     }
-    m_rxMsgQueue->push(msg);
+    ITC_LATENCY_STAMP(msg, ITC_LATENCY_STAMP_MAILBOX_PUSH);
+    if(uint32_t priority = ItcAdminMessageHelper::getPriority(msg); priority != ITC_MESSAGE_PRIORITY_DEFAULT) UNLIKELY
+    {
+        pushWithPriority(msg, priority);
+    } else if(m_rxControl) UNLIKELY
+    {
+        if(!pushWithRxControl(msg))
+        {
+            return false;
+        }
+    } else
+    {
+        m_rxMsgQueue->push(msg);
+    }
+    m_statistics->counters.add(ITC_MAILBOX_COUNTER_ENQUEUED_MSGS);
+    notifyReceiver();
     return true;
     // return m_rxMsgQueue->tryPush(msg);
 }
 
+uint32_t ItcMailbox::pushBatch(const ItcAdminMessageRawPtr *msgs, uint32_t count)
+{
+    bool active = m_isActive.load(MEMORY_ORDER_ACQUIRE);
+    if(!active) UNLIKELY
+    {
+        return 0;
+    }
+    bool hasPriorityMsgs = std::any_of(msgs, msgs + count, [](const ItcAdminMessage *msg)
+    {
+        return ItcAdminMessageHelper::getPriority(msg) != ITC_MESSAGE_PRIORITY_DEFAULT;
+    });
+    if(m_rxControl || hasPriorityMsgs) UNLIKELY
+    {
+        /* Overflow policy and priority apply per message, stop at the first refused one so that the rest keep their order. */
+        uint32_t nrPushedMsgs = 0;
+        while(nrPushedMsgs < count && push(msgs[nrPushedMsgs]))
+        {
+            ++nrPushedMsgs;
+        }
+        return nrPushedMsgs;
+    }
+#if defined ITC_LATENCY_TRACE_ENABLE
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        ITC_LATENCY_STAMP(msgs[i], ITC_LATENCY_STAMP_MAILBOX_PUSH);
+    }
+#endif
+    m_rxMsgQueue->pushBatch(msgs, count);
+    m_statistics->counters.add(ITC_MAILBOX_COUNTER_ENQUEUED_MSGS, count);
+    notifyReceiver();
+    return count;
+}
+
+/***
+ * Capacity is checked against the current queue size without reserving a slot,
+ * so concurrent senders may overshoot it by at most one message each. It is a soft limit, the rx queue itself is not.
+ */
+bool ItcMailbox::pushWithRxControl(ItcAdminMessageRawPtr msg)
+{
+    ItcMailboxRxControl &control = *m_rxControl;
+    const uint32_t capacity = control.config.capacity;
+    switch(control.config.overflowPolicy)
+    {
+    case ITC_MAILBOX_RX_OVERFLOW_REJECT:
+        if(m_rxMsgQueue->size() >= capacity || !m_rxMsgQueue->tryPush(msg))
+        {
+            control.nrRejectedMsgs.fetch_add(1, MEMORY_ORDER_RELAXED);
+            return false;
+        }
+        break;
+
+    case ITC_MAILBOX_RX_OVERFLOW_DROP_OLDEST:
+        while(m_rxMsgQueue->size() >= capacity || !m_rxMsgQueue->tryPush(msg))
+        {
+            ItcAdminMessageRawPtr oldestMsg {nullptr};
+            if(m_rxMsgQueue->tryPop(oldestMsg) && oldestMsg)
+            {
+                ItcAdminMessageHelper::deallocate(oldestMsg);
+                control.nrDroppedMsgs.fetch_add(1, MEMORY_ORDER_RELAXED);
+            }
+        }
+        break;
+
+    case ITC_MAILBOX_RX_OVERFLOW_GROW:
+        if(control.nrOverflowMsgs.load(MEMORY_ORDER_ACQUIRE) == 0 && m_rxMsgQueue->size() < capacity && m_rxMsgQueue->tryPush(msg)) LIKELY
+        {
+            break;
+        }
+        {
+            std::scoped_lock<std::mutex> lock(control.overflowMutex);
+            control.overflowMsgs.push_back(msg);
+            control.nrOverflowMsgs.fetch_add(1, MEMORY_ORDER_RELEASE);
+        }
+        break;
+
+    default: /* ITC_MAILBOX_RX_OVERFLOW_BLOCK */
+        while(m_rxMsgQueue->size() >= capacity)
+        {
+            if(!m_isActive.load(MEMORY_ORDER_ACQUIRE)) UNLIKELY
+            {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        m_rxMsgQueue->push(msg);
+        break;
+    }
+
+    if(control.config.highWatermark > 0)
+    {
+        checkHighWatermark(getNrPendingMsgs());
+    }
+    return true;
+}
+
+void ItcMailbox::pushWithPriority(ItcAdminMessageRawPtr msg, uint32_t priority)
+{
+    ItcMailboxPriorityQueues &priorityQueues = *m_priorityQueues;
+    auto &queueSlot = priorityQueues.queues[priority - 1];
+    ItcMailboxRxQueue *queue = queueSlot.load(MEMORY_ORDER_ACQUIRE);
+    if(!queue) UNLIKELY
+    {
+        /* First message of this priority, racing senders agree on one queue. */
+        auto newQueue = std::make_unique<ItcMailboxRxQueue>();
+        if(queueSlot.compare_exchange_strong(queue, newQueue.get(), MEMORY_ORDER_ACQUIRE_RELEASE, MEMORY_ORDER_ACQUIRE))
+        {
+            queue = newQueue.release();
+        }
+    }
+    queue->push(msg);
+
+    /* Pairs with the fence in tryPopPriorityMessage(): either the receiver sees our message, or we see the bit cleared. */
+    const uint32_t bit = 1 << priority;
+    std::atomic_thread_fence(MEMORY_ORDER_SEQ_CONSISTENT);
+    if(!(priorityQueues.occupancy.load(MEMORY_ORDER_RELAXED) & bit))
+    {
+        priorityQueues.occupancy.fetch_or(bit, MEMORY_ORDER_RELEASE);
+    }
+}
+
+void ItcMailbox::checkHighWatermark(uint32_t nrPendingMsgs)
+{
+    ItcMailboxRxControl &control = *m_rxControl;
+    if(nrPendingMsgs < control.config.highWatermark)
+    {
+        return;
+    }
+    /* Only the sender which crosses the watermark reports it, until the receiver has caught up again. */
+    if(!control.isAboveHighWatermark.load(MEMORY_ORDER_RELAXED) && !control.isAboveHighWatermark.exchange(true, MEMORY_ORDER_ACQUIRE_RELEASE))
+    {
+        control.nrHighWatermarkHits.fetch_add(1, MEMORY_ORDER_RELAXED);
+        if(control.config.onHighWatermark)
+        {
+            control.config.onHighWatermark(m_mailboxId, nrPendingMsgs);
+        }
+    }
+}
+
+void ItcMailbox::clearHighWatermark()
+{
+    ItcMailboxRxControl &control = *m_rxControl;
+    if(control.isAboveHighWatermark.load(MEMORY_ORDER_RELAXED) && getNrPendingMsgs() <= control.config.highWatermark / 2)
+    {
+        control.isAboveHighWatermark.store(false, MEMORY_ORDER_RELEASE);
+    }
+}
+
+bool ItcMailbox::tryPopPriorityMessage(ItcAdminMessageRawPtr &msg, uint32_t minPriority)
+{
+    ItcMailboxPriorityQueues &priorityQueues = *m_priorityQueues;
+    const uint32_t mask = ~((2u << minPriority) - 1);
+    uint32_t occupancy = priorityQueues.occupancy.load(MEMORY_ORDER_ACQUIRE) & mask;
+    while(occupancy != 0)
+    {
+        uint32_t priority = 31 - __builtin_clz(occupancy);
+        const uint32_t bit = 1 << priority;
+        ItcMailboxRxQueue *queue = priorityQueues.queues[priority - 1].load(MEMORY_ORDER_ACQUIRE);
+        if(queue->tryPop(msg))
+        {
+            return true;
+        }
+
+        /* Drained, clear the bit and re-check for a push that raced with us. */
+        priorityQueues.occupancy.fetch_and(~bit, MEMORY_ORDER_ACQUIRE_RELEASE);
+        std::atomic_thread_fence(MEMORY_ORDER_SEQ_CONSISTENT);
+        if(!queue->empty())
+        {
+            priorityQueues.occupancy.fetch_or(bit, MEMORY_ORDER_RELAXED);
+            continue;
+        }
+        occupancy &= ~bit;
+    }
+    return false;
+}
+
+bool ItcMailbox::tryPopMessage(ItcAdminMessageRawPtr &msg)
+{
+    if(m_priorityQueues->occupancy.load(MEMORY_ORDER_RELAXED) != 0 && tryPopPriorityMessage(msg)) UNLIKELY
+    {
+        recordReceived(&msg, 1);
+        return true;
+    }
+
+    if(!m_rxControl) LIKELY
+    {
+        if(!m_rxMsgQueue->tryPop(msg))
+        {
+            return false;
+        }
+        recordReceived(&msg, 1);
+        return true;
+    }
+
+    ItcMailboxRxControl &control = *m_rxControl;
+    bool isPopped = m_rxMsgQueue->tryPop(msg);
+    if(!isPopped && control.nrOverflowMsgs.load(MEMORY_ORDER_ACQUIRE) > 0)
+    {
+        /* Overflow segment only once the rx queue is drained, see ItcMailboxRxControl. */
+        std::scoped_lock<std::mutex> lock(control.overflowMutex);
+        if(!control.overflowMsgs.empty())
+        {
+            msg = control.overflowMsgs.front();
+            control.overflowMsgs.pop_front();
+            control.nrOverflowMsgs.fetch_sub(1, MEMORY_ORDER_RELEASE);
+            isPopped = true;
+        }
+    }
+    if(isPopped)
+    {
+        recordReceived(&msg, 1);
+        clearHighWatermark();
+    }
+    return isPopped;
+}
+
+uint32_t ItcMailbox::tryPopMessages(ItcAdminMessageRawPtr *msgs, uint32_t maxCount)
+{
+    uint32_t count = 0;
+    if(m_priorityQueues->occupancy.load(MEMORY_ORDER_RELAXED) != 0) UNLIKELY
+    {
+        while(count < maxCount && tryPopPriorityMessage(msgs[count]))
+        {
+            ++count;
+        }
+    }
+    count += m_rxMsgQueue->tryPopBatch(msgs + count, maxCount - count);
+    if(count > 0)
+    {
+        recordReceived(msgs, count);
+    }
+    if(m_rxControl) UNLIKELY
+    {
+        while(count < maxCount && tryPopMessage(msgs[count]))
+        {
+            ++count;
+        }
+        clearHighWatermark();
+    }
+    return count;
+}
+
+/* Only the receiver gets here, so maxQueueDepth needs no CAS. */
+void ItcMailbox::recordReceived(const ItcAdminMessageRawPtr *msgs, uint32_t count)
+{
+    ItcMailboxStatistics &statistics = *m_statistics;
+    statistics.counters.add(ITC_MAILBOX_COUNTER_RECEIVED_MSGS, count);
+    uint32_t queueDepth = getNrPendingMsgs() + count;
+    if(queueDepth > statistics.maxQueueDepth.load(MEMORY_ORDER_RELAXED))
+    {
+        statistics.maxQueueDepth.store(queueDepth, MEMORY_ORDER_RELAXED);
+    }
+
+#if defined ITC_LATENCY_TRACE_ENABLE
+    uint64_t now = getMonotonicTimeNs();
+    auto &latencyStats = statistics.latencyStats;
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        if(!msgs[i]) UNLIKELY
+        {
+            continue;
+        }
+        /* Stamps of hops the message did not take stay 0, so only stages with both ends are recorded. */
+        const uint64_t *stamps = msgs[i]->latencyStamps;
+        uint64_t sent = stamps[ITC_LATENCY_STAMP_SEND];
+        uint64_t regionTx = stamps[ITC_LATENCY_STAMP_REGION_TX];
+        uint64_t regionRx = stamps[ITC_LATENCY_STAMP_REGION_RX];
+        uint64_t pushed = stamps[ITC_LATENCY_STAMP_MAILBOX_PUSH];
+        if(sent && pushed)
+        {
+            latencyStats[ITC_LATENCY_STAGE_SEND_TO_PUSH].record(pushed - sent);
+        }
+        if(regionTx && regionRx)
+        {
+            latencyStats[ITC_LATENCY_STAGE_REGION_TX_TO_RX].record(regionRx - regionTx);
+        }
+        if(regionRx && pushed)
+        {
+            latencyStats[ITC_LATENCY_STAGE_REGION_RX_TO_PUSH].record(pushed - regionRx);
+        }
+        if(pushed)
+        {
+            latencyStats[ITC_LATENCY_STAGE_PUSH_TO_RECEIVE].record(now - pushed);
+        }
+        if(sent)
+        {
+            latencyStats[ITC_LATENCY_STAGE_SEND_TO_RECEIVE].record(now - sent);
+        }
+    }
+#endif
+}
+
+void ItcMailbox::notifyReceiver()
+{
+    /* Pairs with the fences in pop() and popAny(): either the receiver sees our message, or we see it parked/polling/re-armed. */
+    std::atomic_thread_fence(MEMORY_ORDER_SEQ_CONSISTENT);
+    if(m_rxFdUsers.load(MEMORY_ORDER_RELAXED) != 0) UNLIKELY
+    {
+        if(!m_isRxFdSignalled.load(MEMORY_ORDER_RELAXED) && !m_isRxFdSignalled.exchange(true, MEMORY_ORDER_RELAXED))
+        {
+            /* Empty -> non-empty transition as far as the fd is concerned. */
+            signalRxFd(m_rxFd);
+        }
+    }
+    if(m_rxWaiterState.load(MEMORY_ORDER_RELAXED) == ITC_MAILBOX_RX_PARKED) UNLIKELY
+    {
+        if(m_rxWaiterState.exchange(ITC_MAILBOX_RX_AWAKE, MEMORY_ORDER_RELAXED) == ITC_MAILBOX_RX_PARKED)
+        {
+            futexWake(&m_rxWaiterState, 1);
+        }
+    }
+}
+
 // push
 // test4 average: 369.50 ns
 // test3 average: 426.02 ns
@@ -35,29 +421,352 @@ bool ItcMailbox::push(ItcAdminMessageRawPtr msg)
 
 
 
-ItcAdminMessageRawPtr ItcMailbox::pop(uint32_t mode)
+ItcAdminMessageRawPtr ItcMailbox::pop(uint32_t mode, uint32_t timeout)
 {
     bool active = m_isActive.load(MEMORY_ORDER_ACQUIRE);
     if(!active) UNLIKELY
     {
         return nullptr;
     }
+
+    if(m_deferredMsgs && !m_deferredMsgs->empty()) UNLIKELY
+    {
+        return popDeferredMessage();
+    }
+
+    /* Deadline is taken before spinning, so that spinning counts into the timeout. */
+    struct timespec deadline {};
+    if(mode & ITC_MODE_RECEIVE_TIMEOUT)
+    {
+        calculateDeadline(timeout, deadline);
+        return popFromQueue(mode, &deadline);
+    }
+    return popFromQueue(mode, nullptr);
+}
+
+ItcAdminMessageRawPtr ItcMailbox::popSelective(const std::vector<uint32_t> &filter, uint32_t mode, uint32_t timeout)
+{
+    bool active = m_isActive.load(MEMORY_ORDER_ACQUIRE);
+    if(!active) UNLIKELY
+    {
+        return nullptr;
+    }
+
+    if(filter.empty())
+    {
+        return pop(mode, timeout);
+    }
+
+    auto isWanted = [&filter](ItcAdminMessageRawPtr msg)
+    {
+        return std::find(filter.begin(), filter.end(), msg->msgno) != filter.end();
+    };
+
+    if(!m_deferredMsgs)
+    {
+        m_deferredMsgs = std::make_unique<std::deque<ItcAdminMessageRawPtr>>();
+    }
+    
+    if(auto it = std::find_if(m_deferredMsgs->begin(), m_deferredMsgs->end(), isWanted); it != m_deferredMsgs->end())
+    {
+        ItcAdminMessageRawPtr msg = *it;
+        m_deferredMsgs->erase(it);
+        return msg;
+    }
+
+    struct timespec deadline {};
+    struct timespec *deadlinePtr {nullptr};
+    if(mode & ITC_MODE_RECEIVE_TIMEOUT)
+    {
+        calculateDeadline(timeout, deadline);
+        deadlinePtr = &deadline;
+    }
+
+    /* Every message is taken off the rx queue exactly once, either returned or put aside in order. */
+    ItcAdminMessageRawPtr wantedMsg {nullptr};
+    while(ItcAdminMessageRawPtr msg = popFromQueue(mode, deadlinePtr))
+    {
+        if(isWanted(msg))
+        {
+            wantedMsg = msg;
+            break;
+        }
+        m_deferredMsgs->push_back(msg);
+    }
+
+    if(!m_deferredMsgs->empty() && (m_rxFdUsers.load(MEMORY_ORDER_RELAXED) & ITC_MAILBOX_RX_FD_HANDED_OUT) && !m_isRxFdSignalled.exchange(true, MEMORY_ORDER_RELAXED))
+    {
+        /* Put-aside messages are still pending, keep the fd readable for them. */
+        signalRxFd(m_rxFd);
+    }
+    return wantedMsg;
+}
+
+ItcAdminMessageRawPtr ItcMailbox::popDeferredMessage()
+{
+    /* Skipped by an earlier popSelective(), so they are older than anything queued of the same or a lower priority. */
+    auto it = std::max_element(m_deferredMsgs->begin(), m_deferredMsgs->end(), [](ItcAdminMessageRawPtr lhs, ItcAdminMessageRawPtr rhs)
+    {
+        return ItcAdminMessageHelper::getPriority(lhs) < ItcAdminMessageHelper::getPriority(rhs);
+    });
+    ItcAdminMessageRawPtr msg {nullptr};
+    if(m_priorityQueues->occupancy.load(MEMORY_ORDER_RELAXED) != 0 && tryPopPriorityMessage(msg, ItcAdminMessageHelper::getPriority(*it))) UNLIKELY
+    {
+        recordReceived(&msg, 1);
+        return msg;
+    }
+    msg = *it;
+    m_deferredMsgs->erase(it);
+    return msg;
+}
+
+ItcAdminMessageRawPtr ItcMailbox::popFromQueue(uint32_t mode, const struct timespec *deadline)
+{
+    ItcAdminMessageRawPtr msg {nullptr};
     if(mode & ITC_MODE_RECEIVE_NON_BLOCKING)
     {
-        ItcAdminMessageRawPtr msg {nullptr};
-        m_rxMsgQueue->tryPop(msg);
+        if(tryPopMessage(msg)) LIKELY
+        {
+            return msg;
+        }
+
+        /* Drained, re-arm the fd and re-check for a push that raced with us. */
+        if(m_isRxFdSignalled.load(MEMORY_ORDER_RELAXED))
+        {
+            clearRxFd(m_rxFd);
+            m_isRxFdSignalled.store(false, MEMORY_ORDER_RELAXED);
+            std::atomic_thread_fence(MEMORY_ORDER_SEQ_CONSISTENT);
+            if(tryPopMessage(msg) && !m_isRxFdSignalled.exchange(true, MEMORY_ORDER_RELAXED))
+            {
+                /* Other messages may follow this one, keep the fd readable until we see the queue empty. */
+                signalRxFd(m_rxFd);
+            }
+        }
         return msg;
     }
-    return m_rxMsgQueue->pop();
+
+    for(uint32_t i = 0; i < ITC_MAILBOX_RX_SPIN_COUNT; ++i)
+    {
+        if(tryPopMessage(msg)) LIKELY
+        {
+            return msg;
+        }
+        yieldProcessor();
+    }
+
+    while(m_isActive.load(MEMORY_ORDER_ACQUIRE))
+    {
+        m_rxWaiterState.store(ITC_MAILBOX_RX_PARKED, MEMORY_ORDER_RELAXED);
+        std::atomic_thread_fence(MEMORY_ORDER_SEQ_CONSISTENT);
+        if(tryPopMessage(msg) || !m_isActive.load(MEMORY_ORDER_RELAXED))
+        {
+            m_rxWaiterState.store(ITC_MAILBOX_RX_AWAKE, MEMORY_ORDER_RELAXED);
+            return msg;
+        }
+
+        /* Returns immediately if a sender has already flipped the state back to awake. */
+        bool isInTime = futexWait(&m_rxWaiterState, ITC_MAILBOX_RX_PARKED, deadline);
+        m_rxWaiterState.store(ITC_MAILBOX_RX_AWAKE, MEMORY_ORDER_RELAXED);
+        if(tryPopMessage(msg) || !isInTime)
+        {
+            return msg;
+        }
+    }
+    return nullptr;
+}
+
+uint32_t ItcMailbox::popBatch(ItcAdminMessageRawPtr *msgs, uint32_t maxCount, uint32_t mode, uint32_t timeout)
+{
+    bool active = m_isActive.load(MEMORY_ORDER_ACQUIRE);
+    if(!active || maxCount == 0) UNLIKELY
+    {
+        return 0;
+    }
+
+    uint32_t count = 0;
+    if(m_deferredMsgs) UNLIKELY
+    {
+        for(; count < maxCount && !m_deferredMsgs->empty(); ++count)
+        {
+            msgs[count] = popDeferredMessage();
+        }
+    }
+
+    count += tryPopMessages(msgs + count, maxCount - count);
+    if(count > 0) LIKELY
+    {
+        return count;
+    }
+
+    /* Nothing pending, wait for (or re-arm the fd for) the first message exactly like pop() does. */
+    ItcAdminMessageRawPtr msg = pop(mode, timeout);
+    if(!msg)
+    {
+        return 0;
+    }
+    msgs[0] = msg;
+    return 1 + tryPopMessages(msgs + 1, maxCount - 1);
+}
+
+ItcAdminMessageRawPtr ItcMailbox::popAny(ItcMailbox *const *mboxes, uint32_t count, uint32_t mode, uint32_t timeout)
+{
+    if(count == 0 || count > ITC_MAX_MAILBOXES_PER_THREAD) UNLIKELY
+    {
+        return nullptr;
+    }
+
+    struct timespec deadline {};
+    if(mode & ITC_MODE_RECEIVE_TIMEOUT)
+    {
+        calculateDeadline(timeout, deadline);
+    }
+
+    /* A non-blocking pop() re-arms the fd of every mailbox it finds drained, so after a full miss while polled all fds are armed. */
+    auto tryPopAny = [mboxes, count]() -> ItcAdminMessageRawPtr
+    {
+        for(uint32_t i = 0; i < count; ++i)
+        {
+            if(ItcAdminMessageRawPtr msg = mboxes[i]->pop(ITC_MODE_RECEIVE_NON_BLOCKING))
+            {
+                return msg;
+            }
+        }
+        return nullptr;
+    };
+
+    ItcAdminMessageRawPtr msg = tryPopAny();
+    if(msg || (mode & ITC_MODE_RECEIVE_NON_BLOCKING))
+    {
+        return msg;
+    }
+
+    for(uint32_t i = 0; i < ITC_MAILBOX_RX_SPIN_COUNT; ++i)
+    {
+        yieldProcessor();
+        if((msg = tryPopAny())) LIKELY
+        {
+            return msg;
+        }
+    }
+
+    /* From here on senders signal the fds as well, until we return. */
+    struct RxFdPolling
+    {
+        RxFdPolling(ItcMailbox *const *mboxes, uint32_t count)
+            : m_mboxes(mboxes), m_count(count)
+        {
+            for(uint32_t i = 0; i < m_count; ++i)
+            {
+                m_mboxes[i]->m_rxFdUsers.fetch_or(ITC_MAILBOX_RX_FD_POLLED, MEMORY_ORDER_RELAXED);
+            }
+            /* Pairs with the fence in notifyReceiver(): either we find the message, or its sender sees us polling. */
+            std::atomic_thread_fence(MEMORY_ORDER_SEQ_CONSISTENT);
+        }
+
+        ~RxFdPolling()
+        {
+            for(uint32_t i = 0; i < m_count; ++i)
+            {
+                m_mboxes[i]->m_rxFdUsers.fetch_and(static_cast<uint8_t>(~ITC_MAILBOX_RX_FD_POLLED), MEMORY_ORDER_RELAXED);
+            }
+        }
+
+        ItcMailbox *const *m_mboxes;
+        uint32_t m_count;
+    } rxFdPolling(mboxes, count);
+    if((msg = tryPopAny()))
+    {
+        return msg;
+    }
+
+    std::array<struct pollfd, ITC_MAX_MAILBOXES_PER_THREAD> fds {};
+    while(true)
+    {
+        nfds_t nrFds = 0;
+        for(uint32_t i = 0; i < count; ++i)
+        {
+            if(mboxes[i]->isActive())
+            {
+                fds[nrFds++] = {mboxes[i]->m_rxFd, POLLIN, 0};
+            }
+        }
+        if(nrFds == 0) UNLIKELY
+        {
+            return nullptr;
+        }
+
+        struct timespec remaining {};
+        if(mode & ITC_MODE_RECEIVE_TIMEOUT)
+        {
+            struct timespec now;
+            ::clock_gettime(CLOCK_MONOTONIC, &now);
+            remaining.tv_sec = deadline.tv_sec - now.tv_sec;
+            remaining.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+            if(remaining.tv_nsec < 0)
+            {
+                remaining.tv_sec -= 1;
+                remaining.tv_nsec += 1000000000;
+            }
+            if(remaining.tv_sec < 0)
+            {
+                return tryPopAny();
+            }
+        }
+
+        int ret = ::ppoll(fds.data(), nrFds, (mode & ITC_MODE_RECEIVE_TIMEOUT) ? &remaining : nullptr, nullptr);
+        if((msg = tryPopAny()))
+        {
+            return msg;
+        }
+        if(ret == 0)
+        {
+            /* Timed out. */
+            return nullptr;
+        }
+    }
 }
 
 void ItcMailbox::setState(bool newState)
 {
+    if(newState && m_rxFd < 0)
+    {
+        m_rxFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        m_isRxFdSignalled.store(false, MEMORY_ORDER_RELAXED);
+        m_rxFdUsers.store(0, MEMORY_ORDER_RELAXED);
+    }
+    if(newState && !m_rxMsgQueue)
+    {
+        m_rxMsgQueue = std::make_unique<ItcMailboxRxQueue>();
+    }
+    if(newState && !m_statistics)
+    {
+        m_statistics = std::make_unique<ItcMailboxStatistics>();
+    }
+    if(newState && !m_priorityQueues)
+    {
+        m_priorityQueues = std::make_unique<ItcMailboxPriorityQueues>();
+    }
+
     bool expected = !newState;
     if(m_isActive.compare_exchange_strong(expected, newState, MEMORY_ORDER_RELEASE, MEMORY_ORDER_ACQUIRE))
     {
+        if(newState)
+        {
+            m_statistics->counters.reset();
+            m_statistics->maxQueueDepth.store(0, MEMORY_ORDER_RELAXED);
+#if defined ITC_LATENCY_TRACE_ENABLE
+            for(auto &histogram : m_statistics->latencyStats)
+            {
+                histogram.reset();
+            }
+#endif
+        }
         if(!newState)
         {
+            /* Kick out a receiver parked in pop(). */
+            std::atomic_thread_fence(MEMORY_ORDER_SEQ_CONSISTENT);
+            m_rxWaiterState.store(ITC_MAILBOX_RX_AWAKE, MEMORY_ORDER_RELAXED);
+            futexWake(&m_rxWaiterState, INT_MAX);
             m_mailboxId = ITC_MAILBOX_ID_DEFAULT;
             m_flags = ITC_FLAG_DEFAULT;
             while(!m_rxMsgQueue->empty())
@@ -69,9 +778,146 @@ void ItcMailbox::setState(bool newState)
                     ItcAdminMessageHelper::deallocate(adminMsg);
                 }
             }
+
+            if(m_priorityQueues)
+            {
+                ItcAdminMessageRawPtr adminMsg {nullptr};
+                while(tryPopPriorityMessage(adminMsg))
+                {
+                    ItcAdminMessageHelper::deallocate(adminMsg);
+                }
+            }
+
+            if(m_rxControl)
+            {
+                std::scoped_lock<std::mutex> lock(m_rxControl->overflowMutex);
+                for(auto adminMsg : m_rxControl->overflowMsgs)
+                {
+                    ItcAdminMessageHelper::deallocate(adminMsg);
+                }
+                m_rxControl->overflowMsgs.clear();
+                m_rxControl->nrOverflowMsgs.store(0, MEMORY_ORDER_RELAXED);
+                m_rxControl->isAboveHighWatermark.store(false, MEMORY_ORDER_RELAXED);
+            }
+
+            if(m_deferredMsgs)
+            {
+                for(auto adminMsg : *m_deferredMsgs)
+                {
+                    ItcAdminMessageHelper::deallocate(adminMsg);
+                }
+                m_deferredMsgs->clear();
+            }
+
+            /* The fd is kept for the next activation, a late push() must never write into a recycled fd number. */
+            if(m_rxFd >= 0)
+            {
+                clearRxFd(m_rxFd);
+            }
+            m_isRxFdSignalled.store(false, MEMORY_ORDER_RELAXED);
+            /* The next owner has to ask for the fd again. */
+            m_rxFdUsers.store(0, MEMORY_ORDER_RELAXED);
         }
     }
 }
 
+void ItcMailbox::setRxConfig(const MailboxRxConfig &config)
+{
+    if(config.capacity >= ITC_MAILBOX_RX_MESSAGE_QUEUE_SIZE && config.overflowPolicy == ITC_MAILBOX_RX_OVERFLOW_BLOCK && config.highWatermark == 0)
+    {
+        m_rxControl.reset();
+        return;
+    }
+
+    m_rxControl = std::make_unique<ItcMailboxRxControl>();
+    m_rxControl->config = config;
+    m_rxControl->config.capacity = std::clamp(config.capacity, (uint32_t)(1), ITC_MAILBOX_RX_MESSAGE_QUEUE_SIZE);
+}
+
+bool ItcMailbox::isActive() const
+{
+    return m_isActive.load(MEMORY_ORDER_ACQUIRE);
+}
+
+uint32_t ItcMailbox::getNrPendingMsgs() const
+{
+    uint32_t nrPendingMsgs = m_rxMsgQueue ? m_rxMsgQueue->size() : 0;
+    if(m_rxControl)
+    {
+        nrPendingMsgs += m_rxControl->nrOverflowMsgs.load(MEMORY_ORDER_RELAXED);
+    }
+    if(m_priorityQueues && m_priorityQueues->occupancy.load(MEMORY_ORDER_RELAXED) != 0) UNLIKELY
+    {
+        for(const auto &queue : m_priorityQueues->queues)
+        {
+            if(const ItcMailboxRxQueue *priorityQueue = queue.load(MEMORY_ORDER_ACQUIRE))
+            {
+                nrPendingMsgs += priorityQueue->size();
+            }
+        }
+    }
+    return nrPendingMsgs;
+}
+
+int32_t ItcMailbox::getMboxFd()
+{
+    if(m_rxFd >= 0 && !(m_rxFdUsers.fetch_or(ITC_MAILBOX_RX_FD_HANDED_OUT, MEMORY_ORDER_RELAXED) & ITC_MAILBOX_RX_FD_HANDED_OUT)) UNLIKELY
+    {
+        /* Messages pushed so far did not signal the fd, pairs with the fence in notifyReceiver() like in popAny(). */
+        std::atomic_thread_fence(MEMORY_ORDER_SEQ_CONSISTENT);
+        bool hasDeferredMsgs = m_deferredMsgs && !m_deferredMsgs->empty();
+        if((hasDeferredMsgs || getNrPendingMsgs() > 0) && !m_isRxFdSignalled.exchange(true, MEMORY_ORDER_RELAXED))
+        {
+            signalRxFd(m_rxFd);
+        }
+    }
+    return m_rxFd;
+}
+
+void ItcMailbox::addNrSentMsgs(uint64_t count)
+{
+    if(m_statistics && count > 0) LIKELY
+    {
+        m_statistics->counters.add(ITC_MAILBOX_COUNTER_SENT_MSGS, count);
+    }
+}
+
+bool ItcMailbox::getStatistics(MailboxStatistics &statistics) const
+{
+    if(!m_statistics)
+    {
+        return false;
+    }
+    statistics = MailboxStatistics();
+    statistics.nrSentMsgs = m_statistics->counters.get(ITC_MAILBOX_COUNTER_SENT_MSGS);
+    statistics.nrEnqueuedMsgs = m_statistics->counters.get(ITC_MAILBOX_COUNTER_ENQUEUED_MSGS);
+    statistics.nrReceivedMsgs = m_statistics->counters.get(ITC_MAILBOX_COUNTER_RECEIVED_MSGS);
+    statistics.nrQueuedMsgs = getNrPendingMsgs();
+    statistics.maxQueueDepth = m_statistics->maxQueueDepth.load(MEMORY_ORDER_RELAXED);
+    if(m_rxControl)
+    {
+        statistics.nrDroppedMsgs = m_rxControl->nrDroppedMsgs.load(MEMORY_ORDER_RELAXED);
+        statistics.nrRejectedMsgs = m_rxControl->nrRejectedMsgs.load(MEMORY_ORDER_RELAXED);
+    }
+    return true;
+}
+
+bool ItcMailbox::getLatencySnapshot(MAYBE_UNUSED MailboxLatencySnapshot &snapshot) const
+{
+#if defined ITC_LATENCY_TRACE_ENABLE
+    if(!m_statistics)
+    {
+        return false;
+    }
+    for(uint32_t stage = 0; stage < ITC_LATENCY_NUMBER_OF_STAGES; ++stage)
+    {
+        snapshot.at(stage) = m_statistics->latencyStats.at(stage).snapshot();
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
 } // namespace INTERNAL
 } // namespace ITC
\ No newline at end of file
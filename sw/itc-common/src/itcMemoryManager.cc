@@ -0,0 +1,274 @@
+#include "itcMemoryManager.h"
+
+#include <iostream>
+#include <algorithm>
+
+#include "itcConstant.h"
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+SINGLETON_DEFINITION(MemoryManager)
+
+static constexpr std::array<uint32_t, MEMORY_POOL_NUMBER_OF_SIZE_CLASSES> nrSlotsPerSizeClass {MEMORY_POOL_64_SLOTS, MEMORY_POOL_256_SLOTS, MEMORY_POOL_512_SLOTS};
+
+std::atomic<uint64_t> MemoryManager::m_lastGeneration {0};
+thread_local MemoryManager::ThreadMagazines MemoryManager::m_threadMagazines;
+
+MemoryManager::ThreadMagazines::~ThreadMagazines()
+{
+    if(generation == 0)
+    {
+        return;
+    }
+
+    /***
+     * A reference of our own, so that the MemoryManager cannot be destroyed while the slots are given back.
+     * Threads may outlive it, then its pool is gone and flushThreadCache() finds another generation or nothing.
+     */
+    std::shared_ptr<MemoryManager> memManager;
+    {
+        std::scoped_lock<std::mutex> lock(m_singletonMutex);
+        memManager = m_instance;
+    }
+    if(memManager)
+    {
+        memManager->flushThreadCache();
+    }
+}
+
+MemoryManager::MemoryManager()
+{
+    m_nrNodes = NumaTopology::getNumberOfNodes();
+    for(uint32_t node = 0; node < m_nrNodes; ++node)
+    {
+        auto &allocatorParams = m_allocatorParams[node];
+        allocatorParams.mode = MEMORY_ALLOCATOR_MODE_2;
+        /* With a single node, the first touch puts every page there anyway. */
+        allocatorParams.numaNode = m_nrNodes > 1 ? node : MEMORY_NUMA_NODE_ANY;
+        UInt8RawPtr baseAddr = MemoryAllocator::allocate(MEMORY_POOL_TOTAL_SIZE, allocatorParams);
+        if(!baseAddr) UNLIKELY
+        {
+            TPT_TRACE(TRACE_ABN, SSTR("Failed to allocate memory pool of NUMA node ", node, ", fall back to heap allocation!"));
+            continue;
+        }
+
+        m_memPools[node] = std::make_unique<MemoryPool>(baseAddr, MEMORY_POOL_TOTAL_SIZE);
+        for(uint32_t sizeClass = 0; sizeClass < MEMORY_POOL_NUMBER_OF_SIZE_CLASSES; ++sizeClass)
+        {
+            m_nrFreeMagazines[node][sizeClass].store(nrSlotsPerSizeClass[sizeClass] / MEMORY_MAGAZINE_POOL_SHARE / MEMORY_MAGAZINE_CAPACITY, MEMORY_ORDER_RELAXED);
+        }
+        UInt8RawPtr unlimitedAddr = MemoryAllocator::append(MEMORY_POOL_UNLIMITED_TOTAL_SIZE, allocatorParams);
+        if(!m_memPools[node]->appendUnlimited(unlimitedAddr, MEMORY_POOL_UNLIMITED_TOTAL_SIZE)) UNLIKELY
+        {
+            TPT_TRACE(TRACE_ABN, SSTR("Failed to append unlimited tier to memory pool of NUMA node ", node, ", large messages fall back to heap allocation!"));
+        }
+    }
+    m_generation = m_lastGeneration.fetch_add(1, MEMORY_ORDER_RELAXED) + 1;
+}
+
+MemoryManager::~MemoryManager()
+{
+    /* getInstanceRawPtr() callers go through getInstance() again and get the next one. */
+    m_instanceRawPtr.store(nullptr, MEMORY_ORDER_RELEASE);
+    for(uint32_t node = 0; node < m_nrNodes; ++node)
+    {
+        if(m_memPools[node])
+        {
+            m_memPools[node].reset();
+            MemoryAllocator::deallocate(m_allocatorParams[node]);
+        }
+    }
+}
+
+UInt8RawPtr MemoryManager::allocate(uint32_t size, uint32_t numaNode)
+{
+    if(numaNode != MEMORY_NUMA_NODE_ANY && m_nrNodes > 1) UNLIKELY
+    {
+        return allocateOnNode(size, numaNode);
+    }
+
+    uint32_t sizeClass = MemoryPool::getSizeClass(size);
+    if(sizeClass < MEMORY_POOL_NUMBER_OF_SIZE_CLASSES) LIKELY
+    {
+        auto &threadMagazines = getThreadMagazines();
+        MemoryPool *memPool = m_memPools[threadMagazines.node].get();
+        if(memPool) LIKELY
+        {
+            auto &magazine = threadMagazines.magazines[sizeClass];
+            if(magazine.count == 0) UNLIKELY
+            {
+                if(magazine.isReserved || reserveMagazine(threadMagazines.node, sizeClass, magazine))
+                {
+                    magazine.count = memPool->allocateBatch(sizeClass, magazine.slots.data(), MEMORY_MAGAZINE_BATCH_SIZE);
+                }
+            }
+            if(magazine.count > 0) LIKELY
+            {
+                return magazine.slots[--magazine.count];
+            }
+
+            /* No magazine for us, or this size class is exhausted and a larger one may still have slots. */
+            UInt8RawPtr ptr = memPool->allocate(size);
+            if(ptr)
+            {
+                return ptr;
+            }
+        }
+    } else if(size <= MEMORY_POOL_UNLIMITED_MAX_BLOCK_SIZE)
+    {
+        MemoryPool *memPool = m_memPools[getThreadMagazines().node].get();
+        UInt8RawPtr ptr = memPool ? memPool->allocate(size) : nullptr;
+        if(ptr)
+        {
+            return ptr;
+        }
+    }
+
+    /* Too large for the unlimited tier or pool exhausted. */
+    return new uint8_t[size];
+}
+
+UInt8RawPtr MemoryManager::allocateOnNode(uint32_t size, uint32_t numaNode)
+{
+    m_counters.add(MEMORY_COUNTER_NODE_ALLOCS);
+    if(numaNode == getThreadMagazines().node)
+    {
+        return allocate(size);
+    }
+
+    if(numaNode < m_nrNodes && m_memPools[numaNode]) LIKELY
+    {
+        UInt8RawPtr ptr = m_memPools[numaNode]->allocate(size);
+        if(ptr) LIKELY
+        {
+            return ptr;
+        }
+    }
+
+    m_counters.add(MEMORY_COUNTER_NODE_FALLBACK_ALLOCS);
+    return allocate(size);
+}
+
+void MemoryManager::deallocate(UInt8RawPtr ptr)
+{
+    auto &threadMagazines = getThreadMagazines();
+    MemoryPool *memPool = m_memPools[threadMagazines.node].get();
+    uint32_t sizeClass = memPool ? memPool->getSlotSizeClass(ptr) : MEMORY_POOL_NUMBER_OF_SIZE_CLASSES;
+    if(sizeClass < MEMORY_POOL_NUMBER_OF_SIZE_CLASSES) LIKELY
+    {
+        auto &magazine = threadMagazines.magazines[sizeClass];
+        if(!magazine.isReserved && !reserveMagazine(threadMagazines.node, sizeClass, magazine)) UNLIKELY
+        {
+            memPool->deallocate(ptr);
+            return;
+        }
+        if(magazine.count == MEMORY_MAGAZINE_CAPACITY) UNLIKELY
+        {
+            /* The least recently freed slots go back, the cache-hot ones stay on top. */
+            memPool->deallocateBatch(sizeClass, magazine.slots.data(), MEMORY_MAGAZINE_BATCH_SIZE);
+            std::copy(magazine.slots.begin() + MEMORY_MAGAZINE_BATCH_SIZE, magazine.slots.end(), magazine.slots.begin());
+            magazine.count -= MEMORY_MAGAZINE_BATCH_SIZE;
+        }
+        magazine.slots[magazine.count++] = ptr;
+        return;
+    }
+
+    /* Slots of other nodes and blocks of the unlimited tiers go straight back, magazines only hold size classes of their own node. */
+    for(uint32_t node = 0; node < m_nrNodes; ++node)
+    {
+        if(m_memPools[node] && m_memPools[node]->deallocate(ptr))
+        {
+            return;
+        }
+    }
+
+    MemoryPool *sharedPool = m_sharedPool.load(MEMORY_ORDER_ACQUIRE);
+    if(sharedPool && sharedPool->deallocate(ptr))
+    {
+        return;
+    }
+
+    delete[] ptr;
+}
+
+void MemoryManager::setSharedPool(MemoryPool *sharedPool)
+{
+    m_sharedPool.store(sharedPool, MEMORY_ORDER_RELEASE);
+}
+
+void MemoryManager::flushThreadCache()
+{
+    MemoryPool *memPool = m_memPools[m_threadMagazines.node].get();
+    if(m_threadMagazines.generation != m_generation || !memPool)
+    {
+        return;
+    }
+
+    for(uint32_t sizeClass = 0; sizeClass < MEMORY_POOL_NUMBER_OF_SIZE_CLASSES; ++sizeClass)
+    {
+        auto &magazine = m_threadMagazines.magazines[sizeClass];
+        while(magazine.count > 0)
+        {
+            uint32_t nrSlots = std::min(magazine.count, MEMORY_POOL_MAX_BATCH_SIZE);
+            magazine.count -= nrSlots;
+            memPool->deallocateBatch(sizeClass, magazine.slots.data() + magazine.count, nrSlots);
+        }
+        if(magazine.isReserved)
+        {
+            m_nrFreeMagazines[m_threadMagazines.node][sizeClass].fetch_add(1, MEMORY_ORDER_RELAXED);
+            magazine.isReserved = false;
+        }
+    }
+}
+
+MemoryStatistics MemoryManager::getStatistics() const
+{
+    MemoryStatistics statistics;
+    statistics.nrNumaNodes = m_nrNodes;
+    statistics.nrNodeAllocs = m_counters.get(MEMORY_COUNTER_NODE_ALLOCS);
+    statistics.nrNodeFallbackAllocs = m_counters.get(MEMORY_COUNTER_NODE_FALLBACK_ALLOCS);
+    return statistics;
+}
+
+bool MemoryManager::reserveMagazine(uint32_t node, uint32_t sizeClass, MemoryMagazine &magazine)
+{
+    auto &nrFreeMagazines = m_nrFreeMagazines[node][sizeClass];
+    uint32_t nrFree = nrFreeMagazines.load(MEMORY_ORDER_RELAXED);
+    while(nrFree > 0)
+    {
+        if(nrFreeMagazines.compare_exchange_weak(nrFree, nrFree - 1, MEMORY_ORDER_RELAXED))
+        {
+            magazine.isReserved = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+MemoryManager::ThreadMagazines &MemoryManager::getThreadMagazines()
+{
+    if(m_threadMagazines.generation != m_generation) UNLIKELY
+    {
+        /* Left over from a previous MemoryManager, whose pool has been unmapped together with those slots. */
+        for(auto &magazine : m_threadMagazines.magazines)
+        {
+            magazine.isReserved = false;
+            magazine.count = 0;
+        }
+        m_threadMagazines.generation = m_generation;
+        /* Threads rarely move between nodes, their magazines stay with the node they started on. */
+        uint32_t node = m_nrNodes > 1 ? NumaTopology::getCurrentNode() : 0;
+        m_threadMagazines.node = node < m_nrNodes && m_memPools[node] ? node : 0;
+    }
+    return m_threadMagazines;
+}
+
+} // namespace INTERNAL
+} // namespace ITC
@@ -1,5 +1,7 @@
 #include "itcSyncObject.h"
 
+#include "itcConstant.h"
+
 namespace ITC
 {
 /***
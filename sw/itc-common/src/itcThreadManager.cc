@@ -1,5 +1,7 @@
 #include "itcThreadManager.h"
 
+#include <utility>
+
 // #include <traceIf.h>
 // #include "itc-common/inc/itcTptProvider.h"
 
@@ -82,7 +84,15 @@ ThreadManagerIfReturnCode ThreadManager::addThread(const Task &task, std::shared
 ThreadManagerIfReturnCode ThreadManager::startAllThreads()
 {
 	auto rc = MAKE_RETURN_CODE(ThreadManagerIfReturnCode, THREAD_MANAGER_OK);
+	/* Created threads, whose SyncObject mutex we keep holding until we wait for their ready signal. */
+	std::vector<std::pair<Thread *, std::shared_ptr<SyncObject>>> startingThreads;
 	MUTEX_LOCK(&m_threadListMutex);
+	startingThreads.reserve(m_threadList.size());
+	/***
+	 * Create all threads first and only then wait for them as a single barrier, so that their initialisations
+	 * overlap and startup takes as long as the slowest thread rather than the sum of all of them.
+	 * A thread can not signal before we wait on its cond, since it needs the mutex we are holding.
+	 */
 	for(auto &thr : m_threadList)
 	{
 		if(thr.isRunning) UNLIKELY continue;
@@ -100,22 +110,32 @@ ThreadManagerIfReturnCode ThreadManager::startAllThreads()
 					(thr.useHighestPriority ? m_selfLimitPrio : m_priority));
 		if(rc != MAKE_RETURN_CODE(ThreadManagerIfReturnCode, THREAD_MANAGER_OK)) UNLIKELY
 		{
+			MUTEX_UNLOCK(&syncObj->elems->mtx);
 			TPT_TRACE(TRACE_ERROR, SSTR("Failed to start a thread tid = ", thr.tid));
 			break;
 		}
 		
 		syncObj->calculateExpiredDate();
+		startingThreads.emplace_back(&thr, syncObj);
+	}
+	
+	/* Threads which were already created are waited for even if a later one failed, they are running anyway. */
+	for(auto &[thr, syncObj] : startingThreads)
+	{
 		int32_t ret = CWrapperIf::getInstance().lock()->cPthreadCondTimedWait(&syncObj->elems->cond, &syncObj->elems->mtx, &syncObj->timeout);
 		MUTEX_UNLOCK(&syncObj->elems->mtx);
 		if(ret != 0) UNLIKELY
 		{
-			TPT_TRACE(TRACE_INFO, SSTR("Failed to start thread tid = ", thr.tid, ", waitTime = ", \
+			TPT_TRACE(TRACE_INFO, SSTR("Failed to start thread tid = ", thr->tid, ", waitTime = ", \
 				syncObj->relativeTimeout, " (ms), ret = ", ret));
-			rc = MAKE_RETURN_CODE(ThreadManagerIfReturnCode, THREAD_MANAGER_INITIALISATION_TIMEOUT);
-			break;
+			if(rc == MAKE_RETURN_CODE(ThreadManagerIfReturnCode, THREAD_MANAGER_OK))
+			{
+				rc = MAKE_RETURN_CODE(ThreadManagerIfReturnCode, THREAD_MANAGER_INITIALISATION_TIMEOUT);
+			}
+			continue;
 		}
-		TPT_TRACE(TRACE_INFO, SSTR("Started a thread, tid = ", thr.tid));
-		thr.isRunning = true;
+		TPT_TRACE(TRACE_INFO, SSTR("Started a thread, tid = ", thr->tid));
+		thr->isRunning = true;
 	}
 	MUTEX_UNLOCK(&m_threadListMutex);
 	return rc;
@@ -147,6 +167,7 @@ ThreadManagerIfReturnCode ThreadManager::terminateAllThreads()
 
 		TPT_TRACE(TRACE_INFO, SSTR("Terminating a thread, tid = ", thr.tid));
 		thr.isRunning = false;
+		thr.tid = 0; /* Joined, Thread::reset() must not cancel it again. */
 	}
 	MUTEX_UNLOCK(&m_threadListMutex);
 	return rc;
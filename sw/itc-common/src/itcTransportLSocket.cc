@@ -150,6 +150,7 @@ LocatedResults ItcTransportLSocket::locateItcServer()
 	if(ret < 0)
 	{
 		TPT_TRACE(TRACE_ERROR, SSTR("Failed to connect(), errno = ", errno));
+		cWrapperIf->cClose(sockFd);
 		return locatedResults;
 	}
 
@@ -161,20 +162,20 @@ LocatedResults ItcTransportLSocket::locateItcServer()
     if(ret < 0)
 	{
 		TPT_TRACE(TRACE_ERROR, SSTR("Failed to send ITC_ETHERNET_MESSAGE_LOCATE_ITC_SERVER_REQUEST!"));
+		cWrapperIf->cClose(sockFd);
 		return locatedResults;
 	}
     
     uint8_t rxBuffer[ITC_MAX_SOCKET_RX_BUFFER_SIZE];
     auto lreply = reinterpret_cast<itc_ethernet_message_locate_itc_server_reply *>(rxBuffer);
     auto receivedBytes = cWrapperIf->cRecv(sockFd, lreply, ITC_MAX_SOCKET_RX_BUFFER_SIZE, 0);
+    cWrapperIf->cClose(sockFd);
 	if(receivedBytes < (ssize_t)sizeof(itc_ethernet_message_locate_itc_server_reply))
 	{
 		TPT_TRACE(TRACE_ABN, SSTR("Invalid ITC_ETHERNET_MESSAGE_LOCATE_ITC_SERVER_REQUEST received, receivedBytes = ", receivedBytes));
 		return locatedResults;
 	}
     
-    cWrapperIf->cClose(sockFd);
-    
     /* Done communication, start analyzing the response */
 	if(lreply->msgno == ITC_ETHERNET_MESSAGE_LOCATE_ITC_SERVER_REPLY && lreply->assignedRegionId != ITC_MAILBOX_ID_DEFAULT)
 	{
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <cstddef>
 #include <mutex>
+#include <algorithm>
 
 // #include <traceIf.h>
 // #include "itcTptProvider.h"
@@ -37,15 +38,128 @@ ItcPlatformIfReturnCode ItcTransportLocal::send(ItcAdminMessageRawPtr adminMsg)
     auto receiver = m_mboxList.lock()->at(receiverIndex);
     if(receiver)
     {
-        receiver->push(adminMsg);
-        return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK);
+        /* The receiver may own and free the message as soon as it is pushed. */
+        uint32_t size = adminMsg->size;
+        if(receiver->push(adminMsg)) LIKELY
+        {
+            m_counters.add(ITC_TRANSPORT_COUNTER_SENT_MSGS);
+            m_counters.add(ITC_TRANSPORT_COUNTER_SENT_BYTES, size);
+            return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK);
+        }
+        m_counters.add(ITC_TRANSPORT_COUNTER_FAILED_SENDS);
+        /* Refused by ITC_MAILBOX_RX_OVERFLOW_REJECT, the message stays with the sender. */
+        return receiver->isActive() ? MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_QUEUE_FULL) : MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
     }
+    m_counters.add(ITC_TRANSPORT_COUNTER_FAILED_SENDS);
     return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
 }
 
-ItcAdminMessageRawPtr ItcTransportLocal::receive(ItcMailboxRawPtr myMbox, uint32_t mode)
+ItcPlatformIfReturnCode ItcTransportLocal::sendBatch(ItcAdminMessageRawPtr *adminMsgs, size_t count)
 {
-    return myMbox->pop(mode);
+    auto mboxList = m_mboxList.lock();
+    bool isAllSent {true};
+    uint64_t nrSentMsgs {0};
+    uint64_t nrSentBytes {0};
+    size_t runStart = 0;
+    while(runStart < count)
+    {
+        /* Each run of messages to the same receiver goes into its rx queue at once. */
+        itc_mailbox_id_t receiverId = adminMsgs[runStart]->receiver;
+        size_t runEnd = runStart + 1;
+        uint64_t runBytes = adminMsgs[runStart]->size;
+        while(runEnd < count && adminMsgs[runEnd]->receiver == receiverId)
+        {
+            runBytes += adminMsgs[runEnd]->size;
+            ++runEnd;
+        }
+
+        auto receiver = mboxList->at(receiverId & ITC_MASK_UNIT_ID);
+        size_t nrPushedMsgs = receiver ? receiver->pushBatch(adminMsgs + runStart, runEnd - runStart) : 0;
+        std::fill(adminMsgs + runStart, adminMsgs + runStart + nrPushedMsgs, nullptr);
+        if(runStart + nrPushedMsgs < runEnd) UNLIKELY
+        {
+            /* Only a refused tail is left, it is still ours to measure. */
+            for(size_t i = runStart + nrPushedMsgs; i < runEnd; ++i)
+            {
+                runBytes -= adminMsgs[i]->size;
+            }
+            isAllSent = false;
+        }
+        nrSentMsgs += nrPushedMsgs;
+        nrSentBytes += runBytes;
+        runStart = runEnd;
+    }
+    m_counters.add(ITC_TRANSPORT_COUNTER_SENT_MSGS, nrSentMsgs);
+    m_counters.add(ITC_TRANSPORT_COUNTER_SENT_BYTES, nrSentBytes);
+    if(nrSentMsgs < count) UNLIKELY
+    {
+        m_counters.add(ITC_TRANSPORT_COUNTER_FAILED_SENDS, count - nrSentMsgs);
+    }
+    return isAllSent ? MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK) : MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+}
+
+ItcAdminMessageRawPtr ItcTransportLocal::receive(ItcMailboxRawPtr myMbox, uint32_t mode, uint32_t timeout)
+{
+    auto adminMsg = myMbox->pop(mode, timeout);
+    if(adminMsg) LIKELY
+    {
+        m_counters.add(ITC_TRANSPORT_COUNTER_RECEIVED_MSGS);
+        m_counters.add(ITC_TRANSPORT_COUNTER_RECEIVED_BYTES, adminMsg->size);
+    }
+    return adminMsg;
+}
+
+ItcAdminMessageRawPtr ItcTransportLocal::receiveSelective(ItcMailboxRawPtr myMbox, const std::vector<uint32_t> &filter, uint32_t mode, uint32_t timeout)
+{
+    auto adminMsg = myMbox->popSelective(filter, mode, timeout);
+    if(adminMsg) LIKELY
+    {
+        m_counters.add(ITC_TRANSPORT_COUNTER_RECEIVED_MSGS);
+        m_counters.add(ITC_TRANSPORT_COUNTER_RECEIVED_BYTES, adminMsg->size);
+    }
+    return adminMsg;
+}
+
+ItcAdminMessageRawPtr ItcTransportLocal::receiveAny(ItcMailboxRawPtr *myMboxes, size_t count, uint32_t mode, uint32_t timeout)
+{
+    auto adminMsg = ItcMailbox::popAny(myMboxes, static_cast<uint32_t>(count), mode, timeout);
+    if(adminMsg) LIKELY
+    {
+        m_counters.add(ITC_TRANSPORT_COUNTER_RECEIVED_MSGS);
+        m_counters.add(ITC_TRANSPORT_COUNTER_RECEIVED_BYTES, adminMsg->size);
+    }
+    return adminMsg;
+}
+
+size_t ItcTransportLocal::receiveBatch(ItcMailboxRawPtr myMbox, ItcAdminMessageRawPtr *adminMsgs, size_t maxCount, uint32_t mode, uint32_t timeout)
+{
+    size_t count = myMbox->popBatch(adminMsgs, std::min<size_t>(maxCount, ITC_MAILBOX_RX_MESSAGE_QUEUE_SIZE), mode, timeout);
+    if(count > 0) LIKELY
+    {
+        uint64_t nrBytes = 0;
+        for(size_t i = 0; i < count; ++i)
+        {
+            nrBytes += adminMsgs[i]->size;
+        }
+        m_counters.add(ITC_TRANSPORT_COUNTER_RECEIVED_MSGS, count);
+        m_counters.add(ITC_TRANSPORT_COUNTER_RECEIVED_BYTES, nrBytes);
+    }
+    return count;
+}
+
+TransportStatistics ItcTransportLocal::getStatistics() const
+{
+    return getTransportStatistics(m_counters);
+}
+
+uint32_t ItcTransportLocal::getNumaNode(itc_mailbox_id_t mboxId) const
+{
+    auto mboxList = m_mboxList.lock();
+    if(!mboxList) UNLIKELY
+    {
+        return MEMORY_NUMA_NODE_ANY;
+    }
+    return mboxList->getNode(mboxId & ITC_MASK_UNIT_ID);
 }
 
 } // namespace INTERNAL
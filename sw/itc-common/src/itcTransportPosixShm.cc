@@ -0,0 +1,588 @@
+#include "itcTransportPosixShm.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <string>
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+
+// #include <traceIf.h>
+// #include "itcTptProvider.h"
+#include "itcConstant.h"
+#include "itcAdminMessage.h"
+#include "itcMemoryManager.h"
+#include "itcThreadManagerIf.h"
+#include "itcCWrapperIf.h"
+#include "itcMutex.h"
+#include "itcTransportLocal.h"
+#include "itcSystemProto.h"
+#include "itcLocateCache.h"
+
+using namespace ITC::INTERNAL;
+using ITC::INTERNAL::ItcTransportPosixShm;
+
+void *posixShmRxThreadWrapper(void *args)
+{
+	auto inst = ItcTransportPosixShm::getInstance().lock();
+	return inst->posixShmRxThread(args);
+}
+
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+using namespace ITC::PROVIDED;
+using ItcPlatformIfReturnCode = ItcPlatformIf::ItcPlatformIfReturnCode;
+
+SINGLETON_DEFINITION(ItcTransportPosixShm)
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free, "Futex word must be a plain 32-bit integer!");
+
+/***
+ * Not FUTEX_*_PRIVATE, senders wake the rx thread from other processes.
+ * Unlike an endless wait, one with a timeout is not restarted after a signal handler ran, so SIGCANCEL ends it with EINTR.
+ */
+static inline void futexWaitShared(std::atomic<uint32_t> *addr, uint32_t expected, uint32_t timeout)
+{
+	struct timespec relTimeout {timeout / 1000, (timeout % 1000) * 1000000L};
+	::syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAIT, expected, &relTimeout, nullptr, 0);
+}
+
+static inline void futexWakeShared(std::atomic<uint32_t> *addr, int32_t count)
+{
+	::syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAKE, count, nullptr, nullptr, 0);
+}
+
+ItcTransportPosixShm::~ItcTransportPosixShm()
+{
+	for(size_t i = 0; i < m_contactList.size(); ++i)
+	{
+		detachContactAtIndex(i);
+	}
+	for(auto retired : m_retiredContacts)
+	{
+		destroyContact(retired);
+	}
+	removeSharedSegment();
+}
+
+bool ItcTransportPosixShm::initialise(itc_mailbox_id_t regionId)
+{
+    if(m_isInitialised)
+    {
+        TPT_TRACE(TRACE_INFO, SSTR("ITC system already initialised!"));
+        return false;
+    }
+
+    m_regionId = regionId;
+    if(!createSharedSegment())
+    {
+        return false;
+    }
+
+	m_syncObj = std::make_shared<SyncObject>([](SyncObjectElementsSharedPtr elemsPtr)
+	{
+		auto ret = CWrapperIf::getInstance().lock()->cPthreadCondAttrSetClock(&elemsPtr->condAttrs, CLOCK_MONOTONIC);
+		if(ret != 0)
+		{
+			TPT_TRACE(TRACE_ERROR, SSTR("Failed to pthread_condattr_setclock, error code = ", ret));
+			return -1;
+		}
+		return 0;
+	});
+	m_syncObj->setTimeout(100 /* ms */);
+	m_isRxThreadTerminated = false;
+    ThreadManagerIf::getInstance().lock()->addThread(Task(&posixShmRxThreadWrapper), m_syncObj);
+	m_isInitialised = true;
+    return true;
+}
+
+void ItcTransportPosixShm::release()
+{
+    if(m_isInitialised)
+	{
+		stopRxThread();
+		m_isInitialised = false;
+
+		std::scoped_lock<std::mutex> lock(m_contactListMutex);
+		for(size_t i = 0; i < m_contactList.size(); ++i)
+		{
+			detachContactAtIndex(i);
+		}
+		for(auto retired : m_retiredContacts)
+		{
+			destroyContact(retired);
+		}
+		m_retiredContacts.clear();
+		removeSharedSegment();
+	}
+}
+
+void ItcTransportPosixShm::stopRxThread()
+{
+	m_isRxThreadTerminated = true;
+	if(m_header)
+	{
+		wakeReceiver(m_header);
+	}
+}
+
+ItcPlatformIfReturnCode ItcTransportPosixShm::send(ItcAdminMessageRawPtr adminMsg)
+{
+    if(!m_isInitialised)
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("ITC Transport POSIX Shared Memory not initialised yet!"));
+        return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+    }
+
+	ContactUseGuard contactUseGuard(*this);
+	PosixShmContactInfo *contact = getContact(adminMsg->receiver);
+	if(!contact)
+	{
+		m_counters.add(ITC_TRANSPORT_COUNTER_FAILED_SENDS);
+		return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+	}
+
+	MemoryPool *pool = contact->pool.get();
+	PosixShmRxRingRawPtr rxRing = contact->rxRing;
+	uint32_t size = ITC_ADMIN_MESSAGE_PREAMBLE_SIZE + adminMsg->size + ITC_ADMIN_MESSAGE_ENDPOINT_SIZE;
+	UInt8RawPtr slot = pool->allocate(size);
+	if(!slot)
+	{
+		TPT_TRACE(TRACE_DEBUG, SSTR("No slot for ", size, " bytes in receiver's pool!"));
+		m_counters.add(ITC_TRANSPORT_COUNTER_FAILED_SENDS);
+		return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+	}
+
+	ITC_LATENCY_STAMP(adminMsg, ITC_LATENCY_STAMP_REGION_TX);
+	std::memcpy(slot, adminMsg, size);
+	reinterpret_cast<ItcAdminMessageRawPtr>(slot)->flags &= ITC_MASK_MESSAGE_PRIORITY;
+	auto offset = pool->getOffset(slot);
+	if(!rxRing->tryPush(offset)) UNLIKELY
+	{
+		TPT_TRACE(TRACE_ABN, SSTR("Receiver's posix shm rx ring is full!"));
+		pool->deallocate(slot);
+		dropContactOfDeadOwner(contact);
+		m_counters.add(ITC_TRANSPORT_COUNTER_FAILED_SENDS);
+		return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+	}
+	wakeReceiver(contact->header);
+	m_counters.add(ITC_TRANSPORT_COUNTER_SENT_MSGS);
+	m_counters.add(ITC_TRANSPORT_COUNTER_SENT_BYTES, adminMsg->size);
+
+    /***
+     * ITC System only helps to delete itc messages if the sending was successful,
+     * in case of failures, users have to call ItcPlatform::delete() by themselves.
+     */
+    if(!ItcAdminMessageHelper::deallocate(adminMsg))
+	{
+		TPT_TRACE(TRACE_ERROR, SSTR("Failed to deallocate itc message!"));
+		return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+	}
+    return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK);
+}
+
+ItcPlatformIfReturnCode ItcTransportPosixShm::sendBatch(ItcAdminMessageRawPtr *adminMsgs, size_t count)
+{
+    if(!m_isInitialised)
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("ITC Transport POSIX Shared Memory not initialised yet!"));
+        return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+    }
+
+	if(count == 0)
+	{
+		return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK);
+	}
+
+	ContactUseGuard contactUseGuard(*this);
+	PosixShmContactInfo *contact = getContact(adminMsgs[0]->receiver);
+	if(!contact)
+	{
+		m_counters.add(ITC_TRANSPORT_COUNTER_FAILED_SENDS, count);
+		return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+	}
+
+	MemoryPool *pool = contact->pool.get();
+	PosixShmRxRingRawPtr rxRing = contact->rxRing;
+	std::array<int32_t, ITC_BATCH_CHUNK_SIZE> offsets;
+	for(size_t chunkStart = 0; chunkStart < count; chunkStart += ITC_BATCH_CHUNK_SIZE)
+	{
+		uint32_t chunkSize = std::min<size_t>(ITC_BATCH_CHUNK_SIZE, count - chunkStart);
+		uint32_t nrSlots = 0;
+		uint64_t nrBytes = 0;
+		for(; nrSlots < chunkSize; ++nrSlots)
+		{
+			ItcAdminMessageRawPtr adminMsg = adminMsgs[chunkStart + nrSlots];
+			uint32_t size = ITC_ADMIN_MESSAGE_PREAMBLE_SIZE + adminMsg->size + ITC_ADMIN_MESSAGE_ENDPOINT_SIZE;
+			UInt8RawPtr slot = pool->allocate(size);
+			if(!slot)
+			{
+				TPT_TRACE(TRACE_DEBUG, SSTR("No slot for ", size, " bytes in receiver's pool!"));
+				break;
+			}
+			ITC_LATENCY_STAMP(adminMsg, ITC_LATENCY_STAMP_REGION_TX);
+			std::memcpy(slot, adminMsg, size);
+			reinterpret_cast<ItcAdminMessageRawPtr>(slot)->flags &= ITC_MASK_MESSAGE_PRIORITY;
+			offsets[nrSlots] = pool->getOffset(slot);
+			nrBytes += adminMsg->size;
+		}
+
+		/* One ring operation for the whole chunk, so the receiver sees these messages back to back. */
+		if(!rxRing->tryPushBatch(offsets.data(), nrSlots)) UNLIKELY
+		{
+			TPT_TRACE(TRACE_ABN, SSTR("Receiver's posix shm rx ring is full!"));
+			for(uint32_t i = 0; i < nrSlots; ++i)
+			{
+				pool->deallocate(pool->getAddress(offsets[i]));
+			}
+			dropContactOfDeadOwner(contact);
+			m_counters.add(ITC_TRANSPORT_COUNTER_FAILED_SENDS, count - chunkStart);
+			return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+		}
+		wakeReceiver(contact->header);
+		m_counters.add(ITC_TRANSPORT_COUNTER_SENT_MSGS, nrSlots);
+		m_counters.add(ITC_TRANSPORT_COUNTER_SENT_BYTES, nrBytes);
+
+		for(uint32_t i = 0; i < nrSlots; ++i)
+		{
+			ItcAdminMessageHelper::deallocate(adminMsgs[chunkStart + i]);
+			adminMsgs[chunkStart + i] = nullptr;
+		}
+
+		if(nrSlots < chunkSize)
+		{
+			/* Stop here, later messages must not overtake the ones left to the caller. */
+			m_counters.add(ITC_TRANSPORT_COUNTER_FAILED_SENDS, count - chunkStart - nrSlots);
+			return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
+		}
+	}
+    return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK);
+}
+
+ItcTransportPosixShm::ContactUseGuard::ContactUseGuard(ItcTransportPosixShm &transport)
+	: m_transport(transport)
+{
+	m_transport.m_nrContactUsers.fetch_add(1, MEMORY_ORDER_SEQ_CONSISTENT);
+}
+
+ItcTransportPosixShm::ContactUseGuard::~ContactUseGuard()
+{
+	if(m_transport.m_nrContactUsers.fetch_sub(1, MEMORY_ORDER_SEQ_CONSISTENT) == 1 && m_transport.m_hasRetiredContacts.load(MEMORY_ORDER_RELAXED)) UNLIKELY
+	{
+		/* Whoever holds the mutex is attaching and will be a user itself, its guard tries again. */
+		std::unique_lock<std::mutex> lock(m_transport.m_contactListMutex, std::try_to_lock);
+		if(lock.owns_lock())
+		{
+			m_transport.reclaimRetiredContacts();
+		}
+	}
+}
+
+PosixShmContactInfo *ItcTransportPosixShm::getContact(itc_mailbox_id_t receiver)
+{
+    itc_mailbox_id_t projectId = (receiver & ITC_MASK_REGION_ID) >> ITC_REGION_ID_SHIFT;
+	if(projectId == 0 || projectId >= ITC_MAX_SUPPORTED_REGIONS)
+	{
+		TPT_TRACE(TRACE_ABN, SSTR("Invalid posix shm peer's region id!"));
+		return nullptr;
+	}
+
+	auto &publishedContact = m_contactList.at(projectId);
+	/* Pairs with retireContactAtIndex(), see reclaimRetiredContacts(). */
+	PosixShmContactInfo *contact = publishedContact.load(MEMORY_ORDER_SEQ_CONSISTENT);
+	if(!contact || !contact->header->isReady.load(MEMORY_ORDER_ACQUIRE)) UNLIKELY
+	{
+		/* First message to this Region, or the receiver has re-created its segment since we attached. */
+		std::scoped_lock<std::mutex> lock(m_contactListMutex);
+		contact = publishedContact.load(MEMORY_ORDER_ACQUIRE);
+		if(!contact || !contact->header->isReady.load(MEMORY_ORDER_ACQUIRE))
+		{
+			retireContactAtIndex(projectId);
+			if(!attachContactAtIndex(projectId))
+			{
+				return nullptr;
+			}
+			contact = publishedContact.load(MEMORY_ORDER_RELAXED);
+		}
+	}
+	return contact;
+}
+
+std::string ItcTransportPosixShm::getShmName(itc_mailbox_id_t regionId)
+{
+	return ITC_POSIX_SHM_NAME_PREFIX + std::to_string((regionId & ITC_MASK_REGION_ID) >> ITC_REGION_ID_SHIFT);
+}
+
+bool ItcTransportPosixShm::createSharedSegment()
+{
+	m_params.mode = MEMORY_ALLOCATOR_MODE_3;
+	m_params.attrs.mode3.shmName = getShmName(m_regionId);
+
+	/* Region ids are unique among living processes, so whatever is left under our name belongs to a dead one. */
+	shm_unlink(m_params.attrs.mode3.shmName.c_str());
+
+	UInt8RawPtr baseAddr = MemoryAllocator::allocate(SEGMENT_SIZE, m_params);
+	if(!baseAddr)
+	{
+		TPT_TRACE(TRACE_ERROR, SSTR("Failed to create posix shm segment ", m_params.attrs.mode3.shmName));
+		return false;
+	}
+
+	m_header = new (baseAddr) PosixShmHeader();
+	m_rxRing = new (baseAddr + RX_RING_OFFSET) PosixShmRxRing();
+	m_pool = std::make_unique<MemoryPool>(baseAddr + POOL_OFFSET, MEMORY_POOL_TOTAL_SIZE);
+	UInt8RawPtr unlimitedAddr = MemoryAllocator::append(MEMORY_POOL_UNLIMITED_TOTAL_SIZE, m_params);
+	if(!m_pool->appendUnlimited(unlimitedAddr, MEMORY_POOL_UNLIMITED_TOTAL_SIZE))
+	{
+		TPT_TRACE(TRACE_ABN, SSTR("Failed to append unlimited tier to posix shm segment ", m_params.attrs.mode3.shmName, ", large messages are left to other transports!"));
+	}
+	MemoryManager::getInstance().lock()->setSharedPool(m_pool.get());
+
+	m_header->ownerPid = getpid();
+	m_header->isReady.store(1, MEMORY_ORDER_RELEASE);
+	return true;
+}
+
+void ItcTransportPosixShm::removeSharedSegment()
+{
+	if(!m_header)
+	{
+		return;
+	}
+
+	m_header->isReady.store(0, MEMORY_ORDER_RELEASE);
+	if(auto memManager = MemoryManager::getInstance().lock())
+	{
+		memManager->setSharedPool(nullptr);
+	}
+	m_pool.reset();
+	m_rxRing = nullptr;
+	m_header = nullptr;
+	MemoryAllocator::deallocate(m_params);
+}
+
+bool ItcTransportPosixShm::attachContactAtIndex(size_t atIndex)
+{
+	auto contact = std::make_unique<PosixShmContactInfo>();
+	contact->params.mode = MEMORY_ALLOCATOR_MODE_3;
+	contact->params.attrs.mode3.shmName = getShmName(static_cast<itc_mailbox_id_t>(atIndex) << ITC_REGION_ID_SHIFT);
+	contact->params.attrs.mode3.isAttachOnly = 1;
+
+	UInt8RawPtr baseAddr = MemoryAllocator::allocate(SEGMENT_SIZE, contact->params);
+	if(!baseAddr)
+	{
+		TPT_TRACE(TRACE_ABN, SSTR("Region ", atIndex, " has no posix shm segment!"));
+		return false;
+	}
+
+	contact->header = reinterpret_cast<PosixShmHeader *>(baseAddr);
+	if(!contact->header->isReady.load(MEMORY_ORDER_ACQUIRE) || !isOwnerAlive(contact->header))
+	{
+		MemoryAllocator::deallocate(contact->params);
+		return false;
+	}
+
+	contact->rxRing = reinterpret_cast<PosixShmRxRingRawPtr>(baseAddr + RX_RING_OFFSET);
+	contact->pool = std::make_unique<MemoryPool>(baseAddr + POOL_OFFSET, MEMORY_POOL_TOTAL_SIZE, true);
+	/* Without it, the receiver only takes messages which fit into its size classes. */
+	contact->pool->appendUnlimited(MemoryAllocator::append(MEMORY_POOL_UNLIMITED_TOTAL_SIZE, contact->params), MEMORY_POOL_UNLIMITED_TOTAL_SIZE, true);
+	m_contactList.at(atIndex).store(contact.release(), MEMORY_ORDER_RELEASE);
+	return true;
+}
+
+void ItcTransportPosixShm::detachContactAtIndex(size_t atIndex)
+{
+	if(auto contact = m_contactList.at(atIndex).exchange(nullptr, MEMORY_ORDER_ACQUIRE_RELEASE))
+	{
+		destroyContact(contact);
+	}
+}
+
+void ItcTransportPosixShm::retireContactAtIndex(size_t atIndex)
+{
+	/* Other senders may still be using the old mapping, keep it until reclaimRetiredContacts(). */
+	if(auto contact = m_contactList.at(atIndex).exchange(nullptr, MEMORY_ORDER_SEQ_CONSISTENT))
+	{
+		m_retiredContacts.push_back(contact);
+		m_hasRetiredContacts.store(true, MEMORY_ORDER_RELAXED);
+	}
+}
+
+bool ItcTransportPosixShm::isOwnerAlive(const PosixShmHeader *header)
+{
+	/* EPERM means the process exists but belongs to another user. */
+	return ::kill(header->ownerPid, 0) == 0 || errno != ESRCH;
+}
+
+void ItcTransportPosixShm::dropContactOfDeadOwner(PosixShmContactInfo *contact)
+{
+	/***
+	 * A crashed receiver never clears isReady, its rx ring just fills up. Clearing it here makes
+	 * every sender retire the contact, and attaching again fails until a new owner has re-created the segment.
+	 */
+	if(!isOwnerAlive(contact->header))
+	{
+		TPT_TRACE(TRACE_ABN, SSTR("Owner ", contact->header->ownerPid, " of posix shm segment ", contact->params.attrs.mode3.shmName, " is gone!"));
+		uint32_t isReady {1};
+		contact->header->isReady.compare_exchange_strong(isReady, 0, MEMORY_ORDER_RELEASE, MEMORY_ORDER_RELAXED);
+	}
+}
+
+void ItcTransportPosixShm::wakeReceiver(PosixShmHeader *header)
+{
+	/* Pairs with the fence in posixShmRxThread(): either the rx thread sees our offset, or we see it parked. */
+	std::atomic_thread_fence(MEMORY_ORDER_SEQ_CONSISTENT);
+	if(header->rxWaiterState.load(MEMORY_ORDER_RELAXED) == ITC_POSIX_SHM_RX_PARKED) UNLIKELY
+	{
+		/* Only the first sender after the ring ran empty gets here, the others see it awake. */
+		if(header->rxWaiterState.exchange(ITC_POSIX_SHM_RX_AWAKE, MEMORY_ORDER_RELAXED) == ITC_POSIX_SHM_RX_PARKED)
+		{
+			futexWakeShared(&header->rxWaiterState, 1);
+		}
+	}
+}
+
+void ItcTransportPosixShm::reclaimRetiredContacts()
+{
+	/***
+	 * Must be called with m_contactListMutex held. Retired contacts were taken out of m_contactList before,
+	 * so a sender registering after this check can only find their successors.
+	 */
+	if(m_nrContactUsers.load(MEMORY_ORDER_SEQ_CONSISTENT) != 0)
+	{
+		return;
+	}
+	for(auto retired : m_retiredContacts)
+	{
+		destroyContact(retired);
+	}
+	m_retiredContacts.clear();
+	m_hasRetiredContacts.store(false, MEMORY_ORDER_RELAXED);
+}
+
+void ItcTransportPosixShm::destroyContact(PosixShmContactInfo *contact)
+{
+	contact->pool.reset();
+	MemoryAllocator::deallocate(contact->params);
+	delete contact;
+}
+
+TransportStatistics ItcTransportPosixShm::getStatistics() const
+{
+	return getTransportStatistics(m_counters);
+}
+
+uint32_t ItcTransportPosixShm::forwardRxMessages()
+{
+	uint32_t count {0};
+	int32_t offset {-1};
+	while(m_rxRing->tryPop(offset))
+	{
+		UInt8RawPtr slot = m_pool->getAddress(offset);
+		if(!slot) UNLIKELY
+		{
+			TPT_TRACE(TRACE_ABN, SSTR("Received invalid offset ", offset, " from posix shm rx ring!"));
+			continue;
+		}
+
+		auto adminMsg = reinterpret_cast<ItcAdminMessageRawPtr>(slot);
+		if(ITC_ADMIN_MESSAGE_PREAMBLE_SIZE + adminMsg->size + ITC_ADMIN_MESSAGE_ENDPOINT_SIZE > m_pool->getSlotSize(slot)
+			|| *GET_ITC_ADMIN_MESSAGE_ENDPOINT(adminMsg) != ITC_ADMIN_MESSAGE_ENDPOINT) UNLIKELY
+		{
+			TPT_TRACE(TRACE_ABN, SSTR("Received malform message from posix shm rx ring!"));
+			m_pool->deallocate(slot);
+			m_counters.add(ITC_TRANSPORT_COUNTER_DROPPED_MSGS);
+			continue;
+		}
+
+		if(adminMsg->msgno == ITC_SYSTEM_MESSAGE_NOTIFY_MBOX_DELETION_FROM_ITC_SERVER_INDICATION) UNLIKELY
+		{
+			LocateCache::invalidateAll();
+			m_counters.add(ITC_TRANSPORT_COUNTER_RECEIVED_MSGS);
+			m_counters.add(ITC_TRANSPORT_COUNTER_RECEIVED_BYTES, adminMsg->size);
+			m_pool->deallocate(slot);
+			continue;
+		}
+
+		ITC_LATENCY_STAMP(adminMsg, ITC_LATENCY_STAMP_REGION_RX);
+		/* The receiver may own and free the message as soon as it is forwarded. */
+		uint32_t size = adminMsg->size;
+		auto rc = ItcTransportLocal::getInstance().lock()->send(adminMsg);
+		if(rc != MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK))
+		{
+			TPT_TRACE(TRACE_ABN, SSTR("Failed to forward message from posix shm to local transport mailbox!"));
+			m_pool->deallocate(slot);
+			m_counters.add(ITC_TRANSPORT_COUNTER_DROPPED_MSGS);
+			continue;
+		}
+		m_counters.add(ITC_TRANSPORT_COUNTER_RECEIVED_MSGS);
+		m_counters.add(ITC_TRANSPORT_COUNTER_RECEIVED_BYTES, size);
+		++count;
+	}
+	return count;
+}
+
+void *ItcTransportPosixShm::posixShmRxThread(void *args)
+{
+	auto cWrapperIf = CWrapperIf::getInstance().lock();
+	if(!cWrapperIf)
+	{
+		return nullptr;
+	}
+	if(::prctl(PR_SET_NAME, "itcPosixShmRx", 0, 0, 0) == -1)
+	{
+		TPT_TRACE(TRACE_ERROR, SSTR("Failed to prctl()!"));
+		return nullptr;
+	}
+
+	MUTEX_LOCK(&m_syncObj->elems->mtx);
+	cWrapperIf->cPthreadCondSignal(&m_syncObj->elems->cond);
+	MUTEX_UNLOCK(&m_syncObj->elems->mtx);
+
+	while(true)
+	{
+		if(m_isRxThreadTerminated)
+		{
+			TPT_TRACE(TRACE_INFO, SSTR("Terminating posix shm rx thread..."));
+			break;
+		}
+
+		if(forwardRxMessages() != 0)
+		{
+			continue;
+		}
+
+		m_header->rxWaiterState.store(ITC_POSIX_SHM_RX_PARKED, MEMORY_ORDER_RELAXED);
+		std::atomic_thread_fence(MEMORY_ORDER_SEQ_CONSISTENT);
+		if(m_rxRing->empty() && !m_isRxThreadTerminated)
+		{
+			/* Returns immediately if a sender has already flipped the state back to awake. */
+			futexWaitShared(&m_header->rxWaiterState, ITC_POSIX_SHM_RX_PARKED, ITC_POSIX_SHM_RX_PARK_TIMEOUT);
+		}
+		/* A raw futex wait is no cancellation point, ThreadManager::terminateAllThreads() would never get to join us. */
+		::pthread_testcancel();
+		m_header->rxWaiterState.store(ITC_POSIX_SHM_RX_AWAKE, MEMORY_ORDER_RELAXED);
+	}
+
+	return nullptr;
+}
+
+} // namespace INTERNAL
+} // namespace ITC
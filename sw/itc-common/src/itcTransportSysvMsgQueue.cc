@@ -26,6 +26,7 @@
 #include "itcCWrapperIf.h"
 #include "itcTransportLocal.h"
 #include "itcPlatform.h"
+#include "itcLocateCache.h"
 
 using namespace ITC::INTERNAL;
 using ITC::INTERNAL::ItcTransportSysvMsgQueue;
@@ -127,6 +128,7 @@ ItcPlatformIfReturnCode ItcTransportSysvMsgQueue::send(ItcAdminMessageRawPtr adm
 	if(projectId == 0 || projectId >= ITC_MAX_SUPPORTED_REGIONS)
 	{
 		TPT_TRACE(TRACE_ABN, SSTR("Invalid sysv message queue peer's region id!"));
+		m_counters.add(ITC_TRANSPORT_COUNTER_FAILED_SENDS);
 		return MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED);
 	}
     
@@ -135,6 +137,7 @@ ItcPlatformIfReturnCode ItcTransportSysvMsgQueue::send(ItcAdminMessageRawPtr adm
     auto txMsg {reinterpret_cast<long *>(txBuffer)};
 	*txMsg = (long)ITC_SYSV_MESSAGE_QUEUE_TX_MSGNO;
 	auto cWrapperIf = CWrapperIf::getInstance().lock();
+	ITC_LATENCY_STAMP(adminMsg, ITC_LATENCY_STAMP_REGION_TX);
 	cWrapperIf->cMemcpy(reinterpret_cast<void *>(txMsg + 1), adminMsg, size);
     
     while(cWrapperIf->cMsgsnd(m_contactList.at(projectId).msgQueueId, reinterpret_cast<const void *>(txMsg), size, MSG_NOERROR) == -1)
@@ -160,6 +163,8 @@ ItcPlatformIfReturnCode ItcTransportSysvMsgQueue::send(ItcAdminMessageRawPtr adm
 	}
 	delete[] txBuffer;
 	txBuffer = nullptr;
+	m_counters.add(ITC_TRANSPORT_COUNTER_SENT_MSGS);
+	m_counters.add(ITC_TRANSPORT_COUNTER_SENT_BYTES, adminMsg->size);
 	
     /***
      * ITC System only helps to delete itc messages if the sending was successful,
@@ -243,6 +248,7 @@ bool ItcTransportSysvMsgQueue::parseAndForwardMessage(uint8_t *rxBuffer, ssize_t
 	if(*sysvMsgno != ITC_SYSV_MESSAGE_QUEUE_TX_MSGNO)
 	{
 		TPT_TRACE(TRACE_ABN, SSTR("Unknown SYSV TX MSGNO ", *sysvMsgno, " received!"));
+		m_counters.add(ITC_TRANSPORT_COUNTER_DROPPED_MSGS);
 		return false;
 	}
 	
@@ -251,6 +257,7 @@ bool ItcTransportSysvMsgQueue::parseAndForwardMessage(uint8_t *rxBuffer, ssize_t
 	{
 		TPT_TRACE(TRACE_ABN, SSTR("Received malform message from some mailbox, invalid length = ", \
 				length, ", rxMsg->size = ", rxMsg->size));
+		m_counters.add(ITC_TRANSPORT_COUNTER_DROPPED_MSGS);
 		return false;
 	}
 	
@@ -259,25 +266,45 @@ bool ItcTransportSysvMsgQueue::parseAndForwardMessage(uint8_t *rxBuffer, ssize_t
 	{
 		TPT_TRACE(TRACE_ABN, SSTR("Received malform message from some mailbox, invalid ENDPOINT = 0x", \
 										std::hex, std::setw(2), std::setfill('0'), *endpoint & 0xFF));
+		m_counters.add(ITC_TRANSPORT_COUNTER_DROPPED_MSGS);
 		return false;
 	}
 	
-	ItcMessageRawPtr newMsg = CONVERT_TO_USER_MESSAGE(ItcAdminMessageHelper::allocate(rxMsg->msgno, rxMsg->size));
+	if(rxMsg->msgno == ITC_SYSTEM_MESSAGE_NOTIFY_MBOX_DELETION_FROM_ITC_SERVER_INDICATION) UNLIKELY
+	{
+		LocateCache::invalidateAll();
+		m_counters.add(ITC_TRANSPORT_COUNTER_RECEIVED_MSGS);
+		m_counters.add(ITC_TRANSPORT_COUNTER_RECEIVED_BYTES, rxMsg->size);
+		return true;
+	}
+	
+	/* Copied onto the receiver's NUMA node, which reads it next, rather than this rx thread's. */
+	auto transportLocal = ItcTransportLocal::getInstance().lock();
+	ItcMessageRawPtr newMsg = CONVERT_TO_USER_MESSAGE(ItcAdminMessageHelper::allocate(rxMsg->msgno, rxMsg->size, transportLocal->getNumaNode(rxMsg->receiver)));
 	ItcAdminMessageRawPtr newAdminMsg = CONVERT_TO_ADMIN_MESSAGE(newMsg);
 	uint32_t storedFlags = newAdminMsg->flags;
 	CWrapperIf::getInstance().lock()->cMemcpy(newAdminMsg, rxMsg, ITC_ADMIN_MESSAGE_PREAMBLE_SIZE + rxMsg->size + ITC_ADMIN_MESSAGE_ENDPOINT_SIZE);
-	newAdminMsg->flags = storedFlags;
+	newAdminMsg->flags = storedFlags | (rxMsg->flags & ITC_MASK_MESSAGE_PRIORITY);
+	ITC_LATENCY_STAMP(newAdminMsg, ITC_LATENCY_STAMP_REGION_RX);
 	
-	auto rc = ItcTransportLocal::getInstance().lock()->send(newAdminMsg);
+	auto rc = transportLocal->send(newAdminMsg);
 	if(rc != MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK))
 	{
 		TPT_TRACE(TRACE_ABN, SSTR("Failed to forward message from sysv message queue to local transport mailbox!"));
+		m_counters.add(ITC_TRANSPORT_COUNTER_DROPPED_MSGS);
 		return false;
 	}
 	
+	m_counters.add(ITC_TRANSPORT_COUNTER_RECEIVED_MSGS);
+	m_counters.add(ITC_TRANSPORT_COUNTER_RECEIVED_BYTES, rxMsg->size);
 	return true;
 }
 
+TransportStatistics ItcTransportSysvMsgQueue::getStatistics() const
+{
+	return getTransportStatistics(m_counters);
+}
+
 void ItcTransportSysvMsgQueue::destructRxThread(void *args)
 {
 	if(m_msgQueueId != -1)
@@ -4,6 +4,8 @@
 #include <memory>
 #include <string>
 #include <thread>
+#include <vector>
+#include <atomic>
 #include <gtest/gtest.h>
 
 namespace ITC
@@ -78,5 +80,98 @@ TEST_F(ConcurrentContainerTest, test1)
     testRaceCondtition();
 }
 
+TEST_F(ConcurrentContainerTest, hashMapTest1)
+{
+    /***
+     * Test scenario: entries are found by name until removed, duplicates and too long names are refused,
+     * and names come back after lots of add/remove cycles in the same probe sequences.
+     */
+    TestData *entry1 = m_cArray.tryPopFromQueue();
+    TestData *entry2 = m_cArray.tryPopFromQueue();
+    ASSERT_TRUE(m_cArray.addEntryToHashMap(entry1->name, entry1));
+    ASSERT_TRUE(m_cArray.addEntryToHashMap(entry2->name, entry2));
+    ASSERT_FALSE(m_cArray.addEntryToHashMap(entry1->name, entry2));
+    ASSERT_FALSE(m_cArray.addEntryToHashMap(std::string(CONCURRENT_CONTAINER_MAX_KEY_LENGTH + 1, 'a'), entry2));
+    ASSERT_TRUE(m_cArray.addEntryToHashMap(std::string(CONCURRENT_CONTAINER_MAX_KEY_LENGTH, 'a'), entry2));
+    ASSERT_EQ(m_cArray.lookUpFromHashMap(std::string(CONCURRENT_CONTAINER_MAX_KEY_LENGTH, 'a')), entry2);
+    ASSERT_EQ(m_cArray.lookUpFromHashMap(entry1->name), entry1);
+    ASSERT_EQ(m_cArray.lookUpFromHashMap(entry2->name), entry2);
+    ASSERT_EQ(m_cArray.lookUpFromHashMap("unknown"), nullptr);
+
+    ASSERT_TRUE(m_cArray.removeEntryFromHashMap(entry1->name));
+    ASSERT_FALSE(m_cArray.removeEntryFromHashMap(entry1->name));
+    ASSERT_EQ(m_cArray.lookUpFromHashMap(entry1->name), nullptr);
+    ASSERT_EQ(m_cArray.lookUpFromHashMap(entry2->name), entry2);
+
+    for(uint32_t i = 0; i < 10000; ++i)
+    {
+        std::string name = "churn" + std::to_string(i % 100);
+        ASSERT_TRUE(m_cArray.addEntryToHashMap(name, entry1));
+        ASSERT_EQ(m_cArray.lookUpFromHashMap(name), entry1);
+        ASSERT_TRUE(m_cArray.removeEntryFromHashMap(name));
+    }
+    ASSERT_EQ(m_cArray.lookUpFromHashMap(entry2->name), entry2);
+    ASSERT_TRUE(m_cArray.removeEntryFromHashMap(entry2->name));
+    ASSERT_TRUE(m_cArray.removeEntryFromHashMap(std::string(CONCURRENT_CONTAINER_MAX_KEY_LENGTH, 'a')));
+    m_cArray.tryPushIntoQueue(entry1);
+    m_cArray.tryPushIntoQueue(entry2);
+}
+
+TEST_F(ConcurrentContainerTest, hashMapTest2)
+{
+    /***
+     * Test scenario: lock-free lookups always find the names which stay in the index, and never return
+     * a wrong entry, while another thread keeps adding and removing other names.
+     */
+    constexpr uint32_t NUMBER_OF_READERS = 4;
+    constexpr uint32_t NUMBER_OF_STABLE_ENTRIES = 16;
+    std::vector<TestData *> stableEntries;
+    for(uint32_t i = 0; i < NUMBER_OF_STABLE_ENTRIES; ++i)
+    {
+        stableEntries.push_back(m_cArray.tryPopFromQueue());
+        ASSERT_TRUE(m_cArray.addEntryToHashMap(stableEntries.back()->name, stableEntries.back()));
+    }
+    TestData *churnEntry = m_cArray.tryPopFromQueue();
+
+    std::atomic_bool isDone {false};
+    std::atomic<uint32_t> nrErrors {0};
+    std::vector<std::thread> readerThreads;
+    for(uint32_t reader = 0; reader < NUMBER_OF_READERS; ++reader)
+    {
+        readerThreads.emplace_back([&]()
+        {
+            while(!isDone.load())
+            {
+                for(auto entry : stableEntries)
+                {
+                    nrErrors += m_cArray.lookUpFromHashMap(entry->name) != entry;
+                }
+                auto found = m_cArray.lookUpFromHashMap("churn0");
+                nrErrors += found != nullptr && found != churnEntry;
+            }
+        });
+    }
+
+    for(uint32_t i = 0; i < 100000; ++i)
+    {
+        std::string name = "churn" + std::to_string(i % 32);
+        m_cArray.addEntryToHashMap(name, churnEntry);
+        m_cArray.removeEntryFromHashMap(name);
+    }
+    isDone = true;
+    for(auto &thread : readerThreads)
+    {
+        thread.join();
+    }
+    ASSERT_EQ(nrErrors.load(), 0);
+
+    for(auto entry : stableEntries)
+    {
+        ASSERT_TRUE(m_cArray.removeEntryFromHashMap(entry->name));
+        m_cArray.tryPushIntoQueue(entry);
+    }
+    m_cArray.tryPushIntoQueue(churnEntry);
+}
+
 } // namespace INTERNAL
 } // namespace ITC
\ No newline at end of file
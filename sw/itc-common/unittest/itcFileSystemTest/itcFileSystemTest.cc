@@ -5,6 +5,7 @@
 #include <string>
 #include <filesystem>
 #include <fstream>
+#include <unistd.h>
 #include <gtest/gtest.h>
 
 #include "itc.h"
@@ -90,6 +91,10 @@ TEST_F(FileSystemIfTest, removePathTest2)
     /***
      * Test scenario: test remove a not-permitted path.
      */
+    if(::geteuid() == 0)
+    {
+        GTEST_SKIP() << "Running as root, /etc is permitted";
+    }
     std::filesystem::path path {"/etc"};
     auto rc = m_fileSystem->removePath(path);
     ASSERT_EQ(rc, MAKE_RETURN_CODE(FileSystemIfReturnCode, ITC_FILESYSTEM_EXCEPTION_THROWN));
@@ -130,6 +135,10 @@ TEST_F(FileSystemIfTest, createPathTest4)
     /***
      * Test scenario: test create an not-permitted directory.
      */
+    if(::geteuid() == 0)
+    {
+        GTEST_SKIP() << "Running as root, /etc is permitted";
+    }
     constexpr size_t PATH_ETC_DIRECTORY_POSITION = 1;
     ASSERT_EQ(createAndVerifyPath("/etc", PathType::DIRECTORY, PATH_ETC_DIRECTORY_POSITION), false);
 }
@@ -163,6 +172,10 @@ TEST_F(FileSystemIfTest, isAccessibleTest2)
     /***
      * Test scenario: test can access a non-accessible file.
      */
+    if(::geteuid() == 0)
+    {
+        GTEST_SKIP() << "Running as root, /etc is permitted";
+    }
     ASSERT_EQ(m_fileSystem->isAccessible("/etc"), false);
 }
 
@@ -0,0 +1,114 @@
+#include "itcLatencyHistogram.h"
+
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+
+namespace ITC
+{
+namespace INTERNAL
+{
+
+using namespace ::testing;
+
+class LatencyHistogramTest : public testing::Test
+{
+protected:
+    LatencyHistogramTest()
+    {}
+
+    ~LatencyHistogramTest()
+    {}
+    
+    void SetUp() override
+    {}
+
+    void TearDown() override
+    {}
+};
+
+TEST_F(LatencyHistogramTest, bucketTest1)
+{
+    /***
+     * Test scenario: every value falls into a bucket whose upper bound is at least the value
+     * and at most 12.5% above it, and buckets are ascending without gaps.
+     */
+    for(uint64_t value = 0; value < 100000; value += (value < 1024 ? 1 : 97))
+    {
+        uint32_t index = LatencyHistogram::getBucketIndex(value);
+        uint64_t upperBound = LatencyHistogram::getBucketUpperBound(index);
+        ASSERT_GE(upperBound, value);
+        ASSERT_LE(upperBound - value, value / LatencyHistogram::SUB_BUCKETS) << "value = " << value;
+        if(index > 0)
+        {
+            ASSERT_LT(LatencyHistogram::getBucketUpperBound(index - 1), value);
+        }
+    }
+    ASSERT_EQ(LatencyHistogram::getBucketIndex(UINT64_MAX), LatencyHistogram::NUMBER_OF_BUCKETS - 1);
+    ASSERT_EQ(LatencyHistogram::getBucketUpperBound(LatencyHistogram::NUMBER_OF_BUCKETS - 1), (1ULL << ITC_LATENCY_HISTOGRAM_MAX_BITS) - 1);
+}
+
+TEST_F(LatencyHistogramTest, snapshotTest1)
+{
+    /***
+     * Test scenario: 1..1000 recorded, percentiles are within a bucket width of the exact ones.
+     */
+    LatencyHistogram histogram;
+    ASSERT_EQ(histogram.snapshot().count, 0);
+    ASSERT_EQ(histogram.snapshot().getPercentile(50), 0);
+
+    for(uint64_t value = 1; value <= 1000; ++value)
+    {
+        histogram.record(value);
+    }
+    auto snapshot = histogram.snapshot();
+    ASSERT_EQ(snapshot.count, 1000);
+    ASSERT_EQ(snapshot.min, 1);
+    ASSERT_EQ(snapshot.max, 1000);
+    ASSERT_EQ(snapshot.sum, 500500);
+    ASSERT_GE(snapshot.getPercentile(50), 500);
+    ASSERT_LE(snapshot.getPercentile(50), 500 + 500 / LatencyHistogram::SUB_BUCKETS);
+    ASSERT_GE(snapshot.getPercentile(99), 990);
+    ASSERT_EQ(snapshot.getPercentile(100), 1000);
+
+    histogram.reset();
+    snapshot = histogram.snapshot();
+    ASSERT_EQ(snapshot.count, 0);
+    ASSERT_EQ(snapshot.min, 0);
+    ASSERT_EQ(snapshot.max, 0);
+    ASSERT_TRUE(snapshot.buckets.empty());
+}
+
+TEST_F(LatencyHistogramTest, concurrentRecordTest1)
+{
+    /***
+     * Test scenario: several threads record into the same histogram, no sample is lost.
+     */
+    constexpr uint32_t NUMBER_OF_THREADS = 4;
+    constexpr uint64_t NUMBER_OF_SAMPLES = 100000;
+    LatencyHistogram histogram;
+    std::vector<std::thread> threads;
+    for(uint32_t i = 0; i < NUMBER_OF_THREADS; ++i)
+    {
+        threads.emplace_back([&histogram, i]()
+        {
+            for(uint64_t value = 1; value <= NUMBER_OF_SAMPLES; ++value)
+            {
+                histogram.record(value * (i + 1));
+            }
+        });
+    }
+    for(auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    auto snapshot = histogram.snapshot();
+    ASSERT_EQ(snapshot.count, NUMBER_OF_THREADS * NUMBER_OF_SAMPLES);
+    ASSERT_EQ(snapshot.min, 1);
+    ASSERT_EQ(snapshot.max, NUMBER_OF_THREADS * NUMBER_OF_SAMPLES);
+}
+
+} // namespace INTERNAL
+} // namespace ITC
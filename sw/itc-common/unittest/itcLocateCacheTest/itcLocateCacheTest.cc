@@ -0,0 +1,86 @@
+#include "itcLocateCache.h"
+
+#include <string>
+#include <thread>
+#include <gtest/gtest.h>
+
+
+namespace ITC
+{
+namespace INTERNAL
+{
+
+using namespace ::testing;
+
+class LocateCacheTest : public testing::Test
+{
+protected:
+    LocateCacheTest()
+    {}
+
+    ~LocateCacheTest()
+    {}
+    
+    void SetUp() override
+    {}
+
+    void TearDown() override
+    {}
+};
+
+TEST_F(LocateCacheTest, lookUpTest1)
+{
+    /***
+     * Test scenario: an inserted name is found again with the same mode only, other names and modes miss.
+     */
+    LocateCache cache;
+    MailboxContactInfo info;
+    uint64_t generation = LocateCache::getGeneration();
+    ASSERT_FALSE(cache.lookUp("locateCacheMbox1", ITC_MODE_LOCATE_IN_WORLD, info));
+    
+    cache.insert("locateCacheMbox1", ITC_MODE_LOCATE_IN_WORLD, MailboxContactInfo(0x00200005), generation);
+    ASSERT_TRUE(cache.lookUp("locateCacheMbox1", ITC_MODE_LOCATE_IN_WORLD, info));
+    ASSERT_EQ(info.mailboxId, 0x00200005);
+    ASSERT_EQ(info.worldId, 0);
+    ASSERT_FALSE(cache.lookUp("locateCacheMbox1", ITC_MODE_LOCATE_IN_ALL, info));
+    ASSERT_FALSE(cache.lookUp("locateCacheMbox2", ITC_MODE_LOCATE_IN_WORLD, info));
+    
+    for(uint32_t i = 0; i < ITC_LOCATE_CACHE_MAX_ENTRIES + 1; ++i)
+    {
+        cache.insert("locateCacheMbox" + std::to_string(i), ITC_MODE_LOCATE_IN_WORLD, MailboxContactInfo(i), generation);
+    }
+    ASSERT_LE(cache.size(), ITC_LOCATE_CACHE_MAX_ENTRIES);
+    ASSERT_TRUE(cache.lookUp("locateCacheMbox" + std::to_string(ITC_LOCATE_CACHE_MAX_ENTRIES), ITC_MODE_LOCATE_IN_WORLD, info));
+}
+
+TEST_F(LocateCacheTest, invalidateTest1)
+{
+    /***
+     * Test scenario: invalidateAll() from another thread drops the entries of this thread's cache,
+     * and an answer taken before the invalidation is not cached anymore.
+     */
+    LocateCache cache;
+    MailboxContactInfo info;
+    uint64_t generation = LocateCache::getGeneration();
+    cache.insert("locateCacheMbox1", ITC_MODE_LOCATE_IN_ALL, MailboxContactInfo(0x00200005), generation);
+    ASSERT_TRUE(cache.lookUp("locateCacheMbox1", ITC_MODE_LOCATE_IN_ALL, info));
+    
+    std::thread deleter([]()
+    {
+        LocateCache::invalidateAll();
+    });
+    deleter.join();
+    ASSERT_NE(LocateCache::getGeneration(), generation);
+    ASSERT_FALSE(cache.lookUp("locateCacheMbox1", ITC_MODE_LOCATE_IN_ALL, info));
+    ASSERT_EQ(cache.size(), 0);
+    
+    cache.insert("locateCacheMbox1", ITC_MODE_LOCATE_IN_ALL, MailboxContactInfo(0x00200005), generation);
+    ASSERT_FALSE(cache.lookUp("locateCacheMbox1", ITC_MODE_LOCATE_IN_ALL, info));
+    
+    cache.insert("locateCacheMbox1", ITC_MODE_LOCATE_IN_ALL, MailboxContactInfo(0x00200006), LocateCache::getGeneration());
+    ASSERT_TRUE(cache.lookUp("locateCacheMbox1", ITC_MODE_LOCATE_IN_ALL, info));
+    ASSERT_EQ(info.mailboxId, 0x00200006);
+}
+
+} // namespace INTERNAL
+} // namespace ITC
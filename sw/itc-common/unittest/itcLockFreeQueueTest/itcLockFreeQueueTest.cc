@@ -34,11 +34,8 @@ protected:
     void TearDown() override
     {}
     
-    void benchmarkSPSC()
+    void exchangeSPSC()
     {
-        std::chrono::_V2::system_clock::time_point start;
-        std::chrono::_V2::system_clock::time_point end;
-        
         long long NUMBER_OF_MESSAGES = QUEUE_SIZE;
         // Producer thread: Enqueue items
         auto producer = [this, NUMBER_OF_MESSAGES]() {
@@ -64,7 +61,6 @@ protected:
             ASSERT_EQ(count, NUMBER_OF_MESSAGES);
         };
 
-        start = std::chrono::high_resolution_clock::now();
         // Create threads for producer and consumer
         std::thread producerThread(producer);
         std::thread consumerThread(consumer);
@@ -72,17 +68,10 @@ protected:
         // Wait for threads to finish
         producerThread.join();
         consumerThread.join();
-        end = std::chrono::high_resolution_clock::now();
-
-        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
-        std::cout << "[BENCHMARK] LockFreeQueue_test1 " << " took " << duration / NUMBER_OF_MESSAGES << " ns\n";
     }
     
-    void benchmarkMPMC()
+    void exchangeMPMC()
     {
-        std::chrono::_V2::system_clock::time_point start;
-        std::chrono::_V2::system_clock::time_point end;
-        
         uint32_t NUMBER_OF_MESSAGES = QUEUE_SIZE;
         constexpr uint32_t NUMBER_OF_PRODUCERS = 4;
         constexpr uint32_t NUMBER_OF_CONSUMERS = 4;
@@ -111,7 +100,6 @@ protected:
 
         std::thread producerThread[NUMBER_OF_PRODUCERS];
         std::thread consumerThread[NUMBER_OF_CONSUMERS];
-        start = std::chrono::high_resolution_clock::now();
         // Create threads for producer and consumer
         for(uint32_t i = 0; i < NUMBER_OF_PRODUCERS; ++i)
         {
@@ -125,10 +113,6 @@ protected:
             producerThread[i].join();
             consumerThread[i].join();
         }
-        end = std::chrono::high_resolution_clock::now();
-
-        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
-        std::cout << "[BENCHMARK] LockFreeQueue_test2 " << " took " << duration / NUMBER_OF_MESSAGES << " ns\n";
     }
 
 protected:
@@ -141,7 +125,7 @@ TEST_F(LockFreeQueueTest, test1)
     /***
      * Test scenario: test Single Producer Single Consumer queue.
      */
-    benchmarkSPSC();
+    exchangeSPSC();
 }
 
 TEST_F(LockFreeQueueTest, test2)
@@ -149,7 +133,55 @@ TEST_F(LockFreeQueueTest, test2)
     /***
      * Test scenario: test Multi Producer Multi Consumer queue.
      */
-    benchmarkMPMC();
+    exchangeMPMC();
+}
+
+TEST_F(LockFreeQueueTest, batchTest1)
+{
+    /***
+     * Test scenario: batches are pushed with a single head advance, and rejected as a whole if they do not fit.
+     */
+    LockFreeQueue<uint32_t, 8, 0, MINIMIZE_CONTENTION, MAXIMIZE_THROUGHPUT, !IS_TOTAL_ORDER, !IS_SPSC> queue;
+    uint32_t batch[] = {1, 2, 3, 4, 5, 6};
+    ASSERT_TRUE(queue.tryPushBatch(batch, 6));
+    ASSERT_EQ(queue.size(), 6);
+    ASSERT_FALSE(queue.tryPushBatch(batch, 3));
+    ASSERT_EQ(queue.size(), 6);
+    ASSERT_TRUE(queue.tryPushBatch(batch, 2));
+    ASSERT_TRUE(queue.full());
+
+    for(uint32_t i = 0; i < 6; ++i)
+    {
+        ASSERT_EQ(queue.pop(), batch[i]);
+    }
+    queue.pushBatch(batch + 2, 4);
+    for(uint32_t expected : {1, 2, 3, 4, 5, 6})
+    {
+        uint32_t value {0};
+        ASSERT_TRUE(queue.tryPop(value));
+        ASSERT_EQ(value, expected);
+    }
+    ASSERT_TRUE(queue.empty());
+}
+
+TEST_F(LockFreeQueueTest, batchTest2)
+{
+    /***
+     * Test scenario: a batch pop takes whatever is pending up to the requested count, in order.
+     */
+    LockFreeQueue<uint32_t, 8, 0, MINIMIZE_CONTENTION, MAXIMIZE_THROUGHPUT, !IS_TOTAL_ORDER, !IS_SPSC> queue;
+    uint32_t out[8] = {};
+    ASSERT_EQ(queue.tryPopBatch(out, 8), 0);
+
+    uint32_t batch[] = {1, 2, 3, 4, 5};
+    ASSERT_TRUE(queue.tryPushBatch(batch, 5));
+    ASSERT_EQ(queue.tryPopBatch(out, 3), 3);
+    ASSERT_EQ(queue.tryPopBatch(out + 3, 8), 2);
+    for(uint32_t i = 0; i < 5; ++i)
+    {
+        ASSERT_EQ(out[i], batch[i]);
+    }
+    ASSERT_TRUE(queue.empty());
 }
 
 } // namespace INTERNAL
@@ -0,0 +1,560 @@
+#include "itcMemoryManager.h"
+#include "itcAdminMessage.h"
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <gtest/gtest.h>
+
+
+namespace ITC
+{
+namespace INTERNAL
+{
+using namespace testing;
+
+class MemoryManagerTest : public testing::Test
+{
+protected:
+    MemoryManagerTest()
+    {}
+
+    ~MemoryManagerTest()
+    {}
+
+    void SetUp() override
+    {
+        m_params.mode = MEMORY_ALLOCATOR_MODE_2;
+        m_baseAddr = MemoryAllocator::allocate(MEMORY_POOL_TOTAL_SIZE, m_params);
+    }
+
+    void TearDown() override
+    {
+        MemoryAllocator::deallocate(m_params);
+    }
+
+    /* Pool the calling thread's magazines are filled from, the one of node 0 unless this is a NUMA machine. */
+    static MemoryPool *getLocalPool(const std::shared_ptr<MemoryManager> &memManager)
+    {
+        return memManager->m_memPools[memManager->getThreadMagazines().node].get();
+    }
+
+protected:
+    MemoryAllocatorParams m_params;
+    UInt8RawPtr m_baseAddr {nullptr};
+};
+
+TEST_F(MemoryManagerTest, memoryPoolTest1)
+{
+    /***
+     * Test scenario: each request is served from the smallest size class which fits it.
+     */
+    ASSERT_NE(m_baseAddr, nullptr);
+    MemoryPool pool(m_baseAddr, MEMORY_POOL_TOTAL_SIZE);
+    ASSERT_TRUE(pool.isInitialised());
+
+    auto ptr64 = pool.allocate(MEMORY_POOL_64_SLOT_SIZE);
+    auto ptr256 = pool.allocate(MEMORY_POOL_64_SLOT_SIZE + 1);
+    auto ptr512 = pool.allocate(MEMORY_POOL_512_SLOT_SIZE);
+    ASSERT_NE(ptr64, nullptr);
+    ASSERT_NE(ptr256, nullptr);
+    ASSERT_NE(ptr512, nullptr);
+    ASSERT_EQ(ptr64, m_baseAddr + MEMORY_POOL_64_START_OFFSET);
+    ASSERT_EQ(ptr256, m_baseAddr + MEMORY_POOL_256_START_OFFSET);
+    ASSERT_EQ(ptr512, m_baseAddr + MEMORY_POOL_512_START_OFFSET);
+
+    ASSERT_TRUE(pool.deallocate(ptr64));
+    ASSERT_TRUE(pool.deallocate(ptr256));
+    ASSERT_TRUE(pool.deallocate(ptr512));
+}
+
+TEST_F(MemoryManagerTest, memoryPoolTest2)
+{
+    /***
+     * Test scenario: oversized requests and foreign pointers are not handled by the pool.
+     */
+    ASSERT_NE(m_baseAddr, nullptr);
+    MemoryPool pool(m_baseAddr, MEMORY_POOL_TOTAL_SIZE);
+
+    ASSERT_EQ(pool.allocate(MEMORY_POOL_512_SLOT_SIZE + 1), nullptr);
+
+    auto heapPtr = new uint8_t[8];
+    ASSERT_FALSE(pool.owns(heapPtr));
+    ASSERT_FALSE(pool.deallocate(heapPtr));
+    delete[] heapPtr;
+
+    ASSERT_FALSE(pool.owns(m_baseAddr)); /* Metadata is not an allocatable slot. */
+}
+
+TEST_F(MemoryManagerTest, memoryPoolTest3)
+{
+    /***
+     * Test scenario: an exhausted size class falls through to the next larger one,
+     * and freed slots become available again.
+     */
+    ASSERT_NE(m_baseAddr, nullptr);
+    MemoryPool pool(m_baseAddr, MEMORY_POOL_TOTAL_SIZE);
+
+    std::vector<UInt8RawPtr> slots;
+    for(uint32_t i = 0; i < MEMORY_POOL_64_SLOTS; ++i)
+    {
+        auto ptr = pool.allocate(MEMORY_POOL_64_SLOT_SIZE);
+        ASSERT_NE(ptr, nullptr);
+        slots.push_back(ptr);
+    }
+
+    auto fallThrough = pool.allocate(MEMORY_POOL_64_SLOT_SIZE);
+    ASSERT_NE(fallThrough, nullptr);
+    ASSERT_GE(fallThrough, m_baseAddr + MEMORY_POOL_256_START_OFFSET);
+    ASSERT_TRUE(pool.deallocate(fallThrough));
+
+    ASSERT_TRUE(pool.deallocate(slots.back()));
+    auto reused = pool.allocate(MEMORY_POOL_64_SLOT_SIZE);
+    ASSERT_EQ(reused, slots.back());
+    slots.back() = reused;
+
+    for(auto ptr : slots)
+    {
+        ASSERT_TRUE(pool.deallocate(ptr));
+    }
+}
+
+TEST_F(MemoryManagerTest, memoryManagerTest1)
+{
+    /***
+     * Test scenario: small and large messages come from the pool, huge ones from the heap.
+     */
+    auto memManager = MemoryManager::getInstance().lock();
+    ASSERT_NE(memManager, nullptr);
+    ASSERT_NE(getLocalPool(memManager), nullptr);
+
+    auto small = memManager->allocate(MEMORY_POOL_64_SLOT_SIZE);
+    ASSERT_TRUE(getLocalPool(memManager)->owns(small));
+    memManager->deallocate(small);
+
+    auto large = memManager->allocate(MEMORY_POOL_512_SLOT_SIZE * 4);
+    ASSERT_NE(large, nullptr);
+    ASSERT_TRUE(getLocalPool(memManager)->owns(large));
+    memManager->deallocate(large);
+
+    auto huge = memManager->allocate(MEMORY_POOL_UNLIMITED_MAX_BLOCK_SIZE + 1);
+    ASSERT_NE(huge, nullptr);
+    ASSERT_FALSE(getLocalPool(memManager)->owns(huge));
+    memManager->deallocate(huge);
+}
+
+TEST_F(MemoryManagerTest, memoryManagerTest2)
+{
+    /***
+     * Test scenario: ItcAdminMessageHelper allocates messages through MemoryManager, without taking a reference on it.
+     */
+    auto memManager = MemoryManager::getInstance().lock();
+    ASSERT_NE(memManager, nullptr);
+    ASSERT_EQ(MemoryManager::getInstanceRawPtr(), memManager.get());
+    auto nrReferences = memManager.use_count();
+
+    auto adminMsg = ItcAdminMessageHelper::allocate(0xAAAABBBB, 32);
+    ASSERT_NE(adminMsg, nullptr);
+    ASSERT_TRUE(getLocalPool(memManager)->owns(reinterpret_cast<UInt8RawPtr>(adminMsg)));
+    ASSERT_EQ(adminMsg->msgno, 0xAAAABBBB);
+    ASSERT_TRUE(ItcAdminMessageHelper::deallocate(adminMsg));
+    ASSERT_EQ(memManager.use_count(), nrReferences);
+
+    auto bigMsg = ItcAdminMessageHelper::allocate(0xAAAABBBB, 4096);
+    ASSERT_NE(bigMsg, nullptr);
+    ASSERT_TRUE(getLocalPool(memManager)->owns(reinterpret_cast<UInt8RawPtr>(bigMsg)));
+    ASSERT_TRUE(ItcAdminMessageHelper::deallocate(bigMsg));
+
+    auto hugeMsg = ItcAdminMessageHelper::allocate(0xAAAABBBB, MEMORY_POOL_UNLIMITED_MAX_BLOCK_SIZE);
+    ASSERT_NE(hugeMsg, nullptr);
+    ASSERT_FALSE(getLocalPool(memManager)->owns(reinterpret_cast<UInt8RawPtr>(hugeMsg)));
+    ASSERT_TRUE(ItcAdminMessageHelper::deallocate(hugeMsg));
+}
+
+TEST_F(MemoryManagerTest, magazineTest1)
+{
+    /***
+     * Test scenario: a thread gets its own freed slots back without touching the pool's free list, which is only
+     * used once per MEMORY_MAGAZINE_BATCH_SIZE slots, and a full magazine gives its oldest slots back.
+     */
+    auto memManager = MemoryManager::getInstance().lock();
+    ASSERT_NE(memManager, nullptr);
+    memManager->flushThreadCache();
+    auto &pool64 = *getLocalPool(memManager)->m_pool64;
+    uint32_t nrFreeSlots = pool64.size();
+
+    auto ptr = memManager->allocate(MEMORY_POOL_64_SLOT_SIZE);
+    ASSERT_EQ(pool64.size(), nrFreeSlots - MEMORY_MAGAZINE_BATCH_SIZE);
+    memManager->deallocate(ptr);
+    ASSERT_EQ(memManager->allocate(MEMORY_POOL_64_SLOT_SIZE), ptr);
+    memManager->deallocate(ptr);
+    ASSERT_EQ(pool64.size(), nrFreeSlots - MEMORY_MAGAZINE_BATCH_SIZE);
+
+    std::vector<UInt8RawPtr> slots;
+    for(uint32_t i = 0; i < MEMORY_MAGAZINE_CAPACITY * 2; ++i)
+    {
+        slots.push_back(memManager->allocate(MEMORY_POOL_64_SLOT_SIZE));
+        ASSERT_TRUE(getLocalPool(memManager)->owns(slots.back()));
+    }
+    for(auto slot : slots)
+    {
+        memManager->deallocate(slot);
+    }
+    auto &magazine = MemoryManager::m_threadMagazines.magazines[MEMORY_POOL_SIZE_CLASS_64];
+    ASSERT_LE(magazine.count, MEMORY_MAGAZINE_CAPACITY);
+    ASSERT_EQ(magazine.slots[magazine.count - 1], slots.back());
+
+    memManager->flushThreadCache();
+    ASSERT_EQ(magazine.count, 0);
+    ASSERT_EQ(pool64.size(), nrFreeSlots);
+}
+
+TEST_F(MemoryManagerTest, magazineTest2)
+{
+    /***
+     * Test scenario: slots allocated by one thread and freed by another flow back through the pool in batches,
+     * and whatever a thread still holds when it exits is given back as well.
+     */
+    constexpr uint32_t NUMBER_OF_ROUNDS = 100;
+    constexpr uint32_t NUMBER_OF_SLOTS = 200;
+    auto memManager = MemoryManager::getInstance().lock();
+    ASSERT_NE(memManager, nullptr);
+    memManager->flushThreadCache();
+    auto &pool256 = *getLocalPool(memManager)->m_pool256;
+    uint32_t nrFreeSlots = pool256.size();
+
+    std::vector<UInt8RawPtr> slots(NUMBER_OF_SLOTS);
+    for(uint32_t round = 0; round < NUMBER_OF_ROUNDS; ++round)
+    {
+        std::thread producer([&memManager, &slots]()
+        {
+            for(auto &slot : slots)
+            {
+                slot = memManager->allocate(MEMORY_POOL_256_SLOT_SIZE);
+            }
+        });
+        producer.join();
+        std::thread consumer([&memManager, &slots]()
+        {
+            for(auto slot : slots)
+            {
+                ASSERT_TRUE(getLocalPool(memManager)->owns(slot));
+                memManager->deallocate(slot);
+            }
+        });
+        consumer.join();
+        ASSERT_EQ(pool256.size(), nrFreeSlots);
+    }
+}
+
+TEST_F(MemoryManagerTest, magazineTest3)
+{
+    /***
+     * Test scenario: only so many threads keep magazines of the 512-byte size class at the same time, the next one
+     * uses the pool directly. Reservations are given back when the threads exit, together with their slots.
+     */
+    auto memManager = MemoryManager::getInstance().lock();
+    ASSERT_NE(memManager, nullptr);
+    memManager->flushThreadCache();
+    auto &pool512 = *getLocalPool(memManager)->m_pool512;
+    uint32_t nrFreeSlots = pool512.size();
+    auto &nrFreeMagazines = memManager->m_nrFreeMagazines[memManager->getThreadMagazines().node][MEMORY_POOL_SIZE_CLASS_512];
+    uint32_t nrMagazines = nrFreeMagazines.load();
+    ASSERT_EQ(nrMagazines, MEMORY_POOL_512_SLOTS / MEMORY_MAGAZINE_POOL_SHARE / MEMORY_MAGAZINE_CAPACITY);
+
+    std::atomic<uint32_t> nrStartedThreads {0};
+    std::atomic<uint32_t> nrReservedMagazines {0};
+    std::vector<std::thread> threads;
+    for(uint32_t i = 0; i < nrMagazines + 1; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            memManager->deallocate(memManager->allocate(MEMORY_POOL_512_SLOT_SIZE));
+            nrReservedMagazines += MemoryManager::m_threadMagazines.magazines[MEMORY_POOL_SIZE_CLASS_512].isReserved;
+            ++nrStartedThreads;
+            while(nrStartedThreads.load() < nrMagazines + 1)
+            {
+                std::this_thread::yield();
+            }
+        });
+    }
+    for(auto &thread : threads)
+    {
+        thread.join();
+    }
+    ASSERT_EQ(nrReservedMagazines.load(), nrMagazines);
+    ASSERT_EQ(nrFreeMagazines.load(), nrMagazines);
+    ASSERT_EQ(pool512.size(), nrFreeSlots);
+}
+
+TEST_F(MemoryManagerTest, hugePagesTest1)
+{
+    /***
+     * Test scenario: a pool asked to be on huge pages lies within whole 2 MiB pages on a 2 MiB boundary and works as
+     * any other, whether reserved huge pages exist on this machine or the transparent fallback was taken.
+     * The next pool starts one page further in, so that the two do not compete for the same cache sets.
+     */
+    MemoryAllocatorParams params;
+    params.mode = MEMORY_ALLOCATOR_MODE_2;
+    params.isHugePages = 1;
+    UInt8RawPtr baseAddr = MemoryAllocator::allocate(MEMORY_POOL_TOTAL_SIZE, params);
+    ASSERT_NE(baseAddr, nullptr);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(baseAddr - params.attrs.mode2.colourOffset) % MEMORY_POOL_HUGE_PAGE_SIZE, 0);
+    ASSERT_EQ(params.attrs.mode2.size, MEMORY_POOL_HUGE_PAGE_SIZE);
+    ASSERT_LE(params.attrs.mode2.colourOffset + MEMORY_POOL_TOTAL_SIZE, params.attrs.mode2.size);
+
+    MemoryAllocatorParams nextParams;
+    nextParams.mode = MEMORY_ALLOCATOR_MODE_2;
+    nextParams.isHugePages = 1;
+    ASSERT_NE(MemoryAllocator::allocate(MEMORY_POOL_TOTAL_SIZE, nextParams), nullptr);
+    ASSERT_EQ(nextParams.attrs.mode2.colourOffset, (params.attrs.mode2.colourOffset + MEMORY_POOL_PAGE_SIZE) % (MEMORY_POOL_HUGE_PAGE_COLOURS * MEMORY_POOL_PAGE_SIZE));
+    MemoryAllocator::deallocate(nextParams);
+
+    MemoryPool pool(baseAddr, MEMORY_POOL_TOTAL_SIZE);
+    ASSERT_TRUE(pool.isInitialised());
+    auto ptr = pool.allocate(MEMORY_POOL_512_SLOT_SIZE);
+    ASSERT_NE(ptr, nullptr);
+    std::memset(ptr, 0xAB, MEMORY_POOL_512_SLOT_SIZE);
+    ASSERT_TRUE(pool.deallocate(ptr));
+    MemoryAllocator::deallocate(params);
+    ASSERT_EQ(params.attrs.mode2.baseAddr, nullptr);
+
+    /* POSIX shared memory is grown to whole huge pages, so that tmpfs can back all of it with them. */
+    MemoryAllocatorParams shmParams;
+    shmParams.mode = MEMORY_ALLOCATOR_MODE_3;
+    shmParams.isHugePages = 1;
+    shmParams.attrs.mode3.shmName = "/itcMemoryManagerTest.hugePagesTest1";
+    shm_unlink(shmParams.attrs.mode3.shmName.c_str());
+    baseAddr = MemoryAllocator::allocate(MEMORY_POOL_TOTAL_SIZE, shmParams);
+    ASSERT_NE(baseAddr, nullptr);
+    ASSERT_EQ(shmParams.attrs.mode3.size, MEMORY_POOL_HUGE_PAGE_SIZE);
+    struct stat shmStat;
+    ASSERT_EQ(fstat(shmParams.attrs.mode3.shmId, &shmStat), 0);
+    ASSERT_EQ(shmStat.st_size, MEMORY_POOL_HUGE_PAGE_SIZE);
+    MemoryAllocator::deallocate(shmParams);
+}
+
+TEST_F(MemoryManagerTest, numaTest1)
+{
+    /***
+     * Test scenario: messages for another NUMA node come from that node's pool without going through the magazines,
+     * and go straight back there once freed. With that pool exhausted they come from the local one, counted as
+     * remote. A single node machine gets a second node faked, whose pool is on the first one as well.
+     */
+    auto memManager = MemoryManager::getInstance().lock();
+    ASSERT_NE(memManager, nullptr);
+    ASSERT_GE(NumaTopology::getNumberOfNodes(), 1);
+    ASSERT_LT(NumaTopology::getCurrentNode(), NumaTopology::getNumberOfNodes());
+    uint32_t pageNode = NumaTopology::getNodeOfAddress(m_baseAddr);
+    ASSERT_TRUE(pageNode == MEMORY_NUMA_NODE_ANY || pageNode < NumaTopology::getNumberOfNodes());
+
+    bool isFaked = memManager->m_nrNodes == 1;
+    if(isFaked)
+    {
+        memManager->m_nrNodes = 2;
+        memManager->m_memPools[1] = std::make_unique<MemoryPool>(m_baseAddr, MEMORY_POOL_TOTAL_SIZE);
+    }
+    uint32_t localNode = memManager->getThreadMagazines().node;
+    uint32_t remoteNode = (localNode + 1) % memManager->m_nrNodes;
+    MemoryPool *remotePool = memManager->m_memPools[remoteNode].get();
+    ASSERT_NE(remotePool, nullptr);
+    auto statistics = memManager->getStatistics();
+
+    auto remotePtr = memManager->allocate(MEMORY_POOL_256_SLOT_SIZE, remoteNode);
+    auto localPtr = memManager->allocate(MEMORY_POOL_256_SLOT_SIZE, localNode);
+    ASSERT_TRUE(remotePool->owns(remotePtr));
+    ASSERT_TRUE(getLocalPool(memManager)->owns(localPtr));
+    uint32_t nrFreeSlots = remotePool->m_pool256->size();
+    memManager->deallocate(remotePtr);
+    ASSERT_EQ(remotePool->m_pool256->size(), nrFreeSlots + 1);
+    memManager->deallocate(localPtr);
+
+    std::vector<UInt8RawPtr> slots;
+    while(auto slot = remotePool->allocate(MEMORY_POOL_512_SLOT_SIZE))
+    {
+        slots.push_back(slot);
+    }
+    auto fallbackPtr = memManager->allocate(MEMORY_POOL_512_SLOT_SIZE, remoteNode);
+    ASSERT_NE(fallbackPtr, nullptr);
+    ASSERT_FALSE(remotePool->owns(fallbackPtr));
+    memManager->deallocate(fallbackPtr);
+    for(auto slot : slots)
+    {
+        ASSERT_TRUE(remotePool->deallocate(slot));
+    }
+
+    ASSERT_EQ(memManager->getStatistics().nrNodeAllocs - statistics.nrNodeAllocs, 3);
+    ASSERT_EQ(memManager->getStatistics().nrNodeFallbackAllocs - statistics.nrNodeFallbackAllocs, 1);
+    if(isFaked)
+    {
+        memManager->m_memPools[1].reset();
+        memManager->m_nrNodes = 1;
+    }
+}
+
+TEST_F(MemoryManagerTest, unlimitedTest1)
+{
+    /***
+     * Test scenario: large messages come from buddy blocks of the unlimited tier, which are split as needed and
+     * merged again once freed, until the whole area is in use. A second mapping of the same POSIX shared memory
+     * object, as a peer Region has it, sees the same blocks at the same offsets.
+     */
+    MemoryAllocatorParams shmParams;
+    shmParams.mode = MEMORY_ALLOCATOR_MODE_3;
+    shmParams.attrs.mode3.shmName = "/itcMemoryManagerTest.unlimitedTest1";
+    shm_unlink(shmParams.attrs.mode3.shmName.c_str());
+    UInt8RawPtr baseAddr = MemoryAllocator::allocate(MEMORY_POOL_TOTAL_SIZE, shmParams);
+    ASSERT_NE(baseAddr, nullptr);
+    MemoryPool pool(baseAddr, MEMORY_POOL_TOTAL_SIZE);
+    ASSERT_EQ(pool.allocate(MEMORY_POOL_512_SLOT_SIZE + 1), nullptr);
+    UInt8RawPtr unlimitedAddr = MemoryAllocator::append(MEMORY_POOL_UNLIMITED_TOTAL_SIZE, shmParams);
+    ASSERT_NE(unlimitedAddr, nullptr);
+    ASSERT_EQ(MemoryAllocator::append(MEMORY_POOL_UNLIMITED_TOTAL_SIZE, shmParams), nullptr);
+    ASSERT_TRUE(pool.appendUnlimited(unlimitedAddr, MEMORY_POOL_UNLIMITED_TOTAL_SIZE));
+    ASSERT_TRUE(pool.hasUnlimited());
+
+    /* 1KB and 2KB blocks are split off the first 256KB one, the 1KB one's buddy is left free. */
+    auto ptr1K = pool.allocate(MEMORY_POOL_512_SLOT_SIZE + 1);
+    auto ptr2K = pool.allocate(2 * MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE);
+    auto ptr1KBuddy = pool.allocate(MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE);
+    ASSERT_EQ(ptr1K, unlimitedAddr + MEMORY_POOL_UNLIMITED_HEADER_SIZE);
+    ASSERT_EQ(ptr1KBuddy, ptr1K + MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE);
+    ASSERT_EQ(ptr2K, ptr1K + 2 * MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE);
+    ASSERT_EQ(pool.getSlotSize(ptr1K), MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE);
+    ASSERT_EQ(pool.getSlotSize(ptr2K), 2 * MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE);
+    ASSERT_EQ(pool.getSlotSize(ptr1K + 1), 0);
+    ASSERT_EQ(pool.getOffset(ptr1K), MEMORY_POOL_UNLIMITED_START_OFFSET);
+    ASSERT_EQ(pool.getAddress(pool.getOffset(ptr2K)), ptr2K);
+    ASSERT_FALSE(pool.deallocate(ptr2K + MEMORY_POOL_64_SLOT_SIZE));
+    std::memset(ptr2K, 0xCD, 2 * MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE);
+
+    MemoryAllocatorParams peerParams;
+    peerParams.mode = MEMORY_ALLOCATOR_MODE_3;
+    peerParams.attrs.mode3.shmName = shmParams.attrs.mode3.shmName;
+    peerParams.attrs.mode3.isAttachOnly = 1;
+    UInt8RawPtr peerBaseAddr = MemoryAllocator::allocate(MEMORY_POOL_TOTAL_SIZE, peerParams);
+    ASSERT_NE(peerBaseAddr, nullptr);
+    MemoryPool peerPool(peerBaseAddr, MEMORY_POOL_TOTAL_SIZE, true);
+    ASSERT_TRUE(peerPool.appendUnlimited(MemoryAllocator::append(MEMORY_POOL_UNLIMITED_TOTAL_SIZE, peerParams), MEMORY_POOL_UNLIMITED_TOTAL_SIZE, true));
+    UInt8RawPtr peerPtr2K = peerPool.getAddress(pool.getOffset(ptr2K));
+    ASSERT_NE(peerPtr2K, ptr2K);
+    ASSERT_EQ(peerPtr2K[2 * MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE - 1], 0xCD);
+    ASSERT_TRUE(peerPool.deallocate(peerPtr2K));
+    ASSERT_FALSE(pool.deallocate(ptr2K));
+    auto peerPtr4K = peerPool.allocate(4 * MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE);
+    ASSERT_EQ(pool.getAddress(peerPool.getOffset(peerPtr4K)), ptr1K + 4 * MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE);
+    ASSERT_TRUE(peerPool.deallocate(peerPtr4K));
+    MemoryAllocator::deallocate(peerParams);
+
+    /* Once everything is back, the first block is whole again. */
+    ASSERT_TRUE(pool.deallocate(ptr1KBuddy));
+    ASSERT_TRUE(pool.deallocate(ptr1K));
+    auto ptrMax = pool.allocate(MEMORY_POOL_UNLIMITED_MAX_BLOCK_SIZE);
+    ASSERT_EQ(ptrMax, ptr1K);
+    ASSERT_TRUE(pool.deallocate(ptrMax));
+
+    std::vector<UInt8RawPtr> blocks;
+    while(auto block = pool.allocate(MEMORY_POOL_UNLIMITED_MAX_BLOCK_SIZE / 2 + 1))
+    {
+        blocks.push_back(block);
+    }
+    ASSERT_EQ(blocks.size(), MEMORY_POOL_UNLIMITED_MAX_BLOCKS);
+    ASSERT_EQ(pool.allocate(MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE), nullptr);
+    ASSERT_NE(pool.allocate(MEMORY_POOL_512_SLOT_SIZE), nullptr);
+    for(auto block : blocks)
+    {
+        ASSERT_TRUE(pool.deallocate(block));
+    }
+    MemoryAllocator::deallocate(shmParams);
+}
+
+TEST_F(MemoryManagerTest, unlimitedTest2)
+{
+    /***
+     * Test scenario: threads allocating and freeing large messages of all sizes at the same time leave the
+     * unlimited tier as whole as it was.
+     */
+    constexpr uint32_t NUMBER_OF_THREADS = 4;
+    constexpr uint32_t NUMBER_OF_ROUNDS = 2000;
+    auto memManager = MemoryManager::getInstance().lock();
+    ASSERT_NE(memManager, nullptr);
+    MemoryPool *pool = getLocalPool(memManager);
+    ASSERT_TRUE(pool->hasUnlimited());
+
+    std::atomic<uint32_t> nrErrors {0};
+    std::vector<std::thread> threads;
+    for(uint32_t i = 0; i < NUMBER_OF_THREADS; ++i)
+    {
+        threads.emplace_back([&memManager, &nrErrors, pool, i]()
+        {
+            std::vector<UInt8RawPtr> ptrs;
+            for(uint32_t round = 0; round < NUMBER_OF_ROUNDS; ++round)
+            {
+                uint32_t size = MEMORY_POOL_512_SLOT_SIZE + 1 + (round * 7919 + i * 104729) % (64 * 1024);
+                auto ptr = memManager->allocate(size);
+                nrErrors += !pool->owns(ptr) || pool->getSlotSize(ptr) < size;
+                std::memset(ptr, static_cast<int>(i), size);
+                ptrs.push_back(ptr);
+                if(ptrs.size() == 8)
+                {
+                    for(auto freed : ptrs)
+                    {
+                        nrErrors += freed[0] != static_cast<uint8_t>(i);
+                        memManager->deallocate(freed);
+                    }
+                    ptrs.clear();
+                }
+            }
+            for(auto freed : ptrs)
+            {
+                memManager->deallocate(freed);
+            }
+        });
+    }
+    for(auto &thread : threads)
+    {
+        thread.join();
+    }
+    ASSERT_EQ(nrErrors.load(), 0);
+
+    auto header = pool->m_poolUnlimitedHeader;
+    uint32_t maxOrder = MEMORY_POOL_UNLIMITED_NUMBER_OF_ORDERS - 1;
+    for(uint32_t order = 0; order < maxOrder; ++order)
+    {
+        ASSERT_EQ(header->freeLists[order], -1);
+    }
+    for(uint32_t block = 0; block < header->nrMaxBlocks; ++block)
+    {
+        ASSERT_EQ(header->blockStates[block << maxOrder], MEMORY_POOL_UNLIMITED_BLOCK_FREE | maxOrder);
+    }
+}
+
+TEST_F(MemoryManagerTest, unlimitedTest3)
+{
+    /***
+     * Test scenario: a thread dies holding the unlimited tier's lock half way through its free lists.
+     * The next one to lock it rebuilds them and the tier is usable again.
+     */
+    auto unlimitedArea = std::make_unique<uint8_t[]>(MEMORY_POOL_UNLIMITED_TOTAL_SIZE);
+    MemoryPool pool(m_baseAddr, MEMORY_POOL_TOTAL_SIZE);
+    ASSERT_TRUE(pool.appendUnlimited(unlimitedArea.get(), MEMORY_POOL_UNLIMITED_TOTAL_SIZE));
+    auto ptr1K = pool.allocate(MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE);
+    ASSERT_NE(ptr1K, nullptr);
+
+    std::thread([&pool]()
+    {
+        pool.lockUnlimited();
+        pool.m_poolUnlimitedHeader->freeLists.fill(0x7FFF);
+    }).join();
+
+    auto ptr2K = pool.allocate(2 * MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE);
+    ASSERT_EQ(ptr2K, ptr1K + 2 * MEMORY_POOL_UNLIMITED_MIN_BLOCK_SIZE);
+    ASSERT_TRUE(pool.deallocate(ptr2K));
+    ASSERT_TRUE(pool.deallocate(ptr1K));
+    ASSERT_EQ(pool.allocate(MEMORY_POOL_UNLIMITED_MAX_BLOCK_SIZE), ptr1K);
+}
+
+} // namespace INTERNAL
+} // namespace ITC
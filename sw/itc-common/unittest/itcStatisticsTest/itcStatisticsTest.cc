@@ -0,0 +1,80 @@
+#include "itcStatistics.h"
+
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+
+namespace ITC
+{
+namespace INTERNAL
+{
+
+using namespace ::testing;
+
+class StatisticsTest : public testing::Test
+{
+protected:
+    StatisticsTest()
+    {}
+
+    ~StatisticsTest()
+    {}
+    
+    void SetUp() override
+    {}
+
+    void TearDown() override
+    {}
+};
+
+TEST_F(StatisticsTest, shardedCountersTest1)
+{
+    /***
+     * Test scenario: more threads than shards add concurrently, the sums are exact and counters are independent.
+     */
+    constexpr uint32_t NUMBER_OF_THREADS = 2 * ITC_STATISTICS_NUMBER_OF_SHARDS;
+    constexpr uint64_t NUMBER_OF_ADDS = 10000;
+    ItcTransportCounters counters;
+    std::vector<std::thread> threads;
+    for(uint32_t i = 0; i < NUMBER_OF_THREADS; ++i)
+    {
+        threads.emplace_back([&counters]()
+        {
+            for(uint64_t j = 0; j < NUMBER_OF_ADDS; ++j)
+            {
+                counters.add(ITC_TRANSPORT_COUNTER_SENT_MSGS);
+                counters.add(ITC_TRANSPORT_COUNTER_SENT_BYTES, 4);
+            }
+        });
+    }
+    for(auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    auto statistics = getTransportStatistics(counters);
+    ASSERT_EQ(statistics.nrSentMsgs, NUMBER_OF_THREADS * NUMBER_OF_ADDS);
+    ASSERT_EQ(statistics.nrSentBytes, 4 * NUMBER_OF_THREADS * NUMBER_OF_ADDS);
+    ASSERT_EQ(statistics.nrFailedSends, 0);
+    ASSERT_EQ(statistics.nrReceivedMsgs, 0);
+
+    counters.reset();
+    ASSERT_EQ(counters.get(ITC_TRANSPORT_COUNTER_SENT_MSGS), 0);
+}
+
+TEST_F(StatisticsTest, shardedCountersTest2)
+{
+    /***
+     * Test scenario: every shard sits in its own cache line, so threads on different shards never share one.
+     */
+    static_assert(sizeof(ItcTransportCounters) == ITC_STATISTICS_NUMBER_OF_SHARDS * CACHE_LINE_SIZE);
+    static_assert(alignof(ItcTransportCounters) == CACHE_LINE_SIZE);
+
+    uint32_t shardIndex = getStatisticsShardIndex();
+    ASSERT_LT(shardIndex, ITC_STATISTICS_NUMBER_OF_SHARDS);
+    ASSERT_EQ(getStatisticsShardIndex(), shardIndex);
+}
+
+} // namespace INTERNAL
+} // namespace ITC
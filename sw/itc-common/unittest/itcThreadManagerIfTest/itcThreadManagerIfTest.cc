@@ -5,8 +5,10 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <latch>
 
 #include <sched.h>
+#include <unistd.h>
 #include <gtest/gtest.h>
 
 #include "itcCWrapperIfMock.h"
@@ -118,6 +120,7 @@ struct TaskFuncArgs
     bool forceInitTimeout {false};
     bool forcePause {false};
     uint32_t timeout {0};
+    std::latch *startLatch {nullptr};
 };
 
 void *taskFunc(void *arg)
@@ -130,6 +133,11 @@ void *taskFunc(void *arg)
             /* Used to test thread initialisation timeout case. */
             sleep(10);
         }
+        if(ptr->startLatch)
+        {
+            /* Used to test that threads initialise concurrently. */
+            ptr->startLatch->arrive_and_wait();
+        }
         if(ptr->cond && ptr->mtx)
         {
             MUTEX_LOCK(ptr->mtx);
@@ -181,6 +189,10 @@ TEST_F(ThreadManagerIfTest, configureAndStartThreadTest3)
     /***
      * Test scenario: test failed to start a Realtime thread without CAP_SYS_RESOURCE privilege.
      */
+    if(::geteuid() == 0)
+    {
+        GTEST_SKIP() << "Running as root, Realtime threads can be started";
+    }
     int32_t policy = SCHED_RR;
     int32_t priority = 30;
     TaskFuncArgs args {0, nullptr, nullptr, false, false, 0};
@@ -317,6 +329,39 @@ TEST_F(ThreadManagerIfTest, startAllThreadsTest3)
     m_cWrapperIfMock->cPthreadDetach(m_threadManager->m_threadList.at(0).tid);
 }
 
+TEST_F(ThreadManagerIfTest, startAllThreadsTest4)
+{
+    /***
+     * Test scenario: test threads which only get ready once all of them are running, which times out
+     * unless all threads are created before waiting for any of them.
+     */
+    constexpr uint32_t NUMBER_OF_THREADS = 3;
+    std::latch startLatch(NUMBER_OF_THREADS);
+    std::vector<std::shared_ptr<SyncObject>> syncObjs;
+    std::vector<TaskFuncArgs> args(NUMBER_OF_THREADS);
+    for(uint32_t i = 0; i < NUMBER_OF_THREADS; ++i)
+    {
+        syncObjs.push_back(std::make_shared<SyncObject>(m_setCondAttrsClockMonotonicFunc));
+        syncObjs.back()->setTimeout(500);
+        args.at(i) = TaskFuncArgs {0, &syncObjs.back()->elems->cond, &syncObjs.back()->elems->mtx, false, false, 0, &startLatch};
+        m_threadManager->m_threadList.emplace_back(Task(taskFunc, &args.at(i)), syncObjs.back());
+    }
+    
+    auto rc = m_threadManager->startAllThreads();
+    ASSERT_EQ(rc, MAKE_RETURN_CODE(ThreadManagerIfReturnCode, THREAD_MANAGER_OK));
+    usleep(5000); /* Small sleep to make sure all threads have successfully set keys. */
+    for(const auto &arg : args)
+    {
+        ASSERT_EQ(arg.key, EXPECTED_KEY_VALUE);
+    }
+    for(const auto &thr : m_threadManager->m_threadList)
+    {
+        ASSERT_TRUE(thr.isRunning);
+        m_cWrapperIfMock->cPthreadCancel(thr.tid);
+        m_cWrapperIfMock->cPthreadDetach(thr.tid);
+    }
+}
+
 TEST_F(ThreadManagerIfTest, terminateAllThreadsTest1)
 {
     /***
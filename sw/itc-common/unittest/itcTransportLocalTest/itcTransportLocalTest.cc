@@ -4,6 +4,10 @@
 #include <memory>
 #include <string>
 #include <chrono>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <array>
 #include <gtest/gtest.h>
 
 #include "itcThreadPool.h"
@@ -77,17 +81,11 @@ TEST_F(ItcTransportLocalTest, test1)
     auto sentMessage = ItcAdminMessageHelper::allocate(msgno);
     sentMessage->receiver = m_receiver->m_mailboxId;
     sentMessage->sender = m_sender->m_mailboxId;
-    std::chrono::_V2::system_clock::time_point start;
-    std::chrono::_V2::system_clock::time_point end;
     
-    start = std::chrono::high_resolution_clock::now();
-    MAYBE_UNUSED auto rc = m_transportLocal->send(sentMessage);
-    // ASSERT_EQ(rc, MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK));
+    ASSERT_EQ(m_transportLocal->send(sentMessage), MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK));
     auto receivedMessage = m_transportLocal->receive(m_receiver, ITC_MODE_RECEIVE_NON_BLOCKING);
-    end = std::chrono::high_resolution_clock::now();
     ASSERT_EQ(receivedMessage, sentMessage);
-    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
-    std::cout << "[BENCHMARK] ItcTransportLocalTest test1 " << " took " << duration << " ns\n";
+    ItcAdminMessageHelper::deallocate(receivedMessage);
 }
 
 TEST_F(ItcTransportLocalTest, test2)
@@ -95,10 +93,6 @@ TEST_F(ItcTransportLocalTest, test2)
     /***
      * Test scenario: test one thread sends and another thread receives a message.
      */
-    std::chrono::_V2::system_clock::time_point start;
-    std::chrono::_V2::system_clock::time_point end;
-    std::chrono::_V2::system_clock::time_point start1;
-    std::chrono::_V2::system_clock::time_point end1;
     constexpr uint32_t NUMBER_OF_MESSAGES = 1000;
     std::array<ItcAdminMessageRawPtr, NUMBER_OF_MESSAGES> receivedMessages;
     auto receiver = [&]()
@@ -117,7 +111,6 @@ TEST_F(ItcTransportLocalTest, test2)
     
     auto sender = [&]()
     {
-        start1 = std::chrono::high_resolution_clock::now();
         std::array<ItcAdminMessageRawPtr, NUMBER_OF_MESSAGES> sentMessages;
         for(uint32_t i = 0; i < NUMBER_OF_MESSAGES; ++i)
         {
@@ -125,7 +118,6 @@ TEST_F(ItcTransportLocalTest, test2)
             sentMessages.at(i)->receiver = m_receiver->m_mailboxId;
             sentMessages.at(i)->sender = m_sender->m_mailboxId;
         }
-        end1 = std::chrono::high_resolution_clock::now();
         
         for(uint32_t i = 0; i < NUMBER_OF_MESSAGES; ++i)
         {
@@ -134,20 +126,212 @@ TEST_F(ItcTransportLocalTest, test2)
         }
     };
 
-    start = std::chrono::high_resolution_clock::now();
     std::thread receiverThread(receiver);
     std::thread senderThread(sender);
     receiverThread.join();
     senderThread.join();
-    end = std::chrono::high_resolution_clock::now();
     
     for(uint32_t i = 0; i < NUMBER_OF_MESSAGES; ++i)
     {
+        ASSERT_EQ(receivedMessages[i]->msgno, 0xFFFF + i);
         ItcAdminMessageHelper::deallocate(receivedMessages[i]);
     }
-    
-    auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>((end - start) - (end1 - start1)).count();
-    std::cout << "[BENCHMARK] ItcTransportLocalTest test2 " << " took " << duration / NUMBER_OF_MESSAGES << " ns\n";
+}
+
+TEST_F(ItcTransportLocalTest, sendBatchTest1)
+{
+    /***
+     * Test scenario: a batch sorted by receiver reaches every receiver in order,
+     * messages to an unknown mailbox are left to the caller.
+     */
+    std::array<ItcAdminMessageRawPtr, 5> batch;
+    for(uint32_t i = 0; i < batch.size(); ++i)
+    {
+        batch.at(i) = ItcAdminMessageHelper::allocate(0xAAAA0000 + i);
+        batch.at(i)->sender = m_sender->m_mailboxId;
+        batch.at(i)->receiver = i < 3 ? m_receiver->m_mailboxId : m_sender->m_mailboxId;
+    }
+    auto rc = m_transportLocal->sendBatch(batch.data(), batch.size());
+    ASSERT_EQ(rc, MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK));
+    for(auto adminMsg : batch)
+    {
+        ASSERT_EQ(adminMsg, nullptr);
+    }
+
+    for(uint32_t i = 0; i < batch.size(); ++i)
+    {
+        auto msg = m_transportLocal->receive(i < 3 ? m_receiver : m_sender, ITC_MODE_RECEIVE_NON_BLOCKING);
+        ASSERT_NE(msg, nullptr);
+        ASSERT_EQ(msg->msgno, 0xAAAA0000 + i);
+        ItcAdminMessageHelper::deallocate(msg);
+    }
+    ASSERT_EQ(m_transportLocal->receive(m_receiver, ITC_MODE_RECEIVE_NON_BLOCKING), nullptr);
+
+    auto orphan = ItcAdminMessageHelper::allocate(0xBBBBBBBB);
+    orphan->receiver = (m_regionId << ITC_REGION_ID_SHIFT) | 100; /* Never activated. */
+    rc = m_transportLocal->sendBatch(&orphan, 1);
+    ASSERT_EQ(rc, MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED));
+    ASSERT_NE(orphan, nullptr);
+    ItcAdminMessageHelper::deallocate(orphan);
+}
+
+TEST_F(ItcTransportLocalTest, receiveBatchTest1)
+{
+    /***
+     * Test scenario: a batch sent to one mailbox is received with one call.
+     */
+    std::array<ItcAdminMessageRawPtr, 4> batch;
+    std::array<ItcAdminMessageRawPtr, 4> sentMessages;
+    for(uint32_t i = 0; i < batch.size(); ++i)
+    {
+        batch.at(i) = ItcAdminMessageHelper::allocate(0xAAAA0000 + i);
+        batch.at(i)->sender = m_sender->m_mailboxId;
+        batch.at(i)->receiver = m_receiver->m_mailboxId;
+        sentMessages.at(i) = batch.at(i);
+    }
+    ASSERT_EQ(m_transportLocal->sendBatch(batch.data(), batch.size()), MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK));
+
+    std::array<ItcAdminMessageRawPtr, 16> receivedMessages {};
+    auto count = m_transportLocal->receiveBatch(m_receiver, receivedMessages.data(), receivedMessages.size());
+    ASSERT_EQ(count, sentMessages.size());
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        ASSERT_EQ(receivedMessages.at(i), sentMessages.at(i));
+        ItcAdminMessageHelper::deallocate(receivedMessages.at(i));
+    }
+}
+
+TEST_F(ItcTransportLocalTest, singletonFastPathTest1)
+{
+    /***
+     * Test scenario: once constructed, singletons are handed out without m_singletonMutex.
+     * Both mutexes are held here while another thread runs the per-message path, which would hang otherwise.
+     */
+    constexpr uint32_t NUMBER_OF_MESSAGES = 1000;
+    MAYBE_UNUSED auto memManager = MemoryManager::getInstance().lock();
+    std::unique_lock<std::mutex> transportLocalLock(ItcTransportLocal::m_singletonMutex);
+    std::unique_lock<std::mutex> memManagerLock(MemoryManager::m_singletonMutex);
+
+    std::atomic<bool> isDone {false};
+    std::thread worker([&]()
+    {
+        for(uint32_t i = 0; i < NUMBER_OF_MESSAGES; ++i)
+        {
+            auto sentMessage = ItcAdminMessageHelper::allocate(0xAAAABBBB);
+            sentMessage->receiver = m_receiver->m_mailboxId;
+            ItcTransportLocal::getInstance().lock()->send(sentMessage);
+            auto receivedMessage = ItcTransportLocal::getInstance().lock()->receive(m_receiver, ITC_MODE_RECEIVE_NON_BLOCKING);
+            ItcAdminMessageHelper::deallocate(receivedMessage);
+        }
+        isDone = true;
+    });
+
+    for(uint32_t i = 0; i < 5000 && !isDone; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    bool isDoneWhileLocked = isDone;
+    memManagerLock.unlock();
+    transportLocalLock.unlock();
+    worker.join();
+    ASSERT_TRUE(isDoneWhileLocked);
+}
+
+TEST_F(ItcTransportLocalTest, statisticsTest1)
+{
+    /***
+     * Test scenario: sent, received and failed messages are counted, bytes are [msgno] + [user payload].
+     */
+    auto sentMessage = ItcAdminMessageHelper::allocate(0xAAAABBBB, 100);
+    sentMessage->receiver = m_receiver->m_mailboxId;
+    ASSERT_EQ(m_transportLocal->send(sentMessage), MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK));
+
+    std::array<ItcAdminMessageRawPtr, 3> batch;
+    for(uint32_t i = 0; i < batch.size(); ++i)
+    {
+        batch.at(i) = ItcAdminMessageHelper::allocate(0xAAAA0000 + i);
+        batch.at(i)->receiver = i < 2 ? m_receiver->m_mailboxId : (m_regionId << ITC_REGION_ID_SHIFT) | 100; /* Never activated. */
+    }
+    ASSERT_EQ(m_transportLocal->sendBatch(batch.data(), batch.size()), MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED));
+
+    auto statistics = m_transportLocal->getStatistics();
+    ASSERT_EQ(statistics.nrSentMsgs, 3);
+    ASSERT_EQ(statistics.nrSentBytes, 100 + 2 * ITC_MESSAGE_MSGNO_SIZE);
+    ASSERT_EQ(statistics.nrFailedSends, 1);
+    ASSERT_EQ(statistics.nrReceivedMsgs, 0);
+
+    ItcAdminMessageHelper::deallocate(m_transportLocal->receive(m_receiver, ITC_MODE_RECEIVE_NON_BLOCKING));
+    std::array<ItcAdminMessageRawPtr, 4> receivedMessages {};
+    ASSERT_EQ(m_transportLocal->receiveBatch(m_receiver, receivedMessages.data(), receivedMessages.size(), ITC_MODE_RECEIVE_NON_BLOCKING), 2);
+    ItcAdminMessageHelper::deallocate(receivedMessages.at(0));
+    ItcAdminMessageHelper::deallocate(receivedMessages.at(1));
+    ItcAdminMessageHelper::deallocate(batch.at(2));
+
+    statistics = m_transportLocal->getStatistics();
+    ASSERT_EQ(statistics.nrReceivedMsgs, 3);
+    ASSERT_EQ(statistics.nrReceivedBytes, 100 + 2 * ITC_MESSAGE_MSGNO_SIZE);
+    ASSERT_EQ(statistics.nrDroppedMsgs, 0);
+}
+
+TEST_F(ItcTransportLocalTest, resendTest1)
+{
+    /***
+     * Test scenario: a received message is sent back in the same buffer with its payload and priority,
+     * messages with an overwritten endpoint are refused.
+     */
+    auto request = ItcAdminMessageHelper::allocate(0xAAAA0001, 16);
+    ItcAdminMessageHelper::setPriority(request, ITC_MESSAGE_PRIORITY_MAX);
+    request->sender = m_sender->m_mailboxId;
+    request->receiver = m_receiver->m_mailboxId;
+    ASSERT_EQ(m_transportLocal->send(request), MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK));
+
+    auto reply = m_transportLocal->receive(m_receiver, ITC_MODE_RECEIVE_NON_BLOCKING);
+    ASSERT_EQ(reply, request);
+    auto payload = reinterpret_cast<uint8_t *>(&reply->msgno + 1);
+    std::fill(payload, payload + 12, 0x5A);
+    ASSERT_TRUE(ItcAdminMessageHelper::prepareResend(reply));
+    ASSERT_EQ(ItcAdminMessageHelper::getPriority(reply), ITC_MESSAGE_PRIORITY_MAX);
+    reply->msgno = 0xAAAA0002;
+    reply->receiver = reply->sender;
+    reply->sender = m_receiver->m_mailboxId;
+    ASSERT_EQ(m_transportLocal->send(reply), MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK));
+
+    auto adminMsg = m_transportLocal->receive(m_sender, ITC_MODE_RECEIVE_NON_BLOCKING);
+    ASSERT_EQ(adminMsg, request);
+    ASSERT_EQ(adminMsg->msgno, 0xAAAA0002);
+    ASSERT_EQ(adminMsg->sender, m_receiver->m_mailboxId);
+    ASSERT_EQ(payload[11], 0x5A);
+
+    auto endpoint = GET_ITC_ADMIN_MESSAGE_ENDPOINT(adminMsg);
+    *endpoint = 0;
+    ASSERT_FALSE(ItcAdminMessageHelper::prepareResend(adminMsg));
+    *endpoint = ITC_ADMIN_MESSAGE_ENDPOINT;
+    ASSERT_TRUE(ItcAdminMessageHelper::deallocate(adminMsg));
+}
+
+TEST_F(ItcTransportLocalTest, receiveAnyTest1)
+{
+    /***
+     * Test scenario: receiveAny() returns the message of the higher priority mailbox first and counts it.
+     */
+    std::array<ItcMailboxRawPtr, 2> myMboxes {m_receiver, m_sender};
+    std::array<ItcAdminMessageRawPtr, 2> sentMessages;
+    for(uint32_t i = 0; i < sentMessages.size(); ++i)
+    {
+        sentMessages.at(i) = ItcAdminMessageHelper::allocate(0xAAAA0000 + i);
+        sentMessages.at(i)->receiver = myMboxes.at(sentMessages.size() - 1 - i)->m_mailboxId;
+        ASSERT_EQ(m_transportLocal->send(sentMessages.at(i)), MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK));
+    }
+
+    auto receivedMessage = m_transportLocal->receiveAny(myMboxes.data(), myMboxes.size(), ITC_MODE_RECEIVE_NON_BLOCKING);
+    ASSERT_EQ(receivedMessage, sentMessages.at(1));
+    ASSERT_EQ(receivedMessage->receiver, m_receiver->m_mailboxId);
+    ItcAdminMessageHelper::deallocate(receivedMessage);
+    receivedMessage = m_transportLocal->receiveAny(myMboxes.data(), myMboxes.size());
+    ASSERT_EQ(receivedMessage, sentMessages.at(0));
+    ItcAdminMessageHelper::deallocate(receivedMessage);
+    ASSERT_EQ(m_transportLocal->receiveAny(myMboxes.data(), myMboxes.size(), ITC_MODE_RECEIVE_NON_BLOCKING), nullptr);
+    ASSERT_EQ(m_transportLocal->getStatistics().nrReceivedMsgs, 2);
 }
 
 // TEST_F(ItcTransportLocalTest, sendReceiveTest3)
@@ -0,0 +1,300 @@
+#include "itcTransportPosixShm.h"
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <future>
+#include <thread>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "itcThreadManager.h"
+
+
+namespace ITC
+{
+namespace INTERNAL
+{
+using namespace testing;
+using namespace ITC::PROVIDED;
+using ItcPlatformIfReturnCode = ItcPlatformIf::ItcPlatformIfReturnCode;
+using ThreadManagerIfReturnCode = ThreadManagerIf::ThreadManagerIfReturnCode;
+
+class ItcTransportPosixShmTest : public testing::Test
+{
+protected:
+    ItcTransportPosixShmTest()
+    {}
+
+    ~ItcTransportPosixShmTest()
+    {}
+
+    void SetUp() override
+    {
+        m_regionId = 200 << ITC_REGION_ID_SHIFT;
+        m_transportPosixShm = ItcTransportPosixShm::getInstance().lock();
+        m_transportPosixShm->m_regionId = m_regionId;
+    }
+
+    void TearDown() override
+    {
+        m_transportPosixShm->m_instance.reset();
+    }
+
+protected:
+    itc_mailbox_id_t m_regionId {ITC_MAILBOX_ID_DEFAULT};
+    std::shared_ptr<ItcTransportPosixShm> m_transportPosixShm;
+};
+
+TEST_F(ItcTransportPosixShmTest, createSharedSegmentTest1)
+{
+    /***
+     * Test scenario: the Region's segment is created, registered to MemoryManager and removed again.
+     */
+    ASSERT_TRUE(m_transportPosixShm->createSharedSegment());
+    ASSERT_NE(m_transportPosixShm->m_header, nullptr);
+    ASSERT_EQ(m_transportPosixShm->m_header->isReady.load(), 1);
+    ASSERT_TRUE(m_transportPosixShm->m_pool->isInitialised());
+    ASSERT_EQ(MemoryManager::getInstance().lock()->m_sharedPool.load(), m_transportPosixShm->m_pool.get());
+
+    auto shmName = ItcTransportPosixShm::getShmName(m_regionId);
+    m_transportPosixShm->removeSharedSegment();
+    ASSERT_EQ(m_transportPosixShm->m_header, nullptr);
+    ASSERT_EQ(MemoryManager::getInstance().lock()->m_sharedPool.load(), nullptr);
+    ASSERT_LT(shm_open(shmName.c_str(), O_RDWR, 0666), 0);
+    ASSERT_EQ(errno, ENOENT);
+}
+
+TEST_F(ItcTransportPosixShmTest, attachContactTest1)
+{
+    /***
+     * Test scenario: attaching to a Region without segment fails, attaching to an existing one succeeds.
+     */
+    size_t projectId = m_regionId >> ITC_REGION_ID_SHIFT;
+    ASSERT_FALSE(m_transportPosixShm->attachContactAtIndex(projectId));
+    ASSERT_EQ(m_transportPosixShm->m_contactList.at(projectId).load(), nullptr);
+
+    ASSERT_TRUE(m_transportPosixShm->createSharedSegment());
+    ASSERT_TRUE(m_transportPosixShm->attachContactAtIndex(projectId));
+    auto contact = m_transportPosixShm->m_contactList.at(projectId).load();
+    ASSERT_NE(contact, nullptr);
+    ASSERT_NE(reinterpret_cast<UInt8RawPtr>(contact->header), reinterpret_cast<UInt8RawPtr>(m_transportPosixShm->m_header));
+    ASSERT_EQ(contact->header->ownerPid, getpid());
+}
+
+TEST_F(ItcTransportPosixShmTest, attachContactTest2)
+{
+    /***
+     * Test scenario: a segment left behind by a dead owner, which never got to clear isReady, is not attached to.
+     */
+    size_t projectId = m_regionId >> ITC_REGION_ID_SHIFT;
+    ASSERT_TRUE(m_transportPosixShm->createSharedSegment());
+
+    pid_t childPid = fork();
+    ASSERT_GE(childPid, 0);
+    if(childPid == 0)
+    {
+        _exit(0);
+    }
+    ASSERT_EQ(waitpid(childPid, nullptr, 0), childPid);
+    m_transportPosixShm->m_header->ownerPid = childPid;
+
+    ASSERT_FALSE(m_transportPosixShm->attachContactAtIndex(projectId));
+    ASSERT_EQ(m_transportPosixShm->m_contactList.at(projectId).load(), nullptr);
+    m_transportPosixShm->removeSharedSegment();
+}
+
+TEST_F(ItcTransportPosixShmTest, releaseTest1)
+{
+    /***
+     * Test scenario: an idle rx thread parked on its futex is cancelled and joined like ItcPlatform::release() does it,
+     * before the transport itself is released.
+     */
+    ASSERT_TRUE(m_transportPosixShm->initialise(m_regionId));
+    auto threadManager = ThreadManager::getInstance().lock();
+    if(ThreadManagerIf::getInstance().lock().get() != threadManager.get())
+    {
+        /* initialise() handed the rx thread to a mocked ThreadManagerIf. */
+        threadManager->addThread(Task(&posixShmRxThreadWrapper), m_transportPosixShm->m_syncObj);
+    }
+    ASSERT_EQ(threadManager->startAllThreads(), MAKE_RETURN_CODE(ThreadManagerIfReturnCode, THREAD_MANAGER_OK));
+    while(m_transportPosixShm->m_header->rxWaiterState.load() != ITC_POSIX_SHM_RX_PARKED)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    m_transportPosixShm->stopRxThread();
+    /* Detached, so that a hanging join fails the test instead of blocking it. */
+    auto isTerminated = std::make_shared<std::promise<ThreadManagerIfReturnCode>>();
+    auto rc = isTerminated->get_future();
+    std::thread([threadManager, isTerminated]()
+    {
+        isTerminated->set_value(threadManager->terminateAllThreads());
+    }).detach();
+    ASSERT_EQ(rc.wait_for(std::chrono::milliseconds(ITC_POSIX_SHM_RX_PARK_TIMEOUT / 2)), std::future_status::ready);
+    ASSERT_EQ(rc.get(), MAKE_RETURN_CODE(ThreadManagerIfReturnCode, THREAD_MANAGER_OK));
+
+    m_transportPosixShm->release();
+    ASSERT_FALSE(m_transportPosixShm->m_isInitialised);
+    ASSERT_EQ(m_transportPosixShm->m_header, nullptr);
+}
+
+TEST_F(ItcTransportPosixShmTest, sendTest1)
+{
+    /***
+     * Test scenario: a message sent to a Region shows up in the receiver's own mapping of its pool.
+     */
+    ASSERT_TRUE(m_transportPosixShm->createSharedSegment());
+    m_transportPosixShm->m_isInitialised = true;
+
+    auto adminMsg = ItcAdminMessageHelper::allocate(0xAAAABBBB, 32);
+    adminMsg->receiver = m_regionId | 5;
+    adminMsg->sender = m_regionId | 6;
+    m_transportPosixShm->m_header->rxWaiterState.store(ITC_POSIX_SHM_RX_PARKED);
+    auto rc = m_transportPosixShm->send(adminMsg);
+    ASSERT_EQ(rc, MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK));
+    ASSERT_EQ(m_transportPosixShm->m_header->rxWaiterState.load(), ITC_POSIX_SHM_RX_AWAKE); /* Parked rx thread is woken up. */
+
+    int32_t offset {-1};
+    ASSERT_TRUE(m_transportPosixShm->m_rxRing->tryPop(offset));
+    auto rxMsg = reinterpret_cast<ItcAdminMessageRawPtr>(m_transportPosixShm->m_pool->getBaseAddress() + offset);
+    ASSERT_TRUE(m_transportPosixShm->m_pool->owns(reinterpret_cast<UInt8RawPtr>(rxMsg)));
+    ASSERT_EQ(rxMsg->msgno, 0xAAAABBBB);
+    ASSERT_EQ(rxMsg->receiver, m_regionId | 5);
+    ASSERT_EQ(rxMsg->sender, m_regionId | 6);
+    ASSERT_EQ(rxMsg->size, 32);
+
+    /* Slot goes back into the shared pool. */
+    ASSERT_TRUE(ItcAdminMessageHelper::deallocate(rxMsg));
+    ASSERT_FALSE(m_transportPosixShm->m_rxRing->tryPop(offset));
+}
+
+TEST_F(ItcTransportPosixShmTest, sendTest2)
+{
+    /***
+     * Test scenario: messages too large for the receiver's pool are left to the caller.
+     */
+    ASSERT_TRUE(m_transportPosixShm->createSharedSegment());
+    m_transportPosixShm->m_isInitialised = true;
+
+    auto adminMsg = ItcAdminMessageHelper::allocate(0xAAAABBBB, MEMORY_POOL_UNLIMITED_MAX_BLOCK_SIZE);
+    adminMsg->receiver = m_regionId | 5;
+    auto rc = m_transportPosixShm->send(adminMsg);
+    ASSERT_EQ(rc, MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED));
+    ASSERT_TRUE(m_transportPosixShm->m_rxRing->empty());
+    ASSERT_TRUE(ItcAdminMessageHelper::deallocate(adminMsg));
+
+    adminMsg = ItcAdminMessageHelper::allocate(0xAAAABBBB, 32);
+    adminMsg->receiver = (201 << ITC_REGION_ID_SHIFT) | 5; /* Region without segment. */
+    rc = m_transportPosixShm->send(adminMsg);
+    ASSERT_EQ(rc, MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED));
+    ASSERT_TRUE(ItcAdminMessageHelper::deallocate(adminMsg));
+}
+
+TEST_F(ItcTransportPosixShmTest, sendTest3)
+{
+    /***
+     * Test scenario: sender re-attaches after the receiver has re-created its segment.
+     */
+    ASSERT_TRUE(m_transportPosixShm->createSharedSegment());
+    m_transportPosixShm->m_isInitialised = true;
+
+    auto adminMsg = ItcAdminMessageHelper::allocate(0xAAAABBBB, 32);
+    adminMsg->receiver = m_regionId | 5;
+    ASSERT_EQ(m_transportPosixShm->send(adminMsg), MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK));
+
+    m_transportPosixShm->removeSharedSegment();
+    ASSERT_TRUE(m_transportPosixShm->createSharedSegment());
+
+    adminMsg = ItcAdminMessageHelper::allocate(0xCCCCDDDD, 32);
+    adminMsg->receiver = m_regionId | 5;
+    ASSERT_EQ(m_transportPosixShm->send(adminMsg), MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK));
+    /* No other sender, so the old mapping is gone as soon as this one is done. */
+    ASSERT_TRUE(m_transportPosixShm->m_retiredContacts.empty());
+    ASSERT_EQ(m_transportPosixShm->m_nrContactUsers.load(), 0);
+
+    int32_t offset {-1};
+    ASSERT_TRUE(m_transportPosixShm->m_rxRing->tryPop(offset));
+    auto rxMsg = reinterpret_cast<ItcAdminMessageRawPtr>(m_transportPosixShm->m_pool->getBaseAddress() + offset);
+    ASSERT_EQ(rxMsg->msgno, 0xCCCCDDDD);
+    ASSERT_TRUE(ItcAdminMessageHelper::deallocate(rxMsg));
+}
+
+TEST_F(ItcTransportPosixShmTest, sendTest4)
+{
+    /***
+     * Test scenario: a large message goes through the unlimited tier of the receiver's pool, the rx ring carries
+     * an offset the receiver resolves in its own mapping, and the block goes back into the shared pool.
+     */
+    constexpr uint32_t MESSAGE_SIZE = 64 * 1024;
+    ASSERT_TRUE(m_transportPosixShm->createSharedSegment());
+    ASSERT_TRUE(m_transportPosixShm->m_pool->hasUnlimited());
+    m_transportPosixShm->m_isInitialised = true;
+
+    auto adminMsg = ItcAdminMessageHelper::allocate(0xAAAABBBB, MESSAGE_SIZE);
+    adminMsg->receiver = m_regionId | 5;
+    std::memset(reinterpret_cast<uint8_t *>(adminMsg) + ITC_ADMIN_MESSAGE_PREAMBLE_SIZE + sizeof(uint32_t), 0x5A, MESSAGE_SIZE - sizeof(uint32_t));
+    ASSERT_EQ(m_transportPosixShm->send(adminMsg), MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK));
+
+    int32_t offset {-1};
+    ASSERT_TRUE(m_transportPosixShm->m_rxRing->tryPop(offset));
+    ASSERT_GE(offset, static_cast<int32_t>(MEMORY_POOL_UNLIMITED_START_OFFSET));
+    UInt8RawPtr slot = m_transportPosixShm->m_pool->getAddress(offset);
+    ASSERT_NE(slot, nullptr);
+    ASSERT_GE(m_transportPosixShm->m_pool->getSlotSize(slot), ITC_ADMIN_MESSAGE_PREAMBLE_SIZE + MESSAGE_SIZE + ITC_ADMIN_MESSAGE_ENDPOINT_SIZE);
+    auto rxMsg = reinterpret_cast<ItcAdminMessageRawPtr>(slot);
+    ASSERT_EQ(rxMsg->msgno, 0xAAAABBBB);
+    ASSERT_EQ(rxMsg->size, MESSAGE_SIZE);
+    ASSERT_EQ(slot[ITC_ADMIN_MESSAGE_PREAMBLE_SIZE + MESSAGE_SIZE - 1], 0x5A);
+    ASSERT_EQ(*GET_ITC_ADMIN_MESSAGE_ENDPOINT(rxMsg), ITC_ADMIN_MESSAGE_ENDPOINT);
+
+    ASSERT_TRUE(ItcAdminMessageHelper::deallocate(rxMsg));
+    ASSERT_EQ(m_transportPosixShm->m_pool->getSlotSize(slot), 0);
+}
+
+TEST_F(ItcTransportPosixShmTest, sendBatchTest1)
+{
+    /***
+     * Test scenario: a batch shows up back to back in the receiver's rx ring,
+     * messages which do not fit are left to the caller in their original order.
+     */
+    ASSERT_TRUE(m_transportPosixShm->createSharedSegment());
+    m_transportPosixShm->m_isInitialised = true;
+
+    std::array<ItcAdminMessageRawPtr, 4> batch;
+    for(uint32_t i = 0; i < batch.size(); ++i)
+    {
+        batch.at(i) = ItcAdminMessageHelper::allocate(0xAAAA0000 + i, i == 2 ? MEMORY_POOL_UNLIMITED_MAX_BLOCK_SIZE : 32);
+        batch.at(i)->receiver = m_regionId | 5;
+    }
+    auto rc = m_transportPosixShm->sendBatch(batch.data(), batch.size());
+    ASSERT_EQ(rc, MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_FAILED));
+    ASSERT_EQ(batch.at(0), nullptr);
+    ASSERT_EQ(batch.at(1), nullptr);
+    ASSERT_NE(batch.at(2), nullptr); /* Too large for the pool. */
+    ASSERT_NE(batch.at(3), nullptr); /* Must not overtake the previous one. */
+    ASSERT_EQ(m_transportPosixShm->m_rxRing->size(), 2);
+
+    for(uint32_t i = 0; i < 2; ++i)
+    {
+        int32_t offset {-1};
+        ASSERT_TRUE(m_transportPosixShm->m_rxRing->tryPop(offset));
+        auto rxMsg = reinterpret_cast<ItcAdminMessageRawPtr>(m_transportPosixShm->m_pool->getBaseAddress() + offset);
+        ASSERT_EQ(rxMsg->msgno, 0xAAAA0000 + i);
+        ASSERT_TRUE(ItcAdminMessageHelper::deallocate(rxMsg));
+    }
+    ASSERT_TRUE(ItcAdminMessageHelper::deallocate(batch.at(2)));
+    ASSERT_TRUE(ItcAdminMessageHelper::deallocate(batch.at(3)));
+}
+
+} // namespace INTERNAL
+} // namespace ITC
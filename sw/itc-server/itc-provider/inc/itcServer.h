@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <optional>
+#include <vector>
+#include <unordered_set>
+
+#include <gtest/gtest.h>
+
+#include "itc.h"
+#include "itcConstant.h"
+#include "itcSystemProto.h"
+#include "itcServerRegistry.h"
+#include "itcProxy.h"
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+using namespace ITC::PROVIDED;
+using ItcPlatformIfReturnCode = ItcPlatformIf::ItcPlatformIfReturnCode;
+
+#define ITC_SERVER_MAX_NUMBER_OF_THREADS                (uint32_t)(8) /* Of each kind, I/O and request threads */
+#define ITC_SERVER_MAX_EPOLL_EVENTS                     (uint32_t)(64)
+#define ITC_SERVER_REQUEST_BATCH_SIZE                   (uint32_t)(64)
+#define ITC_SERVER_REQUEST_POLL_TIMEOUT                 (uint32_t)(100000) /* us, how soon request threads notice stop() */
+#define ITC_SERVER_MAILBOX_NAME_PREFIX                  "itc-server-"
+#define ITC_SERVER_PROXY_CONFIG_FILE                    "/etc/itc/itc-proxy.conf" /* Only Worlds with this file talk to others */
+
+/***
+ * itc-server daemon, started by the first Region of a World, see ItcPlatform::checkAndStartItcServer().
+ *
+ * I/O threads each run their own epoll set, all of them watch the listening socket ITC_PATH_ITC_SERVER_SOCKET with
+ * EPOLLEXCLUSIVE, so every incoming Region is accepted and served by exactly one of them:
+ * + ITC_ETHERNET_MESSAGE_LOCATE_ITC_SERVER_REQUEST gets a Region id and the id of the request mailbox serving it.
+ * + The Region then connects to its lsocket, see ItcTransportLSocket::initialise(), which stays open for as long as
+ *   the Region lives. Once it hangs up, all mailboxes of that Region are dropped and the other Regions are told.
+ *
+ * Request threads each own one itc mailbox, Regions are spread over them. They serve the mailbox creation/deletion
+ * notifications and locate requests against the sharded ItcServerRegistry, so none of them is a single choke point.
+ *
+ * With a proxy config, messages sent to other Worlds are handed over to ItcProxy as they are, and messages coming
+ * from other Worlds are delivered to the receiving Region like any other message sent from this one.
+ */
+class ItcServer
+{
+public:
+    ItcServer() = default;
+    ~ItcServer();
+
+    ItcServer(const ItcServer &other) = delete;
+    ItcServer &operator=(const ItcServer &other) = delete;
+    ItcServer(ItcServer &&other) noexcept = delete;
+    ItcServer &operator=(ItcServer &&other) noexcept = delete;
+
+    /* 0 means one thread of each kind per CPU, up to ITC_SERVER_MAX_NUMBER_OF_THREADS. */
+    bool start(uint32_t nrThreads = 0, const std::optional<ItcProxyConfig> &proxyConfig = std::nullopt);
+    void stop();
+
+private:
+    enum class ConnectionType
+    {
+        LISTENER,           /* ITC_PATH_ITC_SERVER_SOCKET */
+        LOCATE_CLIENT,      /* Waiting for ITC_ETHERNET_MESSAGE_LOCATE_ITC_SERVER_REQUEST */
+        REGION_LISTENER,    /* lsocket of a freshly assigned Region */
+        REGION,             /* Accepted lsocket, hangs up once the Region is gone */
+        WAKEUP              /* eventfd written by stop() */
+    };
+
+    struct Connection
+    {
+        int32_t fd {-1};
+        ConnectionType type {ConnectionType::LOCATE_CLIENT};
+        itc_mailbox_id_t regionId {ITC_MAILBOX_ID_DEFAULT};
+    };
+
+    /* Epoll set of one I/O thread and the connections it owns. */
+    struct IoContext
+    {
+        int32_t epollFd {-1};
+        std::unordered_set<Connection *> connections;
+    };
+
+    bool lockServer();
+    void unlockServer();
+    bool createListener();
+    bool addConnection(IoContext &context, Connection *connection, uint32_t events);
+    void closeConnection(IoContext &context, Connection *connection);
+
+    void ioThread(uint32_t index);
+    void acceptLocateClients(IoContext &context);
+    void handleLocateClient(IoContext &context, Connection *connection);
+    void acceptRegion(IoContext &context, Connection *connection);
+    void releaseRegion(itc_mailbox_id_t regionId);
+
+    void requestThread(uint32_t index);
+    void handleNotification(ItcMessageRawPtr msg);
+    void handleLocateSync(ItcMessageRawPtr msg);
+    void handleLocateAsync(ItcMessageRawPtr msg);
+    void sendLocateReply(itc_mailbox_id_t toMboxId, itc_mailbox_id_t locatedMboxId);
+    void notifyRegionsOfDeletion(itc_mailbox_id_t exceptRegionId);
+    bool forwardToWorld(ItcMessageRawPtr msg);
+    void deliverFromWorld(uint32_t fromWorldId, const uint8_t *msg, uint32_t length);
+
+    static std::string getLSocketPath(itc_mailbox_id_t regionId);
+
+private:
+    ItcServerRegistry m_registry;
+    std::shared_ptr<ItcPlatformIf> m_itcPlatformIf {nullptr};
+    int32_t m_lockFd {-1};
+    int32_t m_listenerFd {-1};
+    int32_t m_wakeupFd {-1};
+    Connection m_listener {-1, ConnectionType::LISTENER};
+    Connection m_wakeup {-1, ConnectionType::WAKEUP};
+    std::atomic<bool> m_isRunning {false};
+    /* Mailbox of each request thread, written before any I/O thread starts. */
+    std::vector<itc_mailbox_id_t> m_requestMboxIds;
+    std::vector<std::thread> m_ioThreads;
+    std::vector<std::thread> m_requestThreads;
+    std::unique_ptr<ItcProxy> m_proxy;
+
+    friend class ItcServerTest;
+}; // class ItcServer
+
+} // namespace INTERNAL
+} // namespace ITC
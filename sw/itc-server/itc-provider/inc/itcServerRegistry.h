@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <array>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+
+#include <gtest/gtest.h>
+
+#include "itc.h"
+#include "itcConstant.h"
+#include "itcLockFreeQueue.h"
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+using namespace ITC::PROVIDED;
+
+#define ITC_SERVER_REGISTRY_NUMBER_OF_SHARDS            (uint32_t)(64) /* Power of two */
+#define ITC_SERVER_REGION_INDEX_FIRST_ASSIGNABLE        (uint32_t)(2) /* 0 is invalid, 1 is itc-server itself */
+
+struct RegisteredMailbox
+{
+    itc_mailbox_id_t mboxId {ITC_MAILBOX_ID_DEFAULT};
+    bool isExternalCommunicationNeeded {false};
+};
+
+/***
+ * Everything itc-server knows about the Regions of its World:
+ * + Mailbox names, sharded by name hash so that locating/notifying threads only contend on the same shard.
+ * + Async locates of names which do not exist yet, answered once the mailbox is registered.
+ * + Region ids, handed out from a lock-free bitmap so that Region startups never wait for each other.
+ */
+class ItcServerRegistry
+{
+public:
+    ItcServerRegistry() = default;
+    ~ItcServerRegistry() = default;
+
+    ItcServerRegistry(const ItcServerRegistry &other) = delete;
+    ItcServerRegistry &operator=(const ItcServerRegistry &other) = delete;
+    ItcServerRegistry(ItcServerRegistry &&other) noexcept = delete;
+    ItcServerRegistry &operator=(ItcServerRegistry &&other) noexcept = delete;
+
+    /* Returns the shifted Region id, i.e. what mailbox ids are ORed with, or ITC_MAILBOX_ID_DEFAULT if all are taken. */
+    itc_mailbox_id_t allocateRegion();
+    void releaseRegion(itc_mailbox_id_t regionId);
+    std::vector<itc_mailbox_id_t> getActiveRegions() const;
+
+    /***
+     * Fails if the name is already registered. Mailboxes waiting for that name via addLocator()
+     * are moved into locators, they are to be told about mboxId now.
+     */
+    bool add(const std::string &mboxName, const RegisteredMailbox &mbox, std::vector<itc_mailbox_id_t> &locators);
+    /* Only removes the name if it still belongs to mboxId, a Region may have re-used it meanwhile. */
+    bool remove(const std::string &mboxName, itc_mailbox_id_t mboxId);
+    itc_mailbox_id_t lookUp(const std::string &mboxName) const;
+    /***
+     * As lookUp(), but if not found locator is remembered and handed out by the add() of mboxName.
+     * Both happen under the same shard lock, so the locator is never missed by a concurrent add().
+     */
+    itc_mailbox_id_t lookUpOrAddLocator(const std::string &mboxName, itc_mailbox_id_t locator);
+    /* Drops all mailboxes and locators of a Region which went away, returns the number of mailboxes dropped. */
+    size_t removeRegion(itc_mailbox_id_t regionId);
+    size_t size() const;
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Shard
+    {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, RegisteredMailbox> mailboxes;
+        std::unordered_map<std::string, std::vector<itc_mailbox_id_t>> locators;
+    };
+
+    static constexpr uint32_t NUMBER_OF_REGION_WORDS = (ITC_MAX_SUPPORTED_REGIONS + 1 + 63) / 64;
+
+    Shard &getShard(const std::string &mboxName);
+    const Shard &getShard(const std::string &mboxName) const;
+
+private:
+    std::array<Shard, ITC_SERVER_REGISTRY_NUMBER_OF_SHARDS> m_shards;
+    /* Bit i set means Region index i is in use */
+    std::array<std::atomic<uint64_t>, NUMBER_OF_REGION_WORDS> m_regionBitmap {};
+
+    friend class ItcServerRegistryTest;
+    FRIEND_TEST(ItcServerRegistryTest, regionTest1);
+}; // class ItcServerRegistry
+
+} // namespace INTERNAL
+} // namespace ITC
@@ -0,0 +1,625 @@
+#include "itcServer.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include <latch>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/file.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "itcConstant.h"
+#include "itcAdminMessage.h"
+#include "itcEthernetProto.h"
+#include "itcSystemProto.h"
+#include "itcTransportLocal.h"
+#include "itcTransportLSocket.h"
+#include "itcTransportPosixShm.h"
+#include "itcTransportSysvMsgQueue.h"
+#include "itcFileSystemIf.h"
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+using FileSystemIfReturnCode = FileSystemIf::FileSystemIfReturnCode;
+using PathType = FileSystemIf::PathType;
+
+ItcServer::~ItcServer()
+{
+    stop();
+}
+
+bool ItcServer::start(uint32_t nrThreads, const std::optional<ItcProxyConfig> &proxyConfig)
+{
+    if(m_isRunning)
+    {
+        return true;
+    }
+
+    if(nrThreads == 0)
+    {
+        nrThreads = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    nrThreads = std::min(nrThreads, ITC_SERVER_MAX_NUMBER_OF_THREADS);
+
+    if(!lockServer())
+    {
+        return false;
+    }
+
+    m_itcPlatformIf = ItcPlatformIf::getInstance().lock();
+    if(!m_itcPlatformIf || m_itcPlatformIf->initialise(ITC_FLAG_I_AM_ITC_SERVER) != MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK))
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("Failed to initialise ItcPlatform as itc-server!"));
+        unlockServer();
+        return false;
+    }
+
+    m_isRunning = true;
+
+    /* Regions must not be told about request mailboxes which do not exist yet. */
+    m_requestMboxIds.assign(nrThreads, ITC_MAILBOX_ID_DEFAULT);
+    std::latch mailboxesCreated(nrThreads);
+    for(uint32_t i = 0; i < nrThreads; ++i)
+    {
+        m_requestThreads.emplace_back([this, i, &mailboxesCreated]()
+        {
+            m_requestMboxIds[i] = m_itcPlatformIf->createMailbox(ITC_SERVER_MAILBOX_NAME_PREFIX + std::to_string(i));
+            mailboxesCreated.count_down();
+            requestThread(i);
+        });
+    }
+    mailboxesCreated.wait();
+    if(std::find(m_requestMboxIds.begin(), m_requestMboxIds.end(), ITC_MAILBOX_ID_DEFAULT) != m_requestMboxIds.end())
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("Failed to create request mailboxes!"));
+        stop();
+        return false;
+    }
+
+    if(proxyConfig)
+    {
+        /* Forwarded messages are only released once written to the other World, see forwardToWorld(). */
+        m_proxy = std::make_unique<ItcProxy>(*proxyConfig,
+            [this](uint32_t fromWorldId, const uint8_t *msg, uint32_t length)
+            {
+                deliverFromWorld(fromWorldId, msg, length);
+            },
+            [this](void *cookie)
+            {
+                m_itcPlatformIf->deallocateMessage(static_cast<ItcMessageRawPtr>(cookie));
+            });
+        if(!m_proxy->start())
+        {
+            stop();
+            return false;
+        }
+    }
+
+    if(!createListener())
+    {
+        stop();
+        return false;
+    }
+
+    for(uint32_t i = 0; i < nrThreads; ++i)
+    {
+        m_ioThreads.emplace_back(&ItcServer::ioThread, this, i);
+    }
+    return true;
+}
+
+void ItcServer::stop()
+{
+    if(!m_isRunning.exchange(false))
+    {
+        return;
+    }
+
+    if(m_wakeupFd != -1)
+    {
+        uint64_t value {1};
+        if(::write(m_wakeupFd, &value, sizeof(value)) < 0)
+        {
+            TPT_TRACE(TRACE_ERROR, SSTR("Failed to wake up I/O threads, errno = ", errno));
+        }
+    }
+    for(auto &thread : m_ioThreads)
+    {
+        thread.join();
+    }
+    for(auto &thread : m_requestThreads)
+    {
+        thread.join();
+    }
+    m_ioThreads.clear();
+    m_requestThreads.clear();
+    if(m_proxy)
+    {
+        /* Needs the request mailbox ids and ItcPlatform for what is still in flight. */
+        m_proxy->stop();
+        m_proxy.reset();
+    }
+    m_requestMboxIds.clear();
+
+    if(m_listenerFd != -1)
+    {
+        ::close(m_listenerFd);
+        ::unlink(ITC_PATH_ITC_SERVER_SOCKET);
+        m_listenerFd = -1;
+    }
+    if(m_wakeupFd != -1)
+    {
+        ::close(m_wakeupFd);
+        m_wakeupFd = -1;
+    }
+    m_itcPlatformIf->release();
+    unlockServer();
+}
+
+bool ItcServer::lockServer()
+{
+    std::filesystem::path serverPath(ITC_PATH_ITC_SERVER_SOCKET);
+    if(FileSystemIf::getInstance().lock()->createPath(serverPath.parent_path(), PathType::DIRECTORY, ITC_PATH_ITC_DIRECTORY_POSITION) != MAKE_RETURN_CODE(FileSystemIfReturnCode, ITC_FILESYSTEM_OK))
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("Failed to create itc-server path!"));
+        return false;
+    }
+
+    /***
+     * Regions which start at the same time may all find no itc-server and each spawn one. Only the first one to
+     * take the lock serves the World, the others leave before touching its socket, message queue or shared memory.
+     */
+    m_lockFd = ::open(ITC_PATH_ITC_SERVER_LOCK_FILE, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if(m_lockFd < 0 || ::flock(m_lockFd, LOCK_EX | LOCK_NB) < 0)
+    {
+        TPT_TRACE(TRACE_INFO, SSTR("Another itc-server is already running, errno = ", errno));
+        unlockServer();
+        return false;
+    }
+    return true;
+}
+
+void ItcServer::unlockServer()
+{
+    if(m_lockFd != -1)
+    {
+        /* The lock file itself stays, removing it would let a new itc-server lock a different file. */
+        ::close(m_lockFd);
+        m_lockFd = -1;
+    }
+}
+
+bool ItcServer::createListener()
+{
+    if(FileSystemIf::getInstance().lock()->createPath(ITC_PATH_SOCK_FOLDER_NAME, PathType::DIRECTORY, ITC_PATH_ITC_DIRECTORY_POSITION) != MAKE_RETURN_CODE(FileSystemIfReturnCode, ITC_FILESYSTEM_OK))
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("Failed to create lsocket path!"));
+        return false;
+    }
+
+    m_listenerFd = ::socket(AF_LOCAL, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(m_listenerFd < 0)
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("Failed to open itc-server socket, errno = ", errno));
+        return false;
+    }
+
+    sockaddr_un serverAddr;
+    std::memset(&serverAddr, 0, sizeof(sockaddr_un));
+    serverAddr.sun_family = AF_LOCAL;
+    std::strncpy(serverAddr.sun_path, ITC_PATH_ITC_SERVER_SOCKET, sizeof(serverAddr.sun_path) - 1);
+    /* A previous itc-server may have died without cleaning up, we hold the lock so it is not a living one. */
+    ::unlink(ITC_PATH_ITC_SERVER_SOCKET);
+    if(::bind(m_listenerFd, (const sockaddr*)&serverAddr, sizeof(serverAddr)) < 0 || ::listen(m_listenerFd, SOMAXCONN) < 0)
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("Failed to bind/listen on ", ITC_PATH_ITC_SERVER_SOCKET, ", errno = ", errno));
+        return false;
+    }
+    m_listener.fd = m_listenerFd;
+
+    m_wakeupFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(m_wakeupFd < 0)
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("Failed to create eventfd, errno = ", errno));
+        return false;
+    }
+    m_wakeup.fd = m_wakeupFd;
+    return true;
+}
+
+bool ItcServer::addConnection(IoContext &context, Connection *connection, uint32_t events)
+{
+    epoll_event event;
+    event.events = events;
+    event.data.ptr = connection;
+    if(::epoll_ctl(context.epollFd, EPOLL_CTL_ADD, connection->fd, &event) < 0)
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("Failed to epoll_ctl(EPOLL_CTL_ADD), errno = ", errno));
+        return false;
+    }
+    if(connection != &m_listener && connection != &m_wakeup)
+    {
+        context.connections.insert(connection);
+    }
+    return true;
+}
+
+void ItcServer::closeConnection(IoContext &context, Connection *connection)
+{
+    ::epoll_ctl(context.epollFd, EPOLL_CTL_DEL, connection->fd, nullptr);
+    ::close(connection->fd);
+    if(connection->type == ConnectionType::REGION_LISTENER)
+    {
+        ::unlink(getLSocketPath(connection->regionId).c_str());
+    }
+    context.connections.erase(connection);
+    delete connection;
+}
+
+void ItcServer::ioThread(uint32_t index)
+{
+    ::prctl(PR_SET_NAME, ("itcServerIo" + std::to_string(index)).c_str(), 0, 0, 0);
+
+    IoContext context;
+    context.epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    /* EPOLLEXCLUSIVE wakes up one I/O thread per incoming connection instead of all of them. */
+    if(context.epollFd < 0 || !addConnection(context, &m_listener, EPOLLIN | EPOLLEXCLUSIVE) || !addConnection(context, &m_wakeup, EPOLLIN))
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("Failed to set up epoll for I/O thread ", index, ", errno = ", errno));
+        if(context.epollFd >= 0)
+        {
+            ::close(context.epollFd);
+        }
+        return;
+    }
+
+    std::array<epoll_event, ITC_SERVER_MAX_EPOLL_EVENTS> events;
+    while(m_isRunning.load(MEMORY_ORDER_RELAXED))
+    {
+        int32_t nrEvents = ::epoll_wait(context.epollFd, events.data(), events.size(), -1);
+        if(nrEvents < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            TPT_TRACE(TRACE_ERROR, SSTR("Failed to epoll_wait, errno = ", errno));
+            break;
+        }
+
+        for(int32_t i = 0; i < nrEvents; ++i)
+        {
+            auto connection = static_cast<Connection *>(events[i].data.ptr);
+            switch(connection->type)
+            {
+            case ConnectionType::LISTENER:
+                acceptLocateClients(context);
+                break;
+            case ConnectionType::LOCATE_CLIENT:
+                handleLocateClient(context, connection);
+                break;
+            case ConnectionType::REGION_LISTENER:
+                acceptRegion(context, connection);
+                break;
+            case ConnectionType::REGION:
+                /* Regions never send anything on it, so any event means it hung up. */
+                releaseRegion(connection->regionId);
+                closeConnection(context, connection);
+                break;
+            case ConnectionType::WAKEUP:
+                break;
+            }
+        }
+    }
+
+    while(!context.connections.empty())
+    {
+        closeConnection(context, *context.connections.begin());
+    }
+    ::close(context.epollFd);
+}
+
+void ItcServer::acceptLocateClients(IoContext &context)
+{
+    while(true)
+    {
+        int32_t clientFd = ::accept4(m_listenerFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(clientFd < 0)
+        {
+            if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                TPT_TRACE(TRACE_ERROR, SSTR("Failed to accept, errno = ", errno));
+            }
+            return;
+        }
+
+        auto connection = new Connection {clientFd, ConnectionType::LOCATE_CLIENT};
+        if(!addConnection(context, connection, EPOLLIN | EPOLLRDHUP))
+        {
+            ::close(clientFd);
+            delete connection;
+        }
+    }
+}
+
+void ItcServer::handleLocateClient(IoContext &context, Connection *connection)
+{
+    itc_ethernet_message_locate_itc_server_request request;
+    ssize_t rxLen = ::recv(connection->fd, &request, sizeof(request), 0);
+    if(rxLen < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+    {
+        return;
+    }
+    if(rxLen != sizeof(request) || request.msgno != ITC_ETHERNET_MESSAGE_LOCATE_ITC_SERVER_REQUEST)
+    {
+        TPT_TRACE(TRACE_ABN, SSTR("Invalid ITC_ETHERNET_MESSAGE_LOCATE_ITC_SERVER_REQUEST received, rxLen = ", rxLen));
+        closeConnection(context, connection);
+        return;
+    }
+
+    itc_ethernet_message_locate_itc_server_reply reply;
+    reply.msgno = ITC_ETHERNET_MESSAGE_LOCATE_ITC_SERVER_REPLY;
+    reply.assignedRegionId = m_registry.allocateRegion();
+    if(reply.assignedRegionId != ITC_MAILBOX_ID_DEFAULT)
+    {
+        /* The Region connects to its lsocket right after the reply, so it has to be listening already. */
+        int32_t regionFd = ::socket(AF_LOCAL, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        sockaddr_un regionAddr;
+        std::memset(&regionAddr, 0, sizeof(sockaddr_un));
+        regionAddr.sun_family = AF_LOCAL;
+        std::strncpy(regionAddr.sun_path, getLSocketPath(reply.assignedRegionId).c_str(), sizeof(regionAddr.sun_path) - 1);
+        ::unlink(regionAddr.sun_path);
+
+        auto regionListener = new Connection {regionFd, ConnectionType::REGION_LISTENER, reply.assignedRegionId};
+        if(regionFd < 0 || ::bind(regionFd, (const sockaddr*)&regionAddr, sizeof(regionAddr)) < 0 || ::listen(regionFd, 1) < 0
+            || !addConnection(context, regionListener, EPOLLIN))
+        {
+            TPT_TRACE(TRACE_ERROR, SSTR("Failed to listen on ", regionAddr.sun_path, ", errno = ", errno));
+            if(regionFd >= 0)
+            {
+                ::close(regionFd);
+            }
+            delete regionListener;
+            m_registry.releaseRegion(reply.assignedRegionId);
+            reply.assignedRegionId = ITC_MAILBOX_ID_DEFAULT;
+        } else
+        {
+            uint32_t regionIndex = reply.assignedRegionId >> ITC_REGION_ID_SHIFT;
+            reply.itcServerMboxId = m_requestMboxIds[regionIndex % m_requestMboxIds.size()];
+        }
+    }
+
+    if(::send(connection->fd, &reply, sizeof(reply), MSG_NOSIGNAL) != sizeof(reply))
+    {
+        TPT_TRACE(TRACE_ABN, SSTR("Failed to send ITC_ETHERNET_MESSAGE_LOCATE_ITC_SERVER_REPLY, errno = ", errno));
+    }
+    closeConnection(context, connection);
+}
+
+void ItcServer::acceptRegion(IoContext &context, Connection *connection)
+{
+    int32_t regionFd = ::accept4(connection->fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if(regionFd < 0)
+    {
+        return;
+    }
+
+    /* Only one Region may ever connect to it. */
+    itc_mailbox_id_t regionId = connection->regionId;
+    closeConnection(context, connection);
+
+    static const char ack[4] = "ack";
+    auto region = new Connection {regionFd, ConnectionType::REGION, regionId};
+    if(::send(regionFd, ack, sizeof(ack), MSG_NOSIGNAL) != sizeof(ack) || !addConnection(context, region, EPOLLRDHUP))
+    {
+        TPT_TRACE(TRACE_ABN, SSTR("Failed to acknowledge Region 0x", std::hex, std::setw(8), std::setfill('0'), regionId));
+        ::close(regionFd);
+        delete region;
+        releaseRegion(regionId);
+    }
+}
+
+void ItcServer::releaseRegion(itc_mailbox_id_t regionId)
+{
+    size_t nrRemovedMboxes = m_registry.removeRegion(regionId);
+    m_registry.releaseRegion(regionId);
+    if(nrRemovedMboxes > 0)
+    {
+        notifyRegionsOfDeletion(regionId);
+    }
+}
+
+void ItcServer::requestThread(uint32_t index)
+{
+    ::prctl(PR_SET_NAME, ("itcServerReq" + std::to_string(index)).c_str(), 0, 0, 0);
+
+    std::array<ItcMessageRawPtr, ITC_SERVER_REQUEST_BATCH_SIZE> msgs;
+    while(m_isRunning.load(MEMORY_ORDER_RELAXED))
+    {
+        size_t nrMsgs = m_itcPlatformIf->receiveBatch(msgs.data(), msgs.size(), ITC_MODE_RECEIVE_TIMEOUT, ITC_SERVER_REQUEST_POLL_TIMEOUT);
+        for(size_t i = 0; i < nrMsgs; ++i)
+        {
+            switch(msgs[i]->msgno)
+            {
+            case ITC_SYSTEM_MESSAGE_NOTIFY_MBOX_CREATION_DELETION_TO_ITC_SERVER_REQUEST:
+                handleNotification(msgs[i]);
+                break;
+            case ITC_SYSTEM_MESSAGE_LOCATE_MBOX_SYNC_IN_ITC_SERVER_REQUEST:
+                handleLocateSync(msgs[i]);
+                break;
+            case ITC_SYSTEM_MESSAGE_LOCATE_MBOX_ASYNC_IN_ITC_SERVER_REQUEST:
+                handleLocateAsync(msgs[i]);
+                break;
+            case ITC_SYSTEM_MESSAGE_FORWARD_MESSAGE_TO_ITC_SERVER_REQUEST:
+                if(forwardToWorld(msgs[i]))
+                {
+                    /* Owned by itc-proxy from now on. */
+                    continue;
+                }
+                break;
+            default:
+                TPT_TRACE(TRACE_ABN, SSTR("Unsupported request received, msgno = 0x", std::hex, msgs[i]->msgno));
+                break;
+            }
+            m_itcPlatformIf->deallocateMessage(msgs[i]);
+        }
+    }
+
+    m_itcPlatformIf->deleteMailbox(m_requestMboxIds[index]);
+}
+
+void ItcServer::handleNotification(ItcMessageRawPtr msg)
+{
+    const auto &notification = msg->m_itc_system_message_notify_mbox_creation_deletion_to_itc_server_request;
+    if(notification.isCreation == 1)
+    {
+        std::vector<itc_mailbox_id_t> locators;
+        RegisteredMailbox mbox {notification.mboxId, notification.isExternalCommunicationNeeded != 0};
+        if(m_registry.add(notification.mboxName, mbox, locators))
+        {
+            for(auto locator : locators)
+            {
+                sendLocateReply(locator, notification.mboxId);
+            }
+        }
+    } else if(m_registry.remove(notification.mboxName, notification.mboxId))
+    {
+        /* The deleting Region has already dropped its own locate caches. */
+        notifyRegionsOfDeletion(notification.mboxId & ITC_MASK_REGION_ID);
+    }
+}
+
+void ItcServer::handleLocateSync(ItcMessageRawPtr msg)
+{
+    const auto &request = msg->m_itc_system_message_locate_mbox_sync_in_itc_server_request;
+    /* Not found is answered as well, so that locateMailboxSync() does not wait for nothing. */
+    sendLocateReply(m_itcPlatformIf->getSender(msg), m_registry.lookUp(request.locatedMboxName));
+}
+
+void ItcServer::handleLocateAsync(ItcMessageRawPtr msg)
+{
+    const auto &request = msg->m_itc_system_message_locate_mbox_async_in_itc_server_request;
+    itc_mailbox_id_t locator = m_itcPlatformIf->getSender(msg);
+    itc_mailbox_id_t locatedMboxId = request.replyImmediately ? request.mailboxId : m_registry.lookUpOrAddLocator(request.locatedMboxName, locator);
+    if(locatedMboxId != ITC_MAILBOX_ID_DEFAULT)
+    {
+        sendLocateReply(locator, locatedMboxId);
+    }
+}
+
+void ItcServer::sendLocateReply(itc_mailbox_id_t toMboxId, itc_mailbox_id_t locatedMboxId)
+{
+    auto reply = m_itcPlatformIf->allocateMessage(ITC_SYSTEM_MESSAGE_LOCATE_MBOX_IN_ITC_SERVER_REPLY, sizeof(itc_system_message_locate_mbox_in_itc_server_reply));
+    reply->m_itc_system_message_locate_mbox_in_itc_server_reply.locatedMbox = MailboxContactInfo(locatedMboxId);
+    if(m_itcPlatformIf->send(reply, MailboxContactInfo(toMboxId)) != MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK))
+    {
+        m_itcPlatformIf->deallocateMessage(reply);
+    }
+}
+
+void ItcServer::notifyRegionsOfDeletion(itc_mailbox_id_t exceptRegionId)
+{
+    for(auto regionId : m_registry.getActiveRegions())
+    {
+        if(regionId == exceptRegionId)
+        {
+            continue;
+        }
+        /* Consumed by the Region's rx thread, the unit part of the receiver does not matter. */
+        auto indication = m_itcPlatformIf->allocateMessage(ITC_SYSTEM_MESSAGE_NOTIFY_MBOX_DELETION_FROM_ITC_SERVER_INDICATION);
+        if(m_itcPlatformIf->send(indication, MailboxContactInfo(regionId)) != MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK))
+        {
+            m_itcPlatformIf->deallocateMessage(indication);
+        }
+    }
+}
+
+bool ItcServer::forwardToWorld(ItcMessageRawPtr msg)
+{
+    if(!m_proxy)
+    {
+        TPT_TRACE(TRACE_ABN, SSTR("No itc-proxy configured, cannot forward message to other Worlds!"));
+        return false;
+    }
+
+    /* Written to the socket straight from the request, it already holds the flattened message. */
+    auto &request = msg->m_itc_system_message_forward_message_to_itc_server_request;
+    return m_proxy->send(request.toWorldId, request.flattenMsg, request.flattenMsgLength, msg);
+}
+
+void ItcServer::deliverFromWorld(uint32_t fromWorldId, const uint8_t *msg, uint32_t length)
+{
+    /* msg points into the rx buffer of itc-proxy, which has no alignment guarantee. */
+    ItcAdminMessage preamble;
+    if(length < ITC_ADMIN_MESSAGE_MIN_SIZE)
+    {
+        TPT_TRACE(TRACE_ABN, SSTR("Too short message received from World ", fromWorldId, ", length = ", length));
+        return;
+    }
+    std::memcpy(&preamble, msg, ITC_ADMIN_MESSAGE_PREAMBLE_SIZE + ITC_MESSAGE_MSGNO_SIZE);
+    if(ITC_ADMIN_MESSAGE_PREAMBLE_SIZE + preamble.size + ITC_ADMIN_MESSAGE_ENDPOINT_SIZE != length
+        || msg[length - ITC_ADMIN_MESSAGE_ENDPOINT_SIZE] != ITC_ADMIN_MESSAGE_ENDPOINT)
+    {
+        TPT_TRACE(TRACE_ABN, SSTR("Corrupt message received from World ", fromWorldId, ", length = ", length));
+        return;
+    }
+
+    /* Messages for mailboxes of itc-server itself are copied onto the receiver's NUMA node. */
+    bool isForThisRegion = (preamble.receiver & ITC_MASK_REGION_ID) == (m_requestMboxIds.front() & ITC_MASK_REGION_ID);
+    uint32_t numaNode = isForThisRegion ? ItcTransportLocal::getInstance().lock()->getNumaNode(preamble.receiver) : MEMORY_NUMA_NODE_ANY;
+    auto adminMsg = ItcAdminMessageHelper::allocate(preamble.msgno, preamble.size, numaNode);
+    if(!adminMsg)
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("Failed to allocate message from World ", fromWorldId, ", size = ", preamble.size));
+        return;
+    }
+    std::memcpy(&adminMsg->msgno, msg + ITC_ADMIN_MESSAGE_PREAMBLE_SIZE, preamble.size);
+    adminMsg->sender = preamble.sender;
+    adminMsg->receiver = preamble.receiver;
+    ItcAdminMessageHelper::setPriority(adminMsg, ItcAdminMessageHelper::getPriority(&preamble));
+
+    /* Same transports as ItcPlatform::send() would pick in this Region. */
+    ItcPlatformIfReturnCode rc;
+    if(isForThisRegion)
+    {
+        rc = ItcTransportLocal::getInstance().lock()->send(adminMsg);
+    } else
+    {
+        rc = ItcTransportPosixShm::getInstance().lock()->send(adminMsg);
+        if(rc != MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK))
+        {
+            rc = ItcTransportSysvMsgQueue::getInstance().lock()->send(adminMsg);
+        }
+    }
+    if(rc != MAKE_RETURN_CODE(ItcPlatformIfReturnCode, ITC_OK))
+    {
+        TPT_TRACE(TRACE_ABN, SSTR("Failed to deliver message from World ", fromWorldId, " to mailbox 0x", std::hex, preamble.receiver));
+        ItcAdminMessageHelper::deallocate(adminMsg);
+    }
+}
+
+std::string ItcServer::getLSocketPath(itc_mailbox_id_t regionId)
+{
+    char path[sizeof(sockaddr_un::sun_path)] {};
+    ::snprintf(path, sizeof(path), "%s_0x%08x", ITC_PATH_LSOCK_BASE_FILE_NAME, regionId);
+    return path;
+}
+
+} // namespace INTERNAL
+} // namespace ITC
@@ -0,0 +1,40 @@
+#include <csignal>
+#include <filesystem>
+#include <optional>
+
+#include <pthread.h>
+
+#include "itcServer.h"
+
+using namespace ITC::INTERNAL;
+
+int main()
+{
+    /* Blocked before any thread is started, so that only sigwait() below ever sees them. */
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    std::optional<ItcProxyConfig> proxyConfig;
+    if(std::filesystem::exists(ITC_SERVER_PROXY_CONFIG_FILE))
+    {
+        proxyConfig.emplace();
+        if(!ItcProxy::loadConfig(ITC_SERVER_PROXY_CONFIG_FILE, *proxyConfig))
+        {
+            return 1;
+        }
+    }
+
+    ItcServer server;
+    if(!server.start(0, proxyConfig))
+    {
+        return 1;
+    }
+
+    int signal {0};
+    sigwait(&signals, &signal);
+    server.stop();
+    return 0;
+}
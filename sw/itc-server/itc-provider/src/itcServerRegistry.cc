@@ -0,0 +1,176 @@
+#include "itcServerRegistry.h"
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <algorithm>
+#include <iterator>
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+itc_mailbox_id_t ItcServerRegistry::allocateRegion()
+{
+    for(uint32_t wordIndex = 0; wordIndex < NUMBER_OF_REGION_WORDS; ++wordIndex)
+    {
+        auto &word = m_regionBitmap[wordIndex];
+        uint64_t bits = word.load(MEMORY_ORDER_RELAXED);
+        while(true)
+        {
+            uint64_t freeBits = ~bits;
+            if(wordIndex == 0)
+            {
+                freeBits &= ~((1ULL << ITC_SERVER_REGION_INDEX_FIRST_ASSIGNABLE) - 1);
+            }
+            if(freeBits == 0)
+            {
+                break;
+            }
+
+            uint32_t bitIndex = __builtin_ctzll(freeBits);
+            uint32_t regionIndex = wordIndex * 64 + bitIndex;
+            if(regionIndex > ITC_MAX_SUPPORTED_REGIONS)
+            {
+                return ITC_MAILBOX_ID_DEFAULT;
+            }
+            if(word.compare_exchange_weak(bits, bits | (1ULL << bitIndex), MEMORY_ORDER_ACQUIRE, MEMORY_ORDER_RELAXED))
+            {
+                return regionIndex << ITC_REGION_ID_SHIFT;
+            }
+        }
+    }
+    return ITC_MAILBOX_ID_DEFAULT;
+}
+
+void ItcServerRegistry::releaseRegion(itc_mailbox_id_t regionId)
+{
+    uint32_t regionIndex = (regionId & ITC_MASK_REGION_ID) >> ITC_REGION_ID_SHIFT;
+    if(regionIndex < ITC_SERVER_REGION_INDEX_FIRST_ASSIGNABLE || regionIndex > ITC_MAX_SUPPORTED_REGIONS)
+    {
+        return;
+    }
+    m_regionBitmap[regionIndex / 64].fetch_and(~(1ULL << (regionIndex % 64)), MEMORY_ORDER_RELEASE);
+}
+
+std::vector<itc_mailbox_id_t> ItcServerRegistry::getActiveRegions() const
+{
+    std::vector<itc_mailbox_id_t> regionIds;
+    for(uint32_t wordIndex = 0; wordIndex < NUMBER_OF_REGION_WORDS; ++wordIndex)
+    {
+        uint64_t bits = m_regionBitmap[wordIndex].load(MEMORY_ORDER_ACQUIRE);
+        while(bits)
+        {
+            uint32_t bitIndex = __builtin_ctzll(bits);
+            regionIds.push_back((wordIndex * 64 + bitIndex) << ITC_REGION_ID_SHIFT);
+            bits &= bits - 1;
+        }
+    }
+    return regionIds;
+}
+
+bool ItcServerRegistry::add(const std::string &mboxName, const RegisteredMailbox &mbox, std::vector<itc_mailbox_id_t> &locators)
+{
+    auto &shard = getShard(mboxName);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    if(!shard.mailboxes.try_emplace(mboxName, mbox).second)
+    {
+        TPT_TRACE(TRACE_ABN, SSTR("Mailbox name already registered, mbox_name = ", mboxName));
+        return false;
+    }
+
+    if(auto it = shard.locators.find(mboxName); it != shard.locators.end())
+    {
+        locators.insert(locators.end(), it->second.begin(), it->second.end());
+        shard.locators.erase(it);
+    }
+    return true;
+}
+
+bool ItcServerRegistry::remove(const std::string &mboxName, itc_mailbox_id_t mboxId)
+{
+    auto &shard = getShard(mboxName);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.mailboxes.find(mboxName);
+    if(it == shard.mailboxes.end() || it->second.mboxId != mboxId)
+    {
+        return false;
+    }
+    shard.mailboxes.erase(it);
+    return true;
+}
+
+itc_mailbox_id_t ItcServerRegistry::lookUp(const std::string &mboxName) const
+{
+    const auto &shard = getShard(mboxName);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.mailboxes.find(mboxName);
+    return it != shard.mailboxes.end() ? it->second.mboxId : ITC_MAILBOX_ID_DEFAULT;
+}
+
+itc_mailbox_id_t ItcServerRegistry::lookUpOrAddLocator(const std::string &mboxName, itc_mailbox_id_t locator)
+{
+    auto &shard = getShard(mboxName);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    if(auto it = shard.mailboxes.find(mboxName); it != shard.mailboxes.end())
+    {
+        return it->second.mboxId;
+    }
+    shard.locators[mboxName].push_back(locator);
+    return ITC_MAILBOX_ID_DEFAULT;
+}
+
+size_t ItcServerRegistry::removeRegion(itc_mailbox_id_t regionId)
+{
+    regionId &= ITC_MASK_REGION_ID;
+    auto isInRegion = [regionId](itc_mailbox_id_t mboxId)
+    {
+        return (mboxId & ITC_MASK_REGION_ID) == regionId;
+    };
+
+    size_t nrRemovedMboxes {0};
+    for(auto &shard : m_shards)
+    {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        nrRemovedMboxes += std::erase_if(shard.mailboxes, [&isInRegion](const auto &entry)
+        {
+            return isInRegion(entry.second.mboxId);
+        });
+        for(auto it = shard.locators.begin(); it != shard.locators.end();)
+        {
+            std::erase_if(it->second, isInRegion);
+            it = it->second.empty() ? shard.locators.erase(it) : std::next(it);
+        }
+    }
+    return nrRemovedMboxes;
+}
+
+size_t ItcServerRegistry::size() const
+{
+    size_t count {0};
+    for(const auto &shard : m_shards)
+    {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        count += shard.mailboxes.size();
+    }
+    return count;
+}
+
+ItcServerRegistry::Shard &ItcServerRegistry::getShard(const std::string &mboxName)
+{
+    return m_shards[std::hash<std::string>{}(mboxName) & (ITC_SERVER_REGISTRY_NUMBER_OF_SHARDS - 1)];
+}
+
+const ItcServerRegistry::Shard &ItcServerRegistry::getShard(const std::string &mboxName) const
+{
+    return m_shards[std::hash<std::string>{}(mboxName) & (ITC_SERVER_REGISTRY_NUMBER_OF_SHARDS - 1)];
+}
+
+} // namespace INTERNAL
+} // namespace ITC
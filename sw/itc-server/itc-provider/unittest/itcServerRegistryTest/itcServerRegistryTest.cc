@@ -0,0 +1,169 @@
+#include "itcServerRegistry.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <gtest/gtest.h>
+
+
+namespace ITC
+{
+namespace INTERNAL
+{
+
+using namespace ::testing;
+
+class ItcServerRegistryTest : public testing::Test
+{
+protected:
+    ItcServerRegistryTest()
+    {}
+
+    ~ItcServerRegistryTest()
+    {}
+
+    void SetUp() override
+    {}
+
+    void TearDown() override
+    {}
+};
+
+TEST_F(ItcServerRegistryTest, regionTest1)
+{
+    /***
+     * Test scenario: many threads start Regions at once, each gets a distinct id until all are taken,
+     * released ids are handed out again.
+     */
+    constexpr uint32_t NUMBER_OF_THREADS = 8;
+    constexpr uint32_t NUMBER_OF_REGIONS = ITC_MAX_SUPPORTED_REGIONS + 1 - ITC_SERVER_REGION_INDEX_FIRST_ASSIGNABLE;
+    ItcServerRegistry registry;
+    std::vector<std::vector<itc_mailbox_id_t>> regionIds(NUMBER_OF_THREADS);
+    std::vector<std::thread> threads;
+    for(uint32_t i = 0; i < NUMBER_OF_THREADS; ++i)
+    {
+        threads.emplace_back([&registry, &regionIds, i]()
+        {
+            for(itc_mailbox_id_t regionId = registry.allocateRegion(); regionId != ITC_MAILBOX_ID_DEFAULT; regionId = registry.allocateRegion())
+            {
+                regionIds[i].push_back(regionId);
+            }
+        });
+    }
+    for(auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    std::vector<itc_mailbox_id_t> allRegionIds;
+    for(const auto &ids : regionIds)
+    {
+        allRegionIds.insert(allRegionIds.end(), ids.begin(), ids.end());
+    }
+    std::sort(allRegionIds.begin(), allRegionIds.end());
+    ASSERT_EQ(allRegionIds.size(), NUMBER_OF_REGIONS);
+    ASSERT_EQ(std::adjacent_find(allRegionIds.begin(), allRegionIds.end()), allRegionIds.end());
+    ASSERT_EQ(allRegionIds.front(), ITC_SERVER_REGION_INDEX_FIRST_ASSIGNABLE << ITC_REGION_ID_SHIFT);
+    ASSERT_EQ(allRegionIds.back(), ITC_MAX_SUPPORTED_REGIONS << ITC_REGION_ID_SHIFT);
+    ASSERT_EQ(registry.getActiveRegions(), allRegionIds);
+
+    itc_mailbox_id_t releasedRegionId = allRegionIds.at(NUMBER_OF_REGIONS / 2);
+    registry.releaseRegion(releasedRegionId);
+    ASSERT_EQ(registry.getActiveRegions().size(), NUMBER_OF_REGIONS - 1);
+    ASSERT_EQ(registry.allocateRegion(), releasedRegionId);
+    ASSERT_EQ(registry.allocateRegion(), ITC_MAILBOX_ID_DEFAULT);
+}
+
+TEST_F(ItcServerRegistryTest, mailboxTest1)
+{
+    /***
+     * Test scenario: register, look up and remove mailboxes, names are unique and a stale deletion
+     * never removes a name which has been re-used meanwhile.
+     */
+    ItcServerRegistry registry;
+    std::vector<itc_mailbox_id_t> locators;
+    ASSERT_TRUE(registry.add("serverRegistryMbox1", RegisteredMailbox {0x00200001}, locators));
+    ASSERT_TRUE(registry.add("serverRegistryMbox2", RegisteredMailbox {0x00300001, true}, locators));
+    ASSERT_FALSE(registry.add("serverRegistryMbox1", RegisteredMailbox {0x00400001}, locators));
+    ASSERT_TRUE(locators.empty());
+    ASSERT_EQ(registry.size(), 2);
+    ASSERT_EQ(registry.lookUp("serverRegistryMbox1"), 0x00200001);
+    ASSERT_EQ(registry.lookUp("serverRegistryMbox3"), ITC_MAILBOX_ID_DEFAULT);
+
+    ASSERT_FALSE(registry.remove("serverRegistryMbox1", 0x00400001));
+    ASSERT_TRUE(registry.remove("serverRegistryMbox1", 0x00200001));
+    ASSERT_EQ(registry.lookUp("serverRegistryMbox1"), ITC_MAILBOX_ID_DEFAULT);
+
+    ASSERT_TRUE(registry.add("serverRegistryMbox1", RegisteredMailbox {0x00400001}, locators));
+    ASSERT_FALSE(registry.remove("serverRegistryMbox1", 0x00200001));
+    ASSERT_EQ(registry.lookUp("serverRegistryMbox1"), 0x00400001);
+}
+
+TEST_F(ItcServerRegistryTest, locatorTest1)
+{
+    /***
+     * Test scenario: async locates of a name which does not exist yet are handed out once it is registered,
+     * locators of a Region which went away are dropped together with its mailboxes.
+     */
+    ItcServerRegistry registry;
+    std::vector<itc_mailbox_id_t> locators;
+    ASSERT_EQ(registry.lookUpOrAddLocator("serverRegistryMbox1", 0x00200001), ITC_MAILBOX_ID_DEFAULT);
+    ASSERT_EQ(registry.lookUpOrAddLocator("serverRegistryMbox1", 0x00300001), ITC_MAILBOX_ID_DEFAULT);
+    ASSERT_EQ(registry.lookUpOrAddLocator("serverRegistryMbox2", 0x00300001), ITC_MAILBOX_ID_DEFAULT);
+    ASSERT_TRUE(registry.add("serverRegistryMbox3", RegisteredMailbox {0x00300002}, locators));
+    ASSERT_TRUE(registry.add("serverRegistryMbox4", RegisteredMailbox {0x00300003}, locators));
+
+    ASSERT_TRUE(registry.add("serverRegistryMbox1", RegisteredMailbox {0x00400001}, locators));
+    ASSERT_EQ(locators, std::vector<itc_mailbox_id_t>({0x00200001, 0x00300001}));
+    ASSERT_EQ(registry.lookUpOrAddLocator("serverRegistryMbox1", 0x00200002), 0x00400001);
+
+    ASSERT_EQ(registry.removeRegion(0x00300000), 2);
+    ASSERT_EQ(registry.size(), 1);
+    locators.clear();
+    ASSERT_TRUE(registry.add("serverRegistryMbox2", RegisteredMailbox {0x00400002}, locators));
+    ASSERT_TRUE(locators.empty());
+}
+
+TEST_F(ItcServerRegistryTest, concurrencyTest1)
+{
+    /***
+     * Test scenario: request threads register, look up and remove their own names concurrently,
+     * nothing is lost or duplicated across shards.
+     */
+    constexpr uint32_t NUMBER_OF_THREADS = 8;
+    constexpr uint32_t NUMBER_OF_MAILBOXES = 500;
+    ItcServerRegistry registry;
+    std::vector<std::thread> threads;
+    std::vector<uint32_t> nrErrors(NUMBER_OF_THREADS, 0);
+    for(uint32_t i = 0; i < NUMBER_OF_THREADS; ++i)
+    {
+        threads.emplace_back([&registry, &nrErrors, i]()
+        {
+            itc_mailbox_id_t regionId = (i + ITC_SERVER_REGION_INDEX_FIRST_ASSIGNABLE) << ITC_REGION_ID_SHIFT;
+            std::vector<itc_mailbox_id_t> locators;
+            for(uint32_t j = 0; j < NUMBER_OF_MAILBOXES; ++j)
+            {
+                std::string name = "serverRegistryMbox" + std::to_string(i) + "_" + std::to_string(j);
+                nrErrors[i] += !registry.add(name, RegisteredMailbox {regionId | j}, locators);
+                nrErrors[i] += registry.lookUp(name) != (regionId | j);
+                if(j % 2)
+                {
+                    nrErrors[i] += !registry.remove(name, regionId | j);
+                }
+            }
+        });
+    }
+    for(auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ(std::count(nrErrors.begin(), nrErrors.end(), 0), NUMBER_OF_THREADS);
+    ASSERT_EQ(registry.size(), NUMBER_OF_THREADS * NUMBER_OF_MAILBOXES / 2);
+    ASSERT_EQ(registry.removeRegion(ITC_SERVER_REGION_INDEX_FIRST_ASSIGNABLE << ITC_REGION_ID_SHIFT), NUMBER_OF_MAILBOXES / 2);
+    ASSERT_EQ(registry.size(), (NUMBER_OF_THREADS - 1) * NUMBER_OF_MAILBOXES / 2);
+}
+
+} // namespace INTERNAL
+} // namespace ITC
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <gtest/gtest.h>
+
+#include "itc.h"
+#include "itcConstant.h"
+#include "itcEthernetProto.h"
+#include "itcLockFreeQueue.h"
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+using namespace ITC::PROVIDED;
+
+#define ITC_PROXY_MAX_EPOLL_EVENTS                      (uint32_t)(64)
+#define ITC_PROXY_MAX_FRAME_SIZE                        (uint32_t)(16 * 1024 * 1024) /* Anything bigger means a broken peer */
+#define ITC_PROXY_RX_CHUNK_SIZE                         (uint32_t)(64 * 1024)
+#define ITC_PROXY_MAX_IOVECS_PER_WRITE                  (uint32_t)(1024) /* IOV_MAX, two per message: frame header and message */
+
+struct ItcProxyWorld
+{
+    uint32_t worldId {0};
+    std::string address; /* IPv4 dotted address */
+    uint16_t port {0};
+};
+
+struct ItcProxyConfig
+{
+    uint32_t myWorldId {0};
+    std::string listenAddress {"0.0.0.0"};
+    uint16_t listenPort {0}; /* 0 lets the kernel pick one, see ItcProxy::getListenPort() */
+    std::vector<ItcProxyWorld> worlds;
+};
+
+struct ItcProxyStatistics
+{
+    uint64_t nrSentMsgs {0};
+    uint64_t nrWritevCalls {0};
+    uint64_t nrReceivedMsgs {0};
+    uint64_t nrDroppedMsgs {0};
+};
+
+/***
+ * itc-proxy, the gateway of itc-server towards other Worlds over TCP.
+ *
+ * One I/O thread owns all sockets:
+ * + One persistent connection per remote World, connected on the first message to it. Nagle is disabled, instead
+ *   everything queued by send() since the last write goes out in one writev() of [frame header][message] pairs.
+ * + Connections accepted from other Worlds are read in chunks, frames split across reads are put together again
+ *   and handed to the rx handler one by one, see itc_ethernet_proxy_frame_header.
+ *
+ * Messages are never copied on the way out, the caller keeps them alive until the tx done handler is called with
+ * their cookie, whether they were written or dropped because the World could not be reached.
+ */
+class ItcProxy
+{
+public:
+    /* Called from the I/O thread, msg is only valid during the call. */
+    using RxHandler = std::function<void(uint32_t fromWorldId, const uint8_t *msg, uint32_t length)>;
+    using TxDoneHandler = std::function<void(void *cookie)>;
+
+    ItcProxy(const ItcProxyConfig &config, RxHandler rxHandler, TxDoneHandler txDoneHandler);
+    ~ItcProxy();
+
+    ItcProxy(const ItcProxy &other) = delete;
+    ItcProxy &operator=(const ItcProxy &other) = delete;
+    ItcProxy(ItcProxy &&other) noexcept = delete;
+    ItcProxy &operator=(ItcProxy &&other) noexcept = delete;
+
+    bool start();
+    void stop();
+
+    /***
+     * Queues length bytes at msg for toWorldId, returns false if that World is not configured or the proxy is not
+     * running, then the caller still owns the message.
+     */
+    bool send(uint32_t toWorldId, const uint8_t *msg, uint32_t length, void *cookie);
+
+    uint16_t getListenPort() const;
+    ItcProxyStatistics getStatistics() const;
+
+    /***
+     * Reads a config file with one entry per line, '#' starts a comment:
+     *     world <myWorldId>
+     *     listen <address> <port>
+     *     peer <worldId> <address> <port>
+     */
+    static bool loadConfig(const std::string &path, ItcProxyConfig &config);
+
+private:
+    enum class ConnectionType
+    {
+        LISTENER,
+        RX,         /* Accepted from another World */
+        TX,         /* Towards a configured World */
+        WAKEUP      /* eventfd written by send() and stop() */
+    };
+
+    struct Connection
+    {
+        int32_t fd {-1};
+        ConnectionType type {ConnectionType::RX};
+        uint32_t worldId {0};
+        std::vector<uint8_t> rxBuffer;
+        size_t rxLength {0};
+    };
+
+    struct PendingMessage
+    {
+        itc_ethernet_proxy_frame_header header;
+        const uint8_t *msg {nullptr};
+        void *cookie {nullptr};
+    };
+
+    struct RemoteWorld
+    {
+        ItcProxyWorld config;
+        /* Filled by send(). */
+        std::mutex mutex;
+        std::deque<PendingMessage> queue;
+        /* Only touched by the I/O thread. */
+        std::deque<PendingMessage> txQueue;
+        size_t txOffset {0}; /* Bytes of txQueue.front() frame already written */
+        Connection connection;
+        bool isConnecting {false};
+        bool isWaitingForWritable {false};
+    };
+
+    bool createListener();
+    bool addConnection(Connection *connection, uint32_t events);
+    void closeConnection(Connection *connection);
+
+    void ioThread();
+    void acceptWorlds();
+    void receiveFrames(Connection *connection);
+    void takeQueuedMessages();
+    void flush(RemoteWorld &world);
+    bool connectWorld(RemoteWorld &world);
+    void onWritable(RemoteWorld &world);
+    void disconnectWorld(RemoteWorld &world);
+    void setWaitingForWritable(RemoteWorld &world, bool isWaiting);
+
+private:
+    ItcProxyConfig m_config;
+    RxHandler m_rxHandler;
+    TxDoneHandler m_txDoneHandler;
+    std::unordered_map<uint32_t, std::unique_ptr<RemoteWorld>> m_worlds;
+    std::unordered_set<Connection *> m_rxConnections;
+
+    int32_t m_epollFd {-1};
+    Connection m_listener {-1, ConnectionType::LISTENER, 0, {}, 0};
+    Connection m_wakeup {-1, ConnectionType::WAKEUP, 0, {}, 0};
+    std::atomic<bool> m_isRunning {false};
+    /* Set by the first send() after the I/O thread last looked, so that a burst costs one eventfd write. */
+    std::atomic<bool> m_isWakeupPending {false};
+    std::thread m_ioThread;
+
+    std::atomic<uint64_t> m_nrSentMsgs {0};
+    std::atomic<uint64_t> m_nrWritevCalls {0};
+    std::atomic<uint64_t> m_nrReceivedMsgs {0};
+    std::atomic<uint64_t> m_nrDroppedMsgs {0};
+
+    friend class ItcProxyTest;
+}; // class ItcProxy
+
+} // namespace INTERNAL
+} // namespace ITC
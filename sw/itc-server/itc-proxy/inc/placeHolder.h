@@ -1 +0,0 @@
-// This is placeholder file
\ No newline at end of file
@@ -0,0 +1,581 @@
+#include "itcProxy.h"
+
+#include <cstdint>
+#include <cstring>
+#include <array>
+#include <fstream>
+#include <sstream>
+
+#include <errno.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace ITC
+{
+/***
+ * Please do not use anything in this namespace outside itc-platform project,
+ * since it's for private usage
+ */
+namespace INTERNAL
+{
+
+ItcProxy::ItcProxy(const ItcProxyConfig &config, RxHandler rxHandler, TxDoneHandler txDoneHandler)
+    : m_config(config),
+      m_rxHandler(std::move(rxHandler)),
+      m_txDoneHandler(std::move(txDoneHandler))
+{
+    /* Fixed from here on, so that send() can look up Worlds without a lock. */
+    for(const auto &worldConfig : m_config.worlds)
+    {
+        auto world = std::make_unique<RemoteWorld>();
+        world->config = worldConfig;
+        world->connection.type = ConnectionType::TX;
+        world->connection.worldId = worldConfig.worldId;
+        m_worlds[worldConfig.worldId] = std::move(world);
+    }
+}
+
+ItcProxy::~ItcProxy()
+{
+    stop();
+}
+
+bool ItcProxy::start()
+{
+    if(m_isRunning)
+    {
+        return true;
+    }
+
+    m_epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    m_wakeup.fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(m_epollFd < 0 || m_wakeup.fd < 0 || !createListener()
+        || !addConnection(&m_listener, EPOLLIN) || !addConnection(&m_wakeup, EPOLLIN))
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("Failed to start itc-proxy, errno = ", errno));
+        stop();
+        return false;
+    }
+
+    m_isRunning = true;
+    m_ioThread = std::thread(&ItcProxy::ioThread, this);
+    return true;
+}
+
+void ItcProxy::stop()
+{
+    if(m_isRunning.exchange(false))
+    {
+        uint64_t value {1};
+        if(::write(m_wakeup.fd, &value, sizeof(value)) < 0)
+        {
+            TPT_TRACE(TRACE_ERROR, SSTR("Failed to wake up itc-proxy I/O thread, errno = ", errno));
+        }
+        m_ioThread.join();
+    }
+
+    while(!m_rxConnections.empty())
+    {
+        closeConnection(*m_rxConnections.begin());
+    }
+    for(auto &[worldId, world] : m_worlds)
+    {
+        {
+            std::lock_guard<std::mutex> lock(world->mutex);
+            world->txQueue.insert(world->txQueue.end(), world->queue.begin(), world->queue.end());
+            world->queue.clear();
+        }
+        disconnectWorld(*world);
+    }
+    for(auto connection : {&m_listener, &m_wakeup})
+    {
+        if(connection->fd != -1)
+        {
+            ::close(connection->fd);
+            connection->fd = -1;
+        }
+    }
+    if(m_epollFd != -1)
+    {
+        ::close(m_epollFd);
+        m_epollFd = -1;
+    }
+}
+
+bool ItcProxy::send(uint32_t toWorldId, const uint8_t *msg, uint32_t length, void *cookie)
+{
+    auto it = m_worlds.find(toWorldId);
+    if(!m_isRunning.load(MEMORY_ORDER_ACQUIRE) || it == m_worlds.end() || length > ITC_PROXY_MAX_FRAME_SIZE)
+    {
+        TPT_TRACE(TRACE_ABN, SSTR("Cannot forward message to World ", toWorldId, ", length = ", length));
+        return false;
+    }
+
+    PendingMessage pending;
+    pending.header.length = htonl(length);
+    pending.header.fromWorldId = htonl(m_config.myWorldId);
+    pending.msg = msg;
+    pending.cookie = cookie;
+    {
+        std::lock_guard<std::mutex> lock(it->second->mutex);
+        it->second->queue.push_back(pending);
+    }
+
+    if(!m_isWakeupPending.exchange(true, MEMORY_ORDER_ACQUIRE_RELEASE))
+    {
+        uint64_t value {1};
+        if(::write(m_wakeup.fd, &value, sizeof(value)) < 0)
+        {
+            TPT_TRACE(TRACE_ERROR, SSTR("Failed to wake up itc-proxy I/O thread, errno = ", errno));
+        }
+    }
+    return true;
+}
+
+uint16_t ItcProxy::getListenPort() const
+{
+    sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+    if(m_listener.fd == -1 || ::getsockname(m_listener.fd, (sockaddr *)&addr, &addrLen) < 0)
+    {
+        return 0;
+    }
+    return ntohs(addr.sin_port);
+}
+
+ItcProxyStatistics ItcProxy::getStatistics() const
+{
+    ItcProxyStatistics statistics;
+    statistics.nrSentMsgs = m_nrSentMsgs.load(MEMORY_ORDER_RELAXED);
+    statistics.nrWritevCalls = m_nrWritevCalls.load(MEMORY_ORDER_RELAXED);
+    statistics.nrReceivedMsgs = m_nrReceivedMsgs.load(MEMORY_ORDER_RELAXED);
+    statistics.nrDroppedMsgs = m_nrDroppedMsgs.load(MEMORY_ORDER_RELAXED);
+    return statistics;
+}
+
+bool ItcProxy::loadConfig(const std::string &path, ItcProxyConfig &config)
+{
+    std::ifstream file(path);
+    if(!file.is_open())
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("Failed to open itc-proxy config ", path));
+        return false;
+    }
+
+    std::string line;
+    while(std::getline(file, line))
+    {
+        std::istringstream tokens(line.substr(0, line.find('#')));
+        std::string keyword;
+        if(!(tokens >> keyword))
+        {
+            continue;
+        }
+
+        bool isValid {false};
+        if(keyword == "world")
+        {
+            isValid = static_cast<bool>(tokens >> config.myWorldId);
+        } else if(keyword == "listen")
+        {
+            isValid = static_cast<bool>(tokens >> config.listenAddress >> config.listenPort);
+        } else if(keyword == "peer")
+        {
+            ItcProxyWorld world;
+            isValid = static_cast<bool>(tokens >> world.worldId >> world.address >> world.port) && world.worldId != 0;
+            config.worlds.push_back(world);
+        }
+        if(!isValid)
+        {
+            TPT_TRACE(TRACE_ERROR, SSTR("Invalid line in itc-proxy config ", path, ": ", line));
+            return false;
+        }
+    }
+    return config.myWorldId != 0;
+}
+
+bool ItcProxy::createListener()
+{
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(m_config.listenPort);
+    if(::inet_pton(AF_INET, m_config.listenAddress.c_str(), &addr.sin_addr) != 1)
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("Invalid itc-proxy listen address ", m_config.listenAddress));
+        return false;
+    }
+
+    m_listener.fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int32_t reuseAddr {1};
+    if(m_listener.fd < 0 || ::setsockopt(m_listener.fd, SOL_SOCKET, SO_REUSEADDR, &reuseAddr, sizeof(reuseAddr)) < 0
+        || ::bind(m_listener.fd, (const sockaddr *)&addr, sizeof(addr)) < 0 || ::listen(m_listener.fd, SOMAXCONN) < 0)
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("Failed to listen on ", m_config.listenAddress, ":", m_config.listenPort, ", errno = ", errno));
+        return false;
+    }
+    return true;
+}
+
+bool ItcProxy::addConnection(Connection *connection, uint32_t events)
+{
+    epoll_event event;
+    event.events = events;
+    event.data.ptr = connection;
+    if(::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, connection->fd, &event) < 0)
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("Failed to epoll_ctl(EPOLL_CTL_ADD), errno = ", errno));
+        return false;
+    }
+    return true;
+}
+
+void ItcProxy::closeConnection(Connection *connection)
+{
+    ::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, connection->fd, nullptr);
+    ::close(connection->fd);
+    m_rxConnections.erase(connection);
+    delete connection;
+}
+
+void ItcProxy::ioThread()
+{
+    ::prctl(PR_SET_NAME, "itcProxyIo", 0, 0, 0);
+
+    std::array<epoll_event, ITC_PROXY_MAX_EPOLL_EVENTS> events;
+    while(m_isRunning.load(MEMORY_ORDER_RELAXED))
+    {
+        int32_t nrEvents = ::epoll_wait(m_epollFd, events.data(), events.size(), -1);
+        if(nrEvents < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            TPT_TRACE(TRACE_ERROR, SSTR("Failed to epoll_wait, errno = ", errno));
+            break;
+        }
+
+        /* New messages are taken last, so that no World is reconnected while events of its old socket are pending. */
+        bool isWokenUp {false};
+        for(int32_t i = 0; i < nrEvents; ++i)
+        {
+            auto connection = static_cast<Connection *>(events[i].data.ptr);
+            switch(connection->type)
+            {
+            case ConnectionType::LISTENER:
+                acceptWorlds();
+                break;
+            case ConnectionType::RX:
+                receiveFrames(connection);
+                break;
+            case ConnectionType::TX:
+            {
+                auto &world = *m_worlds.at(connection->worldId);
+                if(connection->fd == -1)
+                {
+                    break;
+                }
+                /* The other World never sends anything back, so anything but writable means it is gone. */
+                if(!world.isConnecting && (events[i].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP | EPOLLIN)))
+                {
+                    disconnectWorld(world);
+                } else
+                {
+                    onWritable(world);
+                }
+                break;
+            }
+            case ConnectionType::WAKEUP:
+                isWokenUp = true;
+                break;
+            }
+        }
+
+        if(isWokenUp)
+        {
+            uint64_t value {0};
+            if(::read(m_wakeup.fd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+            {
+                TPT_TRACE(TRACE_ERROR, SSTR("Failed to read eventfd, errno = ", errno));
+            }
+            takeQueuedMessages();
+        }
+    }
+}
+
+void ItcProxy::acceptWorlds()
+{
+    while(true)
+    {
+        int32_t fd = ::accept4(m_listener.fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(fd < 0)
+        {
+            if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                TPT_TRACE(TRACE_ERROR, SSTR("Failed to accept, errno = ", errno));
+            }
+            return;
+        }
+
+        auto connection = new Connection {fd, ConnectionType::RX, 0, {}, 0};
+        if(!addConnection(connection, EPOLLIN | EPOLLRDHUP))
+        {
+            ::close(fd);
+            delete connection;
+            continue;
+        }
+        m_rxConnections.insert(connection);
+    }
+}
+
+void ItcProxy::receiveFrames(Connection *connection)
+{
+    auto &buffer = connection->rxBuffer;
+    if(buffer.size() - connection->rxLength < ITC_PROXY_RX_CHUNK_SIZE)
+    {
+        buffer.resize(connection->rxLength + ITC_PROXY_RX_CHUNK_SIZE);
+    }
+
+    ssize_t rxLen = ::recv(connection->fd, buffer.data() + connection->rxLength, buffer.size() - connection->rxLength, 0);
+    if(rxLen < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+    {
+        return;
+    }
+    if(rxLen <= 0)
+    {
+        closeConnection(connection);
+        return;
+    }
+    connection->rxLength += rxLen;
+
+    /* A frame may arrive in any number of pieces, whatever is left of it stays at the front of the buffer. */
+    size_t consumed {0};
+    while(connection->rxLength - consumed >= sizeof(itc_ethernet_proxy_frame_header))
+    {
+        itc_ethernet_proxy_frame_header header;
+        std::memcpy(&header, buffer.data() + consumed, sizeof(header));
+        uint32_t length = ntohl(header.length);
+        if(length > ITC_PROXY_MAX_FRAME_SIZE)
+        {
+            TPT_TRACE(TRACE_ABN, SSTR("Invalid frame received from World ", ntohl(header.fromWorldId), ", length = ", length));
+            closeConnection(connection);
+            return;
+        }
+        if(connection->rxLength - consumed < sizeof(header) + length)
+        {
+            break;
+        }
+
+        m_rxHandler(ntohl(header.fromWorldId), buffer.data() + consumed + sizeof(header), length);
+        m_nrReceivedMsgs.fetch_add(1, MEMORY_ORDER_RELAXED);
+        consumed += sizeof(header) + length;
+    }
+
+    if(consumed > 0)
+    {
+        std::memmove(buffer.data(), buffer.data() + consumed, connection->rxLength - consumed);
+        connection->rxLength -= consumed;
+    }
+}
+
+void ItcProxy::takeQueuedMessages()
+{
+    /* Cleared first, a send() racing with the take below only causes one more wakeup. */
+    m_isWakeupPending.store(false, MEMORY_ORDER_RELEASE);
+    for(auto &[worldId, world] : m_worlds)
+    {
+        {
+            std::lock_guard<std::mutex> lock(world->mutex);
+            if(world->queue.empty())
+            {
+                continue;
+            }
+            world->txQueue.insert(world->txQueue.end(), world->queue.begin(), world->queue.end());
+            world->queue.clear();
+        }
+        flush(*world);
+    }
+}
+
+void ItcProxy::flush(RemoteWorld &world)
+{
+    if(world.txQueue.empty())
+    {
+        return;
+    }
+    if(world.connection.fd == -1 && !connectWorld(world))
+    {
+        disconnectWorld(world);
+        return;
+    }
+    if(world.isConnecting || world.isWaitingForWritable)
+    {
+        return;
+    }
+
+    constexpr size_t HEADER_SIZE = sizeof(itc_ethernet_proxy_frame_header);
+    std::array<iovec, ITC_PROXY_MAX_IOVECS_PER_WRITE> iovecs;
+    while(!world.txQueue.empty())
+    {
+        size_t nrIovecs {0};
+        size_t offset = world.txOffset;
+        for(auto it = world.txQueue.begin(); it != world.txQueue.end() && nrIovecs + 2 <= iovecs.size(); ++it)
+        {
+            size_t length = ntohl(it->header.length);
+            if(offset < HEADER_SIZE)
+            {
+                iovecs[nrIovecs++] = {reinterpret_cast<uint8_t *>(&it->header) + offset, HEADER_SIZE - offset};
+                iovecs[nrIovecs++] = {const_cast<uint8_t *>(it->msg), length};
+            } else
+            {
+                iovecs[nrIovecs++] = {const_cast<uint8_t *>(it->msg) + offset - HEADER_SIZE, length + HEADER_SIZE - offset};
+            }
+            offset = 0;
+        }
+
+        ssize_t written = ::writev(world.connection.fd, iovecs.data(), nrIovecs);
+        m_nrWritevCalls.fetch_add(1, MEMORY_ORDER_RELAXED);
+        if(written < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            if(errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                setWaitingForWritable(world, true);
+                return;
+            }
+            TPT_TRACE(TRACE_ABN, SSTR("Failed to write to World ", world.config.worldId, ", errno = ", errno));
+            disconnectWorld(world);
+            return;
+        }
+
+        size_t remaining = written;
+        while(remaining > 0)
+        {
+            size_t frameRemaining = HEADER_SIZE + ntohl(world.txQueue.front().header.length) - world.txOffset;
+            if(remaining < frameRemaining)
+            {
+                world.txOffset += remaining;
+                break;
+            }
+            remaining -= frameRemaining;
+            world.txOffset = 0;
+            m_txDoneHandler(world.txQueue.front().cookie);
+            world.txQueue.pop_front();
+            m_nrSentMsgs.fetch_add(1, MEMORY_ORDER_RELAXED);
+        }
+    }
+}
+
+bool ItcProxy::connectWorld(RemoteWorld &world)
+{
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(world.config.port);
+    if(::inet_pton(AF_INET, world.config.address.c_str(), &addr.sin_addr) != 1)
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("Invalid address of World ", world.config.worldId, ": ", world.config.address));
+        return false;
+    }
+
+    int32_t fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(fd < 0)
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("Failed to open socket, errno = ", errno));
+        return false;
+    }
+    /* Batching is done by flush(), waiting for more data in the kernel would only add latency. */
+    int32_t noDelay {1};
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    if(::connect(fd, (const sockaddr *)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS)
+    {
+        TPT_TRACE(TRACE_ABN, SSTR("Failed to connect to World ", world.config.worldId, ", errno = ", errno));
+        ::close(fd);
+        return false;
+    }
+
+    world.connection.fd = fd;
+    world.isConnecting = true;
+    world.isWaitingForWritable = true;
+    if(!addConnection(&world.connection, EPOLLOUT | EPOLLRDHUP))
+    {
+        ::close(fd);
+        world.connection.fd = -1;
+        world.isConnecting = false;
+        world.isWaitingForWritable = false;
+        return false;
+    }
+    return true;
+}
+
+void ItcProxy::onWritable(RemoteWorld &world)
+{
+    if(world.isConnecting)
+    {
+        int32_t error {0};
+        socklen_t errorLen = sizeof(error);
+        if(::getsockopt(world.connection.fd, SOL_SOCKET, SO_ERROR, &error, &errorLen) < 0 || error != 0)
+        {
+            TPT_TRACE(TRACE_ABN, SSTR("Failed to connect to World ", world.config.worldId, ", error = ", error));
+            disconnectWorld(world);
+            return;
+        }
+        world.isConnecting = false;
+    }
+    setWaitingForWritable(world, false);
+    flush(world);
+}
+
+void ItcProxy::disconnectWorld(RemoteWorld &world)
+{
+    if(world.connection.fd != -1)
+    {
+        ::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, world.connection.fd, nullptr);
+        ::close(world.connection.fd);
+        world.connection.fd = -1;
+    }
+    world.isConnecting = false;
+    world.isWaitingForWritable = false;
+
+    /* Partly written frames cannot be resumed on a new connection, the rest is not retried either. */
+    for(const auto &pending : world.txQueue)
+    {
+        m_txDoneHandler(pending.cookie);
+    }
+    m_nrDroppedMsgs.fetch_add(world.txQueue.size(), MEMORY_ORDER_RELAXED);
+    world.txQueue.clear();
+    world.txOffset = 0;
+}
+
+void ItcProxy::setWaitingForWritable(RemoteWorld &world, bool isWaiting)
+{
+    if(world.isWaitingForWritable == isWaiting)
+    {
+        return;
+    }
+
+    epoll_event event;
+    event.events = isWaiting ? (EPOLLOUT | EPOLLRDHUP) : EPOLLRDHUP;
+    event.data.ptr = &world.connection;
+    if(::epoll_ctl(m_epollFd, EPOLL_CTL_MOD, world.connection.fd, &event) < 0)
+    {
+        TPT_TRACE(TRACE_ERROR, SSTR("Failed to epoll_ctl(EPOLL_CTL_MOD), errno = ", errno));
+    }
+    world.isWaitingForWritable = isWaiting;
+}
+
+} // namespace INTERNAL
+} // namespace ITC
@@ -0,0 +1,275 @@
+#include "itcProxy.h"
+
+#include <cstring>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+
+namespace ITC
+{
+namespace INTERNAL
+{
+
+using namespace ::testing;
+
+struct ReceivedMessage
+{
+    uint32_t fromWorldId {0};
+    std::vector<uint8_t> msg;
+};
+
+/* What one ItcProxy instance has received and released, filled from its I/O thread. */
+struct ProxyEndpoint
+{
+    std::mutex mutex;
+    std::vector<ReceivedMessage> received;
+    std::vector<void *> txDoneCookies;
+
+    ItcProxy::RxHandler rxHandler()
+    {
+        return [this](uint32_t fromWorldId, const uint8_t *msg, uint32_t length)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            received.push_back({fromWorldId, std::vector<uint8_t>(msg, msg + length)});
+        };
+    }
+
+    ItcProxy::TxDoneHandler txDoneHandler()
+    {
+        return [this](void *cookie)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            txDoneCookies.push_back(cookie);
+        };
+    }
+
+    bool waitFor(size_t nrReceived, size_t nrTxDone)
+    {
+        for(uint32_t i = 0; i < 5000; ++i)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if(received.size() >= nrReceived && txDoneCookies.size() >= nrTxDone)
+                {
+                    return true;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+};
+
+class ItcProxyTest : public testing::Test
+{
+protected:
+    ItcProxyTest()
+    {}
+
+    ~ItcProxyTest()
+    {}
+
+    void SetUp() override
+    {}
+
+    void TearDown() override
+    {}
+
+    /* Both ItcProxy instances have to know each other's port before either one starts. */
+    static uint16_t getFreePort()
+    {
+        int32_t fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t addrLen = sizeof(addr);
+        ::bind(fd, (const sockaddr *)&addr, sizeof(addr));
+        ::getsockname(fd, (sockaddr *)&addr, &addrLen);
+        ::close(fd);
+        return ntohs(addr.sin_port);
+    }
+
+    static std::vector<uint8_t> makeMessage(uint32_t index)
+    {
+        std::vector<uint8_t> msg(sizeof(uint32_t) + index % 100, static_cast<uint8_t>(index));
+        std::memcpy(msg.data(), &index, sizeof(index));
+        return msg;
+    }
+};
+
+TEST_F(ItcProxyTest, burstTest1)
+{
+    /***
+     * Test scenario: two Worlds on loopback send bursts to each other at the same time, every message arrives
+     * once, in order and unchanged, and each burst takes far fewer writev() calls than messages.
+     */
+    constexpr uint32_t NUMBER_OF_MESSAGES = 1000;
+    uint16_t portA = getFreePort();
+    uint16_t portB = getFreePort();
+    ProxyEndpoint endpointA;
+    ProxyEndpoint endpointB;
+    ItcProxy proxyA({1, "127.0.0.1", portA, {{2, "127.0.0.1", portB}}}, endpointA.rxHandler(), endpointA.txDoneHandler());
+    ItcProxy proxyB({2, "127.0.0.1", portB, {{1, "127.0.0.1", portA}}}, endpointB.rxHandler(), endpointB.txDoneHandler());
+    ASSERT_TRUE(proxyA.start());
+    ASSERT_TRUE(proxyB.start());
+    ASSERT_EQ(proxyB.getListenPort(), portB);
+
+    std::vector<std::vector<uint8_t>> msgs;
+    for(uint32_t i = 0; i < NUMBER_OF_MESSAGES; ++i)
+    {
+        msgs.push_back(makeMessage(i));
+    }
+    std::thread senderB([&proxyB, &msgs]()
+    {
+        for(auto &msg : msgs)
+        {
+            ASSERT_TRUE(proxyB.send(1, msg.data(), msg.size(), &msg));
+        }
+    });
+    for(auto &msg : msgs)
+    {
+        ASSERT_TRUE(proxyA.send(2, msg.data(), msg.size(), &msg));
+    }
+    senderB.join();
+
+    ASSERT_TRUE(endpointA.waitFor(NUMBER_OF_MESSAGES, NUMBER_OF_MESSAGES));
+    ASSERT_TRUE(endpointB.waitFor(NUMBER_OF_MESSAGES, NUMBER_OF_MESSAGES));
+    for(auto endpoint : {&endpointA, &endpointB})
+    {
+        std::lock_guard<std::mutex> lock(endpoint->mutex);
+        ASSERT_EQ(endpoint->received.size(), NUMBER_OF_MESSAGES);
+        for(uint32_t i = 0; i < NUMBER_OF_MESSAGES; ++i)
+        {
+            ASSERT_EQ(endpoint->received[i].fromWorldId, endpoint == &endpointA ? 2 : 1);
+            ASSERT_EQ(endpoint->received[i].msg, msgs[i]);
+            ASSERT_EQ(endpoint->txDoneCookies[i], &msgs[i]);
+        }
+    }
+
+    for(auto proxy : {&proxyA, &proxyB})
+    {
+        auto statistics = proxy->getStatistics();
+        ASSERT_EQ(statistics.nrSentMsgs, NUMBER_OF_MESSAGES);
+        ASSERT_EQ(statistics.nrReceivedMsgs, NUMBER_OF_MESSAGES);
+        ASSERT_EQ(statistics.nrDroppedMsgs, 0);
+        ASSERT_LT(statistics.nrWritevCalls, NUMBER_OF_MESSAGES);
+    }
+}
+
+TEST_F(ItcProxyTest, splitFrameTest1)
+{
+    /***
+     * Test scenario: frames arrive in pieces of a few bytes each, split anywhere in header or message, and are
+     * put together again before they are handed over.
+     */
+    ProxyEndpoint endpoint;
+    ItcProxy proxy({2, "127.0.0.1", 0, {}}, endpoint.rxHandler(), endpoint.txDoneHandler());
+    ASSERT_TRUE(proxy.start());
+
+    int32_t fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(proxy.getListenPort());
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(::connect(fd, (const sockaddr *)&addr, sizeof(addr)), 0);
+    int32_t noDelay {1};
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    std::vector<uint8_t> stream;
+    std::vector<std::vector<uint8_t>> msgs;
+    for(uint32_t i = 0; i < 3; ++i)
+    {
+        msgs.push_back(makeMessage(i + 7));
+        itc_ethernet_proxy_frame_header header {htonl(static_cast<uint32_t>(msgs.back().size())), htonl(5)};
+        auto headerBytes = reinterpret_cast<const uint8_t *>(&header);
+        stream.insert(stream.end(), headerBytes, headerBytes + sizeof(header));
+        stream.insert(stream.end(), msgs.back().begin(), msgs.back().end());
+    }
+    for(size_t offset = 0, pieceSize = 1; offset < stream.size(); offset += pieceSize, pieceSize = pieceSize % 7 + 1)
+    {
+        pieceSize = std::min(pieceSize, stream.size() - offset);
+        ASSERT_EQ(::send(fd, stream.data() + offset, pieceSize, 0), pieceSize);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    ASSERT_TRUE(endpoint.waitFor(msgs.size(), 0));
+    std::lock_guard<std::mutex> lock(endpoint.mutex);
+    ASSERT_EQ(endpoint.received.size(), msgs.size());
+    for(size_t i = 0; i < msgs.size(); ++i)
+    {
+        ASSERT_EQ(endpoint.received[i].fromWorldId, 5);
+        ASSERT_EQ(endpoint.received[i].msg, msgs[i]);
+    }
+    ::close(fd);
+}
+
+TEST_F(ItcProxyTest, unreachableWorldTest1)
+{
+    /***
+     * Test scenario: messages to a World nobody listens for are dropped and handed back, unknown Worlds are refused
+     * right away so that the caller keeps its message.
+     */
+    ProxyEndpoint endpoint;
+    ItcProxy proxy({1, "127.0.0.1", 0, {{3, "127.0.0.1", getFreePort()}}}, endpoint.rxHandler(), endpoint.txDoneHandler());
+    std::vector<uint8_t> msg = makeMessage(0);
+    ASSERT_FALSE(proxy.send(3, msg.data(), msg.size(), &msg));
+    ASSERT_TRUE(proxy.start());
+
+    ASSERT_FALSE(proxy.send(4, msg.data(), msg.size(), &msg));
+    ASSERT_TRUE(proxy.send(3, msg.data(), msg.size(), &msg));
+    ASSERT_TRUE(proxy.send(3, msg.data(), msg.size(), &msg));
+    ASSERT_TRUE(endpoint.waitFor(0, 2));
+    ASSERT_EQ(proxy.getStatistics().nrDroppedMsgs, 2);
+    ASSERT_EQ(proxy.getStatistics().nrSentMsgs, 0);
+}
+
+TEST_F(ItcProxyTest, loadConfigTest1)
+{
+    /***
+     * Test scenario: a config file with comments is read into ItcProxyConfig, unknown keywords are rejected.
+     */
+    std::string path = "/tmp/itcProxyTest.conf";
+    {
+        std::ofstream file(path);
+        file << "# itc-proxy of World 1\n"
+             << "world 1\n"
+             << "listen 127.0.0.1 24000  # loopback only\n"
+             << "\n"
+             << "peer 2 10.0.0.2 24000\n"
+             << "peer 3 10.0.0.3 24001\n";
+    }
+    ItcProxyConfig config;
+    ASSERT_TRUE(ItcProxy::loadConfig(path, config));
+    ASSERT_EQ(config.myWorldId, 1);
+    ASSERT_EQ(config.listenAddress, "127.0.0.1");
+    ASSERT_EQ(config.listenPort, 24000);
+    ASSERT_EQ(config.worlds.size(), 2);
+    ASSERT_EQ(config.worlds[1].worldId, 3);
+    ASSERT_EQ(config.worlds[1].address, "10.0.0.3");
+    ASSERT_EQ(config.worlds[1].port, 24001);
+
+    {
+        std::ofstream file(path);
+        file << "world 1\n" << "neighbour 2 10.0.0.2 24000\n";
+    }
+    ItcProxyConfig invalidConfig;
+    ASSERT_FALSE(ItcProxy::loadConfig(path, invalidConfig));
+    ASSERT_FALSE(ItcProxy::loadConfig("/tmp/itcProxyTest.nonexistent.conf", invalidConfig));
+    ::unlink(path.c_str());
+}
+
+} // namespace INTERNAL
+} // namespace ITC